@@ -0,0 +1,49 @@
+#ifndef _H_BENCH_
+#define _H_BENCH_
+
+#include <stdint.h>
+#include <stdio.h>
+
+#define WIN32_LEAN_AND_MEAN
+#include <Windows.h>
+
+#include "MacroDatabase.h"
+
+// Seconds since an arbitrary point, only differences are meaningful
+static inline double Bench_now() {
+  LARGE_INTEGER counter, frequency;
+  QueryPerformanceCounter(&counter);
+  QueryPerformanceFrequency(&frequency);
+  return counter.QuadPart / (double)frequency.QuadPart;
+}
+
+static inline uint32_t Bench_random(uint64_t *state) {
+  *state ^= *state << 13;
+  *state ^= *state >> 7;
+  *state ^= *state << 17;
+  return (uint32_t)(*state >> 32);
+}
+
+// Valid synthetic meal, dates walk forward a few meals per day from 2000/1/1 and wrap back
+// before DATE_MAX_DAY_NUM so large benches stay storable
+static inline Meal_t Bench_randomMeal(uint64_t *state, uint64_t index) {
+  DayNum_t first = Date_toDayNum((Date_t) { 2000, 1, 1 });
+  uint32_t protein = Bench_random(state) % 80;
+  uint32_t fat = Bench_random(state) % 60;
+  uint32_t carbs = Bench_random(state) % 150;
+
+  return (Meal_t) {
+    .macro = {
+      .cals = (protein + carbs) * 4 + fat * 9 + 1 + Bench_random(state) % 200,
+      .protein = protein,
+      .fat = fat,
+      .carbs = carbs
+    },
+    .date = Date_fromDayNum(first + (DayNum_t)(index / 4 % (DATE_MAX_DAY_NUM - first + 1)))
+  };
+}
+
+#define BENCH_REPORT(name, seconds, rows) \
+  printf("%-32s %10.3f ms %10.1f Mrows/s\n", name, (seconds) * 1000.0, (rows) / (seconds) / 1e6)
+
+#endif
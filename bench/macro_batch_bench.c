@@ -0,0 +1,66 @@
+#include "Bench.h"
+#include "MacroKernel.h"
+
+#define BENCH_MEAL_COUNT 5000000u
+#define BENCH_REJECT_EVERY 97
+
+int main(void) {
+  Meal_t *meals = malloc(sizeof(Meal_t) * BENCH_MEAL_COUNT);
+  uint8_t *rejectMask = malloc((BENCH_MEAL_COUNT + 7) / 8);
+  uint8_t *scalarMask = malloc((BENCH_MEAL_COUNT + 7) / 8);
+
+  uint64_t state = 0x2545F4914F6CDD1Dull;
+  for (uint32_t index = 0; index < BENCH_MEAL_COUNT; index++) {
+    meals[index] = Bench_randomMeal(&state, index);
+  }
+
+  // Validation alone, a few meals are broken so every kernel has something to reject
+  for (uint32_t index = 0; index < BENCH_MEAL_COUNT; index += BENCH_REJECT_EVERY) {
+    meals[index].macro.cals = 0;
+  }
+
+  const char *isaNames[] = { "validate scalar", "validate sse2", "validate avx2" };
+  size_t expected = MacroKernel_validateScalar(meals, BENCH_MEAL_COUNT, scalarMask);
+  for (MacroKernelIsa_t isa = MACRO_KERNEL_ISA_SCALAR; isa <= MACRO_KERNEL_ISA_AVX2; isa++) {
+    MacroKernel_setIsa(isa);
+    if (MacroKernel_isa() != isa) {
+      printf("%-32s unsupported\n", isaNames[isa]);
+      continue;
+    }
+
+    double start = Bench_now();
+    size_t rejected = MacroKernel_validate(meals, BENCH_MEAL_COUNT, rejectMask);
+    BENCH_REPORT(isaNames[isa], Bench_now() - start, BENCH_MEAL_COUNT);
+
+    if (rejected != expected || memcmp(rejectMask, scalarMask, (BENCH_MEAL_COUNT + 7) / 8) != 0)
+      printf("MISMATCH: %zu rejected vs %zu\n", rejected, expected);
+  }
+  MacroKernel_setIsa(MACRO_KERNEL_ISA_AVX2);
+
+  for (uint32_t index = 0; index < BENCH_MEAL_COUNT; index += BENCH_REJECT_EVERY) {
+    meals[index].macro.cals = meals[index + 1].macro.cals;
+    meals[index].macro.protein = meals[index + 1].macro.protein;
+    meals[index].macro.fat = meals[index + 1].macro.fat;
+    meals[index].macro.carbs = meals[index + 1].macro.carbs;
+  }
+
+  // Whole history import, one call per meal against one call per batch
+  MacroDatabase_t *db = MacroDatabase_create(0);
+  double start = Bench_now();
+  for (uint32_t index = 0; index < BENCH_MEAL_COUNT; index++) {
+    MacroDatabase_add(db, meals[index]);
+  }
+  BENCH_REPORT("MacroDatabase_add per meal", Bench_now() - start, db->mealCount);
+  MacroDatabase_destroy(db);
+
+  db = MacroDatabase_create(0);
+  start = Bench_now();
+  size_t added = MacroDatabase_addBatch(db, meals, BENCH_MEAL_COUNT, rejectMask);
+  BENCH_REPORT("MacroDatabase_addBatch", Bench_now() - start, added);
+  MacroDatabase_destroy(db);
+
+  free(scalarMask);
+  free(rejectMask);
+  free(meals);
+  return 0;
+}
@@ -0,0 +1,78 @@
+#include "Bench.h"
+#include "FoodCatalog.h"
+
+// About the size of the USDA FoodData Central branded foods
+#define BENCH_FOOD_COUNT 500000u
+#define BENCH_LOOKUPS 5000000u
+#define BENCH_MEAL_ITEMS 8
+
+uint32_t _Bench_foodName(uint64_t *state, uint32_t index, char *out) {
+  static const char *words[] = {
+    "chicken", "breast", "raw", "cooked", "rice", "white", "brown", "oats", "rolled", "milk",
+    "whole", "skim", "cheese", "cheddar", "egg", "yolk", "bread", "wheat", "apple", "banana"
+  };
+
+  uint32_t length = 0;
+  for (uint32_t word = 0; word < 3; word++) {
+    length += sprintf(&out[length], "%s ", words[Bench_random(state) % 20]);
+  }
+  length += sprintf(&out[length], "#%u", index);
+  return length;
+}
+
+int main(void) {
+  FoodCatalog_t catalog;
+  FoodCatalog_init(&catalog);
+
+  uint64_t state = 0x2545F4914F6CDD1Dull;
+  char name[128];
+  double start = Bench_now();
+  for (uint32_t index = 0; index < BENCH_FOOD_COUNT; index++) {
+    uint32_t length = _Bench_foodName(&state, index, name);
+    FoodNutrients_t per100g = { .cals = 50.f + Bench_random(&state) % 400, .protein = Bench_random(&state) % 30,
+      .fat = Bench_random(&state) % 20, .carbs = Bench_random(&state) % 60 };
+    FoodCatalog_add(&catalog, name, length, &per100g);
+  }
+  BENCH_REPORT("intern", Bench_now() - start, BENCH_FOOD_COUNT);
+  printf("%u foods, %.1f B/food resident (%u B of names)\n", catalog.foodCount,
+    (double)FoodCatalog_size(&catalog) / catalog.foodCount, catalog.namesSize
+  );
+
+  // Lookups by name go through the hash index, names are read back from the arena
+  uint32_t missing = 0;
+  start = Bench_now();
+  for (uint32_t lookup = 0; lookup < BENCH_LOOKUPS; lookup++) {
+    FoodId_t id = Bench_random(&state) % catalog.foodCount;
+    const Food_t *food = FoodCatalog_get(&catalog, id);
+    missing += FoodCatalog_find(&catalog, FoodCatalog_name(&catalog, id), food->nameLength) != id;
+  }
+  BENCH_REPORT("find by name", Bench_now() - start, BENCH_LOOKUPS);
+  if (missing != 0)
+    printf("MISMATCH: %u names not found\n", missing);
+
+  FoodMeal_t meal;
+  FoodMeal_init(&meal, (Date_t) { 2024, 1, 1 });
+  for (uint32_t item = 0; item < BENCH_MEAL_ITEMS; item++) {
+    FoodMeal_add(&meal, Bench_random(&state) % catalog.foodCount, 20 + Bench_random(&state) % 200);
+  }
+
+  uint64_t checksum = 0;
+  start = Bench_now();
+  for (uint32_t lookup = 0; lookup < BENCH_LOOKUPS; lookup++) {
+    meal._totalsVersion = 0;
+    checksum += FoodMeal_totals(&meal, &catalog).cals;
+  }
+  BENCH_REPORT("meal totals, computed", Bench_now() - start, BENCH_LOOKUPS);
+
+  start = Bench_now();
+  for (uint32_t lookup = 0; lookup < BENCH_LOOKUPS; lookup++) {
+    checksum -= FoodMeal_totals(&meal, &catalog).cals;
+  }
+  BENCH_REPORT("meal totals, cached", Bench_now() - start, BENCH_LOOKUPS);
+  if (checksum != 0)
+    printf("MISMATCH: cached totals differ\n");
+
+  FoodMeal_cleanup(&meal);
+  FoodCatalog_cleanup(&catalog);
+  return 0;
+}
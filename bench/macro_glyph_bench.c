@@ -0,0 +1,165 @@
+#include "Bench.h"
+#include "GlyphTable.h"
+
+#define BENCH_TEXT_LENGTH (1u << 16)
+#define BENCH_REPEATS 100
+
+// About the size of the renderer's glyph
+typedef struct __BenchGlyph_t {
+  UC_t character;
+  float metrics[10];
+  uint32_t page;
+  float uv[4];
+} BenchGlyph_t;
+
+// Range of code points words are drawn from
+typedef struct __BenchScript_t {
+  UC_t first;
+  uint32_t count;
+} BenchScript_t;
+
+// Latin, Cyrillic, Greek, CJK, emoji and math letters
+static const BenchScript_t _benchScripts[] = {
+  { 0x61, 26 },
+  { 0x430, 32 },
+  { 0x3B1, 25 },
+  { 0x4E00, 3000 },
+  { 0x1F600, 80 },
+  { 0x1D400, 1000 }
+};
+#define BENCH_SCRIPT_COUNT (sizeof(_benchScripts) / sizeof(_benchScripts[0]))
+
+// What a lookup cost before, a direct index then a scan of the sorted glyphs
+typedef struct __BenchSorted_t {
+  BenchGlyph_t *glyphs;
+  uint32_t count, cap;
+} BenchSorted_t;
+
+BenchGlyph_t *_Bench_sortedGet(BenchSorted_t *self, UC_t character) {
+  if (character < self->count && self->glyphs[character].character == character)
+    return &self->glyphs[character];
+
+  for (uint32_t index = 0; index < self->count; index++) {
+    if (self->glyphs[index].character == character)
+      return &self->glyphs[index];
+    if (self->glyphs[index].character > character)
+      return NULL;
+  }
+  return NULL;
+}
+
+void _Bench_sortedInsert(BenchSorted_t *self, const BenchGlyph_t *glyph) {
+  if (self->count == self->cap) {
+    self->cap = self->cap == 0 ? 128 : self->cap << 1;
+    self->glyphs = realloc(self->glyphs, sizeof(BenchGlyph_t) * self->cap);
+  }
+
+  uint32_t index = 0;
+  while (index < self->count && self->glyphs[index].character < glyph->character) {
+    index++;
+  }
+  memmove(&self->glyphs[index + 1], &self->glyphs[index], sizeof(BenchGlyph_t) * (self->count - index));
+  self->glyphs[index] = *glyph;
+  self->count++;
+}
+
+BenchGlyph_t _Bench_glyph(UC_t character) {
+  BenchGlyph_t glyph = { .character = character, .page = character % 7 };
+  for (uint32_t index = 0; index < 10; index++) {
+    glyph.metrics[index] = (float)(character * (index + 1));
+  }
+  return glyph;
+}
+
+// Words of 2 to 9 code points from one script each, separated by spaces
+void _Bench_text(uint64_t *state, UC_t *text, uint32_t length) {
+  uint32_t at = 0;
+  while (at < length) {
+    const BenchScript_t *script = &_benchScripts[Bench_random(state) % BENCH_SCRIPT_COUNT];
+    uint32_t word = 2 + Bench_random(state) % 8;
+    for (uint32_t index = 0; index < word && at < length; index++) {
+      text[at++] = script->first + Bench_random(state) % script->count;
+    }
+    if (at < length)
+      text[at++] = ' ';
+  }
+}
+
+int main(void) {
+  UC_t *text = malloc(sizeof(UC_t) * BENCH_TEXT_LENGTH);
+  uint64_t state = 0x2545F4914F6CDD1Dull;
+  _Bench_text(&state, text, BENCH_TEXT_LENGTH);
+
+  GlyphTable_t table;
+  GlyphTable_init(&table, sizeof(BenchGlyph_t));
+  BenchSorted_t sorted = {0};
+
+  // The renderer loads ASCII up front, the rest on first sight
+  BenchGlyph_t *ascii[128];
+  for (UC_t character = 0; character < 128; character++) {
+    ascii[character] = GlyphTable_insert(&table, character);
+    *ascii[character] = _Bench_glyph(character);
+  }
+
+  double start = Bench_now();
+  for (uint32_t index = 0; index < BENCH_TEXT_LENGTH; index++) {
+    if (GlyphTable_get(&table, text[index]) != NULL)
+      continue;
+
+    BenchGlyph_t *glyph = GlyphTable_insert(&table, text[index]);
+    *glyph = _Bench_glyph(text[index]);
+  }
+  double seconds = Bench_now() - start;
+  printf("%-32s %10.3f ms, %u glyphs\n", "table, load", seconds * 1000.0, table.count);
+
+  for (UC_t character = 0; character < 128; character++) {
+    BenchGlyph_t glyph = _Bench_glyph(character);
+    _Bench_sortedInsert(&sorted, &glyph);
+  }
+  start = Bench_now();
+  for (uint32_t index = 0; index < BENCH_TEXT_LENGTH; index++) {
+    if (_Bench_sortedGet(&sorted, text[index]) != NULL)
+      continue;
+
+    BenchGlyph_t glyph = _Bench_glyph(text[index]);
+    _Bench_sortedInsert(&sorted, &glyph);
+  }
+  seconds = Bench_now() - start;
+  printf("%-32s %10.3f ms, %u glyphs\n", "sorted array, load", seconds * 1000.0, sorted.count);
+
+  // Every frame looks up every code point it draws again
+  uint64_t sum = 0;
+  start = Bench_now();
+  for (uint32_t repeat = 0; repeat < BENCH_REPEATS; repeat++) {
+    for (uint32_t index = 0; index < BENCH_TEXT_LENGTH; index++) {
+      sum += ((BenchGlyph_t *)GlyphTable_get(&table, text[index]))->page;
+    }
+  }
+  seconds = (Bench_now() - start) / BENCH_REPEATS;
+  printf("%-32s %10.1f ns per code point\n", "table, lookup", seconds / BENCH_TEXT_LENGTH * 1e9);
+
+  uint64_t sortedSum = 0;
+  start = Bench_now();
+  for (uint32_t index = 0; index < BENCH_TEXT_LENGTH; index++) {
+    sortedSum += _Bench_sortedGet(&sorted, text[index])->page;
+  }
+  seconds = Bench_now() - start;
+  printf("%-32s %10.1f ns per code point\n", "sorted array, lookup", seconds / BENCH_TEXT_LENGTH * 1e9);
+
+  // Same glyphs either way, and the ones taken before every insert never moved
+  uint32_t mismatches = table.count != sorted.count || sum != sortedSum * BENCH_REPEATS;
+  for (uint32_t index = 0; index < sorted.count; index++) {
+    BenchGlyph_t *glyph = GlyphTable_get(&table, sorted.glyphs[index].character);
+    mismatches += glyph == NULL || memcmp(glyph, &sorted.glyphs[index], sizeof(BenchGlyph_t)) != 0;
+  }
+  for (UC_t character = 0; character < 128; character++) {
+    mismatches += GlyphTable_get(&table, character) != ascii[character] || ascii[character]->character != character;
+  }
+  if (mismatches > 0)
+    printf("MISMATCH in %u glyphs\n", mismatches);
+
+  GlyphTable_cleanup(&table);
+  free(sorted.glyphs);
+  free(text);
+  return 0;
+}
@@ -0,0 +1,102 @@
+#include "Bench.h"
+#include "MacroGoal.h"
+
+// 30 years of history, 4 meals a day
+#define BENCH_MEAL_COUNT (4u * 365u * 30u)
+#define BENCH_ADD_COUNT 100000u
+#define BENCH_QUERY_COUNT 1000000u
+
+// Weekends get more room
+#define BENCH_WEEKDAY { .cals = 3300, .calsTolerance = 500, .proteinMin = 130, .fatMax = 150, .carbsMax = 380 }
+#define BENCH_WEEKEND { .cals = 3500, .calsTolerance = 700, .proteinMin = 120, .fatMax = 170, .carbsMax = 420 }
+static const MacroGoalTarget_t _benchTargets[7] = {
+  BENCH_WEEKDAY, BENCH_WEEKDAY, BENCH_WEEKDAY, BENCH_WEEKDAY, BENCH_WEEKDAY, BENCH_WEEKEND, BENCH_WEEKEND
+};
+
+uint32_t _Bench_compare(MacroGoals_t *goals, MacroGoals_t *fresh) {
+  uint32_t mismatches = goals->dayCount != fresh->dayCount || goals->longestStreak != fresh->longestStreak ||
+    MacroGoals_currentStreak(goals) != MacroGoals_currentStreak(fresh);
+
+  for (uint32_t index = 0; index < goals->dayCount && index < fresh->dayCount; index++) {
+    mismatches += goals->days[index].status != fresh->days[index].status;
+  }
+
+  MacroGoalSummary_t a, b;
+  MacroGoals_summary(goals, DAY_NUM_MIN, DAY_NUM_MAX, &a);
+  MacroGoals_summary(fresh, DAY_NUM_MIN, DAY_NUM_MAX, &b);
+  return mismatches + (memcmp(&a, &b, sizeof(MacroGoalSummary_t)) != 0);
+}
+
+int main(void) {
+  MacroDatabase_t *db = MacroDatabase_create(0);
+  uint64_t state = 0x2545F4914F6CDD1Dull;
+  for (uint32_t index = 0; index < BENCH_MEAL_COUNT; index++) {
+    Meal_t meal = Bench_randomMeal(&state, index);
+    if (Bench_random(&state) % 64 != 0)
+      MacroDatabase_add(db, meal);
+  }
+
+  double start = Bench_now();
+  MacroGoals_t *goals = MacroDatabase_setGoals(db, _benchTargets);
+  double seconds = Bench_now() - start;
+  if (goals == NULL)
+    return 1;
+  BENCH_REPORT("evaluate history", seconds, db->mealCount);
+
+  MacroGoalSummary_t summary;
+  MacroGoals_summary(goals, DAY_NUM_MIN, DAY_NUM_MAX, &summary);
+  printf("%u days, %u logged, %u passed, longest streak %u, current %u\n", goals->dayCount,
+    summary.logged, summary.passed, goals->longestStreak, MacroGoals_currentStreak(goals)
+  );
+
+  // Meals for the last day, then for random days of the history
+  DayNum_t lastDay = goals->firstDay + goals->dayCount - 1;
+  start = Bench_now();
+  for (uint32_t add = 0; add < BENCH_ADD_COUNT; add++) {
+    Meal_t meal = Bench_randomMeal(&state, 0);
+    meal.macro.cals = 1 + meal.macro.cals / 64;
+    meal.macro.protein = meal.macro.fat = meal.macro.carbs = 0;
+    meal.date = Date_fromDayNum(lastDay + add / 64);
+    MacroDatabase_add(db, meal);
+    MacroGoals_currentStreak(goals);
+  }
+  seconds = Bench_now() - start;
+  printf("%-32s %10.1f ns per meal and streak read\n", "add, latest day", seconds / BENCH_ADD_COUNT * 1e9);
+
+  start = Bench_now();
+  for (uint32_t add = 0; add < BENCH_ADD_COUNT; add++) {
+    Meal_t meal = Bench_randomMeal(&state, 0);
+    meal.macro.cals = 1 + meal.macro.cals / 16;
+    meal.macro.protein = meal.macro.fat = meal.macro.carbs = 0;
+    meal.date = Date_fromDayNum(goals->firstDay + Bench_random(&state) % goals->dayCount);
+    MacroDatabase_add(db, meal);
+    MacroGoals_currentStreak(goals);
+  }
+  seconds = Bench_now() - start;
+  printf("%-32s %10.1f ns per meal and streak read\n", "add, random day", seconds / BENCH_ADD_COUNT * 1e9);
+
+  // The first summary after the backfill sums the changed days again, later ones are lookups
+  start = Bench_now();
+  MacroGoals_summary(goals, DAY_NUM_MIN, DAY_NUM_MAX, &summary);
+  printf("%-32s %10.3f ms\n", "summary after backfill", (Bench_now() - start) * 1000.0);
+
+  start = Bench_now();
+  for (uint32_t query = 0; query < BENCH_QUERY_COUNT; query++) {
+    DayNum_t from = goals->firstDay + Bench_random(&state) % goals->dayCount;
+    MacroGoals_summary(goals, from, from + 30, &summary);
+  }
+  seconds = Bench_now() - start;
+  printf("%-32s %10.1f ns per 31 day compliance\n", "summary", seconds / BENCH_QUERY_COUNT * 1e9);
+
+  // Kept up to date, the results match goals evaluated from scratch
+  MacroGoals_t fresh;
+  MacroGoals_init(&fresh, _benchTargets);
+  MacroGoals_build(&fresh, db);
+  uint32_t mismatches = _Bench_compare(goals, &fresh);
+  if (mismatches > 0)
+    printf("MISMATCH in %u results against goals evaluated again\n", mismatches);
+
+  MacroGoals_cleanup(&fresh);
+  MacroDatabase_destroy(db);
+  return 0;
+}
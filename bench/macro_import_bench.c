@@ -0,0 +1,70 @@
+#include "Bench.h"
+#include "MacroImport.h"
+
+#define BENCH_DEFAULT_ROW_COUNT 20000000u
+#define BENCH_CSV_PATH "macro_import_bench.csv"
+#define BENCH_JSON_PATH "macro_import_bench.json"
+
+// Export files the way other trackers write them, a header and a few meals per day
+void _Bench_generate(const char *path, MacroImportFormat_t format, uint32_t rowCount) {
+  FILE *file = fopen(path, "wb");
+  uint64_t state = 0x2545F4914F6CDD1Dull;
+
+  fputs(format == MACRO_IMPORT_CSV ? "date,calories,protein,fat,carbs\n" : "[\n", file);
+  for (uint32_t row = 0; row < rowCount; row++) {
+    Meal_t meal = Bench_randomMeal(&state, row);
+    if (format == MACRO_IMPORT_CSV) {
+      fprintf(file, "%04u-%02u-%02u,%u,%u,%u,%u\n", meal.date.year, meal.date.month, meal.date.day,
+        meal.macro.cals, meal.macro.protein, meal.macro.fat, meal.macro.carbs);
+    } else {
+      fprintf(file, "  {\"date\": \"%04u-%02u-%02uT12:00:00Z\", \"cals\": %u, \"protein\": %u, \"fat\": %u, \"carbs\": %u}%s\n",
+        meal.date.year, meal.date.month, meal.date.day,
+        meal.macro.cals, meal.macro.protein, meal.macro.fat, meal.macro.carbs,
+        row + 1 < rowCount ? "," : "");
+    }
+  }
+  if (format == MACRO_IMPORT_JSON)
+    fputs("]\n", file);
+
+  fclose(file);
+}
+
+void _Bench_import(const char *label, const char *path, MacroImportFormat_t format, uint32_t rowCount, uint32_t threadCount) {
+  MacroImportInfo_t info = MACRO_IMPORT_INFO_INIT;
+  info.format = format;
+  info.threadCount = threadCount;
+
+  MacroImportStats_t stats = {0};
+  MacroDatabase_t *db = MacroDatabase_create(rowCount);
+  double start = Bench_now();
+  Result_t result = MacroImport_file(db, path, &info, &stats);
+  double seconds = Bench_now() - start;
+
+  printf("%-12s %2u threads %10.3f ms %8.1f MB/s %8.2f Mrows/s (%llu added, %llu malformed)%s\n",
+    label, threadCount, seconds * 1000.0, stats.bytes / seconds / 1e6, stats.rows / seconds / 1e6,
+    (unsigned long long)stats.added, (unsigned long long)stats.malformed,
+    result == RESULT_SUCCESS ? "" : " FAILED"
+  );
+  MacroDatabase_destroy(db);
+}
+
+int main(int argc, char **argv) {
+  uint32_t rowCount = argc > 1 ? (uint32_t)strtoul(argv[1], NULL, 10) : BENCH_DEFAULT_ROW_COUNT;
+
+  SYSTEM_INFO system = {0};
+  GetSystemInfo(&system);
+
+  _Bench_generate(BENCH_CSV_PATH, MACRO_IMPORT_CSV, rowCount);
+  _Bench_generate(BENCH_JSON_PATH, MACRO_IMPORT_JSON, rowCount);
+
+  for (uint32_t threads = 1; threads <= system.dwNumberOfProcessors; threads <<= 1) {
+    _Bench_import("csv", BENCH_CSV_PATH, MACRO_IMPORT_CSV, rowCount, threads);
+  }
+  for (uint32_t threads = 1; threads <= system.dwNumberOfProcessors; threads <<= 1) {
+    _Bench_import("json", BENCH_JSON_PATH, MACRO_IMPORT_JSON, rowCount, threads);
+  }
+
+  DeleteFileA(BENCH_CSV_PATH);
+  DeleteFileA(BENCH_JSON_PATH);
+  return 0;
+}
@@ -0,0 +1,67 @@
+#include "Bench.h"
+#include "MacroKernel.h"
+#include "MacroPack.h"
+
+#define BENCH_MEAL_COUNT 10000000u
+#define BENCH_REPEATS 5
+
+void _Bench_scan(const char *label, MacroDatabase_t *db, DayNum_t from, DayNum_t to, MacroStats_t *out) {
+  double start = Bench_now();
+  for (uint32_t repeat = 0; repeat < BENCH_REPEATS; repeat++) {
+    MacroDatabase_statsDays(db, from, to, out);
+  }
+  BENCH_REPORT(label, (Bench_now() - start) / BENCH_REPEATS, db->mealCount);
+}
+
+void _Bench_compare(const char *label, MacroDatabase_t *db, const MacroStats_t *columns, DayNum_t from, DayNum_t to) {
+  printf("-- %s\n", label);
+
+  const char *isaNames[] = { "packed scalar", "packed sse2", "packed avx2 (sse2 unpack)" };
+  for (MacroKernelIsa_t isa = MACRO_KERNEL_ISA_SCALAR; isa <= MACRO_KERNEL_ISA_AVX2; isa++) {
+    MacroKernel_setIsa(isa);
+    if (MacroKernel_isa() != isa)
+      continue;
+
+    MacroStats_t packed = {0};
+    _Bench_scan(isaNames[isa], db, from, to, &packed);
+    for (uint32_t column = 0; column < MACRO_COLUMN_COUNT; column++) {
+      if (packed.count != columns->count || packed.sum[column] != columns->sum[column] ||
+          packed.min[column] != columns->min[column] || packed.max[column] != columns->max[column])
+        printf("MISMATCH in column %u\n", column);
+    }
+  }
+  MacroKernel_setIsa(MACRO_KERNEL_ISA_AVX2);
+}
+
+int main(void) {
+  MacroDatabase_t *db = MacroDatabase_create(0);
+  uint64_t state = 0x2545F4914F6CDD1Dull;
+  for (uint32_t index = 0; index < BENCH_MEAL_COUNT; index++) {
+    MacroDatabase_add(db, Bench_randomMeal(&state, index));
+  }
+
+  // Baselines on the plain columns, every scan of the frozen history has to reproduce them
+  DayNum_t first = Date_toDayNum((Date_t) { 2000, 1, 1 });
+  MacroStats_t full = {0}, year = {0};
+  printf("-- columns\n");
+  _Bench_scan("full scan (best isa)", db, DAY_NUM_MIN, DAY_NUM_MAX, &full);
+  _Bench_scan("one year (best isa)", db, first + 3650, first + 3650 + 364, &year);
+
+  double start = Bench_now();
+  if (MacroDatabase_freeze(db, db->mealCount) != RESULT_SUCCESS)
+    return 1;
+  BENCH_REPORT("freeze", Bench_now() - start, db->frozenCount);
+
+  size_t columnBytes = sizeof(uint32_t) * (MACRO_COLUMN_COUNT + 1) * (size_t)db->frozenCount;
+  size_t packedBytes = MacroPack_size(db->_cold);
+  printf("Meal_t %zu B/meal, columns %.2f B/meal, packed %.2f B/meal (%.1fx less resident memory)\n",
+    sizeof(Meal_t), (double)columnBytes / db->frozenCount, (double)packedBytes / db->frozenCount,
+    (double)columnBytes / packedBytes
+  );
+
+  _Bench_compare("full scan", db, &full, DAY_NUM_MIN, DAY_NUM_MAX);
+  _Bench_compare("one year", db, &year, first + 3650, first + 3650 + 364);
+
+  MacroDatabase_destroy(db);
+  return 0;
+}
@@ -0,0 +1,72 @@
+#include "Bench.h"
+#include "MacroKernel.h"
+#include "MacroMorsel.h"
+#include "MacroQuery.h"
+
+#define BENCH_MEAL_COUNT 20000000u
+#define BENCH_REPEATS 5
+
+static const char *_benchQuery =
+  "where protein < 60 and (cals > 600 or fat > 40) group by month select count, avg(cals), max(protein), sum(carbs)";
+
+int main(void) {
+  MacroDatabase_t *db = MacroDatabase_create(BENCH_MEAL_COUNT);
+  uint64_t state = 0x2545F4914F6CDD1Dull;
+  for (uint32_t index = 0; index < BENCH_MEAL_COUNT; index++) {
+    MacroDatabase_add(db, Bench_randomMeal(&state, index));
+  }
+
+  DayNum_t from = DAY_NUM_MIN, to = DAY_NUM_MAX;
+  MacroQuery_t query;
+  if (MacroQuery_compile(&query, _benchQuery) != RESULT_SUCCESS)
+    return 1;
+
+  // Single threaded baselines, every thread count has to reproduce them exactly
+  MacroStats_t expectedStats;
+  MacroDatabase_statsDays(db, from, to, &expectedStats);
+  MacroQueryResult_t expected;
+  MacroQuery_run(&query, db, &expected);
+
+  uint32_t maxThreads = MacroMorsel_threadCount(0);
+  printf("%u meals, %u logical processors, %u rows per morsel\n", db->mealCount, maxThreads, MACRO_MORSEL_ROWS);
+  printf("%-8s %12s %10s %12s %10s\n", "threads", "stats ms", "speedup", "query ms", "speedup");
+
+  double statsBase = 0.0, queryBase = 0.0;
+  for (uint32_t threads = 1; threads <= maxThreads; threads = threads * 2 <= maxThreads || threads == maxThreads ? threads * 2 : maxThreads) {
+    MacroStats_t stats;
+    double start = Bench_now();
+    for (uint32_t repeat = 0; repeat < BENCH_REPEATS; repeat++) {
+      MacroDatabase_statsDaysParallel(db, from, to, threads, &stats);
+    }
+    double statsTime = (Bench_now() - start) / BENCH_REPEATS;
+
+    MacroQueryResult_t result = {0};
+    start = Bench_now();
+    for (uint32_t repeat = 0; repeat < BENCH_REPEATS; repeat++) {
+      MacroQueryResult_cleanup(&result);
+      MacroQuery_runParallel(&query, db, threads, &result);
+    }
+    double queryTime = (Bench_now() - start) / BENCH_REPEATS;
+
+    if (memcmp(stats.sum, expectedStats.sum, sizeof(stats.sum)) != 0 || stats.count != expectedStats.count ||
+        memcmp(stats.min, expectedStats.min, sizeof(stats.min)) != 0 || memcmp(stats.max, expectedStats.max, sizeof(stats.max)) != 0)
+      printf("STATS MISMATCH at %u threads\n", threads);
+    if (result.rowCount != expected.rowCount ||
+        memcmp(result.rows, expected.rows, sizeof(MacroQueryRow_t) * expected.rowCount) != 0)
+      printf("QUERY MISMATCH at %u threads\n", threads);
+    MacroQueryResult_cleanup(&result);
+
+    statsBase = threads == 1 ? statsTime : statsBase;
+    queryBase = threads == 1 ? queryTime : queryBase;
+    printf("%-8u %12.3f %9.2fx %12.3f %9.2fx\n", threads,
+      statsTime * 1000.0, statsBase / statsTime, queryTime * 1000.0, queryBase / queryTime
+    );
+
+    if (threads == maxThreads)
+      break;
+  }
+
+  MacroQueryResult_cleanup(&expected);
+  MacroDatabase_destroy(db);
+  return 0;
+}
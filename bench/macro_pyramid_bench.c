@@ -0,0 +1,150 @@
+#include "Bench.h"
+#include "MacroPyramid.h"
+#include "MacroRollup.h"
+
+// 30 years of history, 4 meals a day
+#define BENCH_MEAL_COUNT (4u * 365u * 30u)
+#define BENCH_LATE_MEALS 1000u
+#define BENCH_CHART_WIDTH 1000u
+#define BENCH_REPEATS 1000
+#define BENCH_DB_PATH "macro_pyramid_bench"
+
+// What a chart cost before, every day of the range from the rollups folded into the same buckets
+double _Bench_naiveChart(MacroDatabase_t *db, DayNum_t from, DayNum_t to, uint32_t level, MacroPyramidBucket_t *out) {
+  const MacroRollup_t *rollup = MacroDatabase_rollup(db);
+  if (rollup == NULL)
+    return 0.0;
+  double start = Bench_now();
+
+  uint32_t firstKey = from >> level;
+  memset(out, 0, sizeof(MacroPyramidBucket_t) * ((to >> level) - firstKey + 1));
+  for (DayNum_t day = firstKey << level; day < (((to >> level) + 1) << level); day++) {
+    MacroTotals_t totals;
+    MacroRollup_bucket(rollup, MACRO_ROLLUP_DAY, day, &totals);
+    if (totals.count == 0)
+      continue;
+
+    MacroPyramidBucket_t *bucket = &out[(day >> level) - firstKey];
+    uint32_t value = (uint32_t)totals.sum[MACRO_COLUMN_CALS];
+    bucket->min = bucket->days == 0 || value < bucket->min ? value : bucket->min;
+    bucket->max = bucket->days == 0 || value > bucket->max ? value : bucket->max;
+    bucket->sum += value;
+    bucket->days++;
+  }
+
+  return Bench_now() - start;
+}
+
+uint32_t _Bench_compare(const MacroPyramid_t *a, const MacroPyramid_t *b) {
+  uint32_t mismatches = 0;
+  for (uint32_t level = 0; level < MACRO_PYRAMID_LEVELS; level++) {
+    const MacroPyramidLevel_t *left = &a->levels[level], *right = &b->levels[level];
+    if (left->firstKey != right->firstKey || left->count != right->count) {
+      mismatches++;
+      continue;
+    }
+    for (uint32_t column = 0; column < MACRO_COLUMN_COUNT; column++) {
+      mismatches += memcmp(left->columns[column], right->columns[column], sizeof(MacroPyramidBucket_t) * left->count) != 0;
+    }
+  }
+  return mismatches;
+}
+
+MacroDatabase_t *_Bench_open(const char *label) {
+  MacroLogInfo_t info = MACRO_LOG_INFO_INIT;
+  double start = Bench_now();
+  MacroDatabase_t *db = MacroDatabase_open(BENCH_DB_PATH, &info, 0);
+  if (db == NULL)
+    return NULL;
+
+  double seconds = Bench_now() - start;
+  printf("%-32s %10.3f ms, pyramid %s\n", label, seconds * 1000.0, db->_pyramid != NULL ? "loaded" : "not loaded");
+  return db;
+}
+
+uint32_t _Bench_checkRebuilt(MacroDatabase_t *db) {
+  const MacroPyramid_t *pyramid = MacroDatabase_pyramid(db);
+  if (pyramid == NULL)
+    return UINT32_MAX;
+
+  MacroPyramid_t fresh;
+  MacroPyramid_init(&fresh);
+  MacroPyramid_build(&fresh, db);
+  uint32_t mismatches = _Bench_compare(pyramid, &fresh);
+  MacroPyramid_cleanup(&fresh);
+  return mismatches;
+}
+
+int main(void) {
+  DeleteFileA(BENCH_DB_PATH MACRO_SNAPSHOT_EXT);
+  DeleteFileA(BENCH_DB_PATH MACRO_LOG_EXT);
+  DeleteFileA(BENCH_DB_PATH MACRO_PYRAMID_EXT);
+
+  MacroDatabase_t *db = _Bench_open("open empty");
+  if (db == NULL)
+    return -1;
+
+  Meal_t *meals = malloc(sizeof(Meal_t) * BENCH_MEAL_COUNT);
+  uint64_t state = 0x2545F4914F6CDD1Dull;
+  for (uint32_t index = 0; index < BENCH_MEAL_COUNT; index++) {
+    meals[index] = Bench_randomMeal(&state, index);
+  }
+  MacroDatabase_addBatch(db, meals, BENCH_MEAL_COUNT, NULL);
+  free(meals);
+
+  double start = Bench_now();
+  const MacroPyramid_t *pyramid = MacroDatabase_pyramid(db);
+  double seconds = Bench_now() - start;
+  if (pyramid == NULL)
+    return 1;
+  BENCH_REPORT("build", seconds, db->mealCount);
+
+  // Ten years on a chart a thousand pixels wide
+  DayNum_t to = pyramid->levels[0].firstKey + pyramid->levels[0].count - 1;
+  DayNum_t from = to - 3652;
+  MacroPyramidBucket_t *chart = malloc(sizeof(MacroPyramidBucket_t) * BENCH_CHART_WIDTH);
+  MacroPyramidBucket_t *naive = malloc(sizeof(MacroPyramidBucket_t) * BENCH_CHART_WIDTH);
+  uint32_t level = 0, count = 0;
+
+  start = Bench_now();
+  for (uint32_t repeat = 0; repeat < BENCH_REPEATS; repeat++) {
+    count = MacroPyramid_series(pyramid, MACRO_COLUMN_CALS, from, to, BENCH_CHART_WIDTH, chart, &level);
+  }
+  seconds = (Bench_now() - start) / BENCH_REPEATS;
+  printf("%-32s %10.3f us, %u buckets of %u days\n", "chart, 10 years", seconds * 1e6, count, 1u << level);
+
+  seconds = _Bench_naiveChart(db, from, to, level, naive);
+  printf("%-32s %10.3f us, %u days\n", "naive chart from day rollups", seconds * 1e6, to - from + 1);
+  if (memcmp(chart, naive, sizeof(MacroPyramidBucket_t) * count) != 0)
+    printf("  MISMATCH\n");
+
+  // Compaction persists the pyramid, the next open loads it instead of reading every meal
+  start = Bench_now();
+  if (MacroDatabase_compact(db) != RESULT_SUCCESS)
+    return -1;
+  printf("%-32s %10.3f ms\n", "compact", (Bench_now() - start) * 1000.0);
+  MacroDatabase_destroy(db);
+
+  db = _Bench_open("open after compaction");
+  if (db == NULL)
+    return -1;
+  if (_Bench_checkRebuilt(db) > 0)
+    printf("  MISMATCH against a rebuilt pyramid\n");
+
+  // Meals only in the log update the loaded pyramid while they are replayed
+  for (uint32_t index = 0; index < BENCH_LATE_MEALS; index++) {
+    MacroDatabase_add(db, Bench_randomMeal(&state, BENCH_MEAL_COUNT + index));
+  }
+  MacroDatabase_destroy(db);
+
+  db = _Bench_open("open with a log to replay");
+  if (db == NULL)
+    return -1;
+  if (_Bench_checkRebuilt(db) > 0)
+    printf("  MISMATCH against a rebuilt pyramid\n");
+  MacroDatabase_destroy(db);
+
+  free(chart);
+  free(naive);
+  return 0;
+}
@@ -0,0 +1,79 @@
+#include "Bench.h"
+#include "MacroQuery.h"
+
+#define BENCH_MEAL_COUNT 10000000u
+#define BENCH_REPEATS 5
+
+static const char *_benchQueries[] = {
+  "where protein < 40 and cals > 600 group by weekday select count, avg(cals), max(protein)",
+  "where date >= 2010-01-01 and date < 2015-01-01 group by month select sum(cals), sum(protein)",
+  "where (fat > 50 or carbs > 140) and not weekday = sun group by year select count, min(cals)",
+  "select count, sum(cals), sum(protein), sum(fat), sum(carbs)",
+  "from days where protein < 120 and cals > 2500 group by weekday select count, avg(cals)"
+};
+
+int main(void) {
+  MacroDatabase_t *db = MacroDatabase_create(0);
+  uint64_t state = 0x2545F4914F6CDD1Dull;
+  for (uint32_t index = 0; index < BENCH_MEAL_COUNT; index++) {
+    MacroDatabase_add(db, Bench_randomMeal(&state, index));
+  }
+  if (MacroDatabase_rollup(db) == NULL)
+    return 1;
+
+  for (uint32_t index = 0; index < sizeof(_benchQueries) / sizeof(_benchQueries[0]); index++) {
+    MacroQuery_t query;
+    if (MacroQuery_compile(&query, _benchQueries[index]) != RESULT_SUCCESS)
+      return 1;
+
+    MacroQueryResult_t result = {0};
+    double start = Bench_now();
+    for (uint32_t repeat = 0; repeat < BENCH_REPEATS; repeat++) {
+      MacroQueryResult_cleanup(&result);
+      MacroQuery_run(&query, db, &result);
+    }
+    double elapsed = (Bench_now() - start) / BENCH_REPEATS;
+
+    printf("%s\n", _benchQueries[index]);
+    BENCH_REPORT("  query", elapsed, db->mealCount);
+    printf("  %u groups, first: key %u count %u, %.1f\n", result.rowCount, result.rows[0].key,
+      result.rows[0].count, result.rows[0].values[0]
+    );
+    MacroQueryResult_cleanup(&result);
+  }
+
+  // The same first query as the one-off loop it replaces
+  uint32_t counts[7] = {0}, maxProtein[7] = {0};
+  uint64_t cals[7] = {0};
+  double start = Bench_now();
+  for (uint32_t repeat = 0; repeat < BENCH_REPEATS; repeat++) {
+    memset(counts, 0, sizeof(counts));
+    memset(cals, 0, sizeof(cals));
+    memset(maxProtein, 0, sizeof(maxProtein));
+    for (uint32_t row = 0; row < db->mealCount; row++) {
+      if (db->protein[row] >= 40 || db->cals[row] <= 600)
+        continue;
+
+      uint32_t weekday = (db->days[row] + 3) % 7;
+      counts[weekday]++;
+      cals[weekday] += db->cals[row];
+      maxProtein[weekday] = db->protein[row] > maxProtein[weekday] ? db->protein[row] : maxProtein[weekday];
+    }
+  }
+  BENCH_REPORT("  hand written loop", (Bench_now() - start) / BENCH_REPEATS, db->mealCount);
+
+  MacroQuery_t query;
+  MacroQueryResult_t result;
+  MacroQuery_compile(&query, _benchQueries[0]);
+  MacroQuery_run(&query, db, &result);
+  for (uint32_t row = 0; row < result.rowCount; row++) {
+    uint32_t weekday = result.rows[row].key;
+    if (result.rows[row].count != counts[weekday] || result.rows[row].values[2] != maxProtein[weekday] ||
+        result.rows[row].values[1] != (double)cals[weekday] / counts[weekday])
+      printf("MISMATCH on weekday %u\n", weekday);
+  }
+  MacroQueryResult_cleanup(&result);
+
+  MacroDatabase_destroy(db);
+  return 0;
+}
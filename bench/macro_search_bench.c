@@ -0,0 +1,81 @@
+#include "Bench.h"
+#include "FoodSearch.h"
+
+#define BENCH_FOOD_COUNT 500000u
+
+static const char *_benchWords[] = {
+  "chicken", "breast", "raw", "cooked", "rice", "white", "brown", "oats", "rolled", "milk",
+  "whole", "skim", "cheese", "cheddar", "egg", "yolk", "bread", "wheat", "apple", "banana",
+  "beef", "ground", "lean", "pork", "loin", "salmon", "atlantic", "farmed", "tuna", "canned",
+  "yogurt", "greek", "plain", "butter", "peanut", "almond", "roasted", "salted", "frozen", "fresh"
+};
+#define BENCH_WORD_COUNT (sizeof(_benchWords) / sizeof(_benchWords[0]))
+
+// Every keystroke of each query, as typed
+static const char *_benchQueries[] = {
+  "chicken breast", "Greek yogurt plain", "salmon atl", "chiken brest", "peanot buter", "xqzv"
+};
+
+void _Bench_type(FoodSearchQuery_t *query, const char *text, bool incremental) {
+  uint32_t length = (uint32_t)strlen(text);
+  double worst = 0.0, total = 0.0;
+
+  for (uint32_t typed = 1; typed <= length; typed++) {
+    double start = Bench_now();
+    if (!incremental)
+      FoodSearchQuery_set(query, "", 0);
+    FoodSearchQuery_set(query, text, typed);
+    FoodSearchQuery_run(query, UINT32_MAX);
+    double elapsed = Bench_now() - start;
+
+    total += elapsed;
+    worst = elapsed > worst ? elapsed : worst;
+  }
+
+  const FoodCatalog_t *catalog = query->search->catalog;
+  printf("%-20s %-11s %8.1f us/key, worst %8.1f us, top: %s\n", text, incremental ? "incremental" : "restart",
+    total / length * 1e6, worst * 1e6, query->resultCount > 0 ? FoodCatalog_name(catalog, query->results[0].food) : "-"
+  );
+}
+
+int main(void) {
+  FoodCatalog_t catalog;
+  FoodCatalog_init(&catalog);
+  FoodCatalog_reserve(&catalog, BENCH_FOOD_COUNT, BENCH_FOOD_COUNT * 40);
+
+  uint64_t state = 0x2545F4914F6CDD1Dull;
+  char name[256];
+  for (uint32_t index = 0; index < BENCH_FOOD_COUNT; index++) {
+    uint32_t length = 0;
+    uint32_t words = 2 + Bench_random(&state) % 4;
+    for (uint32_t word = 0; word < words; word++) {
+      length += sprintf(&name[length], word == 0 ? "%s" : (word == 1 ? ", %s" : " %s"),
+        _benchWords[Bench_random(&state) % BENCH_WORD_COUNT]
+      );
+    }
+    length += sprintf(&name[length], " %u", index);
+
+    FoodNutrients_t per100g = {0};
+    FoodCatalog_add(&catalog, name, length, &per100g);
+  }
+
+  FoodSearch_t search;
+  double start = Bench_now();
+  if (FoodSearch_build(&search, &catalog) != RESULT_SUCCESS)
+    return 1;
+  BENCH_REPORT("build", Bench_now() - start, BENCH_FOOD_COUNT);
+  printf("%u names, %u words, index %.1f B/name\n", search.foodCount, search.wordCount,
+    (double)FoodSearch_size(&search) / search.foodCount
+  );
+
+  FoodSearchQuery_t query;
+  FoodSearchQuery_init(&query, &search);
+  for (uint32_t index = 0; index < sizeof(_benchQueries) / sizeof(_benchQueries[0]); index++) {
+    _Bench_type(&query, _benchQueries[index], false);
+    _Bench_type(&query, _benchQueries[index], true);
+  }
+
+  FoodSearch_cleanup(&search);
+  FoodCatalog_cleanup(&catalog);
+  return 0;
+}
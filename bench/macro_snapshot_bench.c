@@ -0,0 +1,80 @@
+#include "Bench.h"
+#include "MacroSnapshot.h"
+
+#define BENCH_DEFAULT_MEAL_COUNT 100000000u
+#define BENCH_DB_PATH "macro_snapshot_bench"
+
+// A month of meals out of the middle of the history, what the UI asks for right after startup
+static uint64_t Bench_monthQuery(MacroDatabase_t *db) {
+  DayNum_t from = Date_toDayNum((Date_t) { 2000, 1, 1 }) + (DayNum_t)(db->mealCount / 8);
+  MacroIndexRange_t range = {0};
+  MacroSpan_t span = {0};
+  uint64_t cals = 0;
+
+  MacroIndex_range(&db->index, from, from + 30, &range);
+  while (MacroIndexRange_next(&range, &span)) {
+    for (uint32_t entry = 0; entry < span.count; entry++) {
+      cals += db->cals[span.rows[entry]];
+    }
+  }
+
+  return cals;
+}
+
+static void Bench_queries(const char *name, MacroDatabase_t *db, double openSeconds) {
+  char label[64] = {0};
+  snprintf(label, sizeof(label), "%s: open", name);
+  BENCH_REPORT(label, openSeconds, db->mealCount);
+
+  double start = Bench_now();
+  uint64_t cals = Bench_monthQuery(db);
+  double monthSeconds = Bench_now() - start;
+  snprintf(label, sizeof(label), "%s: first month query", name);
+  printf("%-32s %10.3f ms (open + query %.3f ms, %llu cals)\n", label, monthSeconds * 1000.0,
+    (openSeconds + monthSeconds) * 1000.0, (unsigned long long)cals
+  );
+
+  MacroStats_t stats = {0};
+  start = Bench_now();
+  MacroDatabase_statsDays(db, DAY_NUM_MIN, DAY_NUM_MAX, &stats);
+  snprintf(label, sizeof(label), "%s: first full scan", name);
+  BENCH_REPORT(label, Bench_now() - start, stats.count);
+}
+
+int main(int argc, char **argv) {
+  uint32_t mealCount = argc > 1 ? (uint32_t)strtoul(argv[1], NULL, 10) : BENCH_DEFAULT_MEAL_COUNT;
+
+  DeleteFileA(BENCH_DB_PATH MACRO_SNAPSHOT_EXT);
+  DeleteFileA(BENCH_DB_PATH MACRO_LOG_EXT);
+
+  MacroDatabase_t *db = MacroDatabase_create(mealCount);
+  uint64_t state = 0x2545F4914F6CDD1Dull;
+  for (uint32_t index = 0; index < mealCount; index++) {
+    MacroDatabase_add(db, Bench_randomMeal(&state, index));
+  }
+
+  double start = Bench_now();
+  if (MacroSnapshot_write(db, BENCH_DB_PATH MACRO_SNAPSHOT_EXT, 0) != RESULT_SUCCESS)
+    return -1;
+  BENCH_REPORT("snapshot write", Bench_now() - start, db->mealCount);
+  MacroDatabase_destroy(db);
+
+  // Both runs start from the page cache, the mapped one still only touches what it queries
+  MacroLogInfo_t info = MACRO_LOG_INFO_INIT;
+  start = Bench_now();
+  db = MacroDatabase_open(BENCH_DB_PATH, &info, mealCount);
+  if (db == NULL)
+    return -1;
+  Bench_queries("mapped", db, Bench_now() - start);
+  MacroDatabase_destroy(db);
+
+  uint64_t nextSequence = 0;
+  start = Bench_now();
+  db = MacroDatabase_create(mealCount);
+  if (MacroSnapshot_read(db, BENCH_DB_PATH MACRO_SNAPSHOT_EXT, &nextSequence) != RESULT_SUCCESS)
+    return -1;
+  Bench_queries("read", db, Bench_now() - start);
+  MacroDatabase_destroy(db);
+
+  return 0;
+}
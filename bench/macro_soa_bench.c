@@ -0,0 +1,84 @@
+#include "Bench.h"
+#include "MacroKernel.h"
+
+#define BENCH_MEAL_COUNT 10000000u
+#define BENCH_REPEATS 5
+
+typedef struct __AosTotals_t {
+  uint64_t sum[MACRO_COLUMN_COUNT];
+  uint32_t count;
+} AosTotals_t;
+
+// Baseline - what the array of structs layout needed for a date ranged sum
+void _Bench_aosSum(Meal_t *meals, size_t count, Date_t from, Date_t to, AosTotals_t *out) {
+  *out = (AosTotals_t) {0};
+  for (Meal_t *meal = meals; meal < &meals[count]; meal++) {
+    uint32_t key = meal->date.year * 10000 + meal->date.month * 100 + meal->date.day;
+    if (key < from.year * 10000 + from.month * 100 + from.day ||
+        key > to.year * 10000 + to.month * 100 + to.day)
+      continue;
+
+    out->sum[MACRO_COLUMN_CALS] += meal->macro.cals;
+    out->sum[MACRO_COLUMN_PROTEIN] += meal->macro.protein;
+    out->sum[MACRO_COLUMN_FAT] += meal->macro.fat;
+    out->sum[MACRO_COLUMN_CARBS] += meal->macro.carbs;
+    out->count++;
+  }
+}
+
+void _Bench_runRange(const char *label, Meal_t *meals, MacroDatabase_t *db, Date_t from, Date_t to) {
+  printf("-- %s (%u/%u/%u - %u/%u/%u)\n", label,
+    from.day, from.month, from.year, to.day, to.month, to.year);
+
+  AosTotals_t aos = {0};
+  double start = Bench_now();
+  for (uint32_t repeat = 0; repeat < BENCH_REPEATS; repeat++) {
+    _Bench_aosSum(meals, db->mealCount, from, to, &aos);
+  }
+  BENCH_REPORT("aos scalar sum", (Bench_now() - start) / BENCH_REPEATS, db->mealCount);
+
+  const char *isaNames[] = { "soa scalar sum/min/max", "soa sse2 sum/min/max", "soa avx2 sum/min/max" };
+  for (MacroKernelIsa_t isa = MACRO_KERNEL_ISA_SCALAR; isa <= MACRO_KERNEL_ISA_AVX2; isa++) {
+    MacroKernel_setIsa(isa);
+    if (MacroKernel_isa() != isa) {
+      printf("%-32s unsupported\n", isaNames[isa]);
+      continue;
+    }
+
+    MacroStats_t stats = {0};
+    start = Bench_now();
+    for (uint32_t repeat = 0; repeat < BENCH_REPEATS; repeat++) {
+      MacroDatabase_stats(db, from, to, &stats);
+    }
+    BENCH_REPORT(isaNames[isa], (Bench_now() - start) / BENCH_REPEATS, db->mealCount);
+
+    if (stats.count != aos.count || stats.sum[MACRO_COLUMN_CALS] != aos.sum[MACRO_COLUMN_CALS]) {
+      printf("MISMATCH: count %u vs %u, cals %llu vs %llu\n", stats.count, aos.count,
+        (unsigned long long)stats.sum[MACRO_COLUMN_CALS],
+        (unsigned long long)aos.sum[MACRO_COLUMN_CALS]);
+    }
+  }
+}
+
+int main(void) {
+  Meal_t *meals = malloc(sizeof(Meal_t) * BENCH_MEAL_COUNT);
+  MacroDatabase_t *db = MacroDatabase_create(0);
+
+  uint64_t state = 0x9E3779B97F4A7C15ull;
+  for (uint32_t index = 0; index < BENCH_MEAL_COUNT; index++) {
+    meals[index] = Bench_randomMeal(&state, index);
+    MacroDatabase_add(db, meals[index]);
+  }
+
+  printf("%u meals, aos %zu bytes/meal, soa %zu bytes/meal\n", db->mealCount,
+    sizeof(Meal_t), sizeof(uint32_t) * MACRO_COLUMN_COUNT + sizeof(DayNum_t));
+
+  Meal_t last = MacroDatabase_getMeal(db, db->mealCount - 1);
+  _Bench_runRange("full history", meals, db, (Date_t) { 2000, 1, 1 }, last.date);
+  _Bench_runRange("one year", meals, db, (Date_t) { 2001, 1, 1 }, (Date_t) { 2001, 12, 31 });
+  _Bench_runRange("one month", meals, db, (Date_t) { 2001, 3, 1 }, (Date_t) { 2001, 3, 31 });
+
+  MacroDatabase_destroy(db);
+  free(meals);
+  return 0;
+}
@@ -0,0 +1,122 @@
+#include "Bench.h"
+#include "MacroRollup.h"
+#include "MacroTrend.h"
+
+// 30 years of history, 4 meals a day
+#define BENCH_MEAL_COUNT (4u * 365u * 30u)
+#define BENCH_ADD_COUNT 100000u
+#define BENCH_REPEATS 20
+
+// What a chart cost before, every day sums its own window again from the day rollups
+double _Bench_naiveSeries(MacroDatabase_t *db, MacroColumn_t column, uint32_t window, DayNum_t from, DayNum_t to, float *out) {
+  const MacroRollup_t *rollup = MacroDatabase_rollup(db);
+  if (rollup == NULL)
+    return 0.0;
+  double start = Bench_now();
+
+  for (DayNum_t day = from; day <= to; day++) {
+    uint64_t sum = 0;
+    uint32_t logged = 0;
+    for (DayNum_t back = day - window + 1; back <= day; back++) {
+      MacroTotals_t totals;
+      MacroRollup_bucket(rollup, MACRO_ROLLUP_DAY, back, &totals);
+      sum += totals.sum[column];
+      logged += totals.count > 0;
+    }
+    out[day - from] = logged > 0 ? (float)((double)sum / logged) : 0.f;
+  }
+
+  return Bench_now() - start;
+}
+
+uint32_t _Bench_compare(MacroTrend_t *trend, MacroTrend_t *fresh, DayNum_t from, DayNum_t to, float *a, float *b) {
+  uint32_t mismatches = 0;
+  for (uint32_t line = 0; line < MACRO_TREND_LINE_COUNT; line++) {
+    for (uint32_t column = 0; column < MACRO_COLUMN_COUNT; column++) {
+      MacroTrend_series(trend, line, column, from, to, a);
+      MacroTrend_series(fresh, line, column, from, to, b);
+      mismatches += memcmp(a, b, sizeof(float) * (to - from + 1)) != 0;
+    }
+  }
+  return mismatches;
+}
+
+int main(void) {
+  MacroDatabase_t *db = MacroDatabase_create(0);
+  uint64_t state = 0x2545F4914F6CDD1Dull;
+  for (uint32_t index = 0; index < BENCH_MEAL_COUNT; index++) {
+    // A day off now and then, the averages only count logged days
+    Meal_t meal = Bench_randomMeal(&state, index);
+    if (Bench_random(&state) % 64 != 0)
+      MacroDatabase_add(db, meal);
+  }
+
+  double start = Bench_now();
+  MacroTrend_t *trend = MacroDatabase_trend(db);
+  double seconds = Bench_now() - start;
+  if (trend == NULL)
+    return 1;
+  BENCH_REPORT("build", seconds, db->mealCount);
+
+  DayNum_t from = trend->firstDay;
+  DayNum_t to = trend->firstDay + trend->dayCount - 1 + 45;
+  uint32_t dayCount = to - from + 1;
+  float *series = malloc(sizeof(float) * dayCount);
+  float *naive = malloc(sizeof(float) * dayCount);
+  printf("%u meals over %u days\n", db->mealCount, dayCount);
+
+  // A full chart, every line of every macro
+  start = Bench_now();
+  for (uint32_t repeat = 0; repeat < BENCH_REPEATS; repeat++) {
+    for (uint32_t line = 0; line < MACRO_TREND_LINE_COUNT; line++) {
+      for (uint32_t column = 0; column < MACRO_COLUMN_COUNT; column++) {
+        MacroTrend_series(trend, line, column, from, to, series);
+      }
+    }
+  }
+  seconds = (Bench_now() - start) / BENCH_REPEATS;
+  BENCH_REPORT("series, 12 lines", seconds, (double)dayCount * MACRO_TREND_LINE_COUNT * MACRO_COLUMN_COUNT);
+
+  for (uint32_t line = 0; line < MACRO_TREND_WINDOW_COUNT; line++) {
+    uint32_t window = MacroTrend_windowDays(line);
+    seconds = _Bench_naiveSeries(db, MACRO_COLUMN_CALS, window, from, to, naive);
+    MacroTrend_series(trend, line, MACRO_COLUMN_CALS, from, to, series);
+
+    char label[32];
+    snprintf(label, sizeof(label), "naive sma %u, 1 line", window);
+    BENCH_REPORT(label, seconds, dayCount);
+    if (memcmp(series, naive, sizeof(float) * dayCount) != 0)
+      printf("  MISMATCH\n");
+  }
+
+  // Appends land on the last days, backfills a month back
+  DayNum_t lastDay = trend->firstDay + trend->dayCount - 1;
+  const char *labels[] = { "add, latest day", "add, 30 days back" };
+  const DayNum_t days[] = { lastDay, lastDay - 30 };
+  for (uint32_t kind = 0; kind < 2; kind++) {
+    Meal_t meal = Bench_randomMeal(&state, 0);
+    meal.date = Date_fromDayNum(days[kind]);
+
+    start = Bench_now();
+    for (uint32_t add = 0; add < BENCH_ADD_COUNT; add++) {
+      MacroDatabase_add(db, meal);
+      MacroTrend_series(trend, MACRO_TREND_EMA, MACRO_COLUMN_CALS, lastDay, lastDay, series);
+    }
+    seconds = Bench_now() - start;
+    printf("%-32s %10.1f ns per meal and EMA point\n", labels[kind], seconds / BENCH_ADD_COUNT * 1e9);
+  }
+
+  // Kept up to date, the table matches one built from scratch
+  MacroTrend_t fresh;
+  MacroTrend_init(&fresh);
+  MacroTrend_build(&fresh, db);
+  uint32_t mismatches = _Bench_compare(trend, &fresh, from, to, series, naive);
+  if (mismatches > 0)
+    printf("MISMATCH in %u lines against a rebuilt trend\n", mismatches);
+
+  MacroTrend_cleanup(&fresh);
+  free(series);
+  free(naive);
+  MacroDatabase_destroy(db);
+  return 0;
+}
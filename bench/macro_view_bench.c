@@ -0,0 +1,106 @@
+#include "Bench.h"
+#include "MacroView.h"
+
+#define BENCH_MEAL_COUNT 10000000u
+#define BENCH_BATCH_MEALS 8192u
+#define BENCH_READER_COUNT 3
+
+typedef struct __BenchReader_t {
+  MacroDatabase_t *db;
+  volatile LONG *stop;
+
+  uint64_t pins, inconsistent;
+  double pinSeconds;
+  uint64_t lastVersion;
+} BenchReader_t;
+
+// What a render thread does: pin, read a consistent history, let go
+DWORD WINAPI _Bench_reader(BenchReader_t *self) {
+  MacroReader_t reader;
+  if (MacroReader_open(&reader, self->db) != RESULT_SUCCESS)
+    return 1;
+
+  while (!*self->stop) {
+    double start = Bench_now();
+    const MacroView_t *view = MacroReader_pin(&reader);
+    self->pinSeconds += Bench_now() - start;
+
+    // Totals and rows of one view always agree, whatever the writer does meanwhile
+    MacroTotals_t totals;
+    MacroView_totalsDays(view, DAY_NUM_MIN, DAY_NUM_MAX, &totals);
+    if (totals.count != view->mealCount || view->version < self->lastVersion)
+      self->inconsistent++;
+    if ((self->pins & 63) == 0) {
+      MacroStats_t stats;
+      MacroView_statsDays(view, DAY_NUM_MIN, DAY_NUM_MAX, &stats);
+      if (stats.count != view->mealCount || stats.sum[MACRO_COLUMN_CALS] != totals.sum[MACRO_COLUMN_CALS])
+        self->inconsistent++;
+    }
+    self->lastVersion = view->version;
+
+    MacroReader_unpin(&reader);
+    self->pins++;
+  }
+
+  MacroReader_close(&reader);
+  return 0;
+}
+
+double _Bench_import(MacroDatabase_t *db, const Meal_t *meals) {
+  double start = Bench_now();
+  for (uint32_t meal = 0; meal < BENCH_MEAL_COUNT; meal += BENCH_BATCH_MEALS) {
+    MacroDatabase_addBatch(db, &meals[meal], BENCH_BATCH_MEALS, NULL);
+  }
+  return Bench_now() - start;
+}
+
+int main(void) {
+  Meal_t *meals = malloc(sizeof(Meal_t) * BENCH_MEAL_COUNT);
+  uint64_t state = 0x2545F4914F6CDD1Dull;
+  for (uint32_t meal = 0; meal < BENCH_MEAL_COUNT; meal++) {
+    meals[meal] = Bench_randomMeal(&state, meal);
+  }
+
+  MacroDatabase_t *db = MacroDatabase_create(0);
+  double seconds = _Bench_import(db, meals);
+  BENCH_REPORT("import, no views", seconds, BENCH_MEAL_COUNT);
+  MacroDatabase_destroy(db);
+
+  db = MacroDatabase_create(0);
+  MacroDatabase_enableViews(db);
+  seconds = _Bench_import(db, meals);
+  BENCH_REPORT("import, views", seconds, BENCH_MEAL_COUNT);
+  MacroDatabase_destroy(db);
+
+  db = MacroDatabase_create(0);
+  MacroDatabase_enableViews(db);
+  volatile LONG stop = 0;
+  BenchReader_t readers[BENCH_READER_COUNT] = {0};
+  HANDLE threads[BENCH_READER_COUNT];
+  for (uint32_t reader = 0; reader < BENCH_READER_COUNT; reader++) {
+    readers[reader] = (BenchReader_t) { .db = db, .stop = &stop };
+    threads[reader] = CreateThread(NULL, 0, (LPTHREAD_START_ROUTINE)_Bench_reader, &readers[reader], 0, NULL);
+  }
+
+  seconds = _Bench_import(db, meals);
+  stop = 1;
+  for (uint32_t reader = 0; reader < BENCH_READER_COUNT; reader++) {
+    WaitForSingleObject(threads[reader], INFINITE);
+    CloseHandle(threads[reader]);
+  }
+
+  char label[64];
+  snprintf(label, sizeof(label), "import, %u readers", BENCH_READER_COUNT);
+  BENCH_REPORT(label, seconds, BENCH_MEAL_COUNT);
+  for (uint32_t reader = 0; reader < BENCH_READER_COUNT; reader++) {
+    printf("  reader %u: %llu views, %.1f ns per pin, %llu inconsistent\n", reader,
+      (unsigned long long)readers[reader].pins, readers[reader].pinSeconds / (readers[reader].pins + 1) * 1e9,
+      (unsigned long long)readers[reader].inconsistent
+    );
+  }
+  printf("  %u views retired but not freed yet\n", db->_views->_retiredCount);
+
+  MacroDatabase_destroy(db);
+  free(meals);
+  return 0;
+}
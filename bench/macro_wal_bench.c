@@ -0,0 +1,41 @@
+#include "Bench.h"
+
+#define BENCH_MEAL_COUNT 5000000u
+#define BENCH_DB_PATH "macro_wal_bench"
+
+int main(void) {
+  DeleteFileA(BENCH_DB_PATH MACRO_SNAPSHOT_EXT);
+  DeleteFileA(BENCH_DB_PATH MACRO_LOG_EXT);
+
+  MacroLogInfo_t info = MACRO_LOG_INFO_INIT;
+  info.compactThreshold = BENCH_MEAL_COUNT / 2;
+
+  MacroDatabase_t *db = MacroDatabase_open(BENCH_DB_PATH, &info, 0);
+  if (db == NULL)
+    return -1;
+
+  uint64_t state = 0x2545F4914F6CDD1Dull;
+  double start = Bench_now();
+  for (uint32_t index = 0; index < BENCH_MEAL_COUNT; index++) {
+    MacroDatabase_add(db, Bench_randomMeal(&state, index));
+  }
+  MacroDatabase_sync(db);
+  BENCH_REPORT("logged inserts (group commit)", Bench_now() - start, BENCH_MEAL_COUNT);
+  MacroDatabase_destroy(db);
+
+  start = Bench_now();
+  db = MacroDatabase_open(BENCH_DB_PATH, &info, 0);
+  BENCH_REPORT("cold open (snapshot + log)", Bench_now() - start, db->mealCount);
+
+  start = Bench_now();
+  MacroDatabase_compact(db);
+  BENCH_REPORT("compaction", Bench_now() - start, db->mealCount);
+  MacroDatabase_destroy(db);
+
+  start = Bench_now();
+  db = MacroDatabase_open(BENCH_DB_PATH, &info, 0);
+  BENCH_REPORT("cold open (snapshot only)", Bench_now() - start, db->mealCount);
+  MacroDatabase_destroy(db);
+
+  return 0;
+}
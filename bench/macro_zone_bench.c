@@ -0,0 +1,88 @@
+#include "Bench.h"
+#include "MacroKernel.h"
+#include "MacroQuery.h"
+#include "MacroZone.h"
+
+#define BENCH_MEAL_COUNT 10000000u
+#define BENCH_REPEATS 5
+
+static const char *_benchQueries[] = {
+  "where date >= 2010-03-01 and date < 2010-04-01 group by day select count, sum(cals)",
+  "where date >= 2010-01-01 and date < 2011-01-01 and protein > 60 group by month select count, avg(cals)",
+  "where cals > 1000 select count, avg(protein)",
+  "where cals > 1640 select count, avg(protein)",
+  "where not (cals > 1640) and date < 2001-01-01 select count"
+};
+
+void _Bench_report(const char *label, double seconds, const MacroZoneCounts_t *before, const MacroZoneCounts_t *after) {
+  uint64_t read = (after->read - before->read) / BENCH_REPEATS;
+  uint64_t skipped = (after->skipped - before->skipped) / BENCH_REPEATS;
+  printf("  %-24s %10.3f ms %10llu zones read %10llu skipped\n", label, seconds * 1000.0,
+    (unsigned long long)read, (unsigned long long)skipped
+  );
+}
+
+int main(void) {
+  MacroDatabase_t *db = MacroDatabase_create(0);
+  uint64_t state = 0x2545F4914F6CDD1Dull;
+  for (uint32_t index = 0; index < BENCH_MEAL_COUNT; index++) {
+    MacroDatabase_add(db, Bench_randomMeal(&state, index));
+  }
+
+  double start = Bench_now();
+  const MacroZoneMap_t *zones = MacroDatabase_zones(db);
+  if (zones == NULL)
+    return 1;
+  printf("%u meals, %u zones built in %.3f ms\n", db->mealCount, zones->zoneCount, (Bench_now() - start) * 1000.0);
+
+  const DayNum_t ranges[][2] = {
+    { Date_toDayNum((Date_t) { 2010, 3, 1 }), Date_toDayNum((Date_t) { 2010, 3, 31 }) },
+    { Date_toDayNum((Date_t) { 2010, 1, 1 }), Date_toDayNum((Date_t) { 2010, 12, 31 }) },
+    { DAY_NUM_MIN, DAY_NUM_MAX }
+  };
+  const char *rangeLabels[] = { "one month", "one year", "everything" };
+
+  for (uint32_t range = 0; range < 3; range++) {
+    printf("stats over %s\n", rangeLabels[range]);
+
+    MacroStats_t stats, full;
+    MacroZoneCounts_t before = zones->counts;
+    start = Bench_now();
+    for (uint32_t repeat = 0; repeat < BENCH_REPEATS; repeat++) {
+      MacroDatabase_statsDays(db, ranges[range][0], ranges[range][1], &stats);
+    }
+    _Bench_report("zone map", (Bench_now() - start) / BENCH_REPEATS, &before, &zones->counts);
+
+    // What every range cost before, a kernel pass over all meals
+    start = Bench_now();
+    for (uint32_t repeat = 0; repeat < BENCH_REPEATS; repeat++) {
+      MacroStats_reset(&full);
+      MacroKernel_reduce((const uint32_t *const *)db->columns, db->days, db->mealCount, ranges[range][0], ranges[range][1], &full);
+      MacroStats_finalize(&full);
+    }
+    printf("  %-24s %10.3f ms\n", "full scan", (Bench_now() - start) / BENCH_REPEATS * 1000.0);
+
+    if (memcmp(&stats, &full, sizeof(MacroStats_t)) != 0)
+      printf("  MISMATCH\n");
+  }
+
+  for (uint32_t index = 0; index < sizeof(_benchQueries) / sizeof(_benchQueries[0]); index++) {
+    MacroQuery_t query;
+    if (MacroQuery_compile(&query, _benchQueries[index]) != RESULT_SUCCESS)
+      return 1;
+
+    printf("%s\n", _benchQueries[index]);
+    MacroQueryResult_t result = {0};
+    MacroZoneCounts_t before = zones->counts;
+    start = Bench_now();
+    for (uint32_t repeat = 0; repeat < BENCH_REPEATS; repeat++) {
+      MacroQueryResult_cleanup(&result);
+      MacroQuery_run(&query, db, &result);
+    }
+    _Bench_report("query", (Bench_now() - start) / BENCH_REPEATS, &before, &zones->counts);
+    MacroQueryResult_cleanup(&result);
+  }
+
+  MacroDatabase_destroy(db);
+  return 0;
+}
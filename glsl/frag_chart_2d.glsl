@@ -0,0 +1,15 @@
+#version 420
+
+in vec2 iUV;
+in vec4 iColor;
+in vec2 iLocal;
+out vec4 FragColor;
+
+void main()
+{
+  // Geometry panned past the edges of the chart
+  if (any(greaterThan(abs(iLocal), vec2(0.5))))
+    discard;
+
+  FragColor = iColor;
+}
\ No newline at end of file
@@ -0,0 +1,37 @@
+#version 420
+
+// DRAW_QUAD_TEXTURE_SLOTS single channel textures (the glyph atlas pages)
+layout(binding = 0) uniform sampler2D textures[8];
+
+in vec2 iUV;
+in vec2 iLocal;
+in vec4 iColor;
+flat in int iTexture;
+out vec4 FragColor;
+
+void main()
+{
+  // Size of a pixel on the quad, taken before any branch
+  vec2 pixel = fwidth(iLocal);
+
+  if (iTexture == -2) {
+    vec2 edge = min(iLocal, 1.0 - iLocal);
+    if (edge.x > pixel.x && edge.y > pixel.y)
+      discard;
+  }
+
+  float coverage = 1.0;
+  // Constant indices, a 4.2 sampler array can't be indexed by a varying
+  switch (iTexture) {
+    case 0: coverage = textureLod(textures[0], iUV, 0.0).r; break;
+    case 1: coverage = textureLod(textures[1], iUV, 0.0).r; break;
+    case 2: coverage = textureLod(textures[2], iUV, 0.0).r; break;
+    case 3: coverage = textureLod(textures[3], iUV, 0.0).r; break;
+    case 4: coverage = textureLod(textures[4], iUV, 0.0).r; break;
+    case 5: coverage = textureLod(textures[5], iUV, 0.0).r; break;
+    case 6: coverage = textureLod(textures[6], iUV, 0.0).r; break;
+    case 7: coverage = textureLod(textures[7], iUV, 0.0).r; break;
+  }
+
+  FragColor = vec4(iColor.rgb, iColor.a * coverage);
+}
\ No newline at end of file
@@ -0,0 +1,63 @@
+#version 420
+layout (location = 0) in vec2 aPos;
+layout (location = 1) in vec2 aUV;
+// Value and bottom of the instance's point and of the one after it
+layout (location = 2) in vec2 aPoint;
+layout (location = 3) in vec2 aNext;
+
+layout (std140, binding = 0) uniform GlobalUB
+{
+  mat4 projectionView;
+};
+
+layout (std140, binding = 2) uniform ChartUB
+{
+  mat4 model;
+  vec4 color;
+  // Visible data rectangle, offset in xy and 1 / extent in zw
+  vec4 view;
+  int kind;
+  int firstPoint;
+  float lineWidth;
+  float barWidth;
+};
+
+#define KIND_LINE 0
+#define KIND_BAR 1
+#define KIND_AREA 2
+
+out vec2 iUV;
+out vec4 iColor;
+out vec2 iLocal;
+
+// Data space to the element's unit quad
+vec2 toLocal(vec2 point)
+{
+  return (point - view.xy) * view.zw - 0.5;
+}
+
+void main()
+{
+  float x = float(firstPoint + gl_InstanceID);
+  vec2 corner = aPos + 0.5;
+  vec2 local;
+
+  if (kind == KIND_BAR) {
+    local = toLocal(vec2(x + aPos.x * barWidth, aPoint.y + corner.y * aPoint.x));
+  } else if (kind == KIND_AREA) {
+    vec2 point = mix(aPoint, aNext, corner.x);
+    local = toLocal(vec2(x + corner.x, point.y + corner.y * point.x));
+  } else {
+    // Segment to the next point, widened along its normal
+    vec2 from = toLocal(vec2(x, aPoint.x + aPoint.y));
+    vec2 to = toLocal(vec2(x + 1.0, aNext.x + aNext.y));
+    vec2 along = to - from;
+    vec2 normal = normalize(vec2(-along.y, along.x));
+    local = mix(from, to, corner.x) + normal * aPos.y * lineWidth;
+  }
+
+  gl_Position = projectionView * model * vec4(local, 0.0, 1.0);
+  iUV = aUV;
+  iColor = color;
+  iLocal = local;
+}
\ No newline at end of file
@@ -0,0 +1,36 @@
+#version 420
+layout (location = 0) in vec2 aPos;
+layout (location = 1) in vec2 aUV;
+// Color of the instance's day
+layout (location = 2) in vec4 aColor;
+
+layout (std140, binding = 0) uniform GlobalUB
+{
+  mat4 projectionView;
+};
+
+layout (std140, binding = 2) uniform HeatmapUB
+{
+  mat4 model;
+  // Monday = 0
+  int firstWeekday;
+  float cellGap;
+};
+
+#define WEEKS 54.0
+
+out vec2 iUV;
+out vec4 iColor;
+
+void main()
+{
+  // A column per week, Monday on top
+  int cell = gl_InstanceID + firstWeekday;
+  vec2 grid = vec2(cell / 7, 6 - cell % 7);
+  vec2 cellSize = vec2(1.0 / WEEKS, 1.0 / 7.0);
+  vec2 local = (grid + 0.5 + aPos * (1.0 - cellGap)) * cellSize - 0.5;
+
+  gl_Position = projectionView * model * vec4(local, 0.0, 1.0);
+  iUV = aUV;
+  iColor = aColor;
+}
\ No newline at end of file
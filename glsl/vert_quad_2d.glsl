@@ -0,0 +1,30 @@
+#version 420
+layout (location = 0) in vec2 aPos;
+layout (location = 1) in vec2 aUV;
+// 2D part of the quad's model matrix, x and y axis then translation
+layout (location = 2) in vec4 aAxes;
+layout (location = 3) in vec2 aTranslation;
+// Texture slot, negative for flat (-1) and outline (-2) quads
+layout (location = 4) in int aTexture;
+layout (location = 5) in vec4 aUVRect;
+layout (location = 6) in vec4 aColor;
+
+layout (std140, binding = 0) uniform GlobalUB
+{
+  mat4 projectionView;
+};
+
+out vec2 iUV;
+out vec2 iLocal;
+out vec4 iColor;
+flat out int iTexture;
+
+void main()
+{
+  vec2 world = aAxes.xy * aPos.x + aAxes.zw * aPos.y + aTranslation;
+  gl_Position = projectionView * vec4(world, 0.0, 1.0);
+  iUV = mix(aUVRect.xy, aUVRect.zw, aUV);
+  iLocal = aPos + 0.5;
+  iColor = aColor;
+  iTexture = aTexture;
+}
\ No newline at end of file
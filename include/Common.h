@@ -1,6 +1,9 @@
 #ifndef _H_COMMON_
 #define _H_COMMON_
 
+#include <stdint.h>
+#include <stdbool.h>
+
 typedef enum _Result {
   RESULT_FAIL = 0,
   RESULT_SUCCESS = 1
@@ -8,6 +11,20 @@ typedef enum _Result {
 
 #define DEFAULT_BUF_CAP (1 << 10)
 
+// Doubles capacity until it holds count, into *out. Doubling runs in 64 bits since a 32 bit
+// capacity past 2^31 wraps to 0 and never gets there. False when count needs more than 32 bits
+static inline bool Common_growCapacity(uint32_t capacity, uint32_t count, uint32_t *out) {
+  uint64_t grown = capacity > 0 ? capacity : 1;
+  while (grown < count) {
+    grown <<= 1;
+  }
+  if (grown > UINT32_MAX)
+    return false;
+
+  *out = (uint32_t)grown;
+  return true;
+}
+
 #if defined(_WIN64) || defined(_WIN32)
 #define WINDOWS_PLATFORM
 #else
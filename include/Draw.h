@@ -18,6 +18,8 @@
 
 #include "Common.h"
 #include "UStr.h"
+#include "GlyphAtlas.h"
+#include "GlyphTable.h"
 
 typedef struct __GlobalUBData_t {
   mat4 projectionView;
@@ -38,10 +40,62 @@ typedef struct __Transform_t {
 void Transform_toMat4(Transform_t *self, mat4 matrix);
 void Transform_copy(Transform_t *self, Transform_t other);
 
-typedef struct __LocalUBData2D_t {
+// ChartUB of the chart shader, filled per series. Pan and zoom only change view
+typedef struct __ChartUBData_t {
   mat4 model;
   vec4 color;
-} _LocalUBData2D_t;
+  // Visible data rectangle, offset in xy and 1 / extent in zw
+  vec4 view;
+  int32_t kind;
+  // Point of the first instance
+  int32_t firstPoint;
+  float lineWidth;
+  float barWidth;
+} _ChartUBData_t;
+
+// HeatmapUB of the heatmap shader, the day colors come from the instance buffer
+typedef struct __HeatmapUBData_t {
+  mat4 model;
+  int32_t firstWeekday;
+  float cellGap;
+  float _padding[2];
+} _HeatmapUBData_t;
+
+// Frames the CPU can be ahead of the GPU by, each one writes its own region of the stream
+#define DRAW_STREAM_FRAMES 3
+#define DRAW_STREAM_FRAME_SIZE (1 << 20)
+
+// Persistently mapped buffer every per-frame uniform block and instance is written to. A
+// region is only written again after the fence of the frame that last used it signals
+typedef struct __DrawStream_t {
+  GLuint buffer;
+  uint8_t *mapped;
+  GLsizeiptr frameSize;
+  // Region of this frame and the next free byte in it
+  uint32_t frame;
+  GLintptr offset;
+  GLsync fences[DRAW_STREAM_FRAMES];
+  GLint uniformAlignment;
+} _DrawStream_t;
+
+// Textures one batch can sample, a quad needing another one flushes the batch
+#define DRAW_QUAD_TEXTURE_SLOTS 8
+// Texture slots of untextured quads, outlines only keep the pixels on the quad's edge
+#define DRAW_QUAD_FLAT -1
+#define DRAW_QUAD_OUTLINE -2
+
+// One quad of the frame's batch, it goes through axes and translation (the 2D part of its
+// model matrix) straight to world space
+typedef struct __QuadInstance_t {
+  // x axis in xy, y axis in zw
+  vec4 axes;
+  vec2 translation;
+  // Slot in _batchTextures, DRAW_QUAD_FLAT or DRAW_QUAD_OUTLINE
+  int32_t texture;
+  int32_t _padding;
+  vec4 uvRect;
+  vec4 color;
+} _QuadInstance_t;
 
 typedef uint32_t u32vec2[2];
 
@@ -53,7 +107,9 @@ typedef struct __Glyph_t {
 
   bool isWhitespace;
 
-  GLuint glTextureHandle;
+  // Atlas page and uvRect of the bitmap, unset for whitespace
+  uint32_t page;
+  vec4 uv;
 } _Glyph_t;
 
 typedef union _SizeVec2_t {
@@ -72,18 +128,32 @@ typedef struct __Draw_t {
   FT_Library _ft;
   FT_Face _ftFace;
 
-  // TODO: implement flatShader
-  GLuint _texShader, _flatShader;
-  GLuint _quadVAO, _quadVBO, _quadEBO;
+  // Unit quad vertices and indices, shared by every VAO
+  GLuint _quadVBO, _quadEBO;
 
   mat4 _projection, _view;
 
-  GLuint _globalUB, _localUB;
+  // Streamed to binding 0 by every draw
   _GlobalUBData_t _globalUBData;
-
-  // Currently linear search
-  _Glyph_t *_glyphs;
-  size_t _glyphCap, _glyphCount;
+  _DrawStream_t _stream;
+
+  // The quad with the chart points as per instance attributes
+  GLuint _chartShader, _chartVAO;
+  // The quad with a color per instance
+  GLuint _heatmapShader, _heatmapVAO;
+
+  // _Glyph_t per loaded code point
+  GlyphTable_t _glyphs;
+  // Pages the glyph bitmaps are packed into
+  GlyphAtlas_t _atlas;
+
+  // Quads of the frame in painter's order (UI, sprites, glyphs), drawn by one instanced
+  // call per flush
+  GLuint _quadShader, _batchVAO;
+  _QuadInstance_t *_batch;
+  uint32_t _batchCount, _batchCap;
+  GLuint _batchTextures[DRAW_QUAD_TEXTURE_SLOTS];
+  uint32_t _batchTextureCount;
 
   double _lastTime;
   double _deltaTime;
@@ -19,6 +19,8 @@ typedef enum __EVENT_TYPE_t {
   EVENT_TYPE_MOUSE_MOVE = 3,
   EVENT_TYPE_FOCUS_SET = 4,
   EVENT_TYPE_KEY = 5,
+  EVENT_TYPE_MOUSE_PRESS = 6,
+  EVENT_TYPE_SCROLL = 7,
 
   // RENDERER EVENTS
   ET_RENDER_FB_RESIZE = 1
@@ -37,6 +39,8 @@ typedef struct __Event_t {
   union {
     vec2 position;
     UC_t character;
+    // Vertical wheel steps, positive away from the user
+    float scroll;
     struct {
       int glfwKey;
       int glfwAction;
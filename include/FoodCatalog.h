@@ -0,0 +1,103 @@
+#ifndef _H_FOOD_CATALOG_
+#define _H_FOOD_CATALOG_
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "Common.h"
+#include "MacroDatabase.h"
+
+typedef uint32_t FoodId_t;
+
+#define FOOD_ID_NONE UINT32_MAX
+
+// Nutrients per 100 grams, in the units of Macro_t (kcal and grams)
+typedef struct __FoodNutrients_t {
+  union {
+    float values[MACRO_COLUMN_COUNT];
+    struct {
+      float cals, protein, fat, carbs;
+    };
+  };
+} FoodNutrients_t;
+
+typedef struct __Food_t {
+  // Name is names[nameOffset, nameOffset + nameLength), NUL terminated
+  uint32_t nameOffset;
+  uint32_t nameLength;
+  FoodNutrients_t per100g;
+} Food_t;
+
+// Open addressing slot of the name index, hash is kept so probes rarely touch the names
+typedef struct __FoodSlot_t {
+  uint32_t hash;
+  FoodId_t id;
+} FoodSlot_t;
+
+// Foods are ids into a dense array, names are interned once in a single arena
+typedef struct __FoodCatalog_t {
+  Food_t *foods;
+  uint32_t foodCount, _foodCap;
+
+  char *names;
+  uint32_t namesSize, _namesCap;
+
+  // Power of two, at most half full
+  FoodSlot_t *_slots;
+  uint32_t _slotCap;
+
+  // Bumped whenever the nutrients of an existing food change, meals compare it to their cache
+  uint32_t version;
+} FoodCatalog_t;
+
+void FoodCatalog_init(FoodCatalog_t *self);
+void FoodCatalog_cleanup(FoodCatalog_t *self);
+// Grows every table once ahead of a bulk load
+void FoodCatalog_reserve(FoodCatalog_t *self, uint32_t foodCount, uint32_t nameBytes);
+// Adds the foods of a CSV file: rows are name,cals,protein,fat,carbs per 100 grams (a header
+// line is skipped), the name may be quoted as in RFC 4180. Rows that don't parse are skipped
+Result_t FoodCatalog_load(FoodCatalog_t *self, const char *path);
+
+// Interns name, adding the food or updating the nutrients of the one already named so
+FoodId_t FoodCatalog_add(FoodCatalog_t *self, const char *name, uint32_t length, const FoodNutrients_t *per100g);
+// Exact name lookup, FOOD_ID_NONE when there is no such food
+FoodId_t FoodCatalog_find(const FoodCatalog_t *self, const char *name, uint32_t length);
+void FoodCatalog_setNutrients(FoodCatalog_t *self, FoodId_t id, const FoodNutrients_t *per100g);
+
+const Food_t *FoodCatalog_get(const FoodCatalog_t *self, FoodId_t id);
+const char *FoodCatalog_name(const FoodCatalog_t *self, FoodId_t id);
+
+// Bytes held by the foods, the names and the index
+size_t FoodCatalog_size(const FoodCatalog_t *self);
+
+// FNV-1a of the name bytes
+uint32_t Food_hash(const char *name, uint32_t length);
+
+typedef struct __FoodItem_t {
+  FoodId_t food;
+  uint32_t grams;
+} FoodItem_t;
+
+// A meal made of catalog foods, its Macro_t totals are computed on demand and cached until
+// the items or the catalog's nutrients change
+typedef struct __FoodMeal_t {
+  Date_t date;
+  FoodItem_t *items;
+  uint32_t itemCount, _itemCap;
+
+  Macro_t _totals;
+  // Catalog version the totals were computed against, 0 when they are stale
+  uint32_t _totalsVersion;
+} FoodMeal_t;
+
+void FoodMeal_init(FoodMeal_t *self, Date_t date);
+void FoodMeal_cleanup(FoodMeal_t *self);
+// Adds grams of food, merging with an item of the same food
+void FoodMeal_add(FoodMeal_t *self, FoodId_t food, uint32_t grams);
+void FoodMeal_remove(FoodMeal_t *self, uint32_t item);
+
+Macro_t FoodMeal_totals(FoodMeal_t *self, const FoodCatalog_t *catalog);
+// The meal as MacroDatabase_add takes it
+Meal_t FoodMeal_toMeal(FoodMeal_t *self, const FoodCatalog_t *catalog);
+
+#endif
@@ -0,0 +1,101 @@
+#ifndef _H_FOOD_SEARCH_
+#define _H_FOOD_SEARCH_
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "FoodCatalog.h"
+
+#define FOOD_SEARCH_MAX_RESULTS 16
+// Longer queries are cut, they don't narrow the results any further in practice
+#define FOOD_SEARCH_MAX_QUERY 63
+
+// Trigrams over a 37 symbol alphabet: word start, a-z and 0-9
+#define FOOD_SEARCH_SYMBOLS 37
+#define FOOD_SEARCH_TRIGRAM_COUNT (FOOD_SEARCH_SYMBOLS * FOOD_SEARCH_SYMBOLS * FOOD_SEARCH_SYMBOLS)
+// Words scored together, a block whose best score can't make the results is skipped whole
+#define FOOD_SEARCH_BLOCK_WORDS 64
+
+// Read-only index over the names of a catalog, build it again after adding foods.
+// Names are kept normalized (lower case, any run of punctuation and spaces becomes one space).
+// A query matches the start of any word of a name and everything after it, typos are fixed
+// word by word against the vocabulary of the names, then the fixed query is searched too
+typedef struct __FoodSearch_t {
+  const FoodCatalog_t *catalog;
+  uint32_t foodCount;
+
+  // Normalized names in id order, food i is text[textOffsets[i], textOffsets[i + 1] - 1)
+  char *text;
+  uint32_t *textOffsets;
+
+  // Offsets of every word start in text, sorted by the text from there on. The static part of
+  // a match's rank is kept per word and as a maximum per FOOD_SEARCH_BLOCK_WORDS words
+  uint32_t *words;
+  uint16_t *wordScores;
+  uint16_t *blockScores;
+  uint32_t wordCount;
+
+  // Distinct words not starting with a digit, sorted, and how many times each appears
+  uint32_t *vocab;
+  uint32_t *vocabFrequency;
+  uint32_t vocabCount;
+
+  // Vocabulary ids per trigram, delta and varint coded. Trigram t is
+  // postings[postingStart[t], postingStart[t + 1]) and holds postingCount[t] words
+  uint8_t *postings;
+  uint32_t *postingStart;
+  uint32_t *postingCount;
+} FoodSearch_t;
+
+Result_t FoodSearch_build(FoodSearch_t *self, const FoodCatalog_t *catalog);
+void FoodSearch_cleanup(FoodSearch_t *self);
+size_t FoodSearch_size(const FoodSearch_t *self);
+
+typedef struct __FoodSearchResult_t {
+  FoodId_t food;
+  // Matches of the query as typed rank above matches of the corrected one, then name starts
+  // above later words, then shorter names
+  uint32_t score;
+} FoodSearchResult_t;
+
+typedef enum __FoodSearchPhase_t {
+  FOOD_SEARCH_PHASE_PREFIX = 0,
+  FOOD_SEARCH_PHASE_CORRECT = 1,
+  FOOD_SEARCH_PHASE_FUZZY = 2,
+  FOOD_SEARCH_PHASE_DONE = 3
+} FoodSearchPhase_t;
+
+// Type-ahead state kept between keystrokes. A query runs in budgeted steps, setting a new one
+// drops the unfinished work of the last and keeps what still applies: the prefix ranges of the
+// characters both share, and the corrections of the words both share
+typedef struct __FoodSearchQuery_t {
+  const FoodSearch_t *search;
+
+  // Normalized like the names
+  char text[FOOD_SEARCH_MAX_QUERY + 1];
+  uint32_t length;
+
+  // words[_rangeLo[i], _rangeHi[i]) start with the first i characters of text
+  uint32_t _rangeLo[FOOD_SEARCH_MAX_QUERY + 1];
+  uint32_t _rangeHi[FOOD_SEARCH_MAX_QUERY + 1];
+
+  FoodSearchPhase_t _phase;
+  uint32_t _cursor, _end;
+
+  // Corrected text, its first _correctedLength characters are the corrections of the finished
+  // words in text[0, _correctedFrom)
+  char _corrected[FOOD_SEARCH_MAX_QUERY + 1];
+  uint32_t _correctedLength, _correctedFrom;
+
+  FoodSearchResult_t results[FOOD_SEARCH_MAX_RESULTS];
+  uint32_t resultCount;
+} FoodSearchQuery_t;
+
+void FoodSearchQuery_init(FoodSearchQuery_t *self, const FoodSearch_t *search);
+// Replaces the query, call FoodSearchQuery_run until it returns true for the final results
+void FoodSearchQuery_set(FoodSearchQuery_t *self, const char *text, uint32_t length);
+// Looks at up to budget words, returns true once the results are final. Results found so far
+// are already ranked, so a UI can show them between steps
+bool FoodSearchQuery_run(FoodSearchQuery_t *self, uint32_t budget);
+
+#endif
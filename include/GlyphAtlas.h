@@ -0,0 +1,47 @@
+#ifndef _H_GLYPH_ATLAS_
+#define _H_GLYPH_ATLAS_
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "Common.h"
+
+// Empty texels kept around every glyph so linear filtering doesn't pick up its neighbours
+#define GLYPH_ATLAS_PADDING 1
+
+// Top edge of the packed area over [x, x + width)
+typedef struct __GlyphAtlasSkyline_t {
+  uint32_t x, y, width;
+} GlyphAtlasSkyline_t;
+
+typedef struct __GlyphAtlasPage_t {
+  // Left to right, covering the whole page width
+  GlyphAtlasSkyline_t *skyline;
+  uint32_t skylineCount, _skylineCap;
+
+  // GL texture of the page, created by the renderer
+  uint32_t texture;
+} GlyphAtlasPage_t;
+
+typedef struct __GlyphAtlasRect_t {
+  uint32_t page;
+  uint32_t x, y, width, height;
+} GlyphAtlasRect_t;
+
+// Square pages packed with a bottom-left skyline, a page is only added when no open one
+// has room. Glyphs never move once packed
+typedef struct __GlyphAtlas_t {
+  GlyphAtlasPage_t *pages;
+  uint32_t pageCount, _pageCap;
+  uint32_t pageSize;
+} GlyphAtlas_t;
+
+void GlyphAtlas_init(GlyphAtlas_t *self, uint32_t pageSize);
+void GlyphAtlas_cleanup(GlyphAtlas_t *self);
+
+// Finds room for width x height (padding included in out) on the first page it fits in, the
+// lowest spot of that page wins. A new page is added when none has room.
+// Fails only for rectangles bigger than a page
+Result_t GlyphAtlas_pack(GlyphAtlas_t *self, uint32_t width, uint32_t height, GlyphAtlasRect_t *out);
+
+#endif
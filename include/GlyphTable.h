@@ -0,0 +1,47 @@
+#ifndef _H_GLYPH_TABLE_
+#define _H_GLYPH_TABLE_
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "Common.h"
+#include "UStr.h"
+
+// The Basic Multilingual Plane is split into pages of 256 code points, allocated on first use
+#define GLYPH_TABLE_PAGE_BITS 8
+#define GLYPH_TABLE_PAGE_SIZE (1 << GLYPH_TABLE_PAGE_BITS)
+#define GLYPH_TABLE_BMP_PAGES (0x10000 >> GLYPH_TABLE_PAGE_BITS)
+// Entries of code points past the BMP are allocated this many at a time
+#define GLYPH_TABLE_CHUNK_ENTRIES 64
+
+typedef struct __GlyphTablePage_t {
+  // GLYPH_TABLE_PAGE_SIZE entries, one bit per entry that was inserted
+  uint8_t *entries;
+  uint32_t present[GLYPH_TABLE_PAGE_SIZE / 32];
+} GlyphTablePage_t;
+
+// Code point to entry in O(1): a page directory for the BMP, an open addressed map for the
+// rest. Entries are entrySize bytes, zeroed on insert, and never move once inserted
+typedef struct __GlyphTable_t {
+  GlyphTablePage_t *pages[GLYPH_TABLE_BMP_PAGES];
+  size_t entrySize;
+  uint32_t count;
+
+  // Linear probing, key 0 is a free slot since 0 is never past the BMP
+  UC_t *_astralKeys;
+  uint8_t **_astralEntries;
+  uint32_t _astralCount, _astralCap;
+
+  uint8_t **_chunks;
+  uint32_t _chunkCount, _chunkCap, _chunkUsed;
+} GlyphTable_t;
+
+void GlyphTable_init(GlyphTable_t *self, size_t entrySize);
+void GlyphTable_cleanup(GlyphTable_t *self);
+
+// NULL when character was never inserted
+void *GlyphTable_get(const GlyphTable_t *self, UC_t character);
+// Zeroed entry for character, NULL when it is already in the table
+void *GlyphTable_insert(GlyphTable_t *self, UC_t character);
+
+#endif
@@ -7,6 +7,9 @@
 #include <string.h>
 
 #include "Common.h"
+#include "MacroIndex.h"
+#include "MacroLog.h"
+#include "MacroRegion.h"
 
 typedef struct {
   uint32_t cals, protein, fat, carbs;
@@ -23,17 +26,204 @@ typedef struct {
   Date_t date;
 } Meal_t;
 
+DayNum_t Date_toDayNum(Date_t date);
+Date_t Date_fromDayNum(DayNum_t day);
+// 28 to 31, February has 29 in leap years
+uint32_t Date_daysInMonth(uint32_t year, uint32_t month);
+// Month in 1..12 and day inside that month
+_Bool Date_isValid(Date_t date);
+// Days are counted from 1970/1/1, earlier dates would wrap around and sort after every other one
+#define DATE_MIN_YEAR 1970
+#define DATE_MAX_YEAR 9999
+// DATE_MAX_YEAR/12/31, dense per day tables ignore anything later (a wrapped day from an old log)
+#define DATE_MAX_DAY_NUM ((DayNum_t)2932896)
+// Valid and within DATE_MIN_YEAR..DATE_MAX_YEAR, what the database accepts for a meal
+_Bool Date_isStorable(Date_t date);
+
+// Column order matches the member order of Macro_t
+typedef enum __MacroColumn_t {
+  MACRO_COLUMN_CALS = 0,
+  MACRO_COLUMN_PROTEIN = 1,
+  MACRO_COLUMN_FAT = 2,
+  MACRO_COLUMN_CARBS = 3,
+  MACRO_COLUMN_COUNT = 4
+} MacroColumn_t;
+
+typedef struct __MacroStats_t {
+  uint64_t sum[MACRO_COLUMN_COUNT];
+  uint32_t min[MACRO_COLUMN_COUNT];
+  uint32_t max[MACRO_COLUMN_COUNT];
+  double mean[MACRO_COLUMN_COUNT];
+  uint32_t count;
+} MacroStats_t;
+
+// Sums without min/max, what the rollups keep per calendar bucket
+typedef struct __MacroTotals_t {
+  uint64_t sum[MACRO_COLUMN_COUNT];
+  uint32_t count;
+} MacroTotals_t;
+
+// Meals a database holds when created with maxMeals 0. Every column reserves address space
+// for maxMeals up front so it never moves while it grows
+#define MACRO_DATABASE_DEFAULT_MAX_MEALS (1u << 24)
+// Upper bound of maxMeals and of the meals in a snapshot
+#define MACRO_DATABASE_MAX_MEALS_LIMIT (1u << 30)
+
+// Rows MacroDatabase_freeze moves at a time: one zone (MACRO_ZONE_ROWS), a page of every column
+#define MACRO_DATABASE_FREEZE_ROWS 1024
+
+// Storage regions in snapshot section order, the index ones hold the snapshot's sorted run
+typedef enum __MacroDatabaseRegion_t {
+  MACRO_DATABASE_REGION_DAYS = MACRO_COLUMN_COUNT,
+  MACRO_DATABASE_REGION_INDEX_DAYS,
+  MACRO_DATABASE_REGION_INDEX_ROWS,
+  MACRO_DATABASE_REGION_COUNT
+} MacroDatabaseRegion_t;
+
+// Columnar (SoA) storage, row i of every column belongs to the same meal
 typedef struct {
-  Meal_t *meals;
+  union {
+    uint32_t *columns[MACRO_COLUMN_COUNT];
+    struct {
+      uint32_t *cals, *protein, *fat, *carbs;
+    };
+  };
+  DayNum_t *days;
+
+  // Rows ordered by day, meals themselves stay in arrival order
+  MacroIndex_t index;
+
   uint32_t mealCount;
+  uint32_t maxMeals;
   uint32_t _mealCapacity;
+  MacroRegion_t _regions[MACRO_DATABASE_REGION_COUNT];
+
+  // Rows [0, frozenCount) only live packed in _cold, their column pages are given back.
+  // Read rows through MacroDatabase_rows or MacroDatabase_getMeal, not the columns
+  uint32_t frozenCount;
+  struct __MacroPack_t *_cold;
+
+  // Calendar rollups, built by the first query that needs them (see MacroDatabase_rollup)
+  struct __MacroRollup_t *_rollup;
+
+  // Per block min/max of every column, caught up by the scans that use it (see MacroDatabase_zones)
+  struct __MacroZoneMap_t *_zones;
+
+  // Moving averages of the daily totals, built by the first series (see MacroDatabase_trend)
+  struct __MacroTrend_t *_trend;
+
+  // Per day goal results, NULL until MacroDatabase_setGoals
+  struct __MacroGoals_t *_goals;
+
+  // Min/max/sum buckets for charts, built by the first chart or loaded with the snapshot (see MacroDatabase_pyramid)
+  struct __MacroPyramid_t *_pyramid;
+
+  // Published views for reader threads, NULL until MacroDatabase_enableViews
+  struct __MacroViews_t *_views;
+
+  // Persistence, NULL for in-memory databases (MacroDatabase_create)
+  MacroLog_t *_log;
+  char *_path;
 } MacroDatabase_t;
 
+// Rows handed out by MacroDatabase_rows, columns and days hold count of them
+typedef struct __MacroRows_t {
+  const uint32_t *columns[MACRO_COLUMN_COUNT];
+  const DayNum_t *days;
+  uint32_t count;
+
+  // Frozen rows are decoded here
+  uint32_t _values[MACRO_COLUMN_COUNT][MACRO_DATABASE_FREEZE_ROWS];
+  DayNum_t _days[MACRO_DATABASE_FREEZE_ROWS];
+} MacroRows_t;
+
+#define MACRO_SNAPSHOT_EXT ".snap"
+#define MACRO_LOG_EXT ".wal"
+#define MACRO_PYRAMID_EXT ".lod"
+
 void Meal_logData(Meal_t *meal);
 _Bool Meal_validate(Meal_t *self);
-MacroDatabase_t *MacroDatabase_create();
+// Room for maxMeals meals (MACRO_DATABASE_DEFAULT_MAX_MEALS when 0), NULL when it can't be reserved
+MacroDatabase_t *MacroDatabase_create(uint32_t maxMeals);
+// Persistent database at <path>.snap + <path>.wal, every add is appended to the log.
+// The snapshot is mapped rather than read, so opening costs O(1) in its size
+MacroDatabase_t *MacroDatabase_open(const char *path, const MacroLogInfo_t *info, uint32_t maxMeals);
+// Forces buffered log records to disk
+Result_t MacroDatabase_sync(MacroDatabase_t *self);
+// Syncs the log once its window elapsed, call it every frame or tick so the last meals before
+// an idle stretch don't wait for the next add to become durable
+Result_t MacroDatabase_poll(MacroDatabase_t *self);
+// Rewrites the snapshot from memory and empties the log
+Result_t MacroDatabase_compact(MacroDatabase_t *self);
 void MacroDatabase_destroy(MacroDatabase_t *self);
 void MacroDatabase_logToConsole(MacroDatabase_t *self);
+// Drops meals whose macros fail Meal_validate or whose date isn't Date_isStorable
 void MacroDatabase_add(MacroDatabase_t *self, Meal_t meal);
+// Validates the macros of the whole batch in one SIMD pass, the dates once per distinct day, and stores the valid meals with a single resize.
+// Bit i of rejectMask ((n + 7) / 8 bytes, may be NULL) is set when meals[i] was rejected,
+// returns the number of meals added
+size_t MacroDatabase_addBatch(MacroDatabase_t *self, const Meal_t *meals, size_t n, uint8_t *rejectMask);
+// Grows mealCount, the new rows are left uninitialized
+Result_t _MacroDatabase_resize(MacroDatabase_t *self, uint32_t newCount);
+// Refreshes the column pointers and capacity after _regions changed
+void _MacroDatabase_bindRegions(MacroDatabase_t *self);
+Meal_t MacroDatabase_getMeal(MacroDatabase_t *self, uint32_t index);
+
+// Rows from first on, at most count of them. Hot rows are windows on the columns, frozen ones
+// are decoded into out, at most MACRO_DATABASE_FREEZE_ROWS of them. Returns out->count
+uint32_t MacroDatabase_rows(const MacroDatabase_t *self, uint32_t first, uint32_t count, MacroRows_t *out);
+// First and last day of the meals, days past DATE_MAX_DAY_NUM left out. False without any meal
+_Bool MacroDatabase_dayBounds(const MacroDatabase_t *self, DayNum_t *first, DayNum_t *last);
+// Moves the rows before rowCount (rounded down to MACRO_DATABASE_FREEZE_ROWS) into the packed cold
+// tier and gives their column pages back, a history takes about a quarter of its column memory.
+// Scans read the packed blocks, inserts stay on the columns. Fails when views are enabled, their
+// readers address the columns directly
+Result_t MacroDatabase_freeze(MacroDatabase_t *self, uint32_t rowCount);
+
+// Date ordered spans of meal rows within [from, to], see MacroIndexRange_next
+void MacroDatabase_range(MacroDatabase_t *self, Date_t from, Date_t to, MacroIndexRange_t *out);
+
+// Sum/min/max/mean of every macro over meals dated within [from, to]. Blocks of meals whose
+// zone lies outside the dates aren't read
+void MacroDatabase_stats(MacroDatabase_t *self, Date_t from, Date_t to, MacroStats_t *out);
+void MacroDatabase_statsDays(MacroDatabase_t *self, DayNum_t from, DayNum_t to, MacroStats_t *out);
+// Same over threadCount threads (0 = one per logical processor) pulling morsels of rows,
+// worth it once the history runs into the millions of meals
+void MacroDatabase_statsParallel(MacroDatabase_t *self, Date_t from, Date_t to, uint32_t threadCount, MacroStats_t *out);
+void MacroDatabase_statsDaysParallel(MacroDatabase_t *self, DayNum_t from, DayNum_t to, uint32_t threadCount, MacroStats_t *out);
+
+// Zone map covering every meal, summarizing the meals added since the last call first. NULL
+// when it can't be allocated, stats then read every row
+const struct __MacroZoneMap_t *MacroDatabase_zones(MacroDatabase_t *self);
+
+// Day/week/month/year totals, kept up to date by every insert once built. The first call
+// scans the meals once, opening a database stays independent of its size. NULL when they can't
+// be allocated, totals then read every row
+const struct __MacroRollup_t *MacroDatabase_rollup(MacroDatabase_t *self);
+// Sums over meals dated within [from, to] from the rollups, independent of the meal count
+void MacroDatabase_totals(MacroDatabase_t *self, Date_t from, Date_t to, MacroTotals_t *out);
+void MacroDatabase_totalsDays(MacroDatabase_t *self, DayNum_t from, DayNum_t to, MacroTotals_t *out);
+
+// SMA/EMA trend lines of the daily totals, kept up to date by every insert once built. A meal
+// only moves the windows that contain its day, series are read in one pass (see MacroTrend_series).
+// NULL when it can't be allocated
+struct __MacroTrend_t *MacroDatabase_trend(MacroDatabase_t *self);
+
+// Sets the targets of every weekday (targets[0] = monday, see MacroGoalTarget_t) and evaluates
+// the history against them. Every insert then re-evaluates its own day and the streaks around it.
+// NULL when the days can't be allocated, a later call tries again
+struct __MacroGoalTarget_t;
+struct __MacroGoals_t *MacroDatabase_setGoals(MacroDatabase_t *self, const struct __MacroGoalTarget_t *targets);
+
+// Level of detail pyramid of the daily totals, kept up to date by every insert once built.
+// Compaction writes it next to the snapshot, opening the database loads it back. NULL when it
+// can't be allocated
+const struct __MacroPyramid_t *MacroDatabase_pyramid(MacroDatabase_t *self);
+
+// Lets other threads read the database while this one keeps writing (see MacroReader_open).
+// Every add and addBatch then publishes a new immutable view, readers pin the latest one and
+// never block the writer, nor the writer them. Call it before starting the readers, and not on
+// a database with frozen rows
+Result_t MacroDatabase_enableViews(MacroDatabase_t *self);
 
-#endif
\ No newline at end of file
+#endif
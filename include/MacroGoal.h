@@ -0,0 +1,73 @@
+#ifndef _H_MACRO_GOAL_
+#define _H_MACRO_GOAL_
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "MacroDatabase.h"
+
+// Targets of one weekday, 0 turns a limit off
+typedef struct __MacroGoalTarget_t {
+  // A day passes within calsTolerance of cals, deficit and surplus are measured against cals
+  uint32_t cals, calsTolerance;
+  uint32_t proteinMin;
+  uint32_t fatMax, carbsMax;
+} MacroGoalTarget_t;
+
+typedef enum __MacroGoalStatus_t {
+  // No meals logged, breaks streaks without counting as failed
+  MACRO_GOAL_NONE = 0,
+  MACRO_GOAL_PASS = 1,
+  MACRO_GOAL_FAIL = 2
+} MacroGoalStatus_t;
+
+typedef struct __MacroGoalSummary_t {
+  uint32_t logged, passed;
+  // Calories under/over the target summed over the logged days
+  uint64_t deficit, surplus;
+} MacroGoalSummary_t;
+
+typedef struct __MacroGoalDay_t {
+  MacroTotals_t totals;
+  uint8_t status;
+  uint64_t deficit, surplus;
+  // Summary of every day up to and including this one
+  MacroGoalSummary_t prefix;
+} MacroGoalDay_t;
+
+// Goal results per day from the first to the last logged day. An add re-evaluates its day and,
+// when the day flips, walks the streaks on either side of it. Streaks are O(1) to read, ranges
+// take two prefix lookups once the days changed since the last one are summed again
+typedef struct __MacroGoals_t {
+  // 0 = monday
+  MacroGoalTarget_t targets[7];
+
+  MacroGoalDay_t *days;
+  DayNum_t firstDay;
+  uint32_t dayCount, _dayCap;
+  // Days from here on have stale prefix summaries
+  uint32_t _prefixDirty;
+
+  // First day of the streak that ends on the last day, dayCount when it doesn't pass
+  uint32_t _streakStart;
+  // Number of passing streaks of every length, up to dayCount
+  uint32_t *_streakCounts;
+  uint32_t longestStreak;
+} MacroGoals_t;
+
+Result_t MacroGoals_init(MacroGoals_t *self, const MacroGoalTarget_t targets[7]);
+void MacroGoals_cleanup(MacroGoals_t *self);
+
+void MacroGoals_add(MacroGoals_t *self, DayNum_t day, const Macro_t *macro);
+// Builds the days from every meal of db (frozen ones included), self has to be empty
+void MacroGoals_build(MacroGoals_t *self, const MacroDatabase_t *db);
+// Evaluates every day again against new targets
+void MacroGoals_setTargets(MacroGoals_t *self, const MacroGoalTarget_t targets[7]);
+
+MacroGoalStatus_t MacroGoals_status(const MacroGoals_t *self, DayNum_t day);
+// Passing days in a row up to the last logged day
+uint32_t MacroGoals_currentStreak(const MacroGoals_t *self);
+// Summary of the days within [from, to]
+void MacroGoals_summary(MacroGoals_t *self, DayNum_t from, DayNum_t to, MacroGoalSummary_t *out);
+
+#endif
@@ -0,0 +1,56 @@
+#ifndef _H_MACRO_IMPORT_
+#define _H_MACRO_IMPORT_
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#define WIN32_LEAN_AND_MEAN
+#include <Windows.h>
+
+#include "Common.h"
+#include "MacroDatabase.h"
+
+// CSV rows are date,cals,protein,fat,carbs (a header line is skipped), fields may be quoted as
+// in RFC 4180. JSON is an array or a stream of flat objects with "date", "cals", "protein",
+// "fat" and "carbs" members. Dates are ISO-8601 (YYYY-MM-DD, a time part is ignored)
+typedef enum __MacroImportFormat_t {
+  MACRO_IMPORT_CSV = 0,
+  MACRO_IMPORT_JSON = 1
+} MacroImportFormat_t;
+
+typedef struct __MacroImportInfo_t {
+  MacroImportFormat_t format;
+  // Parser threads, 0 = one per logical processor
+  uint32_t threadCount;
+  // Bytes parsed per task, also the longest record accepted
+  uint32_t chunkSize;
+} MacroImportInfo_t;
+
+#define MACRO_IMPORT_INFO_INIT (MacroImportInfo_t) { \
+    .format = MACRO_IMPORT_CSV,                      \
+    .threadCount = 0,                                \
+    .chunkSize = 1 << 22,                            \
+  }
+
+typedef struct __MacroImportStats_t {
+  uint64_t bytes;
+  // Records parsed, then how many of them Meal_validate let in
+  uint64_t rows;
+  uint64_t added;
+  // Records that couldn't be parsed
+  uint64_t malformed;
+} MacroImportStats_t;
+
+// Streams path into db: the reader cuts the file into chunks on record boundaries, workers
+// parse them in parallel and the chunks are added in file order with MacroDatabase_addBatch.
+// Memory stays at 2 chunks (plus their parsed meals) per thread whatever the file size
+Result_t MacroImport_file(MacroDatabase_t *db, const char *path, const MacroImportInfo_t *info, MacroImportStats_t *stats);
+
+// Parses one chunk of whole records, returns the number of meals written to out (sized
+// MACRO_IMPORT_MAX_MEALS(size)) and counts the records it had to skip in malformed
+uint32_t MacroImport_parse(MacroImportFormat_t format, const char *data, uint32_t size, Meal_t *out, uint32_t *malformed);
+
+// Shortest possible record is "1970-01-01,0,0,0,0\n"
+#define MACRO_IMPORT_MAX_MEALS(size) ((size) / 16 + 1)
+
+#endif
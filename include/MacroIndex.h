@@ -0,0 +1,69 @@
+#ifndef _H_MACRO_INDEX_
+#define _H_MACRO_INDEX_
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "Common.h"
+
+// Packed date - days since 1970/1/1
+typedef uint32_t DayNum_t;
+
+#define DAY_NUM_MIN ((DayNum_t)0)
+#define DAY_NUM_MAX ((DayNum_t)UINT32_MAX)
+
+// Blocked sorted runs: every block is sorted by day, blocks are ordered by their
+// first day (fence) - a lookup is a binary search over the fences and one inside a block
+#define MACRO_INDEX_BLOCK_CAP (1 << 8)
+
+typedef struct __MacroIndexBlock_t {
+  uint32_t count;
+  DayNum_t days[MACRO_INDEX_BLOCK_CAP];
+  uint32_t rows[MACRO_INDEX_BLOCK_CAP];
+} MacroIndexBlock_t;
+
+typedef struct __MacroIndex_t {
+  // Sorted run loaded with a snapshot (not owned, usually mapped), the blocks hold
+  // every row inserted after it - lookups merge the two
+  const DayNum_t *baseDays;
+  const uint32_t *baseRows;
+  uint32_t baseCount;
+
+  MacroIndexBlock_t **blocks;
+  DayNum_t *fences;
+  uint32_t blockCount, _blockCap;
+
+  uint32_t rowCount;
+} MacroIndex_t;
+
+// Contiguous run of index entries sharing one block, rows[i] is the meal row of days[i]
+typedef struct __MacroSpan_t {
+  const DayNum_t *days;
+  const uint32_t *rows;
+  uint32_t count;
+} MacroSpan_t;
+
+typedef struct __MacroIndexRange_t {
+  const MacroIndex_t *_index;
+  uint32_t _block, _pos;
+  uint32_t _basePos, _baseEnd;
+  DayNum_t _to;
+} MacroIndexRange_t;
+
+Result_t MacroIndex_init(MacroIndex_t *self);
+void MacroIndex_cleanup(MacroIndex_t *self);
+// Meals may arrive in any order, equal days keep their insertion order
+void MacroIndex_insert(MacroIndex_t *self, DayNum_t day, uint32_t row);
+// Rows firstRow + i for days[i], sorted stretches past the last block are appended in bulk
+void MacroIndex_insertBatch(MacroIndex_t *self, const DayNum_t *days, uint32_t firstRow, uint32_t count);
+// Has to be set before anything is inserted, arrays must outlive the index
+void MacroIndex_setBase(MacroIndex_t *self, const DayNum_t *days, const uint32_t *rows, uint32_t count);
+
+// O(log n) positioning, every MacroIndexRange_next is O(1) amortized per span
+void MacroIndex_range(const MacroIndex_t *self, DayNum_t from, DayNum_t to, MacroIndexRange_t *out);
+bool MacroIndexRange_next(MacroIndexRange_t *self, MacroSpan_t *span);
+uint32_t MacroIndex_count(const MacroIndex_t *self, DayNum_t from, DayNum_t to);
+// First and last day indexed in O(1), false when the index is empty
+bool MacroIndex_bounds(const MacroIndex_t *self, DayNum_t *first, DayNum_t *last);
+
+#endif
@@ -0,0 +1,71 @@
+#ifndef _H_MACRO_KERNEL_
+#define _H_MACRO_KERNEL_
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+
+#include "MacroDatabase.h"
+
+typedef enum __MacroKernelIsa_t {
+  MACRO_KERNEL_ISA_SCALAR = 0,
+  MACRO_KERNEL_ISA_SSE2 = 1,
+  MACRO_KERNEL_ISA_AVX2 = 2
+} MacroKernelIsa_t;
+
+// Partial results, merge them with MacroStats_merge before finalizing
+// min has to start at UINT32_MAX, use MacroStats_reset
+void MacroStats_reset(MacroStats_t *self);
+void MacroStats_merge(MacroStats_t *self, const MacroStats_t *other);
+void MacroStats_finalize(MacroStats_t *self);
+
+// Accumulates sum/min/max/count of every column for rows with from <= days[i] <= to
+typedef void(*MacroKernelReduceFn_t)(
+  const uint32_t *const columns[MACRO_COLUMN_COUNT], const DayNum_t *days,
+  size_t count, DayNum_t from, DayNum_t to, MacroStats_t *acc
+);
+
+void MacroKernel_reduceScalar(const uint32_t *const columns[MACRO_COLUMN_COUNT],
+  const DayNum_t *days, size_t count, DayNum_t from, DayNum_t to, MacroStats_t *acc);
+void MacroKernel_reduceSSE2(const uint32_t *const columns[MACRO_COLUMN_COUNT],
+  const DayNum_t *days, size_t count, DayNum_t from, DayNum_t to, MacroStats_t *acc);
+void MacroKernel_reduceAVX2(const uint32_t *const columns[MACRO_COLUMN_COUNT],
+  const DayNum_t *days, size_t count, DayNum_t from, DayNum_t to, MacroStats_t *acc);
+
+// Meal_validate over a whole batch, bit i of rejectMask (LSB first) is set for every meal
+// that fails. rejectMask holds (count + 7) / 8 bytes, returns the number of rejected meals
+typedef size_t(*MacroKernelValidateFn_t)(const Meal_t *meals, size_t count, uint8_t *rejectMask);
+
+size_t MacroKernel_validateScalar(const Meal_t *meals, size_t count, uint8_t *rejectMask);
+size_t MacroKernel_validateSSE2(const Meal_t *meals, size_t count, uint8_t *rejectMask);
+size_t MacroKernel_validateAVX2(const Meal_t *meals, size_t count, uint8_t *rejectMask);
+
+// Bit-packed blocks (see MacroPack.h) hold MACRO_PACK_BLOCK_ROWS values of `bits` bits in
+// 4 interleaved lanes: value i is the (i / 4)th value of lane i % 4, lane l owns every
+// word packed[4 * k + l]. A block takes 4 * bits words
+#define MACRO_PACK_BLOCK_ROWS 128
+#define MACRO_PACK_LANES 4
+
+typedef void(*MacroKernelUnpackFn_t)(const uint32_t *packed, uint32_t bits, uint32_t *out);
+typedef uint64_t(*MacroKernelSumPackedFn_t)(const uint32_t *packed, uint32_t bits);
+
+void MacroKernel_pack(const uint32_t *values, uint32_t bits, uint32_t *packed);
+void MacroKernel_unpackScalar(const uint32_t *packed, uint32_t bits, uint32_t *out);
+void MacroKernel_unpackSSE2(const uint32_t *packed, uint32_t bits, uint32_t *out);
+// Sum of a packed block without writing the values out
+uint64_t MacroKernel_sumPackedScalar(const uint32_t *packed, uint32_t bits);
+uint64_t MacroKernel_sumPackedSSE2(const uint32_t *packed, uint32_t bits);
+
+// Picks the widest instruction set the cpu supports, exactly once however many threads call
+// it. MacroDatabase_create runs it so the kernels are resolved before any worker or reader
+void MacroKernel_init();
+MacroKernelIsa_t MacroKernel_isa();
+// Overrides the instruction set, for benchmarks and tests before any thread runs a kernel
+void MacroKernel_setIsa(MacroKernelIsa_t isa);
+void MacroKernel_reduce(const uint32_t *const columns[MACRO_COLUMN_COUNT],
+  const DayNum_t *days, size_t count, DayNum_t from, DayNum_t to, MacroStats_t *acc);
+size_t MacroKernel_validate(const Meal_t *meals, size_t count, uint8_t *rejectMask);
+void MacroKernel_unpack(const uint32_t *packed, uint32_t bits, uint32_t *out);
+uint64_t MacroKernel_sumPacked(const uint32_t *packed, uint32_t bits);
+
+#endif
@@ -0,0 +1,72 @@
+#ifndef _H_MACRO_LOG_
+#define _H_MACRO_LOG_
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#define WIN32_LEAN_AND_MEAN
+#include <Windows.h>
+
+#include "Common.h"
+#include "MacroIndex.h"
+
+// Fixed size write-ahead log record, checksum covers every byte before it
+typedef struct __MacroLogRecord_t {
+  uint64_t sequence;
+  DayNum_t day;
+  uint32_t cals, protein, fat, carbs;
+  uint32_t checksum;
+} MacroLogRecord_t;
+
+typedef struct __MacroLogInfo_t {
+  // Group commit window, appends inside of it share one FlushFileBuffers (0 = sync every commit)
+  uint32_t syncIntervalMs;
+  // Records kept in the log before they get compacted into the snapshot (0 = never)
+  uint32_t compactThreshold;
+} MacroLogInfo_t;
+
+#define MACRO_LOG_INFO_INIT (MacroLogInfo_t) { \
+    .syncIntervalMs = 50,                      \
+    .compactThreshold = 1 << 22,               \
+  }
+
+#define MACRO_LOG_BUFFER_RECORDS (1 << 11)
+
+typedef struct __MacroLog_t {
+  HANDLE _file;
+  MacroLogInfo_t info;
+
+  MacroLogRecord_t *_buffer;
+  uint32_t _bufferCount;
+
+  uint64_t nextSequence;
+  // Records in the log file, including the buffered ones
+  uint64_t recordCount;
+
+  uint64_t _lastSyncTick;
+  bool _unsynced;
+} MacroLog_t;
+
+typedef void(*MacroLogReplayCBCK_t)(void *, const MacroLogRecord_t *);
+
+uint32_t MacroLog_checksum(const void *data, size_t size);
+
+Result_t MacroLog_open(MacroLog_t *self, const char *path, const MacroLogInfo_t *info);
+void MacroLog_close(MacroLog_t *self);
+
+// Replays records with sequence >= fromSequence, stops at (and truncates) the first torn record
+Result_t MacroLog_recover(MacroLog_t *self, uint64_t fromSequence, MacroLogReplayCBCK_t onRecord, void *ctx);
+
+// Buffers the record, it is written on commit and durable once a later append or poll finds
+// the sync window elapsed. Only fails when the record wasn't buffered, while a full buffer
+// can't be written. Write and sync failures after that come from commit, sync and poll
+Result_t MacroLog_append(MacroLog_t *self, MacroLogRecord_t record);
+// Syncs what was appended once the window elapsed, call it regularly so an idle log still
+// gets its last records to disk (MacroLog_close syncs the rest)
+Result_t MacroLog_poll(MacroLog_t *self);
+Result_t MacroLog_commit(MacroLog_t *self);
+Result_t MacroLog_sync(MacroLog_t *self);
+// Drops every record, used once they are part of a snapshot
+Result_t MacroLog_truncate(MacroLog_t *self);
+
+#endif
@@ -0,0 +1,25 @@
+#ifndef _H_MACRO_MORSEL_
+#define _H_MACRO_MORSEL_
+
+#include <stdint.h>
+
+#include "Common.h"
+
+// Rows per morsel, small enough to even out the workers near the end of a scan and large
+// enough that pulling the next one is noise. A multiple of MACRO_QUERY_BATCH_ROWS
+#define MACRO_MORSEL_ROWS (1u << 16)
+
+// Called for rows [first, first + count) by worker (0 = the calling thread). A worker only
+// ever touches its own partial results, they're merged once every morsel is done. Keep the
+// running totals of a morsel in locals, partials written once per morsel don't false share
+typedef void(*MacroMorselFn_t)(void *ctx, uint32_t worker, uint32_t first, uint32_t count);
+
+// One per logical processor when requested is 0
+uint32_t MacroMorsel_threadCount(uint32_t requested);
+
+// Cuts [0, rowCount) into morsels that threadCount workers pull from a shared counter until
+// it runs out, returns once all of them ran. Fails when a thread couldn't be started, the
+// workers that did start (the calling thread at least) still cover every morsel
+Result_t MacroMorsel_run(uint32_t rowCount, uint32_t threadCount, MacroMorselFn_t fn, void *ctx);
+
+#endif
@@ -0,0 +1,59 @@
+#ifndef _H_MACRO_PACK_
+#define _H_MACRO_PACK_
+
+#include <stdint.h>
+#include <stddef.h>
+
+#include "MacroDatabase.h"
+#include "MacroKernel.h"
+
+// Days are the last packed stream of a block
+#define MACRO_PACK_STREAM_DAYS MACRO_COLUMN_COUNT
+#define MACRO_PACK_STREAM_COUNT (MACRO_COLUMN_COUNT + 1)
+
+// MACRO_PACK_BLOCK_ROWS meal rows in row (arrival) order. Columns are frame of reference coded
+// (value - min), days too (day - minDay) since arrival order isn't day order. Every stream is
+// bit-packed at its own width, a history logged day by day packs its days in a few bits
+typedef struct __MacroPackBlock_t {
+  DayNum_t minDay, maxDay;
+  uint32_t min[MACRO_COLUMN_COUNT];
+  uint32_t max[MACRO_COLUMN_COUNT];
+  uint8_t bits[MACRO_PACK_STREAM_COUNT];
+  // First word of the block in MacroPack_t.words, streams follow each other in stream order
+  uint32_t offset;
+} MacroPackBlock_t;
+
+// Packed rows [0, mealCount) of a database, the cold tier behind MacroDatabase_freeze.
+// Row r lives in block r / MACRO_PACK_BLOCK_ROWS, rows are only ever appended in whole blocks
+typedef struct __MacroPack_t {
+  MacroPackBlock_t *blocks;
+  uint32_t blockCount, _blockCap;
+
+  uint32_t *words;
+  uint32_t wordCount, _wordCap;
+
+  uint32_t mealCount;
+} MacroPack_t;
+
+void MacroPack_init(MacroPack_t *self);
+void MacroPack_cleanup(MacroPack_t *self);
+// Packs count rows (a multiple of MACRO_PACK_BLOCK_ROWS) after the ones self holds
+Result_t MacroPack_append(MacroPack_t *self, const uint32_t *const columns[MACRO_COLUMN_COUNT],
+  const DayNum_t *days, uint32_t count);
+// Bytes held by the blocks and the packed words
+size_t MacroPack_size(const MacroPack_t *self);
+
+// Unpacks rows [first, first + count) into columns and days
+void MacroPack_decode(const MacroPack_t *self, uint32_t first, uint32_t count,
+  uint32_t *const columns[MACRO_COLUMN_COUNT], DayNum_t *days);
+// One row, without unpacking the rest of its block
+void MacroPack_get(const MacroPack_t *self, uint32_t row, Macro_t *macro, DayNum_t *day);
+
+// MacroKernel_reduce over rows [first, first + count). Blocks outside [from, to] are skipped,
+// blocks inside it are summed while unpacking and take min/max from their header
+void MacroPack_reduce(const MacroPack_t *self, uint32_t first, uint32_t count,
+  DayNum_t from, DayNum_t to, MacroStats_t *acc);
+// Same results as MacroDatabase_statsDays over every packed row
+void MacroPack_stats(const MacroPack_t *self, DayNum_t from, DayNum_t to, MacroStats_t *out);
+
+#endif
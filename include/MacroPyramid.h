@@ -0,0 +1,69 @@
+#ifndef _H_MACRO_PYRAMID_
+#define _H_MACRO_PYRAMID_
+
+#include <stdint.h>
+
+#include "Common.h"
+#include "MacroDatabase.h"
+
+// Level k buckets 2^k days, the top one spans about 90 years
+#define MACRO_PYRAMID_LEVELS 16
+
+#define MACRO_PYRAMID_MAGIC 0x444F4C4Du // "MLOD"
+#define MACRO_PYRAMID_VERSION 1
+
+// Daily totals of one column over a bucket, min/max only mean something when days > 0
+typedef struct __MacroPyramidBucket_t {
+  uint64_t sum;
+  uint32_t min, max;
+  // Days with meals
+  uint32_t days;
+} MacroPyramidBucket_t;
+
+// Dense like the rollup tables, buckets [firstKey, firstKey + count) with key = day >> level
+typedef struct __MacroPyramidLevel_t {
+  MacroPyramidBucket_t *columns[MACRO_COLUMN_COUNT];
+  uint32_t firstKey;
+  uint32_t count, _capacity;
+} MacroPyramidLevel_t;
+
+// Min/max/sum pyramid for charts, a chart reads the coarsest level that still gives it a bucket
+// per pixel instead of the days or meals behind it. An add updates one bucket per level
+typedef struct __MacroPyramid_t {
+  MacroPyramidLevel_t levels[MACRO_PYRAMID_LEVELS];
+} MacroPyramid_t;
+
+// File header, followed by the buckets of every level and column in that order. Only valid
+// next to the snapshot with the same mealCount and nextSequence
+typedef struct __MacroPyramidHeader_t {
+  uint32_t magic;
+  uint32_t version;
+  uint32_t mealCount;
+  uint32_t _reserved;
+  uint64_t nextSequence;
+  uint32_t firstKeys[MACRO_PYRAMID_LEVELS];
+  uint32_t counts[MACRO_PYRAMID_LEVELS];
+  // MacroLog_checksum of the buckets, then of every byte before checksum
+  uint32_t bucketChecksum;
+  uint32_t checksum;
+} MacroPyramidHeader_t;
+
+Result_t MacroPyramid_init(MacroPyramid_t *self);
+void MacroPyramid_cleanup(MacroPyramid_t *self);
+
+void MacroPyramid_add(MacroPyramid_t *self, DayNum_t day, const Macro_t *macro);
+// Builds every level from the meals of db in one pass each, self has to be empty
+void MacroPyramid_build(MacroPyramid_t *self, const MacroDatabase_t *db);
+
+// Buckets of column over [from, to] at the finest level that needs at most maxBuckets of them.
+// Bucket i covers days [((from >> level) + i) << level, ((from >> level) + i + 1) << level),
+// returns how many were written to out
+uint32_t MacroPyramid_series(const MacroPyramid_t *self, MacroColumn_t column, DayNum_t from, DayNum_t to,
+  uint32_t maxBuckets, MacroPyramidBucket_t *out, uint32_t *level);
+
+// Written next to path and renamed over it
+Result_t MacroPyramid_write(const MacroPyramid_t *self, const char *path, uint32_t mealCount, uint64_t nextSequence);
+// Reads the pyramid into an empty self, fails when it's missing or belongs to another snapshot
+Result_t MacroPyramid_read(MacroPyramid_t *self, const char *path, uint32_t mealCount, uint64_t nextSequence);
+
+#endif
@@ -0,0 +1,132 @@
+#ifndef _H_MACRO_QUERY_
+#define _H_MACRO_QUERY_
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "Common.h"
+#include "MacroDatabase.h"
+#include "MacroZone.h"
+
+// Queries read like
+//   from days where protein < 120 and cals > 2500 group by weekday select count, avg(cals)
+// every clause is optional and they come in this order:
+//   from meals | days        rows are meals (default) or per day totals of the days with meals
+//   where <expr>             <operand> <|<=|>|>=|=|!= <value>, combined with and, or, not, ( )
+//                            operands: cals protein fat carbs date weekday, values: integers,
+//                            YYYY-MM-DD dates and mon..sun
+//   group by day | week | month | year | weekday
+//   select <aggregate>, ...  count, sum(x), avg(x), min(x), max(x) of a macro, default count
+// Keywords are case insensitive
+
+#define MACRO_QUERY_MAX_PREDICATES 16
+#define MACRO_QUERY_MAX_PROGRAM (MACRO_QUERY_MAX_PREDICATES * 3)
+#define MACRO_QUERY_MAX_SELECT 8
+// Nots and parentheses the where clause can be nested in, deeper parses fail
+#define MACRO_QUERY_MAX_NESTING 32
+// Rows per column batch, every operator works on a whole batch before the next one runs.
+// A meal batch is one zone, the where clause is tried on the zone's ranges first and batches
+// it can't match aren't read (see MacroDatabase_zones for the counts)
+#define MACRO_QUERY_BATCH_ROWS MACRO_ZONE_ROWS
+
+typedef enum __MacroQuerySource_t {
+  MACRO_QUERY_SOURCE_MEALS = 0,
+  MACRO_QUERY_SOURCE_DAYS = 1
+} MacroQuerySource_t;
+
+typedef enum __MacroQueryGroup_t {
+  MACRO_QUERY_GROUP_NONE = 0,
+  MACRO_QUERY_GROUP_DAY = 1,
+  MACRO_QUERY_GROUP_WEEK = 2,
+  MACRO_QUERY_GROUP_MONTH = 3,
+  MACRO_QUERY_GROUP_YEAR = 4,
+  MACRO_QUERY_GROUP_WEEKDAY = 5
+} MacroQueryGroup_t;
+
+// Operands past the macro columns
+#define MACRO_QUERY_OPERAND_DATE MACRO_COLUMN_COUNT
+#define MACRO_QUERY_OPERAND_WEEKDAY (MACRO_COLUMN_COUNT + 1)
+
+typedef enum __MacroQueryCompare_t {
+  MACRO_QUERY_LT = 0,
+  MACRO_QUERY_LE = 1,
+  MACRO_QUERY_GT = 2,
+  MACRO_QUERY_GE = 3,
+  MACRO_QUERY_EQ = 4,
+  MACRO_QUERY_NE = 5
+} MacroQueryCompare_t;
+
+typedef struct __MacroQueryPredicate_t {
+  uint8_t operand;
+  uint8_t compare;
+  // Day number for dates, 0 = monday for weekdays
+  uint32_t value;
+} MacroQueryPredicate_t;
+
+typedef enum __MacroQueryOpcode_t {
+  MACRO_QUERY_OP_PREDICATE = 0,
+  MACRO_QUERY_OP_AND = 1,
+  MACRO_QUERY_OP_OR = 2,
+  MACRO_QUERY_OP_NOT = 3
+} MacroQueryOpcode_t;
+
+// The where clause in postfix order, run over a stack of batch wide masks
+typedef struct __MacroQueryOp_t {
+  uint8_t opcode;
+  uint8_t predicate;
+} MacroQueryOp_t;
+
+typedef enum __MacroQueryAggregate_t {
+  MACRO_QUERY_COUNT = 0,
+  MACRO_QUERY_SUM = 1,
+  MACRO_QUERY_AVG = 2,
+  MACRO_QUERY_MIN = 3,
+  MACRO_QUERY_MAX = 4
+} MacroQueryAggregate_t;
+
+typedef struct __MacroQuerySelect_t {
+  uint8_t aggregate;
+  uint8_t column;
+} MacroQuerySelect_t;
+
+typedef struct __MacroQuery_t {
+  MacroQuerySource_t source;
+
+  MacroQueryPredicate_t predicates[MACRO_QUERY_MAX_PREDICATES];
+  uint32_t predicateCount;
+  MacroQueryOp_t program[MACRO_QUERY_MAX_PROGRAM];
+  uint32_t programLength;
+  // Deepest the mask stack gets while running program
+  uint32_t _stackDepth;
+
+  MacroQueryGroup_t group;
+
+  MacroQuerySelect_t select[MACRO_QUERY_MAX_SELECT];
+  uint32_t selectCount;
+  // Bit per macro column the aggregates read
+  uint32_t _columnMask;
+} MacroQuery_t;
+
+// One group, values follow the order of the select clause
+typedef struct __MacroQueryRow_t {
+  // Day number, weeks since 1969/12/29, year * 12 + month - 1, year, 0 = monday, 0 ungrouped
+  uint32_t key;
+  uint32_t count;
+  double values[MACRO_QUERY_MAX_SELECT];
+} MacroQueryRow_t;
+
+typedef struct __MacroQueryResult_t {
+  // Groups that got rows, in key order. An ungrouped query always has its one row
+  MacroQueryRow_t *rows;
+  uint32_t rowCount;
+} MacroQueryResult_t;
+
+// Parses text into self, logs where and why it failed otherwise
+Result_t MacroQuery_compile(MacroQuery_t *self, const char *text);
+Result_t MacroQuery_run(const MacroQuery_t *self, MacroDatabase_t *db, MacroQueryResult_t *out);
+// Same over threadCount threads (0 = one per logical processor), each aggregating the morsels
+// it pulls into groups of its own that are merged at the end
+Result_t MacroQuery_runParallel(const MacroQuery_t *self, MacroDatabase_t *db, uint32_t threadCount, MacroQueryResult_t *out);
+void MacroQueryResult_cleanup(MacroQueryResult_t *self);
+
+#endif
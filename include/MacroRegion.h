@@ -0,0 +1,41 @@
+#ifndef _H_MACRO_REGION_
+#define _H_MACRO_REGION_
+
+#include <stdint.h>
+
+#define WIN32_LEAN_AND_MEAN
+#include <Windows.h>
+
+#include "Common.h"
+
+// Windows allocation granularity, file views and reservations have to start on it
+#define MACRO_REGION_GRANULARITY (1ull << 16)
+#define MACRO_REGION_COMMIT_STEP (1ull << 20)
+#define MACRO_REGION_PAGE (1ull << 12)
+
+#define ALIGN_UP(x, alignment) (((x) + (alignment) - 1) & ~((uint64_t)(alignment) - 1))
+
+// Reserved address range that grows in place, pointers into it never move.
+// The front may be a copy-on-write view of a file, the rest is committed on demand
+typedef struct __MacroRegion_t {
+  uint8_t *base;
+  uint64_t reserved;
+  // Bytes backed by the file view (multiple of MACRO_REGION_GRANULARITY)
+  uint64_t mapped;
+  // Bytes usable from base, mapped ones included
+  uint64_t committed;
+  // Bytes from base whose pages were given back (see MacroRegion_discard)
+  uint64_t discarded;
+} MacroRegion_t;
+
+Result_t MacroRegion_reserve(MacroRegion_t *self, uint64_t reserveBytes);
+// Copy-on-write view of mapping [offset, offset + viewBytes) followed by anonymous memory
+Result_t MacroRegion_reserveMapped(MacroRegion_t *self, HANDLE mapping,
+  uint64_t offset, uint64_t viewBytes, uint64_t reserveBytes);
+Result_t MacroRegion_commit(MacroRegion_t *self, uint64_t bytes);
+// Gives back the physical pages of [0, bytes) (whole pages only), the range stays reserved and
+// counted as committed but must not be touched again. Mapped pages only leave the working set
+void MacroRegion_discard(MacroRegion_t *self, uint64_t bytes);
+void MacroRegion_release(MacroRegion_t *self);
+
+#endif
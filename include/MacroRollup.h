@@ -0,0 +1,43 @@
+#ifndef _H_MACRO_ROLLUP_
+#define _H_MACRO_ROLLUP_
+
+#include <stdint.h>
+
+#include "MacroDatabase.h"
+
+// Calendar buckets, weeks are ISO weeks (Monday to Sunday)
+typedef enum __MacroRollupLevel_t {
+  MACRO_ROLLUP_DAY = 0,
+  MACRO_ROLLUP_WEEK = 1,
+  MACRO_ROLLUP_MONTH = 2,
+  MACRO_ROLLUP_YEAR = 3,
+  MACRO_ROLLUP_LEVEL_COUNT = 4
+} MacroRollupLevel_t;
+
+// Dense bucket table, keys[firstKey, firstKey + count) are all present (empty ones are zero)
+typedef struct __MacroRollupTable_t {
+  MacroTotals_t *buckets;
+  uint32_t firstKey;
+  uint32_t count, _capacity;
+} MacroRollupTable_t;
+
+// Per level totals kept up to date by every insert/remove, O(1) per level
+typedef struct __MacroRollup_t {
+  MacroRollupTable_t levels[MACRO_ROLLUP_LEVEL_COUNT];
+} MacroRollup_t;
+
+Result_t MacroRollup_init(MacroRollup_t *self);
+void MacroRollup_cleanup(MacroRollup_t *self);
+
+void MacroRollup_add(MacroRollup_t *self, DayNum_t day, const Macro_t *macro);
+// Undoes a MacroRollup_add of the same meal, for deletes and updates
+void MacroRollup_remove(MacroRollup_t *self, DayNum_t day, const Macro_t *macro);
+
+// Key of the bucket holding day: day number, weeks since 1969/12/29, year * 12 + month - 1, year
+uint32_t MacroRollup_key(MacroRollupLevel_t level, DayNum_t day);
+// Totals of the level's bucket that contains day
+void MacroRollup_bucket(const MacroRollup_t *self, MacroRollupLevel_t level, DayNum_t day, MacroTotals_t *out);
+// Totals over [from, to] made of the biggest buckets that fit, a few dozen lookups plus one per year
+void MacroRollup_range(const MacroRollup_t *self, DayNum_t from, DayNum_t to, MacroTotals_t *out);
+
+#endif
@@ -0,0 +1,39 @@
+#ifndef _H_MACRO_SNAPSHOT_
+#define _H_MACRO_SNAPSHOT_
+
+#include <stdint.h>
+
+#include "Common.h"
+#include "MacroDatabase.h"
+#include "MacroRegion.h"
+
+#define MACRO_SNAPSHOT_MAGIC 0x504E534Du // "MSNP"
+#define MACRO_SNAPSHOT_VERSION 2
+// Sections start on the allocation granularity so every one of them can be mapped in place
+#define MACRO_SNAPSHOT_ALIGNMENT MACRO_REGION_GRANULARITY
+
+// Header padded to MACRO_SNAPSHOT_ALIGNMENT, followed by MACRO_DATABASE_REGION_COUNT sections
+// in region order (columns, days, index days, index rows), each mealCount uint32_t long and
+// zero padded to the alignment
+typedef struct __MacroSnapshotHeader_t {
+  uint32_t magic;
+  uint32_t version;
+  uint32_t mealCount;
+  uint32_t alignment;
+  // First write-ahead log sequence that isn't part of the snapshot
+  uint64_t nextSequence;
+  uint32_t _reserved;
+  // MacroLog_checksum of every byte before it
+  uint32_t checksum;
+} MacroSnapshotHeader_t;
+
+// Written next to the destination and renamed over it, a crash leaves the old snapshot intact.
+// A mapped destination is moved aside first and deleted once its last view goes away
+Result_t MacroSnapshot_write(MacroDatabase_t *db, const char *path, uint64_t nextSequence);
+// Reads the snapshot into an empty db, a missing file is an empty snapshot
+Result_t MacroSnapshot_read(MacroDatabase_t *db, const char *path, uint64_t *nextSequence);
+// Same as MacroSnapshot_read but maps the sections copy-on-write instead of reading them,
+// pages are faulted in by the first query that touches them
+Result_t MacroSnapshot_map(MacroDatabase_t *db, const char *path, uint64_t *nextSequence);
+
+#endif
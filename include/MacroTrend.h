@@ -0,0 +1,53 @@
+#ifndef _H_MACRO_TREND_
+#define _H_MACRO_TREND_
+
+#include <stdint.h>
+
+#include "MacroDatabase.h"
+
+// Trend lines over the daily totals. Moving averages are per logged day, days without meals
+// in the window don't pull the average down. The EMA only moves on logged days too
+typedef enum __MacroTrendLine_t {
+  MACRO_TREND_SMA_7 = 0,
+  MACRO_TREND_SMA_30 = 1,
+  MACRO_TREND_EMA = 2,
+  MACRO_TREND_LINE_COUNT = 3
+} MacroTrendLine_t;
+
+// The moving average lines come first
+#define MACRO_TREND_WINDOW_COUNT 2
+// Span of the EMA, alpha = 2 / (span + 1)
+#define MACRO_TREND_EMA_DAYS 14
+
+typedef struct __MacroTrendDay_t {
+  MacroTotals_t totals;
+  // Sums and logged days of the windows ending on this day
+  uint64_t window[MACRO_TREND_WINDOW_COUNT][MACRO_COLUMN_COUNT];
+  uint32_t windowDays[MACRO_TREND_WINDOW_COUNT];
+  double ema[MACRO_COLUMN_COUNT];
+} MacroTrendDay_t;
+
+// Dense table from the first to the last logged day, window sums are kept up to date by every
+// add (O(window)), the EMA is caught up from the earliest changed day by the next series
+typedef struct __MacroTrend_t {
+  MacroTrendDay_t *days;
+  DayNum_t firstDay;
+  uint32_t dayCount, _dayCap;
+  // Days from here on have a stale EMA
+  uint32_t _emaDirty;
+} MacroTrend_t;
+
+Result_t MacroTrend_init(MacroTrend_t *self);
+void MacroTrend_cleanup(MacroTrend_t *self);
+
+void MacroTrend_add(MacroTrend_t *self, DayNum_t day, const Macro_t *macro);
+// Builds the table from every meal of db (frozen ones included), self has to be empty
+void MacroTrend_build(MacroTrend_t *self, const MacroDatabase_t *db);
+
+// Days of the window behind an SMA line
+uint32_t MacroTrend_windowDays(MacroTrendLine_t line);
+// Value of line for column on every day of [from, to] into out (to - from + 1 values), one
+// sequential pass. Days before the first logged one are 0, later days slide over empty days
+void MacroTrend_series(MacroTrend_t *self, MacroTrendLine_t line, MacroColumn_t column, DayNum_t from, DayNum_t to, float *out);
+
+#endif
@@ -0,0 +1,109 @@
+#ifndef _H_MACRO_VIEW_
+#define _H_MACRO_VIEW_
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#define WIN32_LEAN_AND_MEAN
+#include <Windows.h>
+
+#include "Common.h"
+#include "MacroDatabase.h"
+
+// Reader threads that can hold a view at the same time
+#define MACRO_VIEW_MAX_READERS 64
+
+// Day totals are kept in pages of this many days, a write copies the page it lands in once
+// per publish when a view still holds it
+#define MACRO_VIEW_PAGE_SHIFT 7
+#define MACRO_VIEW_PAGE_DAYS (1u << MACRO_VIEW_PAGE_SHIFT)
+
+typedef struct __MacroViewPage_t {
+  MacroTotals_t days[MACRO_VIEW_PAGE_DAYS];
+  // Writer only, version of the view the page was made for. Published pages are older than
+  // the next version, a publish doesn't have to touch them to mark them
+  uint64_t version;
+} MacroViewPage_t;
+
+// Immutable state of the database as of one publish. Meal rows are append-only in regions
+// that never move, so a view shares them and only remembers how many there were
+typedef struct __MacroView_t {
+  const uint32_t *columns[MACRO_COLUMN_COUNT];
+  const DayNum_t *days;
+  uint32_t mealCount;
+  // Publishes so far, including this one
+  uint64_t version;
+
+  // Day totals, page i holds days [(firstPage + i) * MACRO_VIEW_PAGE_DAYS, ...), NULL when empty
+  uint32_t firstPage, pageCount;
+  const MacroViewPage_t *pages[];
+} MacroView_t;
+
+Meal_t MacroView_getMeal(const MacroView_t *self, uint32_t index);
+// Same results as MacroDatabase_statsDays/totalsDays over the meals of the view
+void MacroView_statsDays(const MacroView_t *self, DayNum_t from, DayNum_t to, MacroStats_t *out);
+void MacroView_totalsDays(const MacroView_t *self, DayNum_t from, DayNum_t to, MacroTotals_t *out);
+
+typedef struct __MacroViewSlot_t {
+  // MACRO_VIEW_SLOT_FREE, MACRO_VIEW_SLOT_IDLE or the epoch the reader pinned at
+  volatile LONG64 epoch;
+  // One reader per cache line, pins don't bounce each other's lines
+  uint8_t _padding[64 - sizeof(LONG64)];
+} MacroViewSlot_t;
+
+#define MACRO_VIEW_SLOT_FREE 0
+#define MACRO_VIEW_SLOT_IDLE 1
+
+// A view published by the writer together with the pages only it still held, freed once
+// every reader pinned at or before epoch has let go
+typedef struct __MacroViewRetired_t {
+  MacroView_t *view;
+  MacroViewPage_t **pages;
+  uint32_t pageCount;
+  LONG64 epoch;
+} MacroViewRetired_t;
+
+// Epoch based reclamation (RCU): readers announce the epoch they pin at and read the current
+// view, the writer swaps in a new view, retires the old one at the current epoch and moves the
+// epoch on. Nobody waits on anybody, retired views are freed by later publishes
+typedef struct __MacroViews_t {
+  volatile LONG64 epoch;
+  MacroView_t *volatile current;
+  MacroViewSlot_t slots[MACRO_VIEW_MAX_READERS];
+
+  // Version the next publish gets
+  uint64_t version;
+
+  // Writer side day pages, the ones a view holds already are copied before being written
+  MacroViewPage_t **pages;
+  uint32_t firstPage, pageCount, _pageCap;
+  // Published pages replaced since the last publish, they retire with the current view
+  MacroViewPage_t **_replaced;
+  uint32_t _replacedCount, _replacedCap;
+
+  MacroViewRetired_t *_retired;
+  uint32_t _retiredCount, _retiredCap;
+} MacroViews_t;
+
+// Writer side, called by the thread that owns the database
+MacroViews_t *MacroViews_create(MacroDatabase_t *db);
+// Every reader has to be closed before
+void MacroViews_destroy(MacroViews_t *self);
+void MacroViews_add(MacroViews_t *self, DayNum_t day, const Macro_t *macro);
+// Makes everything added so far visible to the next pins and frees what no reader holds anymore
+void MacroViews_publish(MacroViews_t *self, const MacroDatabase_t *db);
+
+// Reader handle, one per thread
+typedef struct __MacroReader_t {
+  MacroViews_t *views;
+  uint32_t slot;
+} MacroReader_t;
+
+// Fails when views aren't enabled on db (MacroDatabase_enableViews) or every slot is taken
+Result_t MacroReader_open(MacroReader_t *self, MacroDatabase_t *db);
+void MacroReader_close(MacroReader_t *self);
+// Latest published view, valid until the matching unpin. Wait free, never blocks on the writer
+const MacroView_t *MacroReader_pin(MacroReader_t *self);
+void MacroReader_unpin(MacroReader_t *self);
+
+#endif
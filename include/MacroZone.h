@@ -0,0 +1,45 @@
+#ifndef _H_MACRO_ZONE_
+#define _H_MACRO_ZONE_
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "MacroDatabase.h"
+
+// Meal rows summarized per zone, in arrival order. Query batches are one zone each
+#define MACRO_ZONE_ROWS 1024
+
+// Value range of every column over MACRO_ZONE_ROWS meal rows
+typedef struct __MacroZone_t {
+  uint32_t min[MACRO_COLUMN_COUNT];
+  uint32_t max[MACRO_COLUMN_COUNT];
+  DayNum_t minDay, maxDay;
+} MacroZone_t;
+
+typedef struct __MacroZoneCounts_t {
+  uint64_t read, skipped;
+} MacroZoneCounts_t;
+
+// Zone map (min/max index) over the meal columns. Rows are append-only, so catching up after
+// inserts only reads the rows added since and widens the last zone
+typedef struct __MacroZoneMap_t {
+  MacroZone_t *zones;
+  uint32_t zoneCount, _zoneCap;
+  // Rows summarized, the last zone holds rowCount % MACRO_ZONE_ROWS of them when not full
+  uint32_t rowCount;
+
+  // Zones scans read and skipped since the database was created, for tuning and tests
+  MacroZoneCounts_t counts;
+} MacroZoneMap_t;
+
+Result_t MacroZoneMap_init(MacroZoneMap_t *self);
+void MacroZoneMap_cleanup(MacroZoneMap_t *self);
+// Summarizes rows [self->rowCount, rowCount) of the columns, the map is left as it was when
+// the zones can't grow
+Result_t MacroZoneMap_update(MacroZoneMap_t *self, const uint32_t *const columns[MACRO_COLUMN_COUNT],
+  const DayNum_t *days, uint32_t rowCount);
+
+// Whether a zone can hold days in [from, to]
+bool MacroZone_overlapsDays(const MacroZone_t *self, DayNum_t from, DayNum_t to);
+
+#endif
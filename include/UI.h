@@ -11,7 +11,10 @@ typedef enum __UiElType_t {
   UI_EL_TYPE_CONTAINER = 0,
   UI_EL_TYPE_TEXT = 1,
   UI_EL_TYPE_BUTTON = 2,
-  UI_EL_TYPE_INPUT = 3
+  UI_EL_TYPE_INPUT = 3,
+  UI_EL_TYPE_CHART = 4,
+  UI_EL_TYPE_HEATMAP = 5,
+  UI_EL_TYPE_LIST = 6
 } UiElType_t;
 
 typedef enum __UiFlag_t {
@@ -30,7 +33,6 @@ typedef uint32_t UiId_t;
 
 #define DEFAULT_CHILD_CAP (1 << 8)
 
-// TODO: implement atlas
 // TODO: MAKE IT SAFE TO ADD UI IN ANY ORDER
 // -> FIX THE ISSUE WHERE PARENT MEMORY GETS REALLOCED LOSING REFERENCE WITH CHILD POINTERS
 // POSSIBLE FIXES -> ID SYSTEM, BUFFERING MEMORY REALLOCATION (HAVING TWO BUFFERS, ONE YOU SUBMIT CHANGES TO AND A FINAL ONE WHICH INTEGRATES THEM,
@@ -153,15 +155,178 @@ bool UI_buttonProcessEvent(UI_t *self, void *ctx, Event_t *ev);
 
 typedef struct __UiInput_t {
   UStr_t str;
+  // Called after every edit of str, may be NULL
+  UiCBCK_t onChange;
+  // Called when enter is pressed, may be NULL
+  UiCBCK_t onSubmit;
 } UiInput_t;
 
 typedef struct __UiInputInfo_t {
   const char *str;
+  UiCBCK_t onChange;
+  UiCBCK_t onSubmit;
 } UiInputInfo_t;
 
 void __UI_initInput(UI_t *self, UiInputInfo_t *specInfo);
 UI_t *UI_addChildInput(UI_t *self, UiInfo_t *info, UiInputInfo_t *specInfo);
 UI_t *UI_addChildInputById(UI_t *root, UiInfo_t *info, UiInputInfo_t *specInfo);
-bool UI_inputProcessEvent(UI_t *self, Event_t *ev);
+bool UI_inputProcessEvent(UI_t *self, void *ctx, Event_t *ev);
+
+typedef enum __UiChartKind_t {
+  UI_CHART_LINE = 0,
+  UI_CHART_BAR = 1,
+  UI_CHART_AREA = 2
+} UiChartKind_t;
+
+#define UI_CHART_MAX_SERIES 8
+// A wheel step scales the visible x range by this
+#define UI_CHART_ZOOM_STEP 0.9f
+// Fewest points that stay in view when zooming in
+#define UI_CHART_MIN_EXTENT 4.f
+
+typedef struct __UiChartSeries_t {
+  UiChartKind_t kind;
+  vec4 color;
+  bool stacked;
+
+  // Value and the bottom it sits on for every point, the bottom is the top of the
+  // stacked series before this one (0 when it's not stacked)
+  vec2 *points;
+  uint32_t count;
+
+  // Vertex buffer of points, uploaded by the renderer when it's 0 or dirty
+  uint32_t _buffer;
+  bool _dirty;
+} UiChartSeries_t;
+
+// Points are at x = 0, 1, 2... Pan and zoom only move the visible rectangle, the series
+// stay uploaded
+typedef struct __UiChart_t {
+  UiChartSeries_t series[UI_CHART_MAX_SERIES];
+  uint32_t seriesCount;
+
+  // Visible data rectangle, bottom left corner and size
+  vec2 offset, extent;
+  // Line width in fractions of the chart, bar width in fractions of a point
+  float lineWidth, barWidth;
+
+  bool _dragging;
+  vec2 _cursor, _dragStart, _offsetStart;
+} UiChart_t;
+
+typedef struct __UiChartInfo_t {
+  vec2 offset, extent;
+  float lineWidth, barWidth;
+} UiChartInfo_t;
+
+typedef struct __UiChartSeriesInfo_t {
+  UiChartKind_t kind;
+  vec4 color;
+  const float *values;
+  uint32_t count;
+  // Drawn on top of the stacked series added before it
+  bool stacked;
+} UiChartSeriesInfo_t;
+
+void __UI_initChart(UI_t *self, UiChartInfo_t *specInfo);
+UI_t *UI_addChildChart(UI_t *self, UiInfo_t *info, UiChartInfo_t *specInfo);
+UI_t *UI_addChildChartById(UI_t *root, UiInfo_t *info, UiChartInfo_t *specInfo);
+// RETURNS: SERIES INDEX, -1 IF THE CHART IS FULL OR ITS POINTS CAN'T BE ALLOCATED
+int32_t UI_chartAddSeries(UI_t *self, UiChartSeriesInfo_t *seriesInfo);
+// Replaces the values of a series, it's uploaded again on the next frame. The old values
+// stay when the new ones can't be allocated
+Result_t UI_chartSetValues(UI_t *self, uint32_t seriesIndex, const float *values, uint32_t count);
+// Drag pans along x, the wheel zooms x around the cursor
+bool UI_chartProcessEvent(UI_t *self, void *ctx, Event_t *ev);
+
+typedef enum __UiHeatmapMode_t {
+  UI_HEATMAP_CALS = 0,
+  UI_HEATMAP_GOALS = 1
+} UiHeatmapMode_t;
+
+#define UI_HEATMAP_MAX_DAYS 366
+// Enough columns for a leap year starting on a Sunday
+#define UI_HEATMAP_WEEKS 54
+
+// A year of days as one column per week, Monday on top. The renderer keeps colors in an
+// instance buffer and draws every day with one call, changing the year rewrites that buffer
+typedef struct __UiHeatmap_t {
+  int32_t year;
+  UiHeatmapMode_t mode;
+
+  // Day of the week of the first day, Monday = 0
+  uint32_t firstWeekday;
+  uint32_t dayCount;
+  vec4 colors[UI_HEATMAP_MAX_DAYS];
+  // Space between cells in fractions of a cell
+  float cellGap;
+
+  // Called after the year or mode changes, fills the colors with UI_heatmapSetDays
+  UiCBCK_t onChange;
+  vec2 _cursor;
+
+  // Instance buffer of colors, created by the renderer and rewritten when dirty
+  uint32_t _buffer;
+  bool _dirty;
+} UiHeatmap_t;
+
+typedef struct __UiHeatmapInfo_t {
+  int32_t year;
+  UiHeatmapMode_t mode;
+  float cellGap;
+  UiCBCK_t onChange;
+} UiHeatmapInfo_t;
+
+void __UI_initHeatmap(UI_t *self, UiHeatmapInfo_t *specInfo);
+UI_t *UI_addChildHeatmap(UI_t *self, UiInfo_t *info, UiHeatmapInfo_t *specInfo);
+UI_t *UI_addChildHeatmapById(UI_t *root, UiInfo_t *info, UiHeatmapInfo_t *specInfo);
+void UI_heatmapSetDays(UI_t *self, uint32_t firstWeekday, const vec4 *colors, uint32_t dayCount);
+// The wheel steps through the storable years (see Date_isStorable), a click switches the mode
+bool UI_heatmapProcessEvent(UI_t *self, void *ctx, Event_t *ev);
+
+#define UI_LIST_MAX_SLOTS 64
+#define UI_LIST_NO_ROW UINT32_MAX
+// Rows moved by a wheel step
+#define UI_LIST_SCROLL_ROWS 3.f
+
+// Fills out (empty) with the text of row, only called for rows coming into view
+typedef void(*UiListRowCBCK_t)(void *, UI_t *, uint32_t, UStr_t *);
+
+typedef struct __UiListSlot_t {
+  // Row the slot's text node shows, UI_LIST_NO_ROW when it's out of rows
+  uint32_t row;
+  // Text size cached by the renderer until the slot gets another row
+  vec2 _layoutSize;
+  bool _layoutValid;
+} UiListSlot_t;
+
+// Virtualized list, children are a fixed pool of text nodes (one per slot). Row r goes to
+// slot r % slotCount, scrolling a row only refills the slot that row lands in
+typedef struct __UiList_t {
+  uint32_t rowCount;
+  // In fractions of the list height
+  float rowHeight;
+  // Rows scrolled past the top, fractional between rows
+  float scroll;
+  UiListRowCBCK_t getRow;
+
+  uint32_t slotCount;
+  UiListSlot_t slots[UI_LIST_MAX_SLOTS];
+  vec2 _cursor;
+} UiList_t;
+
+typedef struct __UiListInfo_t {
+  float rowHeight;
+  vec4 rowColor;
+  UiListRowCBCK_t getRow;
+} UiListInfo_t;
+
+void __UI_initList(UI_t *self, UiListInfo_t *specInfo);
+UI_t *UI_addChildList(UI_t *self, UiInfo_t *info, UiListInfo_t *specInfo);
+UI_t *UI_addChildListById(UI_t *root, UiInfo_t *info, UiListInfo_t *specInfo);
+// Sets the row count and refills every slot in view, rows may have moved
+void UI_listRefresh(UI_t *self, void *ctx, uint32_t rowCount);
+// The wheel scrolls, rows are refilled through getRow as they come into view
+bool UI_listProcessEvent(UI_t *self, void *ctx, Event_t *ev);
 
 #endif
\ No newline at end of file
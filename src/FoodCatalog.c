@@ -0,0 +1,360 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#include <log.h>
+
+#include "FoodCatalog.h"
+
+#define DEFAULT_FOOD_CAP (1 << 8)
+#define DEFAULT_NAMES_CAP (1 << 12)
+#define DEFAULT_SLOT_CAP (1 << 9)
+#define DEFAULT_ITEM_CAP (1 << 2)
+
+#define FNV_OFFSET_BASIS 2166136261u
+#define FNV_PRIME 16777619u
+
+uint32_t Food_hash(const char *name, uint32_t length) {
+  uint32_t hash = FNV_OFFSET_BASIS;
+  for (uint32_t index = 0; index < length; index++) {
+    hash = (hash ^ (uint8_t)name[index]) * FNV_PRIME;
+  }
+
+  return hash;
+}
+
+void FoodCatalog_init(FoodCatalog_t *self) {
+  *self = (FoodCatalog_t) {
+    .foods = malloc(sizeof(Food_t) * DEFAULT_FOOD_CAP),
+    .foodCount = 0,
+    ._foodCap = DEFAULT_FOOD_CAP,
+    .names = malloc(DEFAULT_NAMES_CAP),
+    .namesSize = 0,
+    ._namesCap = DEFAULT_NAMES_CAP,
+    ._slots = malloc(sizeof(FoodSlot_t) * DEFAULT_SLOT_CAP),
+    ._slotCap = DEFAULT_SLOT_CAP,
+    .version = 1
+  };
+
+  memset(self->_slots, 0xFF, sizeof(FoodSlot_t) * self->_slotCap);
+}
+
+void FoodCatalog_cleanup(FoodCatalog_t *self) {
+  free(self->foods);
+  free(self->names);
+  free(self->_slots);
+  *self = (FoodCatalog_t) {0};
+}
+
+// Slot holding name, or the empty slot it would go in
+FoodSlot_t *_FoodCatalog_probe(const FoodCatalog_t *self, uint32_t hash, const char *name, uint32_t length) {
+  uint32_t mask = self->_slotCap - 1;
+  for (uint32_t slot = hash & mask;; slot = (slot + 1) & mask) {
+    FoodSlot_t *entry = &self->_slots[slot];
+    if (entry->id == FOOD_ID_NONE)
+      return entry;
+
+    const Food_t *food = &self->foods[entry->id];
+    if (entry->hash == hash && food->nameLength == length &&
+        memcmp(&self->names[food->nameOffset], name, length) == 0)
+      return entry;
+  }
+}
+
+void _FoodCatalog_rehash(FoodCatalog_t *self, uint32_t slotCap) {
+  free(self->_slots);
+  self->_slots = malloc(sizeof(FoodSlot_t) * slotCap);
+  self->_slotCap = slotCap;
+  memset(self->_slots, 0xFF, sizeof(FoodSlot_t) * slotCap);
+
+  // Names are unique, every food lands in the first empty slot of its probe
+  uint32_t mask = slotCap - 1;
+  for (FoodId_t id = 0; id < self->foodCount; id++) {
+    const Food_t *food = &self->foods[id];
+    uint32_t hash = Food_hash(&self->names[food->nameOffset], food->nameLength);
+    uint32_t slot = hash & mask;
+    while (self->_slots[slot].id != FOOD_ID_NONE) {
+      slot = (slot + 1) & mask;
+    }
+    self->_slots[slot] = (FoodSlot_t) { .hash = hash, .id = id };
+  }
+}
+
+void FoodCatalog_reserve(FoodCatalog_t *self, uint32_t foodCount, uint32_t nameBytes) {
+  if (foodCount > self->_foodCap) {
+    while (self->_foodCap < foodCount) {
+      self->_foodCap <<= 1;
+    }
+    self->foods = realloc(self->foods, sizeof(Food_t) * self->_foodCap);
+  }
+
+  if (nameBytes > self->_namesCap) {
+    while (self->_namesCap < nameBytes) {
+      self->_namesCap <<= 1;
+    }
+    self->names = realloc(self->names, self->_namesCap);
+  }
+
+  uint32_t slotCap = self->_slotCap;
+  while (slotCap < foodCount * 2) {
+    slotCap <<= 1;
+  }
+  if (slotCap != self->_slotCap)
+    _FoodCatalog_rehash(self, slotCap);
+}
+
+FoodId_t FoodCatalog_add(FoodCatalog_t *self, const char *name, uint32_t length, const FoodNutrients_t *per100g) {
+  uint32_t hash = Food_hash(name, length);
+  FoodSlot_t *slot = _FoodCatalog_probe(self, hash, name, length);
+  if (slot->id != FOOD_ID_NONE) {
+    FoodCatalog_setNutrients(self, slot->id, per100g);
+    return slot->id;
+  }
+
+  if (self->foodCount == self->_foodCap) {
+    self->_foodCap <<= 1;
+    self->foods = realloc(self->foods, sizeof(Food_t) * self->_foodCap);
+  }
+
+  if (self->namesSize + length + 1 > self->_namesCap) {
+    while (self->namesSize + length + 1 > self->_namesCap) {
+      self->_namesCap <<= 1;
+    }
+    self->names = realloc(self->names, self->_namesCap);
+  }
+
+  FoodId_t id = self->foodCount++;
+  self->foods[id] = (Food_t) {
+    .nameOffset = self->namesSize,
+    .nameLength = length,
+    .per100g = *per100g
+  };
+  memcpy(&self->names[self->namesSize], name, length);
+  self->names[self->namesSize + length] = '\0';
+  self->namesSize += length + 1;
+
+  *slot = (FoodSlot_t) { .hash = hash, .id = id };
+  if (self->foodCount * 2 > self->_slotCap)
+    _FoodCatalog_rehash(self, self->_slotCap << 1);
+
+  return id;
+}
+
+FoodId_t FoodCatalog_find(const FoodCatalog_t *self, const char *name, uint32_t length) {
+  return _FoodCatalog_probe(self, Food_hash(name, length), name, length)->id;
+}
+
+// Name field of a CSV row, a quoted one is unescaped in place ("" is a quote).
+// *cursor ends up past the comma that follows the name
+bool _FoodCatalog_csvName(char **cursor, char *end, char **name, uint32_t *length) {
+  char *c = *cursor;
+  while (c < end && *c == ' ') {
+    c++;
+  }
+
+  if (c < end && *c == '"') {
+    char *out = *name = ++c;
+    while (true) {
+      if (c == end)
+        return false;
+      if (*c == '"') {
+        if (c + 1 < end && c[1] == '"') {
+          *out++ = '"';
+          c += 2;
+          continue;
+        }
+        c++;
+        break;
+      }
+      *out++ = *c++;
+    }
+    *length = (uint32_t)(out - *name);
+  } else {
+    *name = c;
+    while (c < end && *c != ',') {
+      c++;
+    }
+    *length = (uint32_t)(c - *name);
+  }
+
+  while (c < end && *c == ' ') {
+    c++;
+  }
+  if (c == end || *c != ',' || *length == 0)
+    return false;
+
+  *cursor = c + 1;
+  return true;
+}
+
+// One row, end is its newline
+bool _FoodCatalog_csvRow(FoodCatalog_t *self, char *cursor, char *end) {
+  char *name;
+  uint32_t length;
+  if (!_FoodCatalog_csvName(&cursor, end, &name, &length))
+    return false;
+
+  FoodNutrients_t per100g;
+  for (uint32_t column = 0; column < MACRO_COLUMN_COUNT; column++) {
+    char *valueEnd;
+    per100g.values[column] = strtof(cursor, &valueEnd);
+    if (valueEnd == cursor || valueEnd > end || !(per100g.values[column] >= 0.f))
+      return false;
+
+    cursor = valueEnd;
+    while (cursor < end && (*cursor == ' ' || *cursor == '\r')) {
+      cursor++;
+    }
+    if (column + 1 < MACRO_COLUMN_COUNT && (cursor == end || *cursor++ != ','))
+      return false;
+  }
+  if (cursor != end)
+    return false;
+
+  FoodCatalog_add(self, name, length, &per100g);
+  return true;
+}
+
+Result_t FoodCatalog_load(FoodCatalog_t *self, const char *path) {
+  FILE *file = NULL;
+  if (fopen_s(&file, path, "rb") != 0 || file == NULL) {
+    log_error("Failed to open the food catalog at %s" ENDL, path);
+    return RESULT_FAIL;
+  }
+
+  // Terminated so strtof stops at the end of the last row
+  fseek(file, 0, SEEK_END);
+  long size = ftell(file);
+  fseek(file, 0, SEEK_SET);
+  char *data = size >= 0 ? malloc((size_t)size + 1) : NULL;
+  if (data == NULL || fread(data, 1, (size_t)size, file) != (size_t)size) {
+    log_error("Failed to read the food catalog at %s" ENDL, path);
+    free(data);
+    fclose(file);
+    return RESULT_FAIL;
+  }
+  fclose(file);
+  data[size] = '\0';
+
+  char *end = data + size;
+  uint32_t rows = 0;
+  for (char *c = data; (c = memchr(c, '\n', (size_t)(end - c))) != NULL; c++) {
+    rows++;
+  }
+  FoodCatalog_reserve(self, self->foodCount + rows + 1, self->namesSize + (uint32_t)size + 1);
+
+  uint32_t added = 0, malformed = 0;
+  char *cursor = memchr(data, '\n', (size_t)size);
+  cursor = cursor != NULL ? cursor + 1 : end;
+  while (cursor < end) {
+    char *rowEnd = memchr(cursor, '\n', (size_t)(end - cursor));
+    rowEnd = rowEnd != NULL ? rowEnd : end;
+
+    if (rowEnd > cursor && !(rowEnd == cursor + 1 && *cursor == '\r')) {
+      if (_FoodCatalog_csvRow(self, cursor, rowEnd))
+        added++;
+      else
+        malformed++;
+    }
+    cursor = rowEnd + 1;
+  }
+  free(data);
+
+  log_info("Loaded %u foods from %s, %u malformed rows skipped" ENDL, added, path, malformed);
+  return RESULT_SUCCESS;
+}
+
+void FoodCatalog_setNutrients(FoodCatalog_t *self, FoodId_t id, const FoodNutrients_t *per100g) {
+  DEBUG_ASSERT(id < self->foodCount, "Food id %u out of range", id);
+  if (memcmp(&self->foods[id].per100g, per100g, sizeof(FoodNutrients_t)) == 0)
+    return;
+
+  self->foods[id].per100g = *per100g;
+  self->version++;
+}
+
+const Food_t *FoodCatalog_get(const FoodCatalog_t *self, FoodId_t id) {
+  DEBUG_ASSERT(id < self->foodCount, "Food id %u out of range", id);
+  return &self->foods[id];
+}
+
+const char *FoodCatalog_name(const FoodCatalog_t *self, FoodId_t id) {
+  DEBUG_ASSERT(id < self->foodCount, "Food id %u out of range", id);
+  return &self->names[self->foods[id].nameOffset];
+}
+
+size_t FoodCatalog_size(const FoodCatalog_t *self) {
+  return sizeof(Food_t) * self->_foodCap + self->_namesCap + sizeof(FoodSlot_t) * self->_slotCap;
+}
+
+void FoodMeal_init(FoodMeal_t *self, Date_t date) {
+  *self = (FoodMeal_t) {
+    .date = date,
+    .items = malloc(sizeof(FoodItem_t) * DEFAULT_ITEM_CAP),
+    .itemCount = 0,
+    ._itemCap = DEFAULT_ITEM_CAP,
+    ._totalsVersion = 0
+  };
+}
+
+void FoodMeal_cleanup(FoodMeal_t *self) {
+  free(self->items);
+  *self = (FoodMeal_t) {0};
+}
+
+void FoodMeal_add(FoodMeal_t *self, FoodId_t food, uint32_t grams) {
+  self->_totalsVersion = 0;
+
+  for (uint32_t item = 0; item < self->itemCount; item++) {
+    if (self->items[item].food == food) {
+      self->items[item].grams += grams;
+      return;
+    }
+  }
+
+  if (self->itemCount == self->_itemCap) {
+    self->_itemCap <<= 1;
+    self->items = realloc(self->items, sizeof(FoodItem_t) * self->_itemCap);
+  }
+  self->items[self->itemCount++] = (FoodItem_t) { .food = food, .grams = grams };
+}
+
+void FoodMeal_remove(FoodMeal_t *self, uint32_t item) {
+  DEBUG_ASSERT(item < self->itemCount, "Meal item %u out of range", item);
+  memmove(&self->items[item], &self->items[item + 1], sizeof(FoodItem_t) * (self->itemCount - item - 1));
+  self->itemCount--;
+  self->_totalsVersion = 0;
+}
+
+Macro_t FoodMeal_totals(FoodMeal_t *self, const FoodCatalog_t *catalog) {
+  if (self->_totalsVersion == catalog->version)
+    return self->_totals;
+
+  // Summed unrounded so a meal of many small items doesn't drift
+  float sums[MACRO_COLUMN_COUNT] = {0};
+  for (uint32_t item = 0; item < self->itemCount; item++) {
+    const Food_t *food = FoodCatalog_get(catalog, self->items[item].food);
+    float scale = self->items[item].grams / 100.f;
+    for (uint32_t column = 0; column < MACRO_COLUMN_COUNT; column++) {
+      sums[column] += food->per100g.values[column] * scale;
+    }
+  }
+
+  uint32_t *totals = &self->_totals.cals;
+  for (uint32_t column = 0; column < MACRO_COLUMN_COUNT; column++) {
+    // llroundf, long is 32 bits with MSVC
+    totals[column] = sums[column] <= 0.f ? 0 :
+      sums[column] >= (float)UINT32_MAX ? UINT32_MAX : (uint32_t)llroundf(sums[column]);
+  }
+  self->_totalsVersion = catalog->version;
+
+  return self->_totals;
+}
+
+Meal_t FoodMeal_toMeal(FoodMeal_t *self, const FoodCatalog_t *catalog) {
+  return (Meal_t) {
+    .macro = FoodMeal_totals(self, catalog),
+    .date = self->date
+  };
+}
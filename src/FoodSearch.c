@@ -0,0 +1,685 @@
+#include <stdlib.h>
+#include <string.h>
+
+#include <log.h>
+
+#include "FoodSearch.h"
+
+#define WORD_SCORE_NAME_START 0x8000u
+#define WORD_SCORE_LENGTH_MASK 0x7FFFu
+
+// Matches of the query as typed, then of its corrected form
+#define RESULT_TIER_EXACT 2u
+#define RESULT_TIER_CORRECTED 1u
+
+uint8_t _FoodSearch_fold(char c) {
+  return (uint8_t)(c >= 'A' && c <= 'Z' ? c - 'A' + 'a' : c);
+}
+
+// Bytes past ASCII are taken as letters so accented words stay whole
+bool _FoodSearch_isWordChar(char c) {
+  uint8_t folded = _FoodSearch_fold(c);
+  return (folded >= 'a' && folded <= 'z') || (folded >= '0' && folded <= '9') || folded >= 0x80;
+}
+
+uint32_t _FoodSearch_symbol(char c) {
+  if (c >= 'a' && c <= 'z')
+    return 1 + c - 'a';
+  if (c >= '0' && c <= '9')
+    return 27 + c - '0';
+  return 0;
+}
+
+// Lower cases text and turns every run of other characters into one space, writes at most
+// cap characters to out and returns how many. A trailing space is kept when keepTrailing is set
+uint32_t _FoodSearch_normalize(const char *text, uint32_t length, char *out, uint32_t cap, bool keepTrailing) {
+  uint32_t count = 0;
+  for (uint32_t index = 0; index < length && count < cap; index++) {
+    if (_FoodSearch_isWordChar(text[index]))
+      out[count++] = (char)_FoodSearch_fold(text[index]);
+    else if (count > 0 && out[count - 1] != ' ')
+      out[count++] = ' ';
+  }
+
+  if (!keepTrailing && count > 0 && out[count - 1] == ' ')
+    count--;
+  return count;
+}
+
+uint32_t _FoodSearch_wordLength(const char *word) {
+  uint32_t length = 0;
+  while (word[length] != ' ' && word[length] != '\0') {
+    length++;
+  }
+
+  return length;
+}
+
+// Distinct trigrams of a single normalized word led by a word start symbol, out is sized length
+uint32_t _FoodSearch_trigrams(const char *word, uint32_t length, uint32_t *out) {
+  uint32_t count = 0;
+  uint32_t previous[2] = { 0, 0 };
+
+  for (uint32_t index = 0; index < length; index++) {
+    uint32_t symbol = _FoodSearch_symbol(word[index]);
+    uint32_t key = (previous[0] * FOOD_SEARCH_SYMBOLS + previous[1]) * FOOD_SEARCH_SYMBOLS + symbol;
+    previous[0] = previous[1];
+    previous[1] = symbol;
+    if (index == 0)
+      continue;
+
+    bool repeated = false;
+    for (uint32_t other = 0; other < count && !repeated; other++) {
+      repeated = out[other] == key;
+    }
+    if (!repeated)
+      out[count++] = key;
+  }
+
+  return count;
+}
+
+// First 4 bytes, big endian so keys order like the text they come from
+uint32_t _FoodSearch_wordKey(const char *text) {
+  uint32_t key = 0;
+  bool ended = false;
+  for (uint32_t index = 0; index < 4; index++) {
+    ended = ended || text[index] == '\0';
+    key = (key << 8) | (ended ? 0 : (uint8_t)text[index]);
+  }
+
+  return key;
+}
+
+int _FoodSearch_compareWords(const char *text, uint64_t a, uint64_t b) {
+  uint32_t keyA = (uint32_t)(a >> 32), keyB = (uint32_t)(b >> 32);
+  if (keyA != keyB)
+    return keyA < keyB ? -1 : 1;
+  if ((keyA & 0xFF) == 0)
+    return 0;
+
+  const uint8_t *textA = (const uint8_t *)&text[(uint32_t)a + 4], *textB = (const uint8_t *)&text[(uint32_t)b + 4];
+  for (; *textA == *textB; textA++, textB++) {
+    if (*textA == 0)
+      return 0;
+  }
+
+  return *textA < *textB ? -1 : 1;
+}
+
+// Bottom up merge sort of (key << 32 | offset) entries, most ties are settled by the key.
+// Returns whichever of entries and scratch ends up sorted
+uint64_t *_FoodSearch_sortWords(const char *text, uint64_t *entries, uint64_t *scratch, uint32_t count) {
+  for (uint32_t width = 1; width < count; width <<= 1) {
+    for (uint32_t left = 0; left < count; left += width << 1) {
+      uint32_t middle = left + width < count ? left + width : count;
+      uint32_t right = middle + width < count ? middle + width : count;
+
+      uint32_t a = left, b = middle, out = left;
+      while (a < middle && b < right) {
+        scratch[out++] = _FoodSearch_compareWords(text, entries[b], entries[a]) < 0 ? entries[b++] : entries[a++];
+      }
+      while (a < middle) {
+        scratch[out++] = entries[a++];
+      }
+      while (b < right) {
+        scratch[out++] = entries[b++];
+      }
+    }
+
+    uint64_t *sorted = scratch;
+    scratch = entries;
+    entries = sorted;
+  }
+
+  return entries;
+}
+
+uint32_t _FoodSearch_varintSize(uint32_t value) {
+  uint32_t size = 1;
+  while (value >= 0x80) {
+    value >>= 7;
+    size++;
+  }
+
+  return size;
+}
+
+// Sizes the vocabulary's trigram postings while postings is NULL, writes them afterwards
+void _FoodSearch_walkTrigrams(FoodSearch_t *self, uint32_t *trigrams, uint32_t *last, uint32_t *cursor) {
+  for (uint32_t key = 0; key < FOOD_SEARCH_TRIGRAM_COUNT; key++) {
+    last[key] = 0;
+  }
+
+  for (uint32_t vocab = 0; vocab < self->vocabCount; vocab++) {
+    const char *word = &self->text[self->vocab[vocab]];
+    uint32_t count = _FoodSearch_trigrams(word, _FoodSearch_wordLength(word), trigrams);
+
+    for (uint32_t index = 0; index < count; index++) {
+      uint32_t key = trigrams[index];
+      uint32_t delta = vocab - last[key];
+      last[key] = vocab;
+
+      if (self->postings == NULL) {
+        self->postingStart[key + 1] += _FoodSearch_varintSize(delta);
+        self->postingCount[key]++;
+        continue;
+      }
+
+      uint8_t *out = &self->postings[cursor[key]];
+      while (delta >= 0x80) {
+        *out++ = (uint8_t)(delta | 0x80);
+        delta >>= 7;
+      }
+      *out++ = (uint8_t)delta;
+      cursor[key] = (uint32_t)(out - self->postings);
+    }
+  }
+}
+
+Result_t _FoodSearch_buildWords(FoodSearch_t *self) {
+  const char *text = self->text;
+  uint32_t textSize = self->textOffsets[self->foodCount];
+  for (uint32_t offset = 0; offset < textSize; offset++) {
+    self->wordCount += text[offset] != ' ' && text[offset] != '\0' && (offset == 0 || text[offset - 1] == ' ' || text[offset - 1] == '\0');
+  }
+
+  uint32_t blockCount = (self->wordCount + FOOD_SEARCH_BLOCK_WORDS - 1) / FOOD_SEARCH_BLOCK_WORDS;
+  uint64_t *entries = malloc(sizeof(uint64_t) * (self->wordCount + 1));
+  uint64_t *scratch = malloc(sizeof(uint64_t) * (self->wordCount + 1));
+  self->words = malloc(sizeof(uint32_t) * (self->wordCount + 1));
+  self->wordScores = malloc(sizeof(uint16_t) * (self->wordCount + 1));
+  self->blockScores = calloc(blockCount + 1, sizeof(uint16_t));
+  self->vocab = malloc(sizeof(uint32_t) * (self->wordCount + 1));
+  self->vocabFrequency = malloc(sizeof(uint32_t) * (self->wordCount + 1));
+  if (entries == NULL || scratch == NULL || self->words == NULL || self->wordScores == NULL ||
+      self->blockScores == NULL || self->vocab == NULL || self->vocabFrequency == NULL) {
+    free(entries);
+    free(scratch);
+    return RESULT_FAIL;
+  }
+
+  uint32_t word = 0;
+  for (uint32_t offset = 0; offset < textSize; offset++) {
+    if (text[offset] != ' ' && text[offset] != '\0' && (offset == 0 || text[offset - 1] == ' ' || text[offset - 1] == '\0'))
+      entries[word++] = (uint64_t)_FoodSearch_wordKey(&text[offset]) << 32 | offset;
+  }
+
+  const uint64_t *sorted = _FoodSearch_sortWords(text, entries, scratch, self->wordCount);
+  for (word = 0; word < self->wordCount; word++) {
+    uint32_t offset = (uint32_t)sorted[word];
+    uint32_t remaining = (uint32_t)strlen(&text[offset]);
+    self->words[word] = offset;
+    self->wordScores[word] = (uint16_t)((offset == 0 || text[offset - 1] == '\0' ? WORD_SCORE_NAME_START : 0) |
+      (WORD_SCORE_LENGTH_MASK - (remaining < WORD_SCORE_LENGTH_MASK ? remaining : WORD_SCORE_LENGTH_MASK)));
+
+    uint16_t *block = &self->blockScores[word / FOOD_SEARCH_BLOCK_WORDS];
+    *block = self->wordScores[word] > *block ? self->wordScores[word] : *block;
+  }
+  free(entries);
+  free(scratch);
+
+  // Suffixes of the same word are next to each other, a space or the end sorts before any letter
+  uint32_t length = 0;
+  for (word = 0; word < self->wordCount; word++) {
+    const char *start = &text[self->words[word]];
+    if (self->vocabCount > 0 && _FoodSearch_wordLength(start) == length &&
+        memcmp(start, &text[self->vocab[self->vocabCount - 1]], length) == 0) {
+      self->vocabFrequency[self->vocabCount - 1]++;
+      continue;
+    }
+
+    length = _FoodSearch_wordLength(start);
+    if (start[0] >= '0' && start[0] <= '9') {
+      length = 0;
+      continue;
+    }
+    self->vocab[self->vocabCount] = self->words[word];
+    self->vocabFrequency[self->vocabCount++] = 1;
+  }
+
+  return RESULT_SUCCESS;
+}
+
+Result_t _FoodSearch_buildTrigrams(FoodSearch_t *self) {
+  uint32_t longest = 0;
+  for (uint32_t vocab = 0; vocab < self->vocabCount; vocab++) {
+    uint32_t length = _FoodSearch_wordLength(&self->text[self->vocab[vocab]]);
+    longest = length > longest ? length : longest;
+  }
+
+  self->postingStart = calloc(FOOD_SEARCH_TRIGRAM_COUNT + 1, sizeof(uint32_t));
+  self->postingCount = calloc(FOOD_SEARCH_TRIGRAM_COUNT, sizeof(uint32_t));
+  uint32_t *trigrams = malloc(sizeof(uint32_t) * (longest + 1));
+  uint32_t *last = malloc(sizeof(uint32_t) * FOOD_SEARCH_TRIGRAM_COUNT);
+  uint32_t *cursor = malloc(sizeof(uint32_t) * FOOD_SEARCH_TRIGRAM_COUNT);
+
+  if (self->postingStart != NULL && self->postingCount != NULL && trigrams != NULL && last != NULL && cursor != NULL) {
+    // Sizes first, then every list is written at its final place
+    _FoodSearch_walkTrigrams(self, trigrams, last, cursor);
+    for (uint32_t key = 0; key < FOOD_SEARCH_TRIGRAM_COUNT; key++) {
+      self->postingStart[key + 1] += self->postingStart[key];
+    }
+    memcpy(cursor, self->postingStart, sizeof(uint32_t) * FOOD_SEARCH_TRIGRAM_COUNT);
+
+    self->postings = malloc(self->postingStart[FOOD_SEARCH_TRIGRAM_COUNT] + 1);
+    if (self->postings != NULL)
+      _FoodSearch_walkTrigrams(self, trigrams, last, cursor);
+  }
+
+  free(trigrams);
+  free(last);
+  free(cursor);
+  return self->postings != NULL ? RESULT_SUCCESS : RESULT_FAIL;
+}
+
+Result_t FoodSearch_build(FoodSearch_t *self, const FoodCatalog_t *catalog) {
+  *self = (FoodSearch_t) {
+    .catalog = catalog,
+    .foodCount = catalog->foodCount,
+    .text = malloc(catalog->namesSize + 1),
+    .textOffsets = malloc(sizeof(uint32_t) * (catalog->foodCount + 1))
+  };
+
+  if (self->text == NULL || self->textOffsets == NULL) {
+    log_error("Couldn't allocate the normalized names of %u foods" ENDL, catalog->foodCount);
+    FoodSearch_cleanup(self);
+    return RESULT_FAIL;
+  }
+
+  uint32_t size = 0;
+  for (FoodId_t id = 0; id < catalog->foodCount; id++) {
+    const Food_t *food = &catalog->foods[id];
+    self->textOffsets[id] = size;
+    size += _FoodSearch_normalize(&catalog->names[food->nameOffset], food->nameLength,
+      &self->text[size], food->nameLength, false
+    );
+    self->text[size++] = '\0';
+  }
+  self->textOffsets[catalog->foodCount] = size;
+  self->text[size] = '\0';
+
+  if (_FoodSearch_buildWords(self) != RESULT_SUCCESS || _FoodSearch_buildTrigrams(self) != RESULT_SUCCESS) {
+    log_error("Couldn't allocate the search index of %u foods" ENDL, catalog->foodCount);
+    FoodSearch_cleanup(self);
+    return RESULT_FAIL;
+  }
+
+  return RESULT_SUCCESS;
+}
+
+void FoodSearch_cleanup(FoodSearch_t *self) {
+  free(self->text);
+  free(self->textOffsets);
+  free(self->words);
+  free(self->wordScores);
+  free(self->blockScores);
+  free(self->vocab);
+  free(self->vocabFrequency);
+  free(self->postings);
+  free(self->postingStart);
+  free(self->postingCount);
+  *self = (FoodSearch_t) {0};
+}
+
+size_t FoodSearch_size(const FoodSearch_t *self) {
+  return self->textOffsets[self->foodCount] + sizeof(uint32_t) * (self->foodCount + 1) +
+    (sizeof(uint32_t) + sizeof(uint16_t)) * self->wordCount +
+    sizeof(uint16_t) * (self->wordCount / FOOD_SEARCH_BLOCK_WORDS + 1) +
+    2 * sizeof(uint32_t) * self->vocabCount +
+    self->postingStart[FOOD_SEARCH_TRIGRAM_COUNT] + sizeof(uint32_t) * (2 * FOOD_SEARCH_TRIGRAM_COUNT + 1);
+}
+
+// Food whose normalized name holds offset
+FoodId_t _FoodSearch_foodAt(const FoodSearch_t *self, uint32_t offset) {
+  uint32_t low = 0, high = self->foodCount;
+  while (high - low > 1) {
+    uint32_t middle = low + (high - low) / 2;
+    if (self->textOffsets[middle] <= offset)
+      low = middle;
+    else
+      high = middle;
+  }
+
+  return low;
+}
+
+// Narrows [*low, *high), whose words match text up to position, to the ones matching text[position] too
+void _FoodSearch_narrow(const FoodSearch_t *self, const char *text, uint32_t position, uint32_t *low, uint32_t *high) {
+  uint8_t c = (uint8_t)text[position];
+  uint32_t first = *low, last = *high;
+  while (first < last) {
+    uint32_t middle = first + (last - first) / 2;
+    if ((uint8_t)self->text[self->words[middle] + position] < c)
+      first = middle + 1;
+    else
+      last = middle;
+  }
+
+  *low = first;
+  last = *high;
+  while (first < last) {
+    uint32_t middle = first + (last - first) / 2;
+    if ((uint8_t)self->text[self->words[middle] + position] <= c)
+      first = middle + 1;
+    else
+      last = middle;
+  }
+  *high = first;
+}
+
+// Edit distance of token to word (to the closest prefix of word when prefix is set), or
+// maxDistance + 1 once it can't be within it. *matched is how much of word the token lines up with
+uint32_t _FoodSearch_distance(const char *token, uint32_t tokenLength, const char *word, uint32_t wordLength,
+  bool prefix, uint32_t maxDistance, uint32_t *matched) {
+  uint8_t rows[2][FOOD_SEARCH_MAX_QUERY + 2];
+  if (wordLength > FOOD_SEARCH_MAX_QUERY)
+    return maxDistance + 1;
+
+  uint8_t *previous = rows[0], *current = rows[1];
+  for (uint32_t column = 0; column <= wordLength; column++) {
+    previous[column] = (uint8_t)column;
+  }
+
+  for (uint32_t row = 1; row <= tokenLength; row++) {
+    current[0] = (uint8_t)row;
+    uint8_t best = current[0];
+    for (uint32_t column = 1; column <= wordLength; column++) {
+      uint8_t replace = previous[column - 1] + (token[row - 1] != word[column - 1]);
+      uint8_t remove = previous[column] + 1;
+      uint8_t insert = current[column - 1] + 1;
+      uint8_t cost = replace < remove ? replace : remove;
+      current[column] = cost < insert ? cost : insert;
+      best = current[column] < best ? current[column] : best;
+    }
+    if (best > maxDistance)
+      return maxDistance + 1;
+
+    uint8_t *swap = previous;
+    previous = current;
+    current = swap;
+  }
+
+  *matched = wordLength;
+  if (!prefix)
+    return previous[wordLength];
+
+  // Shortest prefix at the smallest distance, so the corrected query stays as open as the typed one
+  for (uint32_t column = 0; column <= wordLength; column++) {
+    if (previous[column] < previous[*matched])
+      *matched = column;
+  }
+  return previous[*matched];
+}
+
+typedef struct __FoodPostingCursor_t {
+  const uint8_t *data, *end;
+  uint32_t value;
+} FoodPostingCursor_t;
+
+bool _FoodPostingCursor_next(FoodPostingCursor_t *self) {
+  if (self->data == self->end)
+    return false;
+
+  uint32_t delta = 0;
+  for (uint32_t shift = 0;; shift += 7) {
+    uint8_t byte = *self->data++;
+    delta |= (uint32_t)(byte & 0x7F) << shift;
+    if ((byte & 0x80) == 0)
+      break;
+  }
+  self->value += delta;
+  return true;
+}
+
+// First vocabulary word not ordering before token
+uint32_t _FoodSearch_vocabLowerBound(const FoodSearch_t *self, const char *token, uint32_t length) {
+  uint32_t low = 0, high = self->vocabCount;
+  while (low < high) {
+    uint32_t middle = low + (high - low) / 2;
+    const char *word = &self->text[self->vocab[middle]];
+    uint32_t wordLength = _FoodSearch_wordLength(word);
+    int order = memcmp(word, token, wordLength < length ? wordLength : length);
+    if (order < 0 || (order == 0 && wordLength < length))
+      low = middle + 1;
+    else
+      high = middle;
+  }
+
+  return low;
+}
+
+// Writes the vocabulary word closest to token to out, or token itself when it's known, too
+// short to guess at or nothing is close. The last word of a query is still being typed, so it's
+// matched as a prefix. Returns the length written and adds the words compared to *work
+uint32_t _FoodSearch_correct(const FoodSearch_t *self, const char *token, uint32_t length, bool prefix, char *out, uint32_t *work) {
+  memcpy(out, token, length);
+
+  uint32_t known = _FoodSearch_vocabLowerBound(self, token, length);
+  if (known < self->vocabCount) {
+    const char *word = &self->text[self->vocab[known]];
+    uint32_t wordLength = _FoodSearch_wordLength(word);
+    if (memcmp(word, token, length < wordLength ? length : wordLength) == 0 && (prefix ? wordLength >= length : wordLength == length))
+      return length;
+  }
+
+  uint32_t maxDistance = length <= 2 ? 0 : (length <= 5 ? 1 : 2);
+  if (maxDistance == 0 || (token[0] >= '0' && token[0] <= '9'))
+    return length;
+
+  // A word within maxDistance edits still shares all but 3 * maxDistance of the token's
+  // trigrams, so it's in one of the (3 * maxDistance + 1) rarest lists
+  uint32_t trigrams[FOOD_SEARCH_MAX_QUERY + 1];
+  uint32_t trigramCount = _FoodSearch_trigrams(token, length, trigrams);
+  for (uint32_t index = 1; index < trigramCount; index++) {
+    uint32_t key = trigrams[index];
+    uint32_t position = index;
+    while (position > 0 && self->postingCount[trigrams[position - 1]] > self->postingCount[key]) {
+      trigrams[position] = trigrams[position - 1];
+      position--;
+    }
+    trigrams[position] = key;
+  }
+
+  uint32_t listCount = trigramCount < 3 * maxDistance + 1 ? trigramCount : 3 * maxDistance + 1;
+  FoodPostingCursor_t cursors[3 * 2 + 1];
+  uint32_t cursorCount = 0;
+  for (uint32_t index = 0; index < listCount; index++) {
+    uint32_t key = trigrams[index];
+    cursors[cursorCount] = (FoodPostingCursor_t) {
+      .data = &self->postings[self->postingStart[key]],
+      .end = &self->postings[self->postingStart[key + 1]],
+      .value = 0
+    };
+    cursorCount += _FoodPostingCursor_next(&cursors[cursorCount]);
+  }
+
+  uint32_t bestDistance = maxDistance + 1, bestFrequency = 0, bestVocab = 0, bestMatched = 0;
+  while (cursorCount > 0) {
+    uint32_t vocab = cursors[0].value;
+    for (uint32_t index = 1; index < cursorCount; index++) {
+      vocab = cursors[index].value < vocab ? cursors[index].value : vocab;
+    }
+    for (uint32_t index = 0; index < cursorCount; index++) {
+      if (cursors[index].value == vocab && !_FoodPostingCursor_next(&cursors[index]))
+        cursors[index--] = cursors[--cursorCount];
+    }
+
+    const char *word = &self->text[self->vocab[vocab]];
+    uint32_t matched = 0;
+    uint32_t distance = _FoodSearch_distance(token, length, word, _FoodSearch_wordLength(word), prefix, maxDistance, &matched);
+    (*work)++;
+    if (distance < bestDistance || (distance == bestDistance && self->vocabFrequency[vocab] > bestFrequency)) {
+      bestDistance = distance;
+      bestFrequency = self->vocabFrequency[vocab];
+      bestVocab = vocab;
+      bestMatched = matched;
+    }
+  }
+
+  if (bestDistance > maxDistance)
+    return length;
+
+  memcpy(out, &self->text[self->vocab[bestVocab]], bestMatched);
+  return bestMatched;
+}
+
+void FoodSearchQuery_init(FoodSearchQuery_t *self, const FoodSearch_t *search) {
+  *self = (FoodSearchQuery_t) {
+    .search = search,
+    .length = 0,
+    ._rangeLo = { 0 },
+    ._rangeHi = { search->wordCount },
+    ._phase = FOOD_SEARCH_PHASE_DONE,
+    ._correctedLength = 0,
+    ._correctedFrom = 0,
+    .resultCount = 0
+  };
+}
+
+void FoodSearchQuery_set(FoodSearchQuery_t *self, const char *text, uint32_t length) {
+  char normalized[FOOD_SEARCH_MAX_QUERY];
+  length = _FoodSearch_normalize(text, length, normalized, FOOD_SEARCH_MAX_QUERY, true);
+
+  uint32_t common = 0;
+  while (common < length && common < self->length && normalized[common] == self->text[common]) {
+    common++;
+  }
+
+  memcpy(&self->text[common], &normalized[common], length - common);
+  self->text[length] = '\0';
+  self->length = length;
+  for (uint32_t depth = common + 1; depth <= length; depth++) {
+    self->_rangeLo[depth] = self->_rangeLo[depth - 1];
+    self->_rangeHi[depth] = self->_rangeHi[depth - 1];
+    _FoodSearch_narrow(self->search, self->text, depth - 1, &self->_rangeLo[depth], &self->_rangeHi[depth]);
+  }
+
+  // Corrections hold as long as the words they were made for are untouched
+  if (self->_correctedFrom > common) {
+    self->_correctedFrom = 0;
+    self->_correctedLength = 0;
+  }
+
+  self->resultCount = 0;
+  self->_cursor = self->_rangeLo[length];
+  self->_end = self->_rangeHi[length];
+  self->_phase = length > 0 ? FOOD_SEARCH_PHASE_PREFIX : FOOD_SEARCH_PHASE_DONE;
+}
+
+void _FoodSearchQuery_insert(FoodSearchQuery_t *self, FoodId_t food, uint32_t score) {
+  FoodSearchResult_t *results = self->results;
+  for (uint32_t index = 0; index < self->resultCount; index++) {
+    if (results[index].food != food)
+      continue;
+    if (results[index].score >= score)
+      return;
+
+    memmove(&results[index], &results[index + 1], sizeof(FoodSearchResult_t) * (self->resultCount - index - 1));
+    self->resultCount--;
+    break;
+  }
+
+  uint32_t position = self->resultCount < FOOD_SEARCH_MAX_RESULTS ? self->resultCount : FOOD_SEARCH_MAX_RESULTS - 1;
+  if (self->resultCount == FOOD_SEARCH_MAX_RESULTS && results[position].score >= score)
+    return;
+
+  while (position > 0 && results[position - 1].score < score) {
+    results[position] = results[position - 1];
+    position--;
+  }
+  results[position] = (FoodSearchResult_t) { .food = food, .score = score };
+  self->resultCount += self->resultCount < FOOD_SEARCH_MAX_RESULTS;
+}
+
+// Ranks the words of [_cursor, _end) into the results, returns the budget left
+uint32_t _FoodSearchQuery_scan(FoodSearchQuery_t *self, uint32_t tier, uint32_t budget) {
+  const FoodSearch_t *search = self->search;
+  while (self->_cursor < self->_end && budget > 0) {
+    budget--;
+    uint32_t floor = self->resultCount < FOOD_SEARCH_MAX_RESULTS ? 0 : self->results[FOOD_SEARCH_MAX_RESULTS - 1].score;
+
+    if (self->_cursor % FOOD_SEARCH_BLOCK_WORDS == 0 && self->_cursor + FOOD_SEARCH_BLOCK_WORDS <= self->_end &&
+        (tier << 16 | search->blockScores[self->_cursor / FOOD_SEARCH_BLOCK_WORDS]) <= floor) {
+      self->_cursor += FOOD_SEARCH_BLOCK_WORDS;
+      continue;
+    }
+
+    uint32_t score = tier << 16 | search->wordScores[self->_cursor];
+    if (score > floor)
+      _FoodSearchQuery_insert(self, _FoodSearch_foodAt(search, search->words[self->_cursor]), score);
+    self->_cursor++;
+  }
+
+  return budget;
+}
+
+// Corrects the words of the query, then points the scan at the matches of the corrected text.
+// Returns false when there is nothing to correct
+bool _FoodSearchQuery_correct(FoodSearchQuery_t *self, uint32_t *work) {
+  const FoodSearch_t *search = self->search;
+  char corrected[FOOD_SEARCH_MAX_QUERY * 3];
+  memcpy(corrected, self->_corrected, self->_correctedLength);
+  uint32_t length = self->_correctedLength;
+
+  for (uint32_t start = self->_correctedFrom; start < self->length;) {
+    uint32_t end = start;
+    while (end < self->length && self->text[end] != ' ') {
+      end++;
+    }
+
+    bool finished = end < self->length;
+    length += _FoodSearch_correct(search, &self->text[start], end - start, !finished, &corrected[length], work);
+    if (!finished)
+      break;
+
+    corrected[length++] = ' ';
+    start = end + 1;
+    if (length <= FOOD_SEARCH_MAX_QUERY) {
+      memcpy(&self->_corrected[self->_correctedLength], &corrected[self->_correctedLength], length - self->_correctedLength);
+      self->_correctedLength = length;
+      self->_correctedFrom = start;
+    }
+  }
+
+  length = length < FOOD_SEARCH_MAX_QUERY ? length : FOOD_SEARCH_MAX_QUERY;
+  if (length == self->length && memcmp(corrected, self->text, length) == 0)
+    return false;
+
+  self->_cursor = 0;
+  self->_end = search->wordCount;
+  for (uint32_t position = 0; position < length && self->_cursor < self->_end; position++) {
+    _FoodSearch_narrow(search, corrected, position, &self->_cursor, &self->_end);
+  }
+  return true;
+}
+
+bool FoodSearchQuery_run(FoodSearchQuery_t *self, uint32_t budget) {
+  while (budget > 0 && self->_phase != FOOD_SEARCH_PHASE_DONE) {
+    switch (self->_phase) {
+      case FOOD_SEARCH_PHASE_PREFIX: {
+        budget = _FoodSearchQuery_scan(self, RESULT_TIER_EXACT, budget);
+        if (self->_cursor == self->_end)
+          self->_phase = self->resultCount < FOOD_SEARCH_MAX_RESULTS ? FOOD_SEARCH_PHASE_CORRECT : FOOD_SEARCH_PHASE_DONE;
+        break;
+      }
+      case FOOD_SEARCH_PHASE_CORRECT: {
+        uint32_t work = 0;
+        bool corrected = _FoodSearchQuery_correct(self, &work);
+        budget -= work < budget ? work : budget;
+        self->_phase = corrected ? FOOD_SEARCH_PHASE_FUZZY : FOOD_SEARCH_PHASE_DONE;
+        break;
+      }
+      case FOOD_SEARCH_PHASE_FUZZY: {
+        budget = _FoodSearchQuery_scan(self, RESULT_TIER_CORRECTED, budget);
+        if (self->_cursor == self->_end)
+          self->_phase = FOOD_SEARCH_PHASE_DONE;
+        break;
+      }
+      default:
+        break;
+    }
+  }
+
+  return self->_phase == FOOD_SEARCH_PHASE_DONE;
+}
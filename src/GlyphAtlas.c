@@ -0,0 +1,155 @@
+#include <stdlib.h>
+#include <string.h>
+
+#include "GlyphAtlas.h"
+
+#define DEFAULT_SKYLINE_CAP (1 << 6)
+#define DEFAULT_PAGE_CAP (1 << 2)
+
+void GlyphAtlas_init(GlyphAtlas_t *self, uint32_t pageSize) {
+  *self = (GlyphAtlas_t) {
+    .pages = malloc(sizeof(GlyphAtlasPage_t) * DEFAULT_PAGE_CAP),
+    .pageCount = 0,
+    ._pageCap = DEFAULT_PAGE_CAP,
+    .pageSize = pageSize
+  };
+}
+
+void GlyphAtlas_cleanup(GlyphAtlas_t *self) {
+  for (uint32_t page = 0; page < self->pageCount; page++) {
+    free(self->pages[page].skyline);
+  }
+  free(self->pages);
+  *self = (GlyphAtlas_t) {0};
+}
+
+GlyphAtlasPage_t *_GlyphAtlas_addPage(GlyphAtlas_t *self) {
+  if (self->pageCount == self->_pageCap) {
+    self->_pageCap <<= 1;
+    self->pages = realloc(self->pages, sizeof(GlyphAtlasPage_t) * self->_pageCap);
+  }
+
+  GlyphAtlasPage_t *page = &self->pages[self->pageCount++];
+  *page = (GlyphAtlasPage_t) {
+    .skyline = malloc(sizeof(GlyphAtlasSkyline_t) * DEFAULT_SKYLINE_CAP),
+    .skylineCount = 1,
+    ._skylineCap = DEFAULT_SKYLINE_CAP,
+    .texture = 0
+  };
+  page->skyline[0] = (GlyphAtlasSkyline_t) { .x = 0, .y = 0, .width = self->pageSize };
+  return page;
+}
+
+// Top of a width x height rectangle resting on the skyline from segment index on, false
+// when it runs past the right or top edge
+bool _GlyphAtlas_fit(const GlyphAtlasPage_t *page, uint32_t pageSize, uint32_t index,
+  uint32_t width, uint32_t height, uint32_t *y) {
+  const GlyphAtlasSkyline_t *skyline = page->skyline;
+  if (skyline[index].x + width > pageSize)
+    return false;
+
+  uint32_t top = 0;
+  for (uint32_t covered = 0; covered < width; index++) {
+    top = skyline[index].y > top ? skyline[index].y : top;
+    if (top + height > pageSize)
+      return false;
+
+    covered += skyline[index].width;
+  }
+
+  *y = top;
+  return true;
+}
+
+// Raises the skyline over the placed rectangle, cutting or dropping the segments under it
+void _GlyphAtlas_place(GlyphAtlasPage_t *page, uint32_t index, uint32_t x, uint32_t y, uint32_t width) {
+  if (page->skylineCount == page->_skylineCap) {
+    page->_skylineCap <<= 1;
+    page->skyline = realloc(page->skyline, sizeof(GlyphAtlasSkyline_t) * page->_skylineCap);
+  }
+
+  GlyphAtlasSkyline_t *skyline = page->skyline;
+  memmove(&skyline[index + 1], &skyline[index], sizeof(GlyphAtlasSkyline_t) * (page->skylineCount - index));
+  skyline[index] = (GlyphAtlasSkyline_t) { .x = x, .y = y, .width = width };
+  page->skylineCount++;
+
+  uint32_t right = x + width;
+  uint32_t next = index + 1;
+  while (next < page->skylineCount && skyline[next].x < right) {
+    uint32_t end = skyline[next].x + skyline[next].width;
+    if (end > right) {
+      skyline[next].width = end - right;
+      skyline[next].x = right;
+      break;
+    }
+
+    memmove(&skyline[next], &skyline[next + 1], sizeof(GlyphAtlasSkyline_t) * (page->skylineCount - next - 1));
+    page->skylineCount--;
+  }
+
+  // Neighbours at the same height become one segment
+  for (uint32_t segment = 0; segment + 1 < page->skylineCount;) {
+    if (skyline[segment].y != skyline[segment + 1].y) {
+      segment++;
+      continue;
+    }
+
+    skyline[segment].width += skyline[segment + 1].width;
+    memmove(&skyline[segment + 1], &skyline[segment + 2],
+      sizeof(GlyphAtlasSkyline_t) * (page->skylineCount - segment - 2));
+    page->skylineCount--;
+  }
+}
+
+Result_t GlyphAtlas_pack(GlyphAtlas_t *self, uint32_t width, uint32_t height, GlyphAtlasRect_t *out) {
+  uint32_t paddedWidth = width + GLYPH_ATLAS_PADDING * 2;
+  uint32_t paddedHeight = height + GLYPH_ATLAS_PADDING * 2;
+  if (paddedWidth > self->pageSize || paddedHeight > self->pageSize) {
+    log_error("Glyph of %ux%u doesn't fit an atlas page of %u" ENDL, width, height, self->pageSize);
+    return RESULT_FAIL;
+  }
+
+  // Lowest top first, then the narrowest segment so wide gaps stay open
+  uint32_t bestPage = UINT32_MAX, bestIndex = 0, bestTop = UINT32_MAX, bestWidth = UINT32_MAX, bestY = 0;
+  for (uint32_t page = 0; page < self->pageCount; page++) {
+    const GlyphAtlasPage_t *atlasPage = &self->pages[page];
+    for (uint32_t index = 0; index < atlasPage->skylineCount; index++) {
+      uint32_t y = 0;
+      if (!_GlyphAtlas_fit(atlasPage, self->pageSize, index, paddedWidth, paddedHeight, &y))
+        continue;
+
+      uint32_t top = y + paddedHeight;
+      if (top < bestTop || (top == bestTop && atlasPage->skyline[index].width < bestWidth)) {
+        bestPage = page;
+        bestIndex = index;
+        bestTop = top;
+        bestWidth = atlasPage->skyline[index].width;
+        bestY = y;
+      }
+    }
+
+    // Earlier pages are only filled further when they still have room
+    if (bestPage != UINT32_MAX)
+      break;
+  }
+
+  if (bestPage == UINT32_MAX) {
+    _GlyphAtlas_addPage(self);
+    bestPage = self->pageCount - 1;
+    bestIndex = 0;
+    bestY = 0;
+  }
+
+  GlyphAtlasPage_t *page = &self->pages[bestPage];
+  uint32_t x = page->skyline[bestIndex].x;
+  _GlyphAtlas_place(page, bestIndex, x, bestY + paddedHeight, paddedWidth);
+
+  *out = (GlyphAtlasRect_t) {
+    .page = bestPage,
+    .x = x + GLYPH_ATLAS_PADDING,
+    .y = bestY + GLYPH_ATLAS_PADDING,
+    .width = width,
+    .height = height
+  };
+  return RESULT_SUCCESS;
+}
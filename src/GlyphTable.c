@@ -0,0 +1,138 @@
+#include <stdlib.h>
+#include <string.h>
+
+#include "GlyphTable.h"
+
+#define DEFAULT_ASTRAL_CAP (1 << 6)
+#define DEFAULT_CHUNK_CAP (1 << 2)
+
+void GlyphTable_init(GlyphTable_t *self, size_t entrySize) {
+  *self = (GlyphTable_t) {
+    .entrySize = entrySize,
+    .count = 0,
+    ._astralKeys = calloc(DEFAULT_ASTRAL_CAP, sizeof(UC_t)),
+    ._astralEntries = malloc(sizeof(uint8_t *) * DEFAULT_ASTRAL_CAP),
+    ._astralCount = 0,
+    ._astralCap = DEFAULT_ASTRAL_CAP,
+    ._chunks = malloc(sizeof(uint8_t *) * DEFAULT_CHUNK_CAP),
+    ._chunkCount = 0,
+    ._chunkCap = DEFAULT_CHUNK_CAP,
+    ._chunkUsed = GLYPH_TABLE_CHUNK_ENTRIES
+  };
+}
+
+void GlyphTable_cleanup(GlyphTable_t *self) {
+  for (uint32_t page = 0; page < GLYPH_TABLE_BMP_PAGES; page++) {
+    if (self->pages[page] == NULL)
+      continue;
+
+    free(self->pages[page]->entries);
+    free(self->pages[page]);
+  }
+
+  for (uint32_t chunk = 0; chunk < self->_chunkCount; chunk++) {
+    free(self->_chunks[chunk]);
+  }
+  free(self->_chunks);
+  free(self->_astralKeys);
+  free(self->_astralEntries);
+  *self = (GlyphTable_t) {0};
+}
+
+uint32_t _GlyphTable_hash(UC_t character) {
+  uint32_t hash = character * 0x9E3779B1u;
+  return hash ^ (hash >> 16);
+}
+
+// Slot of character in the astral map, or the free slot it would go in
+uint32_t _GlyphTable_probe(const UC_t *keys, uint32_t cap, UC_t character) {
+  uint32_t slot = _GlyphTable_hash(character) & (cap - 1);
+  while (keys[slot] != 0 && keys[slot] != character) {
+    slot = (slot + 1) & (cap - 1);
+  }
+  return slot;
+}
+
+void *GlyphTable_get(const GlyphTable_t *self, UC_t character) {
+  if (character < 0x10000) {
+    const GlyphTablePage_t *page = self->pages[character >> GLYPH_TABLE_PAGE_BITS];
+    uint32_t index = character & (GLYPH_TABLE_PAGE_SIZE - 1);
+    if (page == NULL || !(page->present[index >> 5] & (1u << (index & 31))))
+      return NULL;
+
+    return page->entries + self->entrySize * index;
+  }
+
+  uint32_t slot = _GlyphTable_probe(self->_astralKeys, self->_astralCap, character);
+  return self->_astralKeys[slot] == 0 ? NULL : self->_astralEntries[slot];
+}
+
+// Rehashes the keys into a map twice the size, the entries themselves stay where they are
+void _GlyphTable_growAstral(GlyphTable_t *self) {
+  uint32_t oldCap = self->_astralCap;
+  UC_t *oldKeys = self->_astralKeys;
+  uint8_t **oldEntries = self->_astralEntries;
+
+  self->_astralCap <<= 1;
+  self->_astralKeys = calloc(self->_astralCap, sizeof(UC_t));
+  self->_astralEntries = malloc(sizeof(uint8_t *) * self->_astralCap);
+
+  for (uint32_t slot = 0; slot < oldCap; slot++) {
+    if (oldKeys[slot] == 0)
+      continue;
+
+    uint32_t newSlot = _GlyphTable_probe(self->_astralKeys, self->_astralCap, oldKeys[slot]);
+    self->_astralKeys[newSlot] = oldKeys[slot];
+    self->_astralEntries[newSlot] = oldEntries[slot];
+  }
+
+  free(oldKeys);
+  free(oldEntries);
+}
+
+// Zeroed entry from the current chunk, a full one is left as is and a new one started
+uint8_t *_GlyphTable_allocAstral(GlyphTable_t *self) {
+  if (self->_chunkUsed == GLYPH_TABLE_CHUNK_ENTRIES) {
+    if (self->_chunkCount == self->_chunkCap) {
+      self->_chunkCap <<= 1;
+      self->_chunks = realloc(self->_chunks, sizeof(uint8_t *) * self->_chunkCap);
+    }
+    self->_chunks[self->_chunkCount++] = calloc(GLYPH_TABLE_CHUNK_ENTRIES, self->entrySize);
+    self->_chunkUsed = 0;
+  }
+
+  return self->_chunks[self->_chunkCount - 1] + self->entrySize * self->_chunkUsed++;
+}
+
+void *GlyphTable_insert(GlyphTable_t *self, UC_t character) {
+  if (character < 0x10000) {
+    GlyphTablePage_t **page = &self->pages[character >> GLYPH_TABLE_PAGE_BITS];
+    if (*page == NULL) {
+      *page = calloc(1, sizeof(GlyphTablePage_t));
+      (*page)->entries = calloc(GLYPH_TABLE_PAGE_SIZE, self->entrySize);
+    }
+
+    uint32_t index = character & (GLYPH_TABLE_PAGE_SIZE - 1);
+    uint32_t bit = 1u << (index & 31);
+    if ((*page)->present[index >> 5] & bit)
+      return NULL;
+
+    (*page)->present[index >> 5] |= bit;
+    self->count++;
+    return (*page)->entries + self->entrySize * index;
+  }
+
+  // Kept at most half full so probes stay short
+  if ((self->_astralCount + 1) * 2 > self->_astralCap)
+    _GlyphTable_growAstral(self);
+
+  uint32_t slot = _GlyphTable_probe(self->_astralKeys, self->_astralCap, character);
+  if (self->_astralKeys[slot] != 0)
+    return NULL;
+
+  self->_astralKeys[slot] = character;
+  self->_astralEntries[slot] = _GlyphTable_allocAstral(self);
+  self->_astralCount++;
+  self->count++;
+  return self->_astralEntries[slot];
+}
@@ -1,4 +1,56 @@
 #include "MacroDatabase.h"
+#include "MacroGoal.h"
+#include "MacroKernel.h"
+#include "MacroMorsel.h"
+#include "MacroPack.h"
+#include "MacroPyramid.h"
+#include "MacroRollup.h"
+#include "MacroSnapshot.h"
+#include "MacroTrend.h"
+#include "MacroView.h"
+#include "MacroZone.h"
+
+// http://howardhinnant.github.io/date_algorithms.html#days_from_civil
+DayNum_t Date_toDayNum(Date_t date) {
+  int32_t year = (int32_t)date.year - (date.month <= 2);
+  int32_t era = (year >= 0 ? year : year - 399) / 400;
+  uint32_t yearOfEra = (uint32_t)(year - era * 400);
+  uint32_t dayOfYear = (153 * (date.month > 2 ? date.month - 3 : date.month + 9) + 2) / 5 + date.day - 1;
+  uint32_t dayOfEra = yearOfEra * 365 + yearOfEra / 4 - yearOfEra / 100 + dayOfYear;
+
+  return (DayNum_t)(era * 146097 + (int32_t)dayOfEra - 719468);
+}
+
+// http://howardhinnant.github.io/date_algorithms.html#civil_from_days
+Date_t Date_fromDayNum(DayNum_t day) {
+  int64_t shifted = (int64_t)day + 719468;
+  int64_t era = shifted / 146097;
+  uint32_t dayOfEra = (uint32_t)(shifted - era * 146097);
+  uint32_t yearOfEra = (dayOfEra - dayOfEra / 1460 + dayOfEra / 36524 - dayOfEra / 146096) / 365;
+  uint32_t dayOfYear = dayOfEra - (365 * yearOfEra + yearOfEra / 4 - yearOfEra / 100);
+  uint32_t monthPrime = (5 * dayOfYear + 2) / 153;
+  uint32_t month = monthPrime < 10 ? monthPrime + 3 : monthPrime - 9;
+
+  return (Date_t) {
+    .year = (uint32_t)(yearOfEra + era * 400) + (month <= 2),
+    .month = month,
+    .day = dayOfYear - (153 * monthPrime + 2) / 5 + 1
+  };
+}
+
+uint32_t Date_daysInMonth(uint32_t year, uint32_t month) {
+  static const uint8_t days[12] = { 31, 28, 31, 30, 31, 30, 31, 31, 30, 31, 30, 31 };
+  bool leap = (year % 4 == 0 && year % 100 != 0) || year % 400 == 0;
+  return month == 2 && leap ? 29 : days[month - 1];
+}
+
+_Bool Date_isValid(Date_t date) {
+  return date.month >= 1 && date.month <= 12 && date.day >= 1 && date.day <= Date_daysInMonth(date.year, date.month);
+}
+
+_Bool Date_isStorable(Date_t date) {
+  return date.year >= DATE_MIN_YEAR && date.year <= DATE_MAX_YEAR && Date_isValid(date);
+}
 
 void Meal_logData(Meal_t *meal) {
   printf("Meal (%u/%u/%u)\n", meal->date.day, meal->date.month, meal->date.year);
@@ -9,42 +61,371 @@ _Bool Meal_validate(Meal_t *self) {
   return self->macro.cals > ((self->macro.protein + self->macro.carbs) * 4 + self->macro.fat * 9);
 }
 
-MacroDatabase_t *MacroDatabase_create() {
+MacroDatabase_t *MacroDatabase_create(uint32_t maxMeals) {
+  if (maxMeals > MACRO_DATABASE_MAX_MEALS_LIMIT) {
+    log_error("Macro database can't hold more than %u meals, %u requested" ENDL,
+      MACRO_DATABASE_MAX_MEALS_LIMIT, maxMeals
+    );
+    return NULL;
+  }
+
+  // Morsel workers and view readers call the kernels, they are picked here before either exists
+  MacroKernel_init();
+
   MacroDatabase_t *self = malloc(sizeof(MacroDatabase_t));
+  if (self == NULL) {
+    log_error("Failed to allocate the macro database" ENDL);
+    return NULL;
+  }
+
   *self = (MacroDatabase_t) {
-    ._mealCapacity = DEFAULT_BUF_CAP,
-    .meals = malloc(sizeof(Meal_t) * DEFAULT_BUF_CAP),
     .mealCount = 0,
+    .maxMeals = maxMeals != 0 ? maxMeals : MACRO_DATABASE_DEFAULT_MAX_MEALS,
+    .frozenCount = 0,
+    ._cold = NULL,
+    ._rollup = NULL,
+    ._zones = NULL,
+    ._trend = NULL,
+    ._goals = NULL,
+    ._pyramid = NULL,
+    ._views = NULL,
+    ._log = NULL,
+    ._path = NULL
   };
 
-  memset(self->meals, 0, self->_mealCapacity * sizeof(Meal_t));
+  // Index regions stay empty until a snapshot is loaded
+  for (uint32_t region = 0; region <= MACRO_DATABASE_REGION_DAYS; region++) {
+    if (MacroRegion_reserve(&self->_regions[region], sizeof(uint32_t) * (uint64_t)self->maxMeals) != RESULT_SUCCESS)
+      goto macro_database_create_fail;
+  }
+  _MacroDatabase_bindRegions(self);
+  if (MacroIndex_init(&self->index) != RESULT_SUCCESS)
+    goto macro_database_create_fail;
 
   return self;
+
+macro_database_create_fail:
+  log_error("Failed to create a macro database for %u meals" ENDL, self->maxMeals);
+  MacroDatabase_destroy(self);
+  return NULL;
+}
+
+void _MacroDatabase_bindRegions(MacroDatabase_t *self) {
+  uint64_t committed = self->_regions[0].committed;
+  for (uint32_t column = 0; column < MACRO_COLUMN_COUNT; column++) {
+    self->columns[column] = (uint32_t *)self->_regions[column].base;
+    committed = self->_regions[column].committed < committed ? self->_regions[column].committed : committed;
+  }
+
+  MacroRegion_t *days = &self->_regions[MACRO_DATABASE_REGION_DAYS];
+  self->days = (DayNum_t *)days->base;
+  committed = days->committed < committed ? days->committed : committed;
+
+  self->_mealCapacity = (uint32_t)(committed / sizeof(uint32_t));
+}
+
+Result_t _MacroDatabase_insert(MacroDatabase_t *self, DayNum_t day, const Macro_t *macro);
+
+void _MacroDatabase_buildPath(MacroDatabase_t *self, const char *extension, char out[MAX_PATH]) {
+  snprintf(out, MAX_PATH, "%s%s", self->_path, extension);
+}
+
+void _MacroDatabase_replayRecord(MacroDatabase_t *self, const MacroLogRecord_t *record) {
+  Macro_t macro = {
+    .cals = record->cals,
+    .protein = record->protein,
+    .fat = record->fat,
+    .carbs = record->carbs
+  };
+  _MacroDatabase_insert(self, record->day, &macro);
+}
+
+MacroDatabase_t *MacroDatabase_open(const char *path, const MacroLogInfo_t *info, uint32_t maxMeals) {
+  MacroDatabase_t *self = MacroDatabase_create(maxMeals);
+  if (self == NULL) {
+    log_error("Failed to open macro database %s" ENDL, path);
+    return NULL;
+  }
+
+  size_t pathSize = strlen(path) + 1;
+  if ((self->_path = malloc(pathSize)) == NULL)
+    goto macro_database_open_fail;
+  memcpy(self->_path, path, pathSize);
+
+  char snapshotPath[MAX_PATH] = {0};
+  char logPath[MAX_PATH] = {0};
+  _MacroDatabase_buildPath(self, MACRO_SNAPSHOT_EXT, snapshotPath);
+  _MacroDatabase_buildPath(self, MACRO_LOG_EXT, logPath);
+
+  uint64_t nextSequence = 0;
+  if (MacroSnapshot_map(self, snapshotPath, &nextSequence) != RESULT_SUCCESS)
+    goto macro_database_open_fail;
+
+  // Loaded before the log is replayed so the records since the snapshot update it
+  char pyramidPath[MAX_PATH] = {0};
+  _MacroDatabase_buildPath(self, MACRO_PYRAMID_EXT, pyramidPath);
+  if ((self->_pyramid = malloc(sizeof(MacroPyramid_t))) == NULL)
+    goto macro_database_open_fail;
+  if (MacroPyramid_init(self->_pyramid) != RESULT_SUCCESS ||
+      MacroPyramid_read(self->_pyramid, pyramidPath, self->mealCount, nextSequence) != RESULT_SUCCESS) {
+    MacroPyramid_cleanup(self->_pyramid);
+    free(self->_pyramid);
+    self->_pyramid = NULL;
+  }
+
+  if ((self->_log = malloc(sizeof(MacroLog_t))) == NULL)
+    goto macro_database_open_fail;
+  if (MacroLog_open(self->_log, logPath, info) != RESULT_SUCCESS) {
+    free(self->_log);
+    self->_log = NULL;
+    goto macro_database_open_fail;
+  }
+
+  if (MacroLog_recover(self->_log, nextSequence,
+      (MacroLogReplayCBCK_t)_MacroDatabase_replayRecord, self) != RESULT_SUCCESS)
+    goto macro_database_open_fail;
+
+  log_info("Opened macro database %s with %u meals (%llu in the log)" ENDL,
+    path, self->mealCount, (unsigned long long)self->_log->recordCount
+  );
+  return self;
+
+macro_database_open_fail:
+  log_error("Failed to open macro database %s" ENDL, path);
+  MacroDatabase_destroy(self);
+  return NULL;
+}
+
+Result_t MacroDatabase_sync(MacroDatabase_t *self) {
+  if (self->_log == NULL)
+    return RESULT_SUCCESS;
+
+  return MacroLog_sync(self->_log);
+}
+
+Result_t MacroDatabase_poll(MacroDatabase_t *self) {
+  if (self->_log == NULL)
+    return RESULT_SUCCESS;
+
+  return MacroLog_poll(self->_log);
+}
+
+Result_t MacroDatabase_compact(MacroDatabase_t *self) {
+  if (self->_log == NULL)
+    return RESULT_SUCCESS;
+
+  char snapshotPath[MAX_PATH] = {0};
+  _MacroDatabase_buildPath(self, MACRO_SNAPSHOT_EXT, snapshotPath);
+
+  // The snapshot is durable before the log gets emptied, a crash in between replays
+  // nothing twice because the snapshot remembers the first sequence it doesn't contain
+  if (MacroSnapshot_write(self, snapshotPath, self->_log->nextSequence) != RESULT_SUCCESS)
+    return RESULT_FAIL;
+
+  // Only a cache of the snapshot, a missing or stale pyramid is built again when needed
+  char pyramidPath[MAX_PATH] = {0};
+  _MacroDatabase_buildPath(self, MACRO_PYRAMID_EXT, pyramidPath);
+  if (self->_pyramid != NULL && self->_pyramid->levels[0].count > 0) {
+    MacroPyramid_write(self->_pyramid, pyramidPath, self->mealCount, self->_log->nextSequence);
+  } else {
+    DeleteFileA(pyramidPath);
+  }
+
+  return MacroLog_truncate(self->_log);
 }
 
 void MacroDatabase_destroy(MacroDatabase_t *self) {
-  free(self->meals);
-  
-  self->_mealCapacity = 0;
+  if (self->_log != NULL) {
+    MacroLog_close(self->_log);
+    free(self->_log);
+    self->_log = NULL;
+  }
+  free(self->_path);
+  self->_path = NULL;
+
+  if (self->_rollup != NULL) {
+    MacroRollup_cleanup(self->_rollup);
+    free(self->_rollup);
+    self->_rollup = NULL;
+  }
+
+  if (self->_zones != NULL) {
+    MacroZoneMap_cleanup(self->_zones);
+    free(self->_zones);
+    self->_zones = NULL;
+  }
+
+  if (self->_trend != NULL) {
+    MacroTrend_cleanup(self->_trend);
+    free(self->_trend);
+    self->_trend = NULL;
+  }
+
+  if (self->_goals != NULL) {
+    MacroGoals_cleanup(self->_goals);
+    free(self->_goals);
+    self->_goals = NULL;
+  }
+
+  if (self->_pyramid != NULL) {
+    MacroPyramid_cleanup(self->_pyramid);
+    free(self->_pyramid);
+    self->_pyramid = NULL;
+  }
+
+  if (self->_views != NULL) {
+    MacroViews_destroy(self->_views);
+    self->_views = NULL;
+  }
+
+  if (self->_cold != NULL) {
+    MacroPack_cleanup(self->_cold);
+    free(self->_cold);
+    self->_cold = NULL;
+  }
+  self->frozenCount = 0;
+
+  // The index may point into the regions, it goes first
+  MacroIndex_cleanup(&self->index);
+  for (uint32_t region = 0; region < MACRO_DATABASE_REGION_COUNT; region++) {
+    MacroRegion_release(&self->_regions[region]);
+  }
+  _MacroDatabase_bindRegions(self);
+
   self->mealCount = 0;
-  self->meals = NULL;
   free(self);
 }
 
-void MacroDatabase_logToConsole(MacroDatabase_t *self) {
-  for (Meal_t *meal = &self->meals[0]; meal < &self->meals[self->mealCount]; meal++) {
-    Meal_logData(meal);
+Meal_t MacroDatabase_getMeal(MacroDatabase_t *self, uint32_t index) {
+  DEBUG_ASSERT(index < self->mealCount, "Meal index out of range");
+
+  if (index < self->frozenCount) {
+    Meal_t meal;
+    DayNum_t day;
+    MacroPack_get(self->_cold, index, &meal.macro, &day);
+    meal.date = Date_fromDayNum(day);
+    return meal;
   }
+
+  return (Meal_t) {
+    .macro = {
+      .cals = self->cals[index],
+      .protein = self->protein[index],
+      .fat = self->fat[index],
+      .carbs = self->carbs[index]
+    },
+    .date = Date_fromDayNum(self->days[index])
+  };
 }
 
-void _MacroDatabase_resize(MacroDatabase_t *self, uint32_t newCount) {
-  self->mealCount = newCount;
+uint32_t MacroDatabase_rows(const MacroDatabase_t *self, uint32_t first, uint32_t count, MacroRows_t *out) {
+  count = count < self->mealCount - first ? count : self->mealCount - first;
+
+  if (first >= self->frozenCount) {
+    for (uint32_t column = 0; column < MACRO_COLUMN_COUNT; column++) {
+      out->columns[column] = &self->columns[column][first];
+    }
+    out->days = &self->days[first];
+    out->count = count;
+    return count;
+  }
+
+  // Stops at the last frozen row, the hot ones after it come with the next call
+  count = count < self->frozenCount - first ? count : self->frozenCount - first;
+  count = count < MACRO_DATABASE_FREEZE_ROWS ? count : MACRO_DATABASE_FREEZE_ROWS;
+
+  uint32_t *values[MACRO_COLUMN_COUNT];
+  for (uint32_t column = 0; column < MACRO_COLUMN_COUNT; column++) {
+    values[column] = out->_values[column];
+    out->columns[column] = out->_values[column];
+  }
+  MacroPack_decode(self->_cold, first, count, values, out->_days);
+  out->days = out->_days;
+  out->count = count;
+  return count;
+}
+
+bool MacroDatabase_dayBounds(const MacroDatabase_t *self, DayNum_t *first, DayNum_t *last) {
+  *first = DAY_NUM_MAX;
+  *last = DAY_NUM_MIN;
+
+  MacroRows_t rows;
+  for (uint32_t row = 0; row < self->mealCount; row += rows.count) {
+    MacroDatabase_rows(self, row, self->mealCount - row, &rows);
+    for (uint32_t index = 0; index < rows.count; index++) {
+      DayNum_t day = rows.days[index];
+      if (day > DATE_MAX_DAY_NUM)
+        continue;
+      *first = day < *first ? day : *first;
+      *last = day > *last ? day : *last;
+    }
+  }
+
+  return *first <= *last;
+}
 
-  while (self->_mealCapacity < sizeof(Meal_t) * self->mealCount) {
-    self->_mealCapacity <<= 1;
+Result_t MacroDatabase_freeze(MacroDatabase_t *self, uint32_t rowCount) {
+  if (self->_views != NULL) {
+    log_error("Can't freeze rows while views are enabled" ENDL);
+    return RESULT_FAIL;
   }
 
-  self->meals = realloc(self->meals, self->_mealCapacity);
+  rowCount = rowCount < self->mealCount ? rowCount : self->mealCount;
+  rowCount -= rowCount % MACRO_DATABASE_FREEZE_ROWS;
+  if (rowCount <= self->frozenCount)
+    return RESULT_SUCCESS;
+
+  if (self->_cold == NULL) {
+    if ((self->_cold = malloc(sizeof(MacroPack_t))) == NULL) {
+      log_error("Failed to allocate the packed meals" ENDL);
+      return RESULT_FAIL;
+    }
+    MacroPack_init(self->_cold);
+  }
+
+  // Zones only ever read the rows added since their last update, summarized now they never
+  // need the frozen ones again
+  if (MacroDatabase_zones(self) == NULL)
+    return RESULT_FAIL;
+
+  const uint32_t *columns[MACRO_COLUMN_COUNT];
+  for (uint32_t column = 0; column < MACRO_COLUMN_COUNT; column++) {
+    columns[column] = &self->columns[column][self->frozenCount];
+  }
+  if (MacroPack_append(self->_cold, columns, &self->days[self->frozenCount], rowCount - self->frozenCount) != RESULT_SUCCESS)
+    return RESULT_FAIL;
+
+  self->frozenCount = rowCount;
+  for (uint32_t region = 0; region <= MACRO_DATABASE_REGION_DAYS; region++) {
+    MacroRegion_discard(&self->_regions[region], sizeof(uint32_t) * (uint64_t)rowCount);
+  }
+
+  log_info("Froze %u meals into %llu packed bytes" ENDL,
+    rowCount, (unsigned long long)MacroPack_size(self->_cold)
+  );
+  return RESULT_SUCCESS;
+}
+
+void MacroDatabase_logToConsole(MacroDatabase_t *self) {
+  for (uint32_t index = 0; index < self->mealCount; index++) {
+    Meal_t meal = MacroDatabase_getMeal(self, index);
+    Meal_logData(&meal);
+  }
+}
+
+// _mealCapacity is counted in meals, every column has _mealCapacity values committed
+Result_t _MacroDatabase_resize(MacroDatabase_t *self, uint32_t newCount) {
+  if (newCount > self->_mealCapacity) {
+    uint64_t bytes = sizeof(uint32_t) * (uint64_t)newCount;
+    for (uint32_t region = 0; region <= MACRO_DATABASE_REGION_DAYS; region++) {
+      if (MacroRegion_commit(&self->_regions[region], bytes) != RESULT_SUCCESS)
+        return RESULT_FAIL;
+    }
+    _MacroDatabase_bindRegions(self);
+  }
+
+  self->mealCount = newCount;
+  return RESULT_SUCCESS;
 }
 
 void MacroDatabase_add(MacroDatabase_t *self, Meal_t meal) {
@@ -52,7 +433,429 @@ void MacroDatabase_add(MacroDatabase_t *self, Meal_t meal) {
     printf("Meal's macros are greater than calories\n");
     return;
   }
+  if (!Date_isStorable(meal.date)) {
+    printf("Meal's date is invalid or before %u\n", DATE_MIN_YEAR);
+    return;
+  }
+
+  DayNum_t day = Date_toDayNum(meal.date);
+  if (_MacroDatabase_insert(self, day, &meal.macro) != RESULT_SUCCESS)
+    return;
+
+  if (self->_views != NULL)
+    MacroViews_publish(self->_views, self);
+  if (self->_log == NULL)
+    return;
+
+  MacroLogRecord_t record = {
+    .day = day,
+    .cals = meal.macro.cals,
+    .protein = meal.macro.protein,
+    .fat = meal.macro.fat,
+    .carbs = meal.macro.carbs
+  };
+  if (MacroLog_append(self->_log, record) != RESULT_SUCCESS) {
+    log_error("Meal was added in memory but couldn't be logged" ENDL);
+    return;
+  }
+
+  if (self->_log->info.compactThreshold != 0 &&
+      self->_log->recordCount >= self->_log->info.compactThreshold)
+    MacroDatabase_compact(self);
+}
+
+// Writes a validated meal into an already resized row, without logging it
+void _MacroDatabase_store(MacroDatabase_t *self, uint32_t row, DayNum_t day, const Macro_t *macro) {
+  self->cals[row] = macro->cals;
+  self->protein[row] = macro->protein;
+  self->fat[row] = macro->fat;
+  self->carbs[row] = macro->carbs;
+  self->days[row] = day;
+
+  MacroIndex_insert(&self->index, day, row);
+  if (self->_rollup != NULL)
+    MacroRollup_add(self->_rollup, day, macro);
+  if (self->_trend != NULL)
+    MacroTrend_add(self->_trend, day, macro);
+  if (self->_goals != NULL)
+    MacroGoals_add(self->_goals, day, macro);
+  if (self->_pyramid != NULL)
+    MacroPyramid_add(self->_pyramid, day, macro);
+  if (self->_views != NULL)
+    MacroViews_add(self->_views, day, macro);
+}
+
+// Stores a meal that is already validated, without logging it
+Result_t _MacroDatabase_insert(MacroDatabase_t *self, DayNum_t day, const Macro_t *macro) {
+  if (_MacroDatabase_resize(self, self->mealCount + 1) != RESULT_SUCCESS) {
+    log_error("Macro database is full, meal dropped" ENDL);
+    return RESULT_FAIL;
+  }
+
+  _MacroDatabase_store(self, self->mealCount - 1, day, macro);
+  return RESULT_SUCCESS;
+}
+
+size_t MacroDatabase_addBatch(MacroDatabase_t *self, const Meal_t *meals, size_t n, uint8_t *rejectMask) {
+  size_t maskSize = (n + 7) / 8;
+  uint8_t *mask = rejectMask != NULL ? rejectMask : malloc(maskSize);
+  if (mask == NULL) {
+    log_error("Failed to allocate the reject mask of %zu meals, batch dropped" ENDL, n);
+    return 0;
+  }
+  size_t accepted = n - MacroKernel_validate(meals, n, mask);
+
+  // Dates repeat between consecutive meals, only a new one is checked
+  Date_t checkedDate = {0};
+  bool checkedValid = false;
+  for (size_t meal = 0; meal < n; meal++) {
+    if (mask[meal >> 3] & (1u << (meal & 7)))
+      continue;
+
+    Date_t date = meals[meal].date;
+    if (date.day != checkedDate.day || date.month != checkedDate.month || date.year != checkedDate.year) {
+      checkedDate = date;
+      checkedValid = Date_isStorable(date);
+    }
+    if (!checkedValid) {
+      mask[meal >> 3] |= (uint8_t)(1u << (meal & 7));
+      accepted--;
+    }
+  }
+
+  // One resize for the whole batch, rejected meals leave no gaps
+  uint32_t row = self->mealCount;
+  if (accepted > self->maxMeals - row ||
+      _MacroDatabase_resize(self, row + (uint32_t)accepted) != RESULT_SUCCESS) {
+    log_error("Macro database can't fit %zu more meals, batch dropped" ENDL, accepted);
+    memset(mask, 0xFF, maskSize);
+    accepted = 0;
+    n = 0;
+  }
+
+  // Columns first, then the index in one go so sorted batches are appended block by block
+  uint32_t firstRow = row;
+  Date_t lastDate = {0};
+  DayNum_t lastDay = 0;
+  for (size_t meal = 0; meal < n; meal++) {
+    if (mask[meal >> 3] & (1u << (meal & 7)))
+      continue;
+
+    // Histories come a few meals per day, the date conversion is reused between them
+    const Meal_t *current = &meals[meal];
+    if (row == firstRow || current->date.day != lastDate.day ||
+        current->date.month != lastDate.month || current->date.year != lastDate.year) {
+      lastDate = current->date;
+      lastDay = Date_toDayNum(lastDate);
+    }
 
-  _MacroDatabase_resize(self, self->mealCount + 1);
-  self->meals[self->mealCount - 1] = meal;
-}
\ No newline at end of file
+    self->cals[row] = current->macro.cals;
+    self->protein[row] = current->macro.protein;
+    self->fat[row] = current->macro.fat;
+    self->carbs[row] = current->macro.carbs;
+    self->days[row] = lastDay;
+    row++;
+  }
+  MacroIndex_insertBatch(&self->index, &self->days[firstRow], firstRow, row - firstRow);
+
+  for (uint32_t stored = firstRow; stored < row; stored++) {
+    if (self->_rollup == NULL && self->_trend == NULL && self->_goals == NULL &&
+        self->_pyramid == NULL && self->_views == NULL && self->_log == NULL)
+      break;
+
+    Macro_t macro = {
+      .cals = self->cals[stored],
+      .protein = self->protein[stored],
+      .fat = self->fat[stored],
+      .carbs = self->carbs[stored]
+    };
+    if (self->_rollup != NULL)
+      MacroRollup_add(self->_rollup, self->days[stored], &macro);
+    if (self->_trend != NULL)
+      MacroTrend_add(self->_trend, self->days[stored], &macro);
+    if (self->_goals != NULL)
+      MacroGoals_add(self->_goals, self->days[stored], &macro);
+    if (self->_pyramid != NULL)
+      MacroPyramid_add(self->_pyramid, self->days[stored], &macro);
+    if (self->_views != NULL)
+      MacroViews_add(self->_views, self->days[stored], &macro);
+    if (self->_log == NULL)
+      continue;
+
+    MacroLogRecord_t record = {
+      .day = self->days[stored],
+      .cals = macro.cals,
+      .protein = macro.protein,
+      .fat = macro.fat,
+      .carbs = macro.carbs
+    };
+    if (MacroLog_append(self->_log, record) != RESULT_SUCCESS)
+      log_error("Meal was added in memory but couldn't be logged" ENDL);
+  }
+
+  if (rejectMask == NULL)
+    free(mask);
+
+  // The whole batch becomes visible to readers at once
+  if (self->_views != NULL && accepted > 0)
+    MacroViews_publish(self->_views, self);
+
+  if (self->_log != NULL && self->_log->info.compactThreshold != 0 &&
+      self->_log->recordCount >= self->_log->info.compactThreshold)
+    MacroDatabase_compact(self);
+
+  return accepted;
+}
+
+void MacroDatabase_range(MacroDatabase_t *self, Date_t from, Date_t to, MacroIndexRange_t *out) {
+  MacroIndex_range(&self->index, Date_toDayNum(from), Date_toDayNum(to), out);
+}
+
+const MacroZoneMap_t *MacroDatabase_zones(MacroDatabase_t *self) {
+  if (self->_zones == NULL) {
+    if ((self->_zones = malloc(sizeof(MacroZoneMap_t))) == NULL) {
+      log_error("Failed to allocate the zone map" ENDL);
+      return NULL;
+    }
+    if (MacroZoneMap_init(self->_zones) != RESULT_SUCCESS) {
+      log_error("Failed to allocate the zone map" ENDL);
+      free(self->_zones);
+      self->_zones = NULL;
+      return NULL;
+    }
+  }
+
+  if (MacroZoneMap_update(self->_zones, (const uint32_t *const *)self->columns, self->days, self->mealCount) != RESULT_SUCCESS) {
+    log_error("Failed to grow the zone map to %u meals" ENDL, self->mealCount);
+    return NULL;
+  }
+  return self->_zones;
+}
+
+void _MacroDatabase_reduceRows(MacroDatabase_t *self, uint32_t first, uint32_t end, DayNum_t from, DayNum_t to, MacroStats_t *acc) {
+  if (first < self->frozenCount) {
+    uint32_t frozenEnd = end < self->frozenCount ? end : self->frozenCount;
+    MacroPack_reduce(self->_cold, first, frozenEnd - first, from, to, acc);
+    first = frozenEnd;
+  }
+  if (end <= first)
+    return;
+
+  const uint32_t *columns[MACRO_COLUMN_COUNT];
+  for (uint32_t column = 0; column < MACRO_COLUMN_COUNT; column++) {
+    columns[column] = &self->columns[column][first];
+  }
+  MacroKernel_reduce(columns, &self->days[first], end - first, from, to, acc);
+}
+
+// Reduces rows [first, first + count) (first on a zone boundary) skipping the zones that can't
+// hold days in [from, to], runs of zones that can go through the kernel in one call
+void _MacroDatabase_reduceZones(MacroDatabase_t *self, const MacroZoneMap_t *zones, uint32_t first, uint32_t count,
+  DayNum_t from, DayNum_t to, MacroStats_t *acc, MacroZoneCounts_t *counts) {
+  uint32_t end = first + count;
+  uint32_t runStart = first;
+  for (uint32_t row = first; row < end; row += MACRO_ZONE_ROWS) {
+    if (MacroZone_overlapsDays(&zones->zones[row / MACRO_ZONE_ROWS], from, to)) {
+      counts->read++;
+      continue;
+    }
+
+    counts->skipped++;
+    _MacroDatabase_reduceRows(self, runStart, row, from, to, acc);
+    runStart = end - row > MACRO_ZONE_ROWS ? row + MACRO_ZONE_ROWS : end;
+  }
+  _MacroDatabase_reduceRows(self, runStart, end, from, to, acc);
+}
+
+void MacroDatabase_statsDays(MacroDatabase_t *self, DayNum_t from, DayNum_t to, MacroStats_t *out) {
+  MacroStats_reset(out);
+  const MacroZoneMap_t *zones = MacroDatabase_zones(self);
+  if (zones != NULL) {
+    _MacroDatabase_reduceZones(self, zones, 0, self->mealCount, from, to, out, &self->_zones->counts);
+  } else {
+    _MacroDatabase_reduceRows(self, 0, self->mealCount, from, to, out);
+  }
+  MacroStats_finalize(out);
+}
+
+void MacroDatabase_stats(MacroDatabase_t *self, Date_t from, Date_t to, MacroStats_t *out) {
+  MacroDatabase_statsDays(self, Date_toDayNum(from), Date_toDayNum(to), out);
+}
+
+typedef struct __MacroStatsMorsels_t {
+  MacroDatabase_t *db;
+  const MacroZoneMap_t *zones;
+  DayNum_t from, to;
+  // One per worker
+  MacroStats_t *partials;
+  MacroZoneCounts_t *counts;
+} MacroStatsMorsels_t;
+
+void _MacroDatabase_statsMorsel(MacroStatsMorsels_t *self, uint32_t worker, uint32_t first, uint32_t count) {
+  MacroStats_t morsel;
+  MacroZoneCounts_t counts = {0};
+  MacroStats_reset(&morsel);
+  if (self->zones != NULL) {
+    _MacroDatabase_reduceZones(self->db, self->zones, first, count, self->from, self->to, &morsel, &counts);
+  } else {
+    _MacroDatabase_reduceRows(self->db, first, first + count, self->from, self->to, &morsel);
+  }
+
+  MacroStats_merge(&self->partials[worker], &morsel);
+  self->counts[worker].read += counts.read;
+  self->counts[worker].skipped += counts.skipped;
+}
+
+void MacroDatabase_statsDaysParallel(MacroDatabase_t *self, DayNum_t from, DayNum_t to, uint32_t threadCount, MacroStats_t *out) {
+  threadCount = MacroMorsel_threadCount(threadCount);
+  MacroStatsMorsels_t morsels = {
+    .db = self,
+    .zones = MacroDatabase_zones(self),
+    .from = from,
+    .to = to,
+    .partials = malloc(sizeof(MacroStats_t) * threadCount),
+    .counts = calloc(threadCount, sizeof(MacroZoneCounts_t))
+  };
+  for (uint32_t worker = 0; worker < threadCount; worker++) {
+    MacroStats_reset(&morsels.partials[worker]);
+  }
+
+  MacroMorsel_run(self->mealCount, threadCount, (MacroMorselFn_t)_MacroDatabase_statsMorsel, &morsels);
+
+  MacroStats_reset(out);
+  for (uint32_t worker = 0; worker < threadCount; worker++) {
+    MacroStats_merge(out, &morsels.partials[worker]);
+    if (morsels.zones == NULL)
+      continue;
+    self->_zones->counts.read += morsels.counts[worker].read;
+    self->_zones->counts.skipped += morsels.counts[worker].skipped;
+  }
+  MacroStats_finalize(out);
+  free(morsels.partials);
+  free(morsels.counts);
+}
+
+void MacroDatabase_statsParallel(MacroDatabase_t *self, Date_t from, Date_t to, uint32_t threadCount, MacroStats_t *out) {
+  MacroDatabase_statsDaysParallel(self, Date_toDayNum(from), Date_toDayNum(to), threadCount, out);
+}
+
+const MacroRollup_t *MacroDatabase_rollup(MacroDatabase_t *self) {
+  if (self->_rollup != NULL)
+    return self->_rollup;
+
+  if ((self->_rollup = malloc(sizeof(MacroRollup_t))) == NULL) {
+    log_error("Failed to allocate the rollups" ENDL);
+    return NULL;
+  }
+  if (MacroRollup_init(self->_rollup) != RESULT_SUCCESS) {
+    log_error("Failed to allocate the rollups" ENDL);
+    MacroRollup_cleanup(self->_rollup);
+    free(self->_rollup);
+    self->_rollup = NULL;
+    return NULL;
+  }
+
+  MacroRows_t rows;
+  for (uint32_t first = 0; first < self->mealCount; first += rows.count) {
+    MacroDatabase_rows(self, first, self->mealCount - first, &rows);
+    for (uint32_t row = 0; row < rows.count; row++) {
+      Macro_t macro = {
+        .cals = rows.columns[MACRO_COLUMN_CALS][row],
+        .protein = rows.columns[MACRO_COLUMN_PROTEIN][row],
+        .fat = rows.columns[MACRO_COLUMN_FAT][row],
+        .carbs = rows.columns[MACRO_COLUMN_CARBS][row]
+      };
+      MacroRollup_add(self->_rollup, rows.days[row], &macro);
+    }
+  }
+
+  return self->_rollup;
+}
+
+void MacroDatabase_totalsDays(MacroDatabase_t *self, DayNum_t from, DayNum_t to, MacroTotals_t *out) {
+  const MacroRollup_t *rollup = MacroDatabase_rollup(self);
+  if (rollup != NULL) {
+    MacroRollup_range(rollup, from, to, out);
+    return;
+  }
+
+  // Without rollups every row is read instead
+  MacroStats_t stats;
+  MacroDatabase_statsDays(self, from, to, &stats);
+  *out = (MacroTotals_t) { .count = stats.count };
+  memcpy(out->sum, stats.sum, sizeof(out->sum));
+}
+
+void MacroDatabase_totals(MacroDatabase_t *self, Date_t from, Date_t to, MacroTotals_t *out) {
+  MacroDatabase_totalsDays(self, Date_toDayNum(from), Date_toDayNum(to), out);
+}
+
+MacroTrend_t *MacroDatabase_trend(MacroDatabase_t *self) {
+  if (self->_trend != NULL)
+    return self->_trend;
+
+  if ((self->_trend = malloc(sizeof(MacroTrend_t))) == NULL) {
+    log_error("Failed to allocate the trend lines" ENDL);
+    return NULL;
+  }
+  if (MacroTrend_init(self->_trend) != RESULT_SUCCESS) {
+    log_error("Failed to allocate the trend lines" ENDL);
+    free(self->_trend);
+    self->_trend = NULL;
+    return NULL;
+  }
+  MacroTrend_build(self->_trend, self);
+  return self->_trend;
+}
+
+MacroGoals_t *MacroDatabase_setGoals(MacroDatabase_t *self, const MacroGoalTarget_t *targets) {
+  if (self->_goals != NULL) {
+    MacroGoals_setTargets(self->_goals, targets);
+    return self->_goals;
+  }
+
+  if ((self->_goals = malloc(sizeof(MacroGoals_t))) == NULL) {
+    log_error("Failed to allocate the goal days" ENDL);
+    return NULL;
+  }
+  if (MacroGoals_init(self->_goals, targets) != RESULT_SUCCESS) {
+    log_error("Failed to allocate the goal days" ENDL);
+    MacroGoals_cleanup(self->_goals);
+    free(self->_goals);
+    self->_goals = NULL;
+    return NULL;
+  }
+  MacroGoals_build(self->_goals, self);
+  return self->_goals;
+}
+
+const MacroPyramid_t *MacroDatabase_pyramid(MacroDatabase_t *self) {
+  if (self->_pyramid != NULL)
+    return self->_pyramid;
+
+  if ((self->_pyramid = malloc(sizeof(MacroPyramid_t))) == NULL) {
+    log_error("Failed to allocate the pyramid" ENDL);
+    return NULL;
+  }
+  if (MacroPyramid_init(self->_pyramid) != RESULT_SUCCESS) {
+    log_error("Failed to allocate the pyramid" ENDL);
+    MacroPyramid_cleanup(self->_pyramid);
+    free(self->_pyramid);
+    self->_pyramid = NULL;
+    return NULL;
+  }
+  MacroPyramid_build(self->_pyramid, self);
+  return self->_pyramid;
+}
+
+Result_t MacroDatabase_enableViews(MacroDatabase_t *self) {
+  if (self->_views != NULL)
+    return RESULT_SUCCESS;
+  if (self->frozenCount > 0) {
+    log_error("Views can't be enabled on a database with frozen rows" ENDL);
+    return RESULT_FAIL;
+  }
+
+  self->_views = MacroViews_create(self);
+  return self->_views != NULL ? RESULT_SUCCESS : RESULT_FAIL;
+}
@@ -0,0 +1,288 @@
+#include <stdlib.h>
+#include <string.h>
+
+#include <log.h>
+
+#include "MacroGoal.h"
+
+#define DEFAULT_GOAL_CAP (1 << 9)
+
+Result_t MacroGoals_init(MacroGoals_t *self, const MacroGoalTarget_t targets[7]) {
+  *self = (MacroGoals_t) {
+    .days = malloc(sizeof(MacroGoalDay_t) * DEFAULT_GOAL_CAP),
+    .firstDay = 0,
+    .dayCount = 0,
+    ._dayCap = DEFAULT_GOAL_CAP,
+    ._prefixDirty = 0,
+    ._streakStart = 0,
+    ._streakCounts = calloc(DEFAULT_GOAL_CAP + 1, sizeof(uint32_t)),
+    .longestStreak = 0
+  };
+  memcpy(self->targets, targets, sizeof(self->targets));
+  return self->days != NULL && self->_streakCounts != NULL ? RESULT_SUCCESS : RESULT_FAIL;
+}
+
+void MacroGoals_cleanup(MacroGoals_t *self) {
+  free(self->days);
+  free(self->_streakCounts);
+  *self = (MacroGoals_t) {0};
+}
+
+bool _MacroGoals_reserve(MacroGoals_t *self, uint32_t count) {
+  if (count <= self->_dayCap)
+    return true;
+
+  uint32_t capacity;
+  if (!Common_growCapacity(self->_dayCap, count, &capacity))
+    return false;
+
+  MacroGoalDay_t *days = realloc(self->days, sizeof(MacroGoalDay_t) * capacity);
+  if (days == NULL)
+    return false;
+  self->days = days;
+
+  uint32_t *streakCounts = realloc(self->_streakCounts, sizeof(uint32_t) * ((size_t)capacity + 1));
+  if (streakCounts == NULL)
+    return false;
+  memset(&streakCounts[self->_dayCap + 1], 0, sizeof(uint32_t) * (capacity - self->_dayCap));
+
+  self->_streakCounts = streakCounts;
+  self->_dayCap = capacity;
+  return true;
+}
+
+// Status, deficit and surplus of a day from its totals
+void _MacroGoals_judge(MacroGoals_t *self, uint32_t index) {
+  MacroGoalDay_t *day = &self->days[index];
+  const MacroGoalTarget_t *target = &self->targets[((uint64_t)self->firstDay + index + 3) % 7];
+  const uint64_t *sum = day->totals.sum;
+
+  day->deficit = day->surplus = 0;
+  if (day->totals.count == 0) {
+    day->status = MACRO_GOAL_NONE;
+    return;
+  }
+
+  bool passes = true;
+  if (target->cals != 0) {
+    uint64_t cals = sum[MACRO_COLUMN_CALS];
+    day->deficit = cals < target->cals ? target->cals - cals : 0;
+    day->surplus = cals > target->cals ? cals - target->cals : 0;
+    passes &= day->deficit <= target->calsTolerance && day->surplus <= target->calsTolerance;
+  }
+  passes &= target->proteinMin == 0 || sum[MACRO_COLUMN_PROTEIN] >= target->proteinMin;
+  passes &= target->fatMax == 0 || sum[MACRO_COLUMN_FAT] <= target->fatMax;
+  passes &= target->carbsMax == 0 || sum[MACRO_COLUMN_CARBS] <= target->carbsMax;
+
+  day->status = passes ? MACRO_GOAL_PASS : MACRO_GOAL_FAIL;
+}
+
+// Adds or drops one streak of length, keeping longestStreak on the longest one left
+void _MacroGoals_streak(MacroGoals_t *self, uint32_t length, bool add) {
+  if (length == 0)
+    return;
+
+  if (add) {
+    self->_streakCounts[length]++;
+    self->longestStreak = length > self->longestStreak ? length : self->longestStreak;
+    return;
+  }
+
+  self->_streakCounts[length]--;
+  while (self->longestStreak > 0 && self->_streakCounts[self->longestStreak] == 0) {
+    self->longestStreak--;
+  }
+}
+
+// Judges the day again, a day that starts or stops passing joins or splits the streaks around it
+void _MacroGoals_evaluate(MacroGoals_t *self, uint32_t index) {
+  bool passed = self->days[index].status == MACRO_GOAL_PASS;
+  _MacroGoals_judge(self, index);
+  self->_prefixDirty = index < self->_prefixDirty ? index : self->_prefixDirty;
+
+  bool passes = self->days[index].status == MACRO_GOAL_PASS;
+  if (passes == passed)
+    return;
+
+  uint32_t before = 0, after = 0;
+  while (before < index && self->days[index - before - 1].status == MACRO_GOAL_PASS) {
+    before++;
+  }
+  while (index + after + 1 < self->dayCount && self->days[index + after + 1].status == MACRO_GOAL_PASS) {
+    after++;
+  }
+
+  // The longer streak goes in first, dropping the shorter ones never walks longestStreak far
+  if (passes) {
+    _MacroGoals_streak(self, before + 1 + after, true);
+    _MacroGoals_streak(self, before, false);
+    _MacroGoals_streak(self, after, false);
+    if (index + 1 == self->_streakStart)
+      self->_streakStart = index - before;
+  } else {
+    _MacroGoals_streak(self, before, true);
+    _MacroGoals_streak(self, after, true);
+    _MacroGoals_streak(self, before + 1 + after, false);
+    if (index >= self->_streakStart)
+      self->_streakStart = index + 1;
+  }
+}
+
+// Index of day, the table grows to it on either side with days without meals. UINT32_MAX when it can't grow
+uint32_t _MacroGoals_at(MacroGoals_t *self, DayNum_t day) {
+  if (self->dayCount == 0) {
+    self->firstDay = day;
+    self->days[0] = (MacroGoalDay_t) {0};
+    self->dayCount = 1;
+    self->_streakStart = 1;
+    return 0;
+  }
+
+  if (day < self->firstDay) {
+    // Empty days before the history don't touch any streak
+    uint32_t shift = self->firstDay - day;
+    if (!_MacroGoals_reserve(self, self->dayCount + shift))
+      return UINT32_MAX;
+    memmove(&self->days[shift], self->days, sizeof(MacroGoalDay_t) * self->dayCount);
+    memset(self->days, 0, sizeof(MacroGoalDay_t) * shift);
+
+    self->firstDay = day;
+    self->dayCount += shift;
+    self->_streakStart += shift;
+    self->_prefixDirty = 0;
+    return 0;
+  }
+
+  uint32_t index = day - self->firstDay;
+  if (index >= self->dayCount) {
+    if (!_MacroGoals_reserve(self, index + 1))
+      return UINT32_MAX;
+    memset(&self->days[self->dayCount], 0, sizeof(MacroGoalDay_t) * (index + 1 - self->dayCount));
+
+    self->_prefixDirty = self->dayCount < self->_prefixDirty ? self->dayCount : self->_prefixDirty;
+    self->dayCount = index + 1;
+    self->_streakStart = self->dayCount;
+  }
+  return index;
+}
+
+void MacroGoals_add(MacroGoals_t *self, DayNum_t day, const Macro_t *macro) {
+  const uint32_t *values = &macro->cals;
+  uint32_t index = day <= DATE_MAX_DAY_NUM ? _MacroGoals_at(self, day) : UINT32_MAX;
+  if (index == UINT32_MAX) {
+    log_error("Day %u left out of the goals" ENDL, day);
+    return;
+  }
+
+  MacroTotals_t *totals = &self->days[index].totals;
+
+  for (uint32_t column = 0; column < MACRO_COLUMN_COUNT; column++) {
+    totals->sum[column] += values[column];
+  }
+  totals->count++;
+
+  _MacroGoals_evaluate(self, index);
+}
+
+// Judges every day and counts the streaks in one pass
+void _MacroGoals_evaluateAll(MacroGoals_t *self) {
+  memset(self->_streakCounts, 0, sizeof(uint32_t) * (self->dayCount + 1));
+  self->longestStreak = 0;
+
+  uint32_t streak = 0;
+  for (uint32_t index = 0; index < self->dayCount; index++) {
+    _MacroGoals_judge(self, index);
+    if (self->days[index].status == MACRO_GOAL_PASS) {
+      streak++;
+      continue;
+    }
+
+    _MacroGoals_streak(self, streak, true);
+    streak = 0;
+  }
+  _MacroGoals_streak(self, streak, true);
+
+  self->_streakStart = self->dayCount - streak;
+  self->_prefixDirty = 0;
+}
+
+void MacroGoals_build(MacroGoals_t *self, const MacroDatabase_t *db) {
+  DEBUG_ASSERT(self->dayCount == 0, "Goal days are already built");
+
+  // Days past DATE_MAX_DAY_NUM are left out, like MacroGoals_add does
+  DayNum_t first, last;
+  if (!MacroDatabase_dayBounds(db, &first, &last) || !_MacroGoals_reserve(self, last - first + 1))
+    return;
+
+  self->firstDay = first;
+  self->dayCount = last - first + 1;
+  memset(self->days, 0, sizeof(MacroGoalDay_t) * self->dayCount);
+
+  MacroRows_t rows;
+  for (uint32_t row = 0; row < db->mealCount; row += rows.count) {
+    MacroDatabase_rows(db, row, db->mealCount - row, &rows);
+    for (uint32_t index = 0; index < rows.count; index++) {
+      if (rows.days[index] > DATE_MAX_DAY_NUM)
+        continue;
+
+      MacroTotals_t *totals = &self->days[rows.days[index] - first].totals;
+      for (uint32_t column = 0; column < MACRO_COLUMN_COUNT; column++) {
+        totals->sum[column] += rows.columns[column][index];
+      }
+      totals->count++;
+    }
+  }
+
+  _MacroGoals_evaluateAll(self);
+}
+
+void MacroGoals_setTargets(MacroGoals_t *self, const MacroGoalTarget_t targets[7]) {
+  memcpy(self->targets, targets, sizeof(self->targets));
+  _MacroGoals_evaluateAll(self);
+}
+
+MacroGoalStatus_t MacroGoals_status(const MacroGoals_t *self, DayNum_t day) {
+  if (self->dayCount == 0 || day < self->firstDay || day - self->firstDay >= self->dayCount)
+    return MACRO_GOAL_NONE;
+
+  return self->days[day - self->firstDay].status;
+}
+
+uint32_t MacroGoals_currentStreak(const MacroGoals_t *self) {
+  return self->dayCount - self->_streakStart;
+}
+
+void MacroGoals_summary(MacroGoals_t *self, DayNum_t from, DayNum_t to, MacroGoalSummary_t *out) {
+  *out = (MacroGoalSummary_t) {0};
+  if (self->dayCount == 0 || from > to)
+    return;
+
+  // Clamped to the days there are
+  DayNum_t lastDay = self->firstDay + self->dayCount - 1;
+  if (to < self->firstDay || from > lastDay)
+    return;
+  uint32_t first = from > self->firstDay ? from - self->firstDay : 0;
+  uint32_t last = to < lastDay ? to - self->firstDay : self->dayCount - 1;
+
+  for (uint32_t index = self->_prefixDirty; index < self->dayCount; index++) {
+    const MacroGoalDay_t *day = &self->days[index];
+    MacroGoalSummary_t *prefix = &self->days[index].prefix;
+    *prefix = index > 0 ? self->days[index - 1].prefix : (MacroGoalSummary_t) {0};
+
+    prefix->logged += day->status != MACRO_GOAL_NONE;
+    prefix->passed += day->status == MACRO_GOAL_PASS;
+    prefix->deficit += day->deficit;
+    prefix->surplus += day->surplus;
+  }
+  self->_prefixDirty = self->dayCount;
+
+  *out = self->days[last].prefix;
+  if (first == 0)
+    return;
+
+  const MacroGoalSummary_t *before = &self->days[first - 1].prefix;
+  out->logged -= before->logged;
+  out->passed -= before->passed;
+  out->deficit -= before->deficit;
+  out->surplus -= before->surplus;
+}
@@ -0,0 +1,490 @@
+#include <log.h>
+
+#include "MacroImport.h"
+
+typedef struct __MacroImportChunk_t {
+  char *data;
+  // Records start at data + offset (a skipped header or BOM is left in front)
+  uint32_t offset, size;
+
+  Meal_t *meals;
+  uint32_t mealCount, malformed;
+  bool parsed;
+} MacroImportChunk_t;
+
+// Chunks are handed out in sequence, chunk i lives in slot i % chunkCount
+typedef struct __MacroImportPool_t {
+  MacroImportFormat_t format;
+  MacroImportChunk_t *chunks;
+  uint32_t chunkCount;
+
+  uint64_t submitted, taken;
+  bool stopping;
+
+  CRITICAL_SECTION lock;
+  CONDITION_VARIABLE workAvailable, workDone;
+} MacroImportPool_t;
+
+bool _MacroImport_isDigit(char c) {
+  return (unsigned char)(c - '0') <= 9;
+}
+
+bool _MacroImport_isSpace(char c) {
+  return c == ' ' || c == '\t' || c == '\r' || c == '\n';
+}
+
+const char *_MacroImport_skipSpace(const char *cursor, const char *end) {
+  while (cursor < end && _MacroImport_isSpace(*cursor)) {
+    cursor++;
+  }
+
+  return cursor;
+}
+
+// End of the CSV record starting at cursor, the first newline outside a quoted field
+const char *_MacroImport_csvRecordEnd(const char *cursor, const char *end) {
+  const char *lineEnd = memchr(cursor, '\n', (size_t)(end - cursor));
+  lineEnd = lineEnd != NULL ? lineEnd : end;
+  if (memchr(cursor, '"', (size_t)(lineEnd - cursor)) == NULL)
+    return lineEnd;
+
+  // A doubled quote toggles twice, so counting quotes is enough to know if c is inside a field
+  bool quoted = false;
+  for (const char *c = cursor; c < end; c++) {
+    if (*c == '"')
+      quoted = !quoted;
+    else if (*c == '\n' && !quoted)
+      return c;
+  }
+  return end;
+}
+
+// RFC 4180 field starting at *cursor: a quoted one runs to its closing quote ("" is an escaped
+// quote), an unquoted one to the next comma. Spaces around either are allowed.
+// [*valueStart, *valueEnd) is the field without its quotes, *cursor ends up on the comma or end
+bool _MacroImport_csvField(const char **cursor, const char *end, const char **valueStart, const char **valueEnd) {
+  const char *c = _MacroImport_skipSpace(*cursor, end);
+  if (c < end && *c == '"') {
+    *valueStart = ++c;
+    while (true) {
+      c = memchr(c, '"', (size_t)(end - c));
+      if (c == NULL)
+        return false;
+      if (c + 1 < end && c[1] == '"') {
+        c += 2;
+        continue;
+      }
+      break;
+    }
+    *valueEnd = c;
+    c = _MacroImport_skipSpace(c + 1, end);
+  } else {
+    *valueStart = c;
+    while (c < end && *c != ',') {
+      c++;
+    }
+    *valueEnd = c;
+    while (*valueEnd > *valueStart && _MacroImport_isSpace((*valueEnd)[-1])) {
+      (*valueEnd)--;
+    }
+  }
+
+  *cursor = c;
+  return c == end || *c == ',';
+}
+
+// Decimal exports are truncated, values past UINT32_MAX are malformed
+bool _MacroImport_parseUint(const char **cursor, const char *end, uint32_t *out) {
+  const char *c = *cursor;
+  if (c == end || !_MacroImport_isDigit(*c))
+    return false;
+
+  uint64_t value = 0;
+  for (; c < end && _MacroImport_isDigit(*c); c++) {
+    value = value * 10 + (uint64_t)(*c - '0');
+    if (value > UINT32_MAX)
+      return false;
+  }
+
+  if (c < end && *c == '.') {
+    for (c++; c < end && _MacroImport_isDigit(*c); c++);
+  }
+
+  *cursor = c;
+  *out = (uint32_t)value;
+  return true;
+}
+
+// Fixed width YYYY-MM-DD, anything after the day (a time, a zone) is left to the caller
+bool _MacroImport_parseDate(const char **cursor, const char *end, Date_t *out) {
+  const char *c = *cursor;
+  if (end - c < 10 || c[4] != '-' || c[7] != '-')
+    return false;
+
+  const uint32_t positions[8] = { 0, 1, 2, 3, 5, 6, 8, 9 };
+  uint32_t digits[8] = {0};
+  for (uint32_t digit = 0; digit < 8; digit++) {
+    if (!_MacroImport_isDigit(c[positions[digit]]))
+      return false;
+    digits[digit] = (uint32_t)(c[positions[digit]] - '0');
+  }
+
+  *out = (Date_t) {
+    .year = digits[0] * 1000 + digits[1] * 100 + digits[2] * 10 + digits[3],
+    .month = digits[4] * 10 + digits[5],
+    .day = digits[6] * 10 + digits[7]
+  };
+  if (!Date_isStorable(*out))
+    return false;
+
+  *cursor = c + 10;
+  return true;
+}
+
+bool _MacroImport_parseCsvRow(const char *c, const char *end, Meal_t *out) {
+  // The rest of a full timestamp is skipped with the field
+  const char *value, *valueEnd;
+  if (!_MacroImport_csvField(&c, end, &value, &valueEnd) ||
+      !_MacroImport_parseDate(&value, valueEnd, &out->date))
+    return false;
+
+  uint32_t *values = &out->macro.cals;
+  for (uint32_t column = 0; column < MACRO_COLUMN_COUNT; column++) {
+    if (c == end)
+      return false;
+
+    c++;
+    if (!_MacroImport_csvField(&c, end, &value, &valueEnd) ||
+        !_MacroImport_parseUint(&value, valueEnd, &values[column]) || value != valueEnd)
+      return false;
+  }
+
+  return c == end;
+}
+
+typedef enum __MacroImportJsonKey_t {
+  JSON_KEY_DATE = MACRO_COLUMN_COUNT,
+  JSON_KEY_UNKNOWN
+} MacroImportJsonKey_t;
+
+uint32_t _MacroImport_jsonKey(const char *key, size_t length) {
+  if (length == 4 && memcmp(key, "date", 4) == 0) return JSON_KEY_DATE;
+  if (length == 4 && memcmp(key, "cals", 4) == 0) return MACRO_COLUMN_CALS;
+  if (length == 8 && memcmp(key, "calories", 8) == 0) return MACRO_COLUMN_CALS;
+  if (length == 7 && memcmp(key, "protein", 7) == 0) return MACRO_COLUMN_PROTEIN;
+  if (length == 3 && memcmp(key, "fat", 3) == 0) return MACRO_COLUMN_FAT;
+  if (length == 5 && memcmp(key, "carbs", 5) == 0) return MACRO_COLUMN_CARBS;
+  return JSON_KEY_UNKNOWN;
+}
+
+// Members of one flat object, between its braces
+bool _MacroImport_parseJsonObject(const char *c, const char *end, Meal_t *out) {
+  uint32_t *values = &out->macro.cals;
+  uint32_t found = 0;
+
+  while (true) {
+    while (c < end && (_MacroImport_isSpace(*c) || *c == ','))
+      c++;
+    if (c == end)
+      break;
+    if (*c != '"')
+      return false;
+
+    const char *keyEnd = memchr(c + 1, '"', (size_t)(end - c - 1));
+    if (keyEnd == NULL)
+      return false;
+    uint32_t key = _MacroImport_jsonKey(c + 1, (size_t)(keyEnd - c - 1));
+
+    for (c = keyEnd + 1; c < end && _MacroImport_isSpace(*c); c++);
+    if (c == end || *c != ':')
+      return false;
+    for (c++; c < end && _MacroImport_isSpace(*c); c++);
+    if (c == end)
+      return false;
+
+    bool quoted = *c == '"';
+    const char *valueEnd = end;
+    if (quoted) {
+      valueEnd = memchr(c + 1, '"', (size_t)(end - c - 1));
+      if (valueEnd == NULL)
+        return false;
+      c++;
+    }
+
+    if (key == JSON_KEY_DATE) {
+      if (!_MacroImport_parseDate(&c, valueEnd, &out->date))
+        return false;
+    } else if (key < MACRO_COLUMN_COUNT) {
+      if (!_MacroImport_parseUint(&c, valueEnd, &values[key]))
+        return false;
+    }
+    if (key != JSON_KEY_UNKNOWN)
+      found |= 1u << key;
+
+    // Rest of the value (time part, unknown members)
+    if (quoted) {
+      c = valueEnd + 1;
+    } else {
+      while (c < end && *c != ',')
+        c++;
+    }
+  }
+
+  return found == (1u << (JSON_KEY_DATE + 1)) - 1;
+}
+
+uint32_t MacroImport_parse(MacroImportFormat_t format, const char *data, uint32_t size, Meal_t *out, uint32_t *malformed) {
+  const char *cursor = data;
+  const char *end = data + size;
+  uint32_t count = 0;
+  *malformed = 0;
+
+  if (format == MACRO_IMPORT_CSV) {
+    while (cursor < end) {
+      const char *lineEnd = _MacroImport_csvRecordEnd(cursor, end);
+
+      if (_MacroImport_parseCsvRow(cursor, lineEnd, &out[count])) {
+        count++;
+      } else if (_MacroImport_skipSpace(cursor, lineEnd) != lineEnd) {
+        (*malformed)++;
+      }
+      cursor = lineEnd + 1;
+    }
+
+    return count;
+  }
+
+  while (cursor < end) {
+    const char *open = memchr(cursor, '{', (size_t)(end - cursor));
+    if (open == NULL)
+      break;
+
+    const char *close = memchr(open, '}', (size_t)(end - open));
+    if (close == NULL) {
+      (*malformed)++;
+      break;
+    }
+
+    if (_MacroImport_parseJsonObject(open + 1, close, &out[count])) {
+      count++;
+    } else {
+      (*malformed)++;
+    }
+    cursor = close + 1;
+  }
+
+  return count;
+}
+
+DWORD WINAPI _MacroImport_worker(MacroImportPool_t *pool) {
+  EnterCriticalSection(&pool->lock);
+  while (true) {
+    while (pool->taken == pool->submitted && !pool->stopping) {
+      SleepConditionVariableCS(&pool->workAvailable, &pool->lock, INFINITE);
+    }
+    if (pool->taken == pool->submitted)
+      break;
+
+    MacroImportChunk_t *chunk = &pool->chunks[pool->taken++ % pool->chunkCount];
+    LeaveCriticalSection(&pool->lock);
+
+    chunk->mealCount = MacroImport_parse(pool->format, chunk->data + chunk->offset,
+      chunk->size, chunk->meals, &chunk->malformed
+    );
+
+    EnterCriticalSection(&pool->lock);
+    chunk->parsed = true;
+    WakeAllConditionVariable(&pool->workDone);
+  }
+  LeaveCriticalSection(&pool->lock);
+
+  return 0;
+}
+
+// Waits for the chunk's parse and adds it, chunks are committed in file order
+void _MacroImport_commit(MacroImportPool_t *pool, MacroImportChunk_t *chunk, MacroDatabase_t *db, MacroImportStats_t *stats) {
+  EnterCriticalSection(&pool->lock);
+  while (!chunk->parsed) {
+    SleepConditionVariableCS(&pool->workDone, &pool->lock, INFINITE);
+  }
+  LeaveCriticalSection(&pool->lock);
+
+  stats->rows += chunk->mealCount;
+  stats->malformed += chunk->malformed;
+  stats->added += MacroDatabase_addBatch(db, chunk->meals, chunk->mealCount, NULL);
+}
+
+// Position after the last whole record, 0 when there is none. Chunks start on a record, so
+// with quotes in a CSV chunk it is scanned forward to skip the newlines inside quoted fields
+uint32_t _MacroImport_lastBoundary(MacroImportFormat_t format, const char *data, uint32_t size) {
+  if (format == MACRO_IMPORT_CSV && memchr(data, '"', size) != NULL) {
+    uint32_t last = 0;
+    bool quoted = false;
+    for (uint32_t position = 0; position < size; position++) {
+      if (data[position] == '"')
+        quoted = !quoted;
+      else if (data[position] == '\n' && !quoted)
+        last = position + 1;
+    }
+    return last;
+  }
+
+  char boundary = format == MACRO_IMPORT_CSV ? '\n' : '}';
+  for (uint32_t position = size; position > 0; position--) {
+    if (data[position - 1] == boundary)
+      return position;
+  }
+
+  return 0;
+}
+
+// UTF-8 BOM and a CSV header line, only present at the start of the file
+uint32_t _MacroImport_preambleSize(MacroImportFormat_t format, const char *data, uint32_t size) {
+  uint32_t offset = 0;
+  if (size >= 3 && memcmp(data, "\xEF\xBB\xBF", 3) == 0)
+    offset = 3;
+
+  if (format != MACRO_IMPORT_CSV || offset == size)
+    return offset;
+
+  uint32_t first = data[offset] == '"' ? offset + 1 : offset;
+  if (first < size && _MacroImport_isDigit(data[first]))
+    return offset;
+
+  const char *lineEnd = memchr(data + offset, '\n', size - offset);
+  return lineEnd != NULL ? (uint32_t)(lineEnd - data) + 1 : size;
+}
+
+Result_t MacroImport_file(MacroDatabase_t *db, const char *path, const MacroImportInfo_t *info, MacroImportStats_t *stats) {
+  *stats = (MacroImportStats_t) {0};
+
+  HANDLE file = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING,
+    FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, NULL
+  );
+  if (file == INVALID_HANDLE_VALUE) {
+    log_error("Couldn't open the import file %s, error code: %lu" ENDL, path, GetLastError());
+    return RESULT_FAIL;
+  }
+
+  uint32_t threadCount = info->threadCount;
+  if (threadCount == 0) {
+    SYSTEM_INFO system = {0};
+    GetSystemInfo(&system);
+    threadCount = system.dwNumberOfProcessors > 0 ? system.dwNumberOfProcessors : 1;
+  }
+
+  // Two chunks per thread, one being parsed while the other waits to be added
+  MacroImportPool_t pool = {
+    .format = info->format,
+    .chunkCount = threadCount * 2,
+    .submitted = 0,
+    .taken = 0,
+    .stopping = false
+  };
+  InitializeCriticalSection(&pool.lock);
+  InitializeConditionVariable(&pool.workAvailable);
+  InitializeConditionVariable(&pool.workDone);
+
+  // Zeroed so the cleanup can free chunks that were never reached
+  pool.chunks = calloc(pool.chunkCount, sizeof(MacroImportChunk_t));
+  bool allocated = pool.chunks != NULL;
+  for (uint32_t chunk = 0; chunk < pool.chunkCount && allocated; chunk++) {
+    pool.chunks[chunk] = (MacroImportChunk_t) {
+      .data = malloc(info->chunkSize),
+      .meals = malloc(sizeof(Meal_t) * MACRO_IMPORT_MAX_MEALS(info->chunkSize))
+    };
+    allocated = pool.chunks[chunk].data != NULL && pool.chunks[chunk].meals != NULL;
+  }
+  char *carry = malloc(info->chunkSize);
+  uint32_t carrySize = 0;
+
+  Result_t result = RESULT_SUCCESS;
+  HANDLE *threads = malloc(sizeof(HANDLE) * threadCount);
+  if (!allocated || carry == NULL || threads == NULL) {
+    log_error("Failed to allocate the import buffers of %u threads" ENDL, threadCount);
+    result = RESULT_FAIL;
+    goto macro_import_file_cleanup;
+  }
+
+  for (uint32_t thread = 0; thread < threadCount; thread++) {
+    threads[thread] = CreateThread(NULL, 0, (LPTHREAD_START_ROUTINE)_MacroImport_worker, &pool, 0, NULL);
+    if (threads[thread] == NULL) {
+      log_error("Failed to create import thread, error code: %lu" ENDL, GetLastError());
+      result = RESULT_FAIL;
+    }
+  }
+
+  uint64_t committed = 0;
+  bool eof = result != RESULT_SUCCESS;
+  for (uint64_t sequence = 0; !eof; sequence++) {
+    MacroImportChunk_t *chunk = &pool.chunks[sequence % pool.chunkCount];
+    if (sequence - committed == pool.chunkCount) {
+      _MacroImport_commit(&pool, chunk, db, stats);
+      committed++;
+    }
+
+    // The partial record left over by the previous chunk goes in front
+    memcpy(chunk->data, carry, carrySize);
+    DWORD requested = info->chunkSize - carrySize;
+    DWORD readBytes = 0;
+    if (!ReadFile(file, chunk->data + carrySize, requested, &readBytes, NULL)) {
+      log_error("Failed to read the import file %s, error code: %lu" ENDL, path, GetLastError());
+      result = RESULT_FAIL;
+      break;
+    }
+    stats->bytes += readBytes;
+    eof = readBytes < requested;
+
+    uint32_t size = carrySize + readBytes;
+    uint32_t offset = sequence == 0 ? _MacroImport_preambleSize(info->format, chunk->data, size) : 0;
+    uint32_t cut = eof ? size : _MacroImport_lastBoundary(info->format, chunk->data, size);
+    if (cut <= offset && !eof) {
+      log_error("Import file %s has a record longer than %u bytes" ENDL, path, info->chunkSize);
+      result = RESULT_FAIL;
+      break;
+    }
+
+    carrySize = size - cut;
+    memcpy(carry, chunk->data + cut, carrySize);
+
+    chunk->offset = offset;
+    chunk->size = cut - offset;
+    chunk->parsed = false;
+
+    EnterCriticalSection(&pool.lock);
+    pool.submitted++;
+    WakeConditionVariable(&pool.workAvailable);
+    LeaveCriticalSection(&pool.lock);
+  }
+
+  // What was submitted is still added on failure, the database stays consistent either way
+  for (; committed < pool.submitted; committed++) {
+    _MacroImport_commit(&pool, &pool.chunks[committed % pool.chunkCount], db, stats);
+  }
+
+  EnterCriticalSection(&pool.lock);
+  pool.stopping = true;
+  WakeAllConditionVariable(&pool.workAvailable);
+  LeaveCriticalSection(&pool.lock);
+
+  for (uint32_t thread = 0; thread < threadCount; thread++) {
+    if (threads[thread] == NULL)
+      continue;
+
+    WaitForSingleObject(threads[thread], INFINITE);
+    CloseHandle(threads[thread]);
+  }
+
+macro_import_file_cleanup:
+  free(threads);
+  for (uint32_t chunk = 0; pool.chunks != NULL && chunk < pool.chunkCount; chunk++) {
+    free(pool.chunks[chunk].data);
+    free(pool.chunks[chunk].meals);
+  }
+  free(pool.chunks);
+  free(carry);
+  DeleteCriticalSection(&pool.lock);
+  CloseHandle(file);
+
+  return result;
+}
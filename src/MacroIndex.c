@@ -0,0 +1,316 @@
+#include <log.h>
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "MacroIndex.h"
+
+#define DEFAULT_BLOCK_CAP (1 << 4)
+
+Result_t MacroIndex_init(MacroIndex_t *self) {
+  *self = (MacroIndex_t) {
+    .baseDays = NULL,
+    .baseRows = NULL,
+    .baseCount = 0,
+    ._blockCap = DEFAULT_BLOCK_CAP,
+    .blockCount = 0,
+    .blocks = malloc(sizeof(MacroIndexBlock_t *) * DEFAULT_BLOCK_CAP),
+    .fences = malloc(sizeof(DayNum_t) * DEFAULT_BLOCK_CAP),
+    .rowCount = 0
+  };
+
+  if (self->blocks == NULL || self->fences == NULL) {
+    log_error("Failed to allocate the macro index" ENDL);
+    return RESULT_FAIL;
+  }
+
+  return RESULT_SUCCESS;
+}
+
+void MacroIndex_cleanup(MacroIndex_t *self) {
+  for (uint32_t block = 0; block < self->blockCount; block++) {
+    free(self->blocks[block]);
+  }
+
+  free(self->blocks);
+  free(self->fences);
+  self->blocks = NULL;
+  self->fences = NULL;
+  self->blockCount = 0;
+  self->_blockCap = 0;
+  self->rowCount = 0;
+
+  self->baseDays = NULL;
+  self->baseRows = NULL;
+  self->baseCount = 0;
+}
+
+void MacroIndex_setBase(MacroIndex_t *self, const DayNum_t *days, const uint32_t *rows, uint32_t count) {
+  DEBUG_ASSERT(self->rowCount == self->baseCount, "Index base has to be set before any insert");
+
+  self->baseDays = days;
+  self->baseRows = rows;
+  self->rowCount = count;
+  self->baseCount = count;
+}
+
+// First position whose day is greater than day (keeps equal days in insertion order)
+uint32_t _MacroIndex_upperBound(const DayNum_t *days, uint32_t count, DayNum_t day) {
+  uint32_t lo = 0, hi = count;
+  while (lo < hi) {
+    uint32_t mid = lo + (hi - lo) / 2;
+    if (days[mid] <= day)
+      lo = mid + 1;
+    else
+      hi = mid;
+  }
+
+  return lo;
+}
+
+// First position whose day is not less than day
+uint32_t _MacroIndex_lowerBound(const DayNum_t *days, uint32_t count, DayNum_t day) {
+  uint32_t lo = 0, hi = count;
+  while (lo < hi) {
+    uint32_t mid = lo + (hi - lo) / 2;
+    if (days[mid] < day)
+      lo = mid + 1;
+    else
+      hi = mid;
+  }
+
+  return lo;
+}
+
+MacroIndexBlock_t *_MacroIndex_insertBlock(MacroIndex_t *self, uint32_t position) {
+  if (self->blockCount + 1 > self->_blockCap) {
+    self->_blockCap <<= 1;
+    self->blocks = realloc(self->blocks, sizeof(MacroIndexBlock_t *) * self->_blockCap);
+    self->fences = realloc(self->fences, sizeof(DayNum_t) * self->_blockCap);
+  }
+
+  uint32_t tail = self->blockCount - position;
+  memmove(&self->blocks[position + 1], &self->blocks[position], sizeof(MacroIndexBlock_t *) * tail);
+  memmove(&self->fences[position + 1], &self->fences[position], sizeof(DayNum_t) * tail);
+  self->blockCount++;
+
+  MacroIndexBlock_t *block = malloc(sizeof(MacroIndexBlock_t));
+  block->count = 0;
+  self->blocks[position] = block;
+  return block;
+}
+
+void MacroIndex_insert(MacroIndex_t *self, DayNum_t day, uint32_t row) {
+  self->rowCount++;
+
+  if (self->blockCount == 0) {
+    MacroIndexBlock_t *first = _MacroIndex_insertBlock(self, 0);
+    first->days[0] = day;
+    first->rows[0] = row;
+    first->count = 1;
+    self->fences[0] = day;
+    return;
+  }
+
+  // Last block whose fence is <= day, days before the first fence go into block 0
+  uint32_t blockIndex = _MacroIndex_upperBound(self->fences, self->blockCount, day);
+  blockIndex = blockIndex > 0 ? blockIndex - 1 : 0;
+
+  MacroIndexBlock_t *block = self->blocks[blockIndex];
+  uint32_t position = _MacroIndex_upperBound(block->days, block->count, day);
+
+  if (block->count == MACRO_INDEX_BLOCK_CAP) {
+    // In order appends start a fresh block instead of leaving half empty ones behind
+    if (position == block->count && blockIndex == self->blockCount - 1) {
+      block = _MacroIndex_insertBlock(self, blockIndex + 1);
+      block->days[0] = day;
+      block->rows[0] = row;
+      block->count = 1;
+      self->fences[blockIndex + 1] = day;
+      return;
+    }
+
+    uint32_t half = MACRO_INDEX_BLOCK_CAP / 2;
+    MacroIndexBlock_t *upper = _MacroIndex_insertBlock(self, blockIndex + 1);
+    block = self->blocks[blockIndex];
+
+    memcpy(upper->days, &block->days[half], sizeof(DayNum_t) * half);
+    memcpy(upper->rows, &block->rows[half], sizeof(uint32_t) * half);
+    upper->count = half;
+    block->count = half;
+    self->fences[blockIndex + 1] = upper->days[0];
+
+    if (position > half) {
+      block = upper;
+      blockIndex++;
+      position -= half;
+    }
+  }
+
+  uint32_t tail = block->count - position;
+  memmove(&block->days[position + 1], &block->days[position], sizeof(DayNum_t) * tail);
+  memmove(&block->rows[position + 1], &block->rows[position], sizeof(uint32_t) * tail);
+  block->days[position] = day;
+  block->rows[position] = row;
+  block->count++;
+
+  self->fences[blockIndex] = block->days[0];
+}
+
+void MacroIndex_insertBatch(MacroIndex_t *self, const DayNum_t *days, uint32_t firstRow, uint32_t count) {
+  uint32_t entry = 0;
+  while (entry < count) {
+    MacroIndexBlock_t *last = self->blockCount > 0 ? self->blocks[self->blockCount - 1] : NULL;
+    if (last == NULL || days[entry] < last->days[last->count - 1]) {
+      MacroIndex_insert(self, days[entry], firstRow + entry);
+      entry++;
+      continue;
+    }
+
+    // Sorted runs past the last block are copied in whole, full blocks are followed by fresh ones
+    uint32_t end = entry + 1;
+    while (end < count && days[end] >= days[end - 1]) {
+      end++;
+    }
+
+    while (entry < end) {
+      if (last->count == MACRO_INDEX_BLOCK_CAP) {
+        last = _MacroIndex_insertBlock(self, self->blockCount);
+        self->fences[self->blockCount - 1] = days[entry];
+      }
+
+      uint32_t chunk = MACRO_INDEX_BLOCK_CAP - last->count;
+      chunk = end - entry < chunk ? end - entry : chunk;
+      memcpy(&last->days[last->count], &days[entry], sizeof(DayNum_t) * chunk);
+      for (uint32_t offset = 0; offset < chunk; offset++) {
+        last->rows[last->count + offset] = firstRow + entry + offset;
+      }
+
+      last->count += chunk;
+      self->rowCount += chunk;
+      entry += chunk;
+    }
+  }
+}
+
+void MacroIndex_range(const MacroIndex_t *self, DayNum_t from, DayNum_t to, MacroIndexRange_t *out) {
+  *out = (MacroIndexRange_t) {
+    ._index = self,
+    ._block = self->blockCount,
+    ._pos = 0,
+    ._basePos = 0,
+    ._baseEnd = 0,
+    ._to = to
+  };
+
+  if (from > to)
+    return;
+
+  out->_basePos = _MacroIndex_lowerBound(self->baseDays, self->baseCount, from);
+  out->_baseEnd = _MacroIndex_upperBound(self->baseDays, self->baseCount, to);
+
+  if (self->blockCount == 0)
+    return;
+
+  // Fences are block minimums, so the first match lives in the last block starting before from
+  uint32_t blockIndex = _MacroIndex_lowerBound(self->fences, self->blockCount, from);
+  blockIndex = blockIndex > 0 ? blockIndex - 1 : 0;
+
+  MacroIndexBlock_t *block = self->blocks[blockIndex];
+  uint32_t position = _MacroIndex_lowerBound(block->days, block->count, from);
+  if (position == block->count) {
+    blockIndex++;
+    position = 0;
+  }
+
+  out->_block = blockIndex;
+  out->_pos = position;
+}
+
+bool MacroIndexRange_next(MacroIndexRange_t *self, MacroSpan_t *span) {
+  const MacroIndex_t *index = self->_index;
+  MacroIndexBlock_t *block = self->_block < index->blockCount ?
+    index->blocks[self->_block] : NULL;
+
+  bool hasBlock = block != NULL && block->days[self->_pos] <= self->_to;
+  bool hasBase = self->_basePos < self->_baseEnd;
+
+  if (!hasBlock && !hasBase) {
+    *span = (MacroSpan_t) {0};
+    return false;
+  }
+
+  // Equal days come from the base first, it holds the older rows
+  if (hasBase && (!hasBlock || index->baseDays[self->_basePos] <= block->days[self->_pos])) {
+    uint32_t end = self->_baseEnd;
+    if (hasBlock) {
+      end = self->_basePos + _MacroIndex_upperBound(&index->baseDays[self->_basePos],
+        end - self->_basePos, block->days[self->_pos]);
+    }
+
+    *span = (MacroSpan_t) {
+      .days = &index->baseDays[self->_basePos],
+      .rows = &index->baseRows[self->_basePos],
+      .count = end - self->_basePos
+    };
+    self->_basePos = end;
+    return true;
+  }
+
+  uint32_t end = block->count;
+  if (block->days[block->count - 1] > self->_to)
+    end = _MacroIndex_upperBound(block->days, block->count, self->_to);
+  if (hasBase) {
+    uint32_t beforeBase = self->_pos + _MacroIndex_lowerBound(&block->days[self->_pos],
+      end - self->_pos, index->baseDays[self->_basePos]);
+    end = beforeBase < end ? beforeBase : end;
+  }
+
+  *span = (MacroSpan_t) {
+    .days = &block->days[self->_pos],
+    .rows = &block->rows[self->_pos],
+    .count = end - self->_pos
+  };
+
+  self->_pos = end;
+  if (self->_pos == block->count) {
+    self->_block++;
+    self->_pos = 0;
+  }
+
+  return true;
+}
+
+uint32_t MacroIndex_count(const MacroIndex_t *self, DayNum_t from, DayNum_t to) {
+  MacroIndexRange_t range = {0};
+  MacroSpan_t span = {0};
+  uint32_t count = 0;
+
+  MacroIndex_range(self, from, to, &range);
+  while (MacroIndexRange_next(&range, &span)) {
+    count += span.count;
+  }
+
+  return count;
+}
+
+bool MacroIndex_bounds(const MacroIndex_t *self, DayNum_t *first, DayNum_t *last) {
+  if (self->baseCount == 0 && self->blockCount == 0)
+    return false;
+
+  *first = DAY_NUM_MAX;
+  *last = DAY_NUM_MIN;
+  if (self->baseCount > 0) {
+    *first = self->baseDays[0];
+    *last = self->baseDays[self->baseCount - 1];
+  }
+
+  // Blocks don't overlap, the first and last one hold the extremes
+  if (self->blockCount > 0) {
+    const MacroIndexBlock_t *lastBlock = self->blocks[self->blockCount - 1];
+    *first = self->blocks[0]->days[0] < *first ? self->blocks[0]->days[0] : *first;
+    *last = lastBlock->days[lastBlock->count - 1] > *last ? lastBlock->days[lastBlock->count - 1] : *last;
+  }
+
+  return true;
+}
@@ -0,0 +1,548 @@
+#define WIN32_LEAN_AND_MEAN
+#include <Windows.h>
+
+#include "MacroKernel.h"
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__x86_64__) || defined(__i386__)
+  #define MACRO_KERNEL_X86
+  #include <immintrin.h>
+  #ifdef _MSC_VER
+    #include <intrin.h>
+    #define MACRO_KERNEL_TARGET_AVX2
+  #else
+    #define MACRO_KERNEL_TARGET_AVX2 __attribute__((target("avx2")))
+  #endif
+#endif
+
+void MacroStats_reset(MacroStats_t *self) {
+  memset(self, 0, sizeof(MacroStats_t));
+  for (uint32_t column = 0; column < MACRO_COLUMN_COUNT; column++) {
+    self->min[column] = UINT32_MAX;
+  }
+}
+
+void MacroStats_merge(MacroStats_t *self, const MacroStats_t *other) {
+  for (uint32_t column = 0; column < MACRO_COLUMN_COUNT; column++) {
+    self->sum[column] += other->sum[column];
+    self->min[column] = other->min[column] < self->min[column] ?
+      other->min[column] : self->min[column];
+    self->max[column] = other->max[column] > self->max[column] ?
+      other->max[column] : self->max[column];
+  }
+
+  self->count += other->count;
+}
+
+void MacroStats_finalize(MacroStats_t *self) {
+  for (uint32_t column = 0; column < MACRO_COLUMN_COUNT; column++) {
+    if (self->count == 0) {
+      self->min[column] = 0;
+      self->mean[column] = 0.0;
+      continue;
+    }
+
+    self->mean[column] = self->sum[column] / (double)self->count;
+  }
+}
+
+void MacroKernel_reduceScalar(const uint32_t *const columns[MACRO_COLUMN_COUNT],
+  const DayNum_t *days, size_t count, DayNum_t from, DayNum_t to, MacroStats_t *acc) {
+  for (size_t row = 0; row < count; row++) {
+    if (days[row] < from || days[row] > to)
+      continue;
+
+    acc->count++;
+    for (uint32_t column = 0; column < MACRO_COLUMN_COUNT; column++) {
+      uint32_t value = columns[column][row];
+      acc->sum[column] += value;
+      acc->min[column] = value < acc->min[column] ? value : acc->min[column];
+      acc->max[column] = value > acc->max[column] ? value : acc->max[column];
+    }
+  }
+}
+
+// Meals are read in place, one Meal_t is this many uint32_t apart from the next
+#define MEAL_STRIDE (sizeof(Meal_t) / sizeof(uint32_t))
+
+uint32_t _MacroKernel_popcount8(uint8_t bits) {
+  bits = bits - ((bits >> 1) & 0x55);
+  bits = (bits & 0x33) + ((bits >> 2) & 0x33);
+  return (bits + (bits >> 4)) & 0x0F;
+}
+
+size_t MacroKernel_validateScalar(const Meal_t *meals, size_t count, uint8_t *rejectMask) {
+  size_t rejected = 0;
+  memset(rejectMask, 0, (count + 7) / 8);
+
+  for (size_t meal = 0; meal < count; meal++) {
+    const Macro_t *macro = &meals[meal].macro;
+    uint32_t reject = macro->cals <= (macro->protein + macro->carbs) * 4 + macro->fat * 9;
+    rejectMask[meal >> 3] |= (uint8_t)(reject << (meal & 7));
+    rejected += reject;
+  }
+
+  return rejected;
+}
+
+// Values per lane, and the mask of a bits wide value (bits may be 32)
+#define PACK_LANE_ROWS (MACRO_PACK_BLOCK_ROWS / MACRO_PACK_LANES)
+#define PACK_MASK(bits) ((bits) == 32 ? UINT32_MAX : (1u << (bits)) - 1)
+
+void MacroKernel_pack(const uint32_t *values, uint32_t bits, uint32_t *packed) {
+  // A zero width stream owns no words, packed may already be the next stream or past the end
+  if (bits == 0)
+    return;
+
+  memset(packed, 0, sizeof(uint32_t) * MACRO_PACK_LANES * bits);
+
+  for (uint32_t row = 0; row < MACRO_PACK_BLOCK_ROWS; row++) {
+    uint32_t lane = row % MACRO_PACK_LANES;
+    uint32_t bit = (row / MACRO_PACK_LANES) * bits;
+    uint32_t word = bit / 32, shift = bit % 32;
+    uint32_t value = values[row] & PACK_MASK(bits);
+
+    packed[word * MACRO_PACK_LANES + lane] |= value << shift;
+    if (shift + bits > 32)
+      packed[(word + 1) * MACRO_PACK_LANES + lane] |= value >> (32 - shift);
+  }
+}
+
+void MacroKernel_unpackScalar(const uint32_t *packed, uint32_t bits, uint32_t *out) {
+  if (bits == 0) {
+    memset(out, 0, sizeof(uint32_t) * MACRO_PACK_BLOCK_ROWS);
+    return;
+  }
+
+  for (uint32_t row = 0; row < MACRO_PACK_BLOCK_ROWS; row++) {
+    uint32_t lane = row % MACRO_PACK_LANES;
+    uint32_t bit = (row / MACRO_PACK_LANES) * bits;
+    uint32_t word = bit / 32, shift = bit % 32;
+
+    uint32_t value = packed[word * MACRO_PACK_LANES + lane] >> shift;
+    if (shift + bits > 32)
+      value |= packed[(word + 1) * MACRO_PACK_LANES + lane] << (32 - shift);
+    out[row] = value & PACK_MASK(bits);
+  }
+}
+
+uint64_t MacroKernel_sumPackedScalar(const uint32_t *packed, uint32_t bits) {
+  uint32_t values[MACRO_PACK_BLOCK_ROWS];
+  MacroKernel_unpackScalar(packed, bits, values);
+
+  uint64_t sum = 0;
+  for (uint32_t row = 0; row < MACRO_PACK_BLOCK_ROWS; row++) {
+    sum += values[row];
+  }
+
+  return sum;
+}
+
+#ifdef MACRO_KERNEL_X86
+
+// One lane per register lane, every step yields the next 4 values (rows 4j .. 4j + 3)
+#define UNPACK_SSE2_STEPS(bits, packed, EMIT) do {                               \
+    const __m128i mask = _mm_set1_epi32((int)PACK_MASK(bits));                   \
+    const __m128i *words = (const __m128i *)(packed);                            \
+    __m128i current = _mm_loadu_si128(words++);                                  \
+    uint32_t shift = 0;                                                          \
+    for (uint32_t step = 0; step < PACK_LANE_ROWS; step++) {                     \
+      __m128i value = _mm_srl_epi32(current, _mm_cvtsi32_si128((int)shift));     \
+      shift += (bits);                                                           \
+      if (shift >= 32 && step + 1 < PACK_LANE_ROWS) {                            \
+        shift -= 32;                                                             \
+        current = _mm_loadu_si128(words++);                                      \
+        if (shift > 0)                                                           \
+          value = _mm_or_si128(value,                                            \
+            _mm_sll_epi32(current, _mm_cvtsi32_si128((int)((bits) - shift))));   \
+      }                                                                          \
+      value = _mm_and_si128(value, mask);                                        \
+      EMIT;                                                                      \
+    }                                                                            \
+  } while (0)
+
+void MacroKernel_unpackSSE2(const uint32_t *packed, uint32_t bits, uint32_t *out) {
+  if (bits == 0) {
+    memset(out, 0, sizeof(uint32_t) * MACRO_PACK_BLOCK_ROWS);
+    return;
+  }
+
+  __m128i *values = (__m128i *)out;
+  UNPACK_SSE2_STEPS(bits, packed, _mm_storeu_si128(values++, value));
+}
+
+// 32 values of at most 27 bits still fit a 32 bit lane, wider ones go through 64 bit sums
+uint64_t MacroKernel_sumPackedSSE2(const uint32_t *packed, uint32_t bits) {
+  if (bits == 0)
+    return 0;
+  if (bits > 27)
+    return MacroKernel_sumPackedScalar(packed, bits);
+
+  __m128i sum = _mm_setzero_si128();
+  UNPACK_SSE2_STEPS(bits, packed, sum = _mm_add_epi32(sum, value));
+
+  uint32_t lanes[MACRO_PACK_LANES];
+  _mm_storeu_si128((__m128i *)lanes, sum);
+  return (uint64_t)lanes[0] + lanes[1] + lanes[2] + lanes[3];
+}
+
+size_t MacroKernel_validateSSE2(const Meal_t *meals, size_t count, uint8_t *rejectMask) {
+  const __m128i bias = _mm_set1_epi32(INT32_MIN);
+  size_t rejected = 0;
+
+  size_t meal = 0;
+  for (; meal + 8 <= count; meal += 8) {
+    uint32_t bits = 0;
+
+    // No gathers before AVX2, every Macro_t is one 16 byte load and 4 of them get transposed
+    for (uint32_t half = 0; half < 2; half++) {
+      __m128 rows[4];
+      for (uint32_t lane = 0; lane < 4; lane++) {
+        rows[lane] = _mm_castsi128_ps(_mm_loadu_si128((const __m128i *)&meals[meal + half * 4 + lane].macro));
+      }
+      _MM_TRANSPOSE4_PS(rows[0], rows[1], rows[2], rows[3]);
+
+      __m128i cals = _mm_castps_si128(rows[MACRO_COLUMN_CALS]);
+      __m128i protein = _mm_castps_si128(rows[MACRO_COLUMN_PROTEIN]);
+      __m128i fat = _mm_castps_si128(rows[MACRO_COLUMN_FAT]);
+      __m128i carbs = _mm_castps_si128(rows[MACRO_COLUMN_CARBS]);
+
+      // (protein + carbs) * 4 + fat * 9 with the same wrap around as the scalar check
+      __m128i limit = _mm_add_epi32(
+        _mm_slli_epi32(_mm_add_epi32(protein, carbs), 2),
+        _mm_add_epi32(_mm_slli_epi32(fat, 3), fat)
+      );
+      __m128i valid = _mm_cmpgt_epi32(_mm_xor_si128(cals, bias), _mm_xor_si128(limit, bias));
+      bits |= (uint32_t)(~_mm_movemask_ps(_mm_castsi128_ps(valid)) & 0xF) << (half * 4);
+    }
+
+    rejectMask[meal >> 3] = (uint8_t)bits;
+    rejected += _MacroKernel_popcount8((uint8_t)bits);
+  }
+
+  return rejected + MacroKernel_validateScalar(&meals[meal], count - meal, &rejectMask[meal >> 3]);
+}
+
+MACRO_KERNEL_TARGET_AVX2
+size_t MacroKernel_validateAVX2(const Meal_t *meals, size_t count, uint8_t *rejectMask) {
+  const __m256i stride = _mm256_mullo_epi32(
+    _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7), _mm256_set1_epi32((int)MEAL_STRIDE)
+  );
+  size_t rejected = 0;
+
+  size_t meal = 0;
+  for (; meal + 8 <= count; meal += 8) {
+    const int *base = (const int *)&meals[meal].macro;
+    __m256i cals = _mm256_i32gather_epi32(base, stride, 4);
+    __m256i protein = _mm256_i32gather_epi32(base + 1, stride, 4);
+    __m256i fat = _mm256_i32gather_epi32(base + 2, stride, 4);
+    __m256i carbs = _mm256_i32gather_epi32(base + 3, stride, 4);
+
+    __m256i limit = _mm256_add_epi32(
+      _mm256_slli_epi32(_mm256_add_epi32(protein, carbs), 2),
+      _mm256_add_epi32(_mm256_slli_epi32(fat, 3), fat)
+    );
+    // cals <= limit
+    __m256i reject = _mm256_cmpeq_epi32(_mm256_min_epu32(cals, limit), cals);
+    uint8_t bits = (uint8_t)_mm256_movemask_ps(_mm256_castsi256_ps(reject));
+
+    rejectMask[meal >> 3] = bits;
+    rejected += _MacroKernel_popcount8(bits);
+  }
+
+  return rejected + MacroKernel_validateScalar(&meals[meal], count - meal, &rejectMask[meal >> 3]);
+}
+
+// SSE2 has no unsigned compares, values are biased by INT32_MIN so the signed ones can be used
+void MacroKernel_reduceSSE2(const uint32_t *const columns[MACRO_COLUMN_COUNT],
+  const DayNum_t *days, size_t count, DayNum_t from, DayNum_t to, MacroStats_t *acc) {
+  const __m128i zero = _mm_setzero_si128();
+  const __m128i ones = _mm_set1_epi32(-1);
+  const __m128i bias = _mm_set1_epi32(INT32_MIN);
+  const __m128i lo = _mm_xor_si128(_mm_set1_epi32((int)from), bias);
+  const __m128i hi = _mm_xor_si128(_mm_set1_epi32((int)to), bias);
+
+  __m128i sumLo[MACRO_COLUMN_COUNT], sumHi[MACRO_COLUMN_COUNT];
+  __m128i minBiased[MACRO_COLUMN_COUNT], maxBiased[MACRO_COLUMN_COUNT];
+  for (uint32_t column = 0; column < MACRO_COLUMN_COUNT; column++) {
+    sumLo[column] = zero;
+    sumHi[column] = zero;
+    minBiased[column] = _mm_xor_si128(ones, bias);
+    maxBiased[column] = bias;
+  }
+  __m128i matched = zero;
+
+  size_t row = 0;
+  for (; row + 4 <= count; row += 4) {
+    __m128i day = _mm_xor_si128(_mm_loadu_si128((const __m128i *)&days[row]), bias);
+    __m128i outside = _mm_or_si128(_mm_cmpgt_epi32(lo, day), _mm_cmpgt_epi32(day, hi));
+    if (_mm_movemask_epi8(outside) == 0xFFFF)
+      continue;
+
+    __m128i mask = _mm_xor_si128(outside, ones);
+    matched = _mm_sub_epi32(matched, mask);
+
+    for (uint32_t column = 0; column < MACRO_COLUMN_COUNT; column++) {
+      __m128i value = _mm_loadu_si128((const __m128i *)&columns[column][row]);
+      __m128i masked = _mm_and_si128(value, mask);
+
+      sumLo[column] = _mm_add_epi64(sumLo[column], _mm_unpacklo_epi32(masked, zero));
+      sumHi[column] = _mm_add_epi64(sumHi[column], _mm_unpackhi_epi32(masked, zero));
+
+      __m128i maxCandidate = _mm_xor_si128(masked, bias);
+      __m128i greater = _mm_cmpgt_epi32(maxCandidate, maxBiased[column]);
+      maxBiased[column] = _mm_or_si128(
+        _mm_and_si128(greater, maxCandidate),
+        _mm_andnot_si128(greater, maxBiased[column])
+      );
+
+      // Rows outside of the range become UINT32_MAX and never win the min
+      __m128i minCandidate = _mm_xor_si128(_mm_or_si128(value, outside), bias);
+      __m128i less = _mm_cmplt_epi32(minCandidate, minBiased[column]);
+      minBiased[column] = _mm_or_si128(
+        _mm_and_si128(less, minCandidate),
+        _mm_andnot_si128(less, minBiased[column])
+      );
+    }
+  }
+
+  uint32_t lanes[4] = {0};
+  uint64_t wideLanes[2] = {0};
+
+  _mm_storeu_si128((__m128i *)lanes, matched);
+  acc->count += lanes[0] + lanes[1] + lanes[2] + lanes[3];
+
+  for (uint32_t column = 0; column < MACRO_COLUMN_COUNT; column++) {
+    _mm_storeu_si128((__m128i *)wideLanes, _mm_add_epi64(sumLo[column], sumHi[column]));
+    acc->sum[column] += wideLanes[0] + wideLanes[1];
+
+    _mm_storeu_si128((__m128i *)lanes, _mm_xor_si128(minBiased[column], bias));
+    for (uint32_t lane = 0; lane < 4; lane++) {
+      acc->min[column] = lanes[lane] < acc->min[column] ? lanes[lane] : acc->min[column];
+    }
+
+    _mm_storeu_si128((__m128i *)lanes, _mm_xor_si128(maxBiased[column], bias));
+    for (uint32_t lane = 0; lane < 4; lane++) {
+      acc->max[column] = lanes[lane] > acc->max[column] ? lanes[lane] : acc->max[column];
+    }
+  }
+
+  const uint32_t *tailColumns[MACRO_COLUMN_COUNT] = {0};
+  for (uint32_t column = 0; column < MACRO_COLUMN_COUNT; column++) {
+    tailColumns[column] = &columns[column][row];
+  }
+  MacroKernel_reduceScalar(tailColumns, &days[row], count - row, from, to, acc);
+}
+
+MACRO_KERNEL_TARGET_AVX2
+void MacroKernel_reduceAVX2(const uint32_t *const columns[MACRO_COLUMN_COUNT],
+  const DayNum_t *days, size_t count, DayNum_t from, DayNum_t to, MacroStats_t *acc) {
+  const __m256i zero = _mm256_setzero_si256();
+  const __m256i ones = _mm256_set1_epi32(-1);
+  const __m256i lo = _mm256_set1_epi32((int)from);
+  const __m256i hi = _mm256_set1_epi32((int)to);
+
+  __m256i sumLo[MACRO_COLUMN_COUNT], sumHi[MACRO_COLUMN_COUNT];
+  __m256i min[MACRO_COLUMN_COUNT], max[MACRO_COLUMN_COUNT];
+  for (uint32_t column = 0; column < MACRO_COLUMN_COUNT; column++) {
+    sumLo[column] = zero;
+    sumHi[column] = zero;
+    min[column] = ones;
+    max[column] = zero;
+  }
+  __m256i matched = zero;
+
+  size_t row = 0;
+  for (; row + 8 <= count; row += 8) {
+    __m256i day = _mm256_loadu_si256((const __m256i *)&days[row]);
+    __m256i mask = _mm256_and_si256(
+      _mm256_cmpeq_epi32(_mm256_max_epu32(day, lo), day),
+      _mm256_cmpeq_epi32(_mm256_min_epu32(day, hi), day)
+    );
+    if (_mm256_testz_si256(mask, mask))
+      continue;
+
+    __m256i outside = _mm256_xor_si256(mask, ones);
+    matched = _mm256_sub_epi32(matched, mask);
+
+    for (uint32_t column = 0; column < MACRO_COLUMN_COUNT; column++) {
+      __m256i value = _mm256_loadu_si256((const __m256i *)&columns[column][row]);
+      __m256i masked = _mm256_and_si256(value, mask);
+
+      sumLo[column] = _mm256_add_epi64(sumLo[column],
+        _mm256_cvtepu32_epi64(_mm256_castsi256_si128(masked)));
+      sumHi[column] = _mm256_add_epi64(sumHi[column],
+        _mm256_cvtepu32_epi64(_mm256_extracti128_si256(masked, 1)));
+
+      max[column] = _mm256_max_epu32(max[column], masked);
+      min[column] = _mm256_min_epu32(min[column], _mm256_or_si256(value, outside));
+    }
+  }
+
+  uint32_t lanes[8] = {0};
+  uint64_t wideLanes[4] = {0};
+
+  _mm256_storeu_si256((__m256i *)lanes, matched);
+  for (uint32_t lane = 0; lane < 8; lane++) {
+    acc->count += lanes[lane];
+  }
+
+  for (uint32_t column = 0; column < MACRO_COLUMN_COUNT; column++) {
+    _mm256_storeu_si256((__m256i *)wideLanes, _mm256_add_epi64(sumLo[column], sumHi[column]));
+    acc->sum[column] += wideLanes[0] + wideLanes[1] + wideLanes[2] + wideLanes[3];
+
+    _mm256_storeu_si256((__m256i *)lanes, min[column]);
+    for (uint32_t lane = 0; lane < 8; lane++) {
+      acc->min[column] = lanes[lane] < acc->min[column] ? lanes[lane] : acc->min[column];
+    }
+
+    _mm256_storeu_si256((__m256i *)lanes, max[column]);
+    for (uint32_t lane = 0; lane < 8; lane++) {
+      acc->max[column] = lanes[lane] > acc->max[column] ? lanes[lane] : acc->max[column];
+    }
+  }
+
+  const uint32_t *tailColumns[MACRO_COLUMN_COUNT] = {0};
+  for (uint32_t column = 0; column < MACRO_COLUMN_COUNT; column++) {
+    tailColumns[column] = &columns[column][row];
+  }
+  MacroKernel_reduceScalar(tailColumns, &days[row], count - row, from, to, acc);
+}
+
+MacroKernelIsa_t _MacroKernel_detectIsa() {
+#ifdef _MSC_VER
+  int info[4] = {0};
+  __cpuid(info, 0);
+  if (info[0] < 7)
+    return MACRO_KERNEL_ISA_SSE2;
+
+  // AVX2 also needs the OS to save the ymm registers (OSXSAVE + XCR0)
+  __cpuid(info, 1);
+  bool osxsave = (info[2] & (1 << 27)) != 0;
+  bool avx = (info[2] & (1 << 28)) != 0;
+  if (!osxsave || !avx || (_xgetbv(0) & 0x6) != 0x6)
+    return MACRO_KERNEL_ISA_SSE2;
+
+  __cpuidex(info, 7, 0);
+  return (info[1] & (1 << 5)) ? MACRO_KERNEL_ISA_AVX2 : MACRO_KERNEL_ISA_SSE2;
+#else
+  __builtin_cpu_init();
+  return __builtin_cpu_supports("avx2") ? MACRO_KERNEL_ISA_AVX2 : MACRO_KERNEL_ISA_SSE2;
+#endif
+}
+
+#else
+
+void MacroKernel_reduceSSE2(const uint32_t *const columns[MACRO_COLUMN_COUNT],
+  const DayNum_t *days, size_t count, DayNum_t from, DayNum_t to, MacroStats_t *acc) {
+  MacroKernel_reduceScalar(columns, days, count, from, to, acc);
+}
+
+void MacroKernel_reduceAVX2(const uint32_t *const columns[MACRO_COLUMN_COUNT],
+  const DayNum_t *days, size_t count, DayNum_t from, DayNum_t to, MacroStats_t *acc) {
+  MacroKernel_reduceScalar(columns, days, count, from, to, acc);
+}
+
+size_t MacroKernel_validateSSE2(const Meal_t *meals, size_t count, uint8_t *rejectMask) {
+  return MacroKernel_validateScalar(meals, count, rejectMask);
+}
+
+size_t MacroKernel_validateAVX2(const Meal_t *meals, size_t count, uint8_t *rejectMask) {
+  return MacroKernel_validateScalar(meals, count, rejectMask);
+}
+
+void MacroKernel_unpackSSE2(const uint32_t *packed, uint32_t bits, uint32_t *out) {
+  MacroKernel_unpackScalar(packed, bits, out);
+}
+
+uint64_t MacroKernel_sumPackedSSE2(const uint32_t *packed, uint32_t bits) {
+  return MacroKernel_sumPackedScalar(packed, bits);
+}
+
+MacroKernelIsa_t _MacroKernel_detectIsa() {
+  return MACRO_KERNEL_ISA_SCALAR;
+}
+
+#endif
+
+static MacroKernelReduceFn_t _MacroKernel_reduceFn = NULL;
+static MacroKernelValidateFn_t _MacroKernel_validateFn = NULL;
+static MacroKernelUnpackFn_t _MacroKernel_unpackFn = NULL;
+static MacroKernelSumPackedFn_t _MacroKernel_sumPackedFn = NULL;
+static MacroKernelIsa_t _MacroKernel_activeIsa = MACRO_KERNEL_ISA_SCALAR;
+static INIT_ONCE _MacroKernel_once = INIT_ONCE_STATIC_INIT;
+
+void _MacroKernel_select(MacroKernelIsa_t isa) {
+  MacroKernelIsa_t supported = _MacroKernel_detectIsa();
+  _MacroKernel_activeIsa = isa > supported ? supported : isa;
+
+  switch (_MacroKernel_activeIsa) {
+    case MACRO_KERNEL_ISA_AVX2:
+      _MacroKernel_reduceFn = MacroKernel_reduceAVX2;
+      _MacroKernel_validateFn = MacroKernel_validateAVX2;
+      // The 4 lane packed layout is one xmm register wide
+      _MacroKernel_unpackFn = MacroKernel_unpackSSE2;
+      _MacroKernel_sumPackedFn = MacroKernel_sumPackedSSE2;
+      break;
+    case MACRO_KERNEL_ISA_SSE2:
+      _MacroKernel_reduceFn = MacroKernel_reduceSSE2;
+      _MacroKernel_validateFn = MacroKernel_validateSSE2;
+      _MacroKernel_unpackFn = MacroKernel_unpackSSE2;
+      _MacroKernel_sumPackedFn = MacroKernel_sumPackedSSE2;
+      break;
+    case MACRO_KERNEL_ISA_SCALAR:
+    default:
+      _MacroKernel_reduceFn = MacroKernel_reduceScalar;
+      _MacroKernel_validateFn = MacroKernel_validateScalar;
+      _MacroKernel_unpackFn = MacroKernel_unpackScalar;
+      _MacroKernel_sumPackedFn = MacroKernel_sumPackedScalar;
+      break;
+  }
+}
+
+BOOL CALLBACK _MacroKernel_resolve(PINIT_ONCE once, PVOID parameter, PVOID *context) {
+  UNREFERENCED_PARAMETER(once);
+  UNREFERENCED_PARAMETER(parameter);
+  UNREFERENCED_PARAMETER(context);
+  _MacroKernel_select(MACRO_KERNEL_ISA_AVX2);
+  return TRUE;
+}
+
+void MacroKernel_init() {
+  InitOnceExecuteOnce(&_MacroKernel_once, _MacroKernel_resolve, NULL, NULL);
+}
+
+void MacroKernel_setIsa(MacroKernelIsa_t isa) {
+  MacroKernel_init();
+  _MacroKernel_select(isa);
+}
+
+MacroKernelIsa_t MacroKernel_isa() {
+  MacroKernel_init();
+
+  return _MacroKernel_activeIsa;
+}
+
+void MacroKernel_reduce(const uint32_t *const columns[MACRO_COLUMN_COUNT],
+  const DayNum_t *days, size_t count, DayNum_t from, DayNum_t to, MacroStats_t *acc) {
+  MacroKernel_init();
+
+  _MacroKernel_reduceFn(columns, days, count, from, to, acc);
+}
+
+size_t MacroKernel_validate(const Meal_t *meals, size_t count, uint8_t *rejectMask) {
+  MacroKernel_init();
+
+  return _MacroKernel_validateFn(meals, count, rejectMask);
+}
+
+void MacroKernel_unpack(const uint32_t *packed, uint32_t bits, uint32_t *out) {
+  MacroKernel_init();
+
+  _MacroKernel_unpackFn(packed, bits, out);
+}
+
+uint64_t MacroKernel_sumPacked(const uint32_t *packed, uint32_t bits) {
+  MacroKernel_init();
+
+  return _MacroKernel_sumPackedFn(packed, bits);
+}
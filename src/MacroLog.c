@@ -0,0 +1,225 @@
+#include <stddef.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <log.h>
+
+#include "MacroLog.h"
+
+// CRC-32C (Castagnoli), reflected polynomial
+#define CRC32C_POLY 0x82F63B78u
+
+static uint32_t _MacroLog_crcTable[256];
+static bool _MacroLog_crcTableReady = false;
+
+void _MacroLog_initCrcTable() {
+  for (uint32_t index = 0; index < 256; index++) {
+    uint32_t crc = index;
+    for (uint32_t bit = 0; bit < 8; bit++) {
+      crc = (crc >> 1) ^ (CRC32C_POLY & (0u - (crc & 1)));
+    }
+    _MacroLog_crcTable[index] = crc;
+  }
+
+  _MacroLog_crcTableReady = true;
+}
+
+uint32_t MacroLog_checksum(const void *data, size_t size) {
+  if (!_MacroLog_crcTableReady)
+    _MacroLog_initCrcTable();
+
+  const uint8_t *bytes = data;
+  uint32_t crc = ~0u;
+  for (size_t index = 0; index < size; index++) {
+    crc = _MacroLog_crcTable[(crc ^ bytes[index]) & 0xFF] ^ (crc >> 8);
+  }
+
+  return ~crc;
+}
+
+Result_t MacroLog_open(MacroLog_t *self, const char *path, const MacroLogInfo_t *info) {
+  *self = (MacroLog_t) {
+    ._file = CreateFileA(path, GENERIC_READ | GENERIC_WRITE, FILE_SHARE_READ,
+      NULL, OPEN_ALWAYS, FILE_ATTRIBUTE_NORMAL, NULL),
+    .info = *info,
+    ._buffer = malloc(sizeof(MacroLogRecord_t) * MACRO_LOG_BUFFER_RECORDS),
+    ._bufferCount = 0,
+    .nextSequence = 0,
+    .recordCount = 0,
+    ._lastSyncTick = GetTickCount64(),
+    ._unsynced = false
+  };
+
+  if (self->_file == INVALID_HANDLE_VALUE) {
+    log_error("Couldn't create/open the write-ahead log %s, error code: %lu" ENDL,
+      path, GetLastError()
+    );
+    free(self->_buffer);
+    self->_buffer = NULL;
+    return RESULT_FAIL;
+  }
+
+  return RESULT_SUCCESS;
+}
+
+void MacroLog_close(MacroLog_t *self) {
+  if (self->_file == INVALID_HANDLE_VALUE)
+    return;
+
+  MacroLog_sync(self);
+  CloseHandle(self->_file);
+  free(self->_buffer);
+
+  self->_file = INVALID_HANDLE_VALUE;
+  self->_buffer = NULL;
+  self->_bufferCount = 0;
+}
+
+bool _MacroLog_isIntact(const MacroLogRecord_t *record) {
+  return record->checksum ==
+    MacroLog_checksum(record, offsetof(MacroLogRecord_t, checksum));
+}
+
+Result_t _MacroLog_seek(MacroLog_t *self, uint64_t offset) {
+  LARGE_INTEGER distance = { .QuadPart = (LONGLONG)offset };
+  return SetFilePointerEx(self->_file, distance, NULL, FILE_BEGIN) ?
+    RESULT_SUCCESS : RESULT_FAIL;
+}
+
+Result_t MacroLog_recover(MacroLog_t *self, uint64_t fromSequence, MacroLogReplayCBCK_t onRecord, void *ctx) {
+  if (_MacroLog_seek(self, 0) != RESULT_SUCCESS)
+    return RESULT_FAIL;
+
+  self->nextSequence = fromSequence;
+  self->recordCount = 0;
+
+  uint64_t validBytes = 0;
+  uint64_t expectedSequence = 0;
+  bool torn = false;
+
+  while (!torn) {
+    DWORD readBytes = 0;
+    if (!ReadFile(self->_file, self->_buffer,
+        sizeof(MacroLogRecord_t) * MACRO_LOG_BUFFER_RECORDS, &readBytes, NULL)) {
+      log_error("Failed to read the write-ahead log, error code: %lu" ENDL, GetLastError());
+      return RESULT_FAIL;
+    }
+
+    if (readBytes == 0)
+      break;
+
+    uint32_t recordCount = readBytes / sizeof(MacroLogRecord_t);
+    torn = recordCount * sizeof(MacroLogRecord_t) != readBytes;
+
+    for (MacroLogRecord_t *record = self->_buffer; record < &self->_buffer[recordCount]; record++) {
+      // Sequences are consecutive, a gap means the tail is garbage from an interrupted write
+      if (!_MacroLog_isIntact(record) ||
+          (self->recordCount > 0 && record->sequence != expectedSequence)) {
+        torn = true;
+        break;
+      }
+
+      expectedSequence = record->sequence + 1;
+      self->recordCount++;
+      validBytes += sizeof(MacroLogRecord_t);
+
+      // Older records are already part of the snapshot (crash between compaction and truncation)
+      if (record->sequence >= fromSequence)
+        onRecord(ctx, record);
+    }
+  }
+
+  if (expectedSequence > self->nextSequence)
+    self->nextSequence = expectedSequence;
+
+  if (torn) {
+    log_warn("Write-ahead log has a torn tail, truncating to %llu records" ENDL,
+      (unsigned long long)self->recordCount
+    );
+  }
+
+  // Drop the torn tail so new appends continue right after the last good record
+  if (_MacroLog_seek(self, validBytes) != RESULT_SUCCESS || !SetEndOfFile(self->_file)) {
+    log_error("Failed to truncate the write-ahead log, error code: %lu" ENDL, GetLastError());
+    return RESULT_FAIL;
+  }
+
+  self->_bufferCount = 0;
+  return RESULT_SUCCESS;
+}
+
+Result_t MacroLog_commit(MacroLog_t *self) {
+  if (self->_bufferCount == 0)
+    return RESULT_SUCCESS;
+
+  DWORD size = sizeof(MacroLogRecord_t) * self->_bufferCount;
+  DWORD written = 0;
+  if (!WriteFile(self->_file, self->_buffer, size, &written, NULL) || written != size) {
+    log_error("Failed to write to the write-ahead log, error code: %lu" ENDL, GetLastError());
+    return RESULT_FAIL;
+  }
+
+  self->_bufferCount = 0;
+  self->_unsynced = true;
+  return RESULT_SUCCESS;
+}
+
+Result_t MacroLog_sync(MacroLog_t *self) {
+  if (MacroLog_commit(self) != RESULT_SUCCESS)
+    return RESULT_FAIL;
+
+  self->_lastSyncTick = GetTickCount64();
+  if (!self->_unsynced)
+    return RESULT_SUCCESS;
+
+  if (!FlushFileBuffers(self->_file)) {
+    log_error("Failed to flush the write-ahead log, error code: %lu" ENDL, GetLastError());
+    return RESULT_FAIL;
+  }
+
+  self->_unsynced = false;
+  return RESULT_SUCCESS;
+}
+
+Result_t MacroLog_poll(MacroLog_t *self) {
+  if (self->_bufferCount == 0 && !self->_unsynced)
+    return RESULT_SUCCESS;
+
+  // Group commit - everything appended inside of the window shares one sync
+  if (GetTickCount64() - self->_lastSyncTick >= self->info.syncIntervalMs)
+    return MacroLog_sync(self);
+
+  return RESULT_SUCCESS;
+}
+
+Result_t MacroLog_append(MacroLog_t *self, MacroLogRecord_t record) {
+  // A buffer left full by a failed write takes nothing until it can be written
+  if (self->_bufferCount == MACRO_LOG_BUFFER_RECORDS &&
+      MacroLog_commit(self) != RESULT_SUCCESS)
+    return RESULT_FAIL;
+
+  record.sequence = self->nextSequence++;
+  record.checksum = MacroLog_checksum(&record, offsetof(MacroLogRecord_t, checksum));
+
+  self->_buffer[self->_bufferCount++] = record;
+  self->recordCount++;
+
+  // The record is buffered either way, a failed write or sync is logged here and reported
+  // again by the next commit, sync or poll
+  if (self->_bufferCount < MACRO_LOG_BUFFER_RECORDS || MacroLog_commit(self) == RESULT_SUCCESS)
+    MacroLog_poll(self);
+  return RESULT_SUCCESS;
+}
+
+Result_t MacroLog_truncate(MacroLog_t *self) {
+  self->_bufferCount = 0;
+  self->recordCount = 0;
+
+  if (_MacroLog_seek(self, 0) != RESULT_SUCCESS || !SetEndOfFile(self->_file)) {
+    log_error("Failed to truncate the write-ahead log, error code: %lu" ENDL, GetLastError());
+    return RESULT_FAIL;
+  }
+
+  self->_unsynced = true;
+  return MacroLog_sync(self);
+}
@@ -0,0 +1,87 @@
+#include <stdlib.h>
+
+#define WIN32_LEAN_AND_MEAN
+#include <Windows.h>
+
+#include <log.h>
+
+#include "MacroMorsel.h"
+
+#define MACRO_MORSEL_CACHE_LINE 64
+
+typedef struct __MacroMorselQueue_t {
+  // Next morsel to hand out, alone on its line since every worker bumps it
+  _Alignas(MACRO_MORSEL_CACHE_LINE) volatile LONG next;
+
+  _Alignas(MACRO_MORSEL_CACHE_LINE) uint32_t rowCount, morselCount;
+  MacroMorselFn_t fn;
+  void *ctx;
+} MacroMorselQueue_t;
+
+typedef struct __MacroMorselWorker_t {
+  MacroMorselQueue_t *queue;
+  uint32_t worker;
+} MacroMorselWorker_t;
+
+uint32_t MacroMorsel_threadCount(uint32_t requested) {
+  if (requested > 0)
+    return requested;
+
+  SYSTEM_INFO system = {0};
+  GetSystemInfo(&system);
+  return system.dwNumberOfProcessors > 0 ? system.dwNumberOfProcessors : 1;
+}
+
+DWORD WINAPI _MacroMorsel_worker(MacroMorselWorker_t *self) {
+  MacroMorselQueue_t *queue = self->queue;
+  for (;;) {
+    uint32_t morsel = (uint32_t)InterlockedExchangeAdd(&queue->next, 1);
+    if (morsel >= queue->morselCount)
+      return 0;
+
+    uint32_t first = morsel * MACRO_MORSEL_ROWS;
+    uint32_t count = queue->rowCount - first < MACRO_MORSEL_ROWS ? queue->rowCount - first : MACRO_MORSEL_ROWS;
+    queue->fn(queue->ctx, self->worker, first, count);
+  }
+}
+
+Result_t MacroMorsel_run(uint32_t rowCount, uint32_t threadCount, MacroMorselFn_t fn, void *ctx) {
+  MacroMorselQueue_t queue = {
+    .next = 0,
+    .rowCount = rowCount,
+    .morselCount = (rowCount + MACRO_MORSEL_ROWS - 1) / MACRO_MORSEL_ROWS,
+    .fn = fn,
+    .ctx = ctx
+  };
+
+  // No point waking more threads than there are morsels
+  threadCount = threadCount < queue.morselCount ? threadCount : queue.morselCount;
+  threadCount = threadCount > 0 ? threadCount : 1;
+
+  MacroMorselWorker_t *workers = malloc(sizeof(MacroMorselWorker_t) * threadCount);
+  HANDLE *threads = malloc(sizeof(HANDLE) * threadCount);
+  Result_t result = RESULT_SUCCESS;
+  for (uint32_t worker = 1; worker < threadCount; worker++) {
+    workers[worker] = (MacroMorselWorker_t) { .queue = &queue, .worker = worker };
+    threads[worker] = CreateThread(NULL, 0, (LPTHREAD_START_ROUTINE)_MacroMorsel_worker, &workers[worker], 0, NULL);
+    if (threads[worker] == NULL) {
+      log_error("Failed to create morsel thread, error code: %lu" ENDL, GetLastError());
+      result = RESULT_FAIL;
+    }
+  }
+
+  workers[0] = (MacroMorselWorker_t) { .queue = &queue, .worker = 0 };
+  _MacroMorsel_worker(&workers[0]);
+
+  for (uint32_t worker = 1; worker < threadCount; worker++) {
+    if (threads[worker] == NULL)
+      continue;
+
+    WaitForSingleObject(threads[worker], INFINITE);
+    CloseHandle(threads[worker]);
+  }
+  free(threads);
+  free(workers);
+
+  return result;
+}
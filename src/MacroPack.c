@@ -0,0 +1,250 @@
+#include <stdlib.h>
+#include <string.h>
+
+#include <log.h>
+
+#include "MacroPack.h"
+
+#define DEFAULT_BLOCK_CAP (1 << 6)
+#define DEFAULT_WORD_CAP (1 << 12)
+
+void MacroPack_init(MacroPack_t *self) {
+  *self = (MacroPack_t) {
+    .blocks = malloc(sizeof(MacroPackBlock_t) * DEFAULT_BLOCK_CAP),
+    .blockCount = 0,
+    ._blockCap = DEFAULT_BLOCK_CAP,
+    .words = malloc(sizeof(uint32_t) * DEFAULT_WORD_CAP),
+    .wordCount = 0,
+    ._wordCap = DEFAULT_WORD_CAP,
+    .mealCount = 0
+  };
+}
+
+void MacroPack_cleanup(MacroPack_t *self) {
+  free(self->blocks);
+  free(self->words);
+  *self = (MacroPack_t) {0};
+}
+
+size_t MacroPack_size(const MacroPack_t *self) {
+  return sizeof(MacroPackBlock_t) * self->blockCount + sizeof(uint32_t) * self->wordCount;
+}
+
+uint32_t _MacroPack_bitWidth(uint32_t range) {
+  uint32_t bits = 0;
+  while (bits < 32 && (range >> bits) != 0) {
+    bits++;
+  }
+
+  return bits;
+}
+
+// Room for one more block of words
+bool _MacroPack_reserve(MacroPack_t *self, uint32_t words) {
+  if (self->blockCount == self->_blockCap) {
+    uint32_t capacity;
+    if (!Common_growCapacity(self->_blockCap, self->blockCount + 1, &capacity))
+      return false;
+    MacroPackBlock_t *blocks = realloc(self->blocks, sizeof(MacroPackBlock_t) * capacity);
+    if (blocks == NULL)
+      return false;
+    self->blocks = blocks;
+    self->_blockCap = capacity;
+  }
+
+  uint64_t needed = (uint64_t)self->wordCount + words;
+  if (needed > self->_wordCap) {
+    uint32_t capacity;
+    if (needed > UINT32_MAX || !Common_growCapacity(self->_wordCap, (uint32_t)needed, &capacity))
+      return false;
+    uint32_t *packed = realloc(self->words, sizeof(uint32_t) * capacity);
+    if (packed == NULL)
+      return false;
+    self->words = packed;
+    self->_wordCap = capacity;
+  }
+
+  return true;
+}
+
+// Encodes one full block of rows
+bool _MacroPack_appendBlock(MacroPack_t *self, const uint32_t *const columns[MACRO_COLUMN_COUNT], const DayNum_t *days) {
+  MacroPackBlock_t block = {0};
+  uint32_t stream[MACRO_PACK_STREAM_COUNT][MACRO_PACK_BLOCK_ROWS];
+  uint32_t words = 0;
+
+  for (uint32_t packed = 0; packed < MACRO_PACK_STREAM_COUNT; packed++) {
+    const uint32_t *values = packed < MACRO_COLUMN_COUNT ? columns[packed] : days;
+    uint32_t min = UINT32_MAX, max = 0;
+    for (uint32_t row = 0; row < MACRO_PACK_BLOCK_ROWS; row++) {
+      min = values[row] < min ? values[row] : min;
+      max = values[row] > max ? values[row] : max;
+    }
+
+    for (uint32_t row = 0; row < MACRO_PACK_BLOCK_ROWS; row++) {
+      stream[packed][row] = values[row] - min;
+    }
+    block.bits[packed] = (uint8_t)_MacroPack_bitWidth(max - min);
+    words += MACRO_PACK_LANES * block.bits[packed];
+
+    if (packed == MACRO_PACK_STREAM_DAYS) {
+      block.minDay = min;
+      block.maxDay = max;
+    } else {
+      block.min[packed] = min;
+      block.max[packed] = max;
+    }
+  }
+
+  if (!_MacroPack_reserve(self, words))
+    return false;
+
+  block.offset = self->wordCount;
+  for (uint32_t packed = 0; packed < MACRO_PACK_STREAM_COUNT; packed++) {
+    MacroKernel_pack(stream[packed], block.bits[packed], &self->words[self->wordCount]);
+    self->wordCount += MACRO_PACK_LANES * block.bits[packed];
+  }
+  self->blocks[self->blockCount++] = block;
+  self->mealCount += MACRO_PACK_BLOCK_ROWS;
+  return true;
+}
+
+Result_t MacroPack_append(MacroPack_t *self, const uint32_t *const columns[MACRO_COLUMN_COUNT],
+  const DayNum_t *days, uint32_t count) {
+  DEBUG_ASSERT(count % MACRO_PACK_BLOCK_ROWS == 0, "Only whole blocks are packed, %u rows given", count);
+
+  for (uint32_t row = 0; row + MACRO_PACK_BLOCK_ROWS <= count; row += MACRO_PACK_BLOCK_ROWS) {
+    const uint32_t *blockColumns[MACRO_COLUMN_COUNT];
+    for (uint32_t column = 0; column < MACRO_COLUMN_COUNT; column++) {
+      blockColumns[column] = &columns[column][row];
+    }
+
+    if (!_MacroPack_appendBlock(self, blockColumns, &days[row])) {
+      log_error("Failed to grow the packed meals past %u rows" ENDL, self->mealCount);
+      return RESULT_FAIL;
+    }
+  }
+
+  return RESULT_SUCCESS;
+}
+
+// Word offset of each stream of block
+void _MacroPack_streams(const MacroPack_t *self, const MacroPackBlock_t *block,
+  const uint32_t *streams[MACRO_PACK_STREAM_COUNT]) {
+  const uint32_t *words = &self->words[block->offset];
+  for (uint32_t packed = 0; packed < MACRO_PACK_STREAM_COUNT; packed++) {
+    streams[packed] = words;
+    words += MACRO_PACK_LANES * block->bits[packed];
+  }
+}
+
+// Every stream of block unpacked and offset back to the stored values
+void _MacroPack_unpackBlock(const MacroPack_t *self, const MacroPackBlock_t *block,
+  uint32_t values[MACRO_PACK_STREAM_COUNT][MACRO_PACK_BLOCK_ROWS]) {
+  const uint32_t *streams[MACRO_PACK_STREAM_COUNT];
+  _MacroPack_streams(self, block, streams);
+
+  for (uint32_t packed = 0; packed < MACRO_PACK_STREAM_COUNT; packed++) {
+    MacroKernel_unpack(streams[packed], block->bits[packed], values[packed]);
+    uint32_t min = packed < MACRO_COLUMN_COUNT ? block->min[packed] : block->minDay;
+    for (uint32_t row = 0; row < MACRO_PACK_BLOCK_ROWS; row++) {
+      values[packed][row] += min;
+    }
+  }
+}
+
+void MacroPack_decode(const MacroPack_t *self, uint32_t first, uint32_t count,
+  uint32_t *const columns[MACRO_COLUMN_COUNT], DayNum_t *days) {
+  DEBUG_ASSERT(first + count <= self->mealCount, "Decoding rows past the packed ones");
+
+  uint32_t values[MACRO_PACK_STREAM_COUNT][MACRO_PACK_BLOCK_ROWS];
+  for (uint32_t row = first; row < first + count;) {
+    uint32_t start = row % MACRO_PACK_BLOCK_ROWS;
+    uint32_t take = MACRO_PACK_BLOCK_ROWS - start;
+    take = take < first + count - row ? take : first + count - row;
+
+    _MacroPack_unpackBlock(self, &self->blocks[row / MACRO_PACK_BLOCK_ROWS], values);
+    for (uint32_t column = 0; column < MACRO_COLUMN_COUNT; column++) {
+      memcpy(&columns[column][row - first], &values[column][start], sizeof(uint32_t) * take);
+    }
+    memcpy(&days[row - first], &values[MACRO_PACK_STREAM_DAYS][start], sizeof(DayNum_t) * take);
+
+    row += take;
+  }
+}
+
+// Value `index` of a packed stream, see the lane layout in MacroKernel.h
+uint32_t _MacroPack_value(const uint32_t *packed, uint32_t bits, uint32_t index) {
+  if (bits == 0)
+    return 0;
+
+  uint32_t lane = index % MACRO_PACK_LANES;
+  uint32_t bit = (index / MACRO_PACK_LANES) * bits;
+  uint32_t word = bit / 32, shift = bit % 32;
+
+  uint32_t value = packed[word * MACRO_PACK_LANES + lane] >> shift;
+  if (shift + bits > 32)
+    value |= packed[(word + 1) * MACRO_PACK_LANES + lane] << (32 - shift);
+  return bits == 32 ? value : value & ((1u << bits) - 1);
+}
+
+void MacroPack_get(const MacroPack_t *self, uint32_t row, Macro_t *macro, DayNum_t *day) {
+  DEBUG_ASSERT(row < self->mealCount, "Packed row out of range");
+
+  const MacroPackBlock_t *block = &self->blocks[row / MACRO_PACK_BLOCK_ROWS];
+  const uint32_t *streams[MACRO_PACK_STREAM_COUNT];
+  _MacroPack_streams(self, block, streams);
+
+  uint32_t index = row % MACRO_PACK_BLOCK_ROWS;
+  uint32_t *values = &macro->cals;
+  for (uint32_t column = 0; column < MACRO_COLUMN_COUNT; column++) {
+    values[column] = block->min[column] + _MacroPack_value(streams[column], block->bits[column], index);
+  }
+  *day = block->minDay + _MacroPack_value(streams[MACRO_PACK_STREAM_DAYS], block->bits[MACRO_PACK_STREAM_DAYS], index);
+}
+
+void MacroPack_reduce(const MacroPack_t *self, uint32_t first, uint32_t count,
+  DayNum_t from, DayNum_t to, MacroStats_t *acc) {
+  DEBUG_ASSERT(first + count <= self->mealCount, "Reducing rows past the packed ones");
+
+  uint32_t values[MACRO_PACK_STREAM_COUNT][MACRO_PACK_BLOCK_ROWS];
+  const uint32_t *streams[MACRO_PACK_STREAM_COUNT];
+
+  for (uint32_t row = first; row < first + count;) {
+    const MacroPackBlock_t *block = &self->blocks[row / MACRO_PACK_BLOCK_ROWS];
+    uint32_t start = row % MACRO_PACK_BLOCK_ROWS;
+    uint32_t take = MACRO_PACK_BLOCK_ROWS - start;
+    take = take < first + count - row ? take : first + count - row;
+    row += take;
+
+    if (block->maxDay < from || block->minDay > to)
+      continue;
+
+    // Whole block in range, the packed sum plus min * rows is exact
+    if (take == MACRO_PACK_BLOCK_ROWS && block->minDay >= from && block->maxDay <= to) {
+      _MacroPack_streams(self, block, streams);
+      for (uint32_t column = 0; column < MACRO_COLUMN_COUNT; column++) {
+        acc->sum[column] += MacroKernel_sumPacked(streams[column], block->bits[column]) +
+          (uint64_t)block->min[column] * MACRO_PACK_BLOCK_ROWS;
+        acc->min[column] = block->min[column] < acc->min[column] ? block->min[column] : acc->min[column];
+        acc->max[column] = block->max[column] > acc->max[column] ? block->max[column] : acc->max[column];
+      }
+      acc->count += MACRO_PACK_BLOCK_ROWS;
+      continue;
+    }
+
+    // Straddles a bound or is cut by the rows, decode it and let the masked reduction pick the rows
+    _MacroPack_unpackBlock(self, block, values);
+    const uint32_t *columns[MACRO_COLUMN_COUNT];
+    for (uint32_t column = 0; column < MACRO_COLUMN_COUNT; column++) {
+      columns[column] = &values[column][start];
+    }
+    MacroKernel_reduce(columns, &values[MACRO_PACK_STREAM_DAYS][start], take, from, to, acc);
+  }
+}
+
+void MacroPack_stats(const MacroPack_t *self, DayNum_t from, DayNum_t to, MacroStats_t *out) {
+  MacroStats_reset(out);
+  MacroPack_reduce(self, 0, self->mealCount, from, to, out);
+  MacroStats_finalize(out);
+}
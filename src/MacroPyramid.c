@@ -0,0 +1,370 @@
+#include <stddef.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <log.h>
+
+#define WIN32_LEAN_AND_MEAN
+#include <Windows.h>
+
+#include "MacroPyramid.h"
+
+#define DEFAULT_LEVEL_CAP (1 << 6)
+
+Result_t MacroPyramid_init(MacroPyramid_t *self) {
+  Result_t result = RESULT_SUCCESS;
+  for (uint32_t level = 0; level < MACRO_PYRAMID_LEVELS; level++) {
+    MacroPyramidLevel_t *table = &self->levels[level];
+    *table = (MacroPyramidLevel_t) {
+      .firstKey = 0,
+      .count = 0,
+      ._capacity = DEFAULT_LEVEL_CAP
+    };
+    for (uint32_t column = 0; column < MACRO_COLUMN_COUNT; column++) {
+      table->columns[column] = malloc(sizeof(MacroPyramidBucket_t) * DEFAULT_LEVEL_CAP);
+      result = table->columns[column] != NULL ? result : RESULT_FAIL;
+    }
+  }
+  return result;
+}
+
+void MacroPyramid_cleanup(MacroPyramid_t *self) {
+  for (uint32_t level = 0; level < MACRO_PYRAMID_LEVELS; level++) {
+    for (uint32_t column = 0; column < MACRO_COLUMN_COUNT; column++) {
+      free(self->levels[level].columns[column]);
+    }
+    self->levels[level] = (MacroPyramidLevel_t) {0};
+  }
+}
+
+bool _MacroPyramidLevel_reserve(MacroPyramidLevel_t *self, uint32_t count) {
+  if (count <= self->_capacity)
+    return true;
+
+  uint32_t capacity;
+  if (!Common_growCapacity(self->_capacity, count, &capacity))
+    return false;
+
+  // A column that did grow keeps its bigger block, _capacity only moves once all of them did
+  for (uint32_t column = 0; column < MACRO_COLUMN_COUNT; column++) {
+    MacroPyramidBucket_t *buckets = realloc(self->columns[column], sizeof(MacroPyramidBucket_t) * capacity);
+    if (buckets == NULL)
+      return false;
+    self->columns[column] = buckets;
+  }
+
+  self->_capacity = capacity;
+  return true;
+}
+
+// Grows the level to cover key on either side with empty buckets, returns the bucket index or
+// UINT32_MAX when it can't grow
+uint32_t _MacroPyramidLevel_at(MacroPyramidLevel_t *self, uint32_t key) {
+  if (self->count == 0) {
+    self->firstKey = key;
+  }
+
+  uint32_t first = key < self->firstKey ? key : self->firstKey;
+  uint32_t last = self->count == 0 ? key : self->firstKey + self->count - 1;
+  last = key > last ? key : last;
+  uint32_t newCount = last - first + 1;
+  if (!_MacroPyramidLevel_reserve(self, newCount))
+    return UINT32_MAX;
+
+  uint32_t shift = self->firstKey - first;
+  for (uint32_t column = 0; column < MACRO_COLUMN_COUNT; column++) {
+    MacroPyramidBucket_t *buckets = self->columns[column];
+    if (shift > 0) {
+      memmove(&buckets[shift], buckets, sizeof(MacroPyramidBucket_t) * self->count);
+      memset(buckets, 0, sizeof(MacroPyramidBucket_t) * shift);
+    }
+    memset(&buckets[shift + self->count], 0, sizeof(MacroPyramidBucket_t) * (newCount - shift - self->count));
+  }
+
+  self->firstKey = first;
+  self->count = newCount;
+  return key - first;
+}
+
+const MacroPyramidBucket_t *_MacroPyramidLevel_find(const MacroPyramidLevel_t *self, uint32_t column, uint32_t key) {
+  if (key < self->firstKey || key - self->firstKey >= self->count)
+    return NULL;
+
+  return &self->columns[column][key - self->firstKey];
+}
+
+// Bucket made of two children, either can be missing
+void _MacroPyramid_merge(MacroPyramidBucket_t *out, const MacroPyramidBucket_t *left, const MacroPyramidBucket_t *right) {
+  *out = (MacroPyramidBucket_t) {0};
+  const MacroPyramidBucket_t *children[2] = { left, right };
+
+  for (uint32_t child = 0; child < 2; child++) {
+    const MacroPyramidBucket_t *bucket = children[child];
+    if (bucket == NULL || bucket->days == 0)
+      continue;
+
+    out->min = out->days == 0 || bucket->min < out->min ? bucket->min : out->min;
+    out->max = out->days == 0 || bucket->max > out->max ? bucket->max : out->max;
+    out->sum += bucket->sum;
+    out->days += bucket->days;
+  }
+}
+
+// Day buckets hold the day's total as min and max
+void _MacroPyramid_setDay(MacroPyramidBucket_t *bucket) {
+  bucket->min = bucket->max = bucket->sum > UINT32_MAX ? UINT32_MAX : (uint32_t)bucket->sum;
+  bucket->days = 1;
+}
+
+void MacroPyramid_add(MacroPyramid_t *self, DayNum_t day, const Macro_t *macro) {
+  const uint32_t *values = &macro->cals;
+
+  MacroPyramidLevel_t *days = &self->levels[0];
+  uint32_t index = day <= DATE_MAX_DAY_NUM ? _MacroPyramidLevel_at(days, day) : UINT32_MAX;
+  if (index == UINT32_MAX) {
+    log_error("Day %u left out of the pyramid" ENDL, day);
+    return;
+  }
+
+  for (uint32_t column = 0; column < MACRO_COLUMN_COUNT; column++) {
+    MacroPyramidBucket_t *bucket = &days->columns[column][index];
+    bucket->sum += values[column];
+    _MacroPyramid_setDay(bucket);
+  }
+
+  // Every level above gets its bucket again from the two below it
+  for (uint32_t level = 1; level < MACRO_PYRAMID_LEVELS; level++) {
+    MacroPyramidLevel_t *table = &self->levels[level];
+    const MacroPyramidLevel_t *below = &self->levels[level - 1];
+    uint32_t key = day >> level;
+    if ((index = _MacroPyramidLevel_at(table, key)) == UINT32_MAX) {
+      log_error("Failed to grow pyramid level %u to key %u" ENDL, level, key);
+      continue;
+    }
+
+    for (uint32_t column = 0; column < MACRO_COLUMN_COUNT; column++) {
+      _MacroPyramid_merge(&table->columns[column][index],
+        _MacroPyramidLevel_find(below, column, key << 1),
+        _MacroPyramidLevel_find(below, column, (key << 1) | 1)
+      );
+    }
+  }
+}
+
+// Fills level from the one below it, which already covers [first, last]
+bool _MacroPyramid_buildLevel(MacroPyramid_t *self, uint32_t level, DayNum_t first, DayNum_t last) {
+  MacroPyramidLevel_t *table = &self->levels[level];
+  const MacroPyramidLevel_t *below = &self->levels[level - 1];
+  if (!_MacroPyramidLevel_reserve(table, (last >> level) - (first >> level) + 1))
+    return false;
+  table->firstKey = first >> level;
+  table->count = (last >> level) - table->firstKey + 1;
+
+  for (uint32_t column = 0; column < MACRO_COLUMN_COUNT; column++) {
+    for (uint32_t index = 0; index < table->count; index++) {
+      uint32_t key = table->firstKey + index;
+      _MacroPyramid_merge(&table->columns[column][index],
+        _MacroPyramidLevel_find(below, column, key << 1),
+        _MacroPyramidLevel_find(below, column, (key << 1) | 1)
+      );
+    }
+  }
+  return true;
+}
+
+void MacroPyramid_build(MacroPyramid_t *self, const MacroDatabase_t *db) {
+  DEBUG_ASSERT(self->levels[0].count == 0, "Pyramid is already built");
+
+  // Days past DATE_MAX_DAY_NUM are left out, like MacroPyramid_add does
+  DayNum_t first, last;
+  MacroPyramidLevel_t *table = &self->levels[0];
+  if (!MacroDatabase_dayBounds(db, &first, &last) || !_MacroPyramidLevel_reserve(table, last - first + 1))
+    return;
+  table->firstKey = first;
+  table->count = last - first + 1;
+
+  for (uint32_t column = 0; column < MACRO_COLUMN_COUNT; column++) {
+    memset(table->columns[column], 0, sizeof(MacroPyramidBucket_t) * table->count);
+  }
+
+  MacroRows_t rows;
+  for (uint32_t row = 0; row < db->mealCount; row += rows.count) {
+    MacroDatabase_rows(db, row, db->mealCount - row, &rows);
+    for (uint32_t column = 0; column < MACRO_COLUMN_COUNT; column++) {
+      MacroPyramidBucket_t *buckets = table->columns[column];
+      for (uint32_t index = 0; index < rows.count; index++) {
+        if (rows.days[index] > DATE_MAX_DAY_NUM)
+          continue;
+        buckets[rows.days[index] - first].sum += rows.columns[column][index];
+        buckets[rows.days[index] - first].days = 1;
+      }
+    }
+  }
+
+  for (uint32_t column = 0; column < MACRO_COLUMN_COUNT; column++) {
+    MacroPyramidBucket_t *buckets = table->columns[column];
+    for (uint32_t index = 0; index < table->count; index++) {
+      if (buckets[index].days > 0)
+        _MacroPyramid_setDay(&buckets[index]);
+    }
+  }
+
+  for (uint32_t level = 1; level < MACRO_PYRAMID_LEVELS; level++) {
+    if (_MacroPyramid_buildLevel(self, level, first, last))
+      continue;
+
+    // Half built levels would pass for a built pyramid, it stays empty instead
+    log_error("Failed to build pyramid level %u" ENDL, level);
+    for (uint32_t reset = 0; reset < MACRO_PYRAMID_LEVELS; reset++) {
+      self->levels[reset].count = 0;
+    }
+    return;
+  }
+}
+
+uint32_t MacroPyramid_series(const MacroPyramid_t *self, MacroColumn_t column, DayNum_t from, DayNum_t to,
+  uint32_t maxBuckets, MacroPyramidBucket_t *out, uint32_t *level) {
+  *level = 0;
+  if (from > to || maxBuckets == 0)
+    return 0;
+
+  // Finest level that fits, the top one is cut short if even it doesn't
+  uint32_t chosen = 0;
+  while (chosen + 1 < MACRO_PYRAMID_LEVELS && (uint64_t)(to >> chosen) - (from >> chosen) + 1 > maxBuckets) {
+    chosen++;
+  }
+  uint32_t firstKey = from >> chosen;
+  uint64_t needed = (uint64_t)(to >> chosen) - firstKey + 1;
+  uint32_t count = needed < maxBuckets ? (uint32_t)needed : maxBuckets;
+
+  const MacroPyramidLevel_t *table = &self->levels[chosen];
+  for (uint32_t index = 0; index < count; index++) {
+    const MacroPyramidBucket_t *bucket = _MacroPyramidLevel_find(table, column, firstKey + index);
+    out[index] = bucket != NULL ? *bucket : (MacroPyramidBucket_t) {0};
+  }
+
+  *level = chosen;
+  return count;
+}
+
+uint64_t _MacroPyramid_bucketBytes(const uint32_t counts[MACRO_PYRAMID_LEVELS]) {
+  uint64_t buckets = 0;
+  for (uint32_t level = 0; level < MACRO_PYRAMID_LEVELS; level++) {
+    buckets += counts[level];
+  }
+  return sizeof(MacroPyramidBucket_t) * MACRO_COLUMN_COUNT * buckets;
+}
+
+Result_t MacroPyramid_write(const MacroPyramid_t *self, const char *path, uint32_t mealCount, uint64_t nextSequence) {
+  MacroPyramidHeader_t header = {
+    .magic = MACRO_PYRAMID_MAGIC,
+    .version = MACRO_PYRAMID_VERSION,
+    .mealCount = mealCount,
+    .nextSequence = nextSequence
+  };
+  for (uint32_t level = 0; level < MACRO_PYRAMID_LEVELS; level++) {
+    header.firstKeys[level] = self->levels[level].firstKey;
+    header.counts[level] = self->levels[level].count;
+  }
+
+  // Small next to the snapshot, the buckets go out in one write
+  uint64_t bucketBytes = _MacroPyramid_bucketBytes(header.counts);
+  if (bucketBytes > UINT32_MAX - sizeof(header)) {
+    log_error("Pyramid is too big to be written" ENDL);
+    return RESULT_FAIL;
+  }
+  uint8_t *data = malloc(sizeof(header) + bucketBytes);
+  uint8_t *cursor = data + sizeof(header);
+  for (uint32_t level = 0; level < MACRO_PYRAMID_LEVELS; level++) {
+    for (uint32_t column = 0; column < MACRO_COLUMN_COUNT; column++) {
+      size_t size = sizeof(MacroPyramidBucket_t) * self->levels[level].count;
+      memcpy(cursor, self->levels[level].columns[column], size);
+      cursor += size;
+    }
+  }
+  header.bucketChecksum = MacroLog_checksum(data + sizeof(header), bucketBytes);
+  header.checksum = MacroLog_checksum(&header, offsetof(MacroPyramidHeader_t, checksum));
+  memcpy(data, &header, sizeof(header));
+
+  char tmpPath[MAX_PATH] = {0};
+  snprintf(tmpPath, sizeof(tmpPath), "%s.tmp", path);
+  HANDLE file = CreateFileA(tmpPath, GENERIC_WRITE, 0, NULL, CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, NULL);
+  if (file == INVALID_HANDLE_VALUE) {
+    log_error("Couldn't create the pyramid file %s, error code: %lu" ENDL, tmpPath, GetLastError());
+    free(data);
+    return RESULT_FAIL;
+  }
+
+  DWORD size = (DWORD)(sizeof(header) + bucketBytes);
+  DWORD written = 0;
+  bool succeeded = WriteFile(file, data, size, &written, NULL) && written == size && FlushFileBuffers(file);
+  CloseHandle(file);
+  free(data);
+
+  if (!succeeded || !MoveFileExA(tmpPath, path, MOVEFILE_REPLACE_EXISTING | MOVEFILE_WRITE_THROUGH)) {
+    log_error("Failed to write the pyramid %s, error code: %lu" ENDL, path, GetLastError());
+    DeleteFileA(tmpPath);
+    return RESULT_FAIL;
+  }
+
+  return RESULT_SUCCESS;
+}
+
+Result_t MacroPyramid_read(MacroPyramid_t *self, const char *path, uint32_t mealCount, uint64_t nextSequence) {
+  DEBUG_ASSERT(self->levels[0].count == 0, "Pyramids are only read into empty ones");
+
+  HANDLE file = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+  if (file == INVALID_HANDLE_VALUE)
+    return RESULT_FAIL;
+
+  MacroPyramidHeader_t header = {0};
+  DWORD readBytes = 0;
+  uint8_t *data = NULL;
+  bool valid = ReadFile(file, &header, sizeof(header), &readBytes, NULL) && readBytes == sizeof(header) &&
+    header.magic == MACRO_PYRAMID_MAGIC && header.version == MACRO_PYRAMID_VERSION &&
+    header.checksum == MacroLog_checksum(&header, offsetof(MacroPyramidHeader_t, checksum));
+
+  // The snapshot was written again without it, the buckets are stale
+  if (valid && (header.mealCount != mealCount || header.nextSequence != nextSequence)) {
+    log_info("Pyramid %s belongs to another snapshot, it will be built again" ENDL, path);
+    CloseHandle(file);
+    return RESULT_FAIL;
+  }
+
+  // Empty pyramids aren't written
+  uint64_t bucketBytes = valid ? _MacroPyramid_bucketBytes(header.counts) : 0;
+  if (valid && bucketBytes > 0 && bucketBytes <= UINT32_MAX) {
+    data = malloc(bucketBytes);
+    valid = ReadFile(file, data, (DWORD)bucketBytes, &readBytes, NULL) && readBytes == bucketBytes &&
+      header.bucketChecksum == MacroLog_checksum(data, bucketBytes);
+  }
+  CloseHandle(file);
+
+  if (!valid || data == NULL) {
+    log_error("Pyramid %s is corrupted or of an unsupported version" ENDL, path);
+    free(data);
+    return RESULT_FAIL;
+  }
+
+  const uint8_t *cursor = data;
+  for (uint32_t level = 0; level < MACRO_PYRAMID_LEVELS; level++) {
+    MacroPyramidLevel_t *table = &self->levels[level];
+    if (!_MacroPyramidLevel_reserve(table, header.counts[level])) {
+      log_error("Pyramid %s doesn't fit in memory" ENDL, path);
+      free(data);
+      return RESULT_FAIL;
+    }
+    table->firstKey = header.firstKeys[level];
+    table->count = header.counts[level];
+
+    for (uint32_t column = 0; column < MACRO_COLUMN_COUNT; column++) {
+      size_t size = sizeof(MacroPyramidBucket_t) * table->count;
+      memcpy(table->columns[column], cursor, size);
+      cursor += size;
+    }
+  }
+
+  free(data);
+  return RESULT_SUCCESS;
+}
@@ -0,0 +1,929 @@
+#include <stdlib.h>
+#include <string.h>
+
+#include <log.h>
+
+#include "MacroQuery.h"
+#include "MacroMorsel.h"
+#include "MacroRollup.h"
+
+#define DEFAULT_GROUP_CAP (1 << 6)
+#define MACRO_QUERY_RECENT_GROUPS 16
+
+typedef struct __MacroQueryParser_t {
+  const char *text, *at;
+  MacroQuery_t *query;
+  uint32_t depth;
+  // Nots and parentheses the parser is inside of
+  uint32_t nesting;
+} MacroQueryParser_t;
+
+bool _MacroQuery_isIdentifierChar(char c) {
+  return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || c == '_';
+}
+
+void _MacroQueryParser_skipSpaces(MacroQueryParser_t *self) {
+  while (*self->at == ' ' || *self->at == '\t' || *self->at == '\n' || *self->at == '\r') {
+    self->at++;
+  }
+}
+
+bool _MacroQueryParser_fail(MacroQueryParser_t *self, const char *message) {
+  log_error("Query error at %u (\"%.16s\"): %s" ENDL, (uint32_t)(self->at - self->text), self->at, message);
+  return false;
+}
+
+// Consumes keyword when it's the next whole word, whatever its case
+bool _MacroQueryParser_keyword(MacroQueryParser_t *self, const char *keyword) {
+  _MacroQueryParser_skipSpaces(self);
+
+  uint32_t length = (uint32_t)strlen(keyword);
+  for (uint32_t index = 0; index < length; index++) {
+    char c = self->at[index];
+    if ((c >= 'A' && c <= 'Z' ? c - 'A' + 'a' : c) != keyword[index])
+      return false;
+  }
+  if (_MacroQuery_isIdentifierChar(self->at[length]))
+    return false;
+
+  self->at += length;
+  return true;
+}
+
+bool _MacroQueryParser_symbol(MacroQueryParser_t *self, const char *symbol) {
+  _MacroQueryParser_skipSpaces(self);
+
+  uint32_t length = (uint32_t)strlen(symbol);
+  if (strncmp(self->at, symbol, length) != 0)
+    return false;
+
+  self->at += length;
+  return true;
+}
+
+// Index of the first of count keywords that comes next, count when none does
+uint32_t _MacroQueryParser_oneOf(MacroQueryParser_t *self, const char *const *keywords, uint32_t count) {
+  for (uint32_t index = 0; index < count; index++) {
+    if (_MacroQueryParser_keyword(self, keywords[index]))
+      return index;
+  }
+
+  return count;
+}
+
+bool _MacroQueryParser_number(MacroQueryParser_t *self, uint32_t *out) {
+  _MacroQueryParser_skipSpaces(self);
+  if (*self->at < '0' || *self->at > '9')
+    return false;
+
+  uint64_t value = 0;
+  while (*self->at >= '0' && *self->at <= '9') {
+    value = value * 10 + (*self->at++ - '0');
+    if (value > UINT32_MAX)
+      return _MacroQueryParser_fail(self, "number out of range");
+  }
+
+  *out = (uint32_t)value;
+  return true;
+}
+
+bool _MacroQueryParser_emit(MacroQueryParser_t *self, MacroQueryOpcode_t opcode, uint32_t predicate) {
+  MacroQuery_t *query = self->query;
+  if (query->programLength == MACRO_QUERY_MAX_PROGRAM)
+    return _MacroQueryParser_fail(self, "where clause too long");
+
+  query->program[query->programLength++] = (MacroQueryOp_t) { .opcode = opcode, .predicate = (uint8_t)predicate };
+  if (opcode == MACRO_QUERY_OP_PREDICATE) {
+    self->depth++;
+    query->_stackDepth = self->depth > query->_stackDepth ? self->depth : query->_stackDepth;
+  } else if (opcode != MACRO_QUERY_OP_NOT) {
+    self->depth--;
+  }
+  return true;
+}
+
+static const char *const _MacroQuery_operands[] = { "cals", "protein", "fat", "carbs", "date", "weekday" };
+static const char *const _MacroQuery_weekdays[] = { "mon", "tue", "wed", "thu", "fri", "sat", "sun" };
+static const char *const _MacroQuery_compares[] = { "<=", ">=", "!=", "<", ">", "=" };
+static const MacroQueryCompare_t _MacroQuery_compareOps[] = {
+  MACRO_QUERY_LE, MACRO_QUERY_GE, MACRO_QUERY_NE, MACRO_QUERY_LT, MACRO_QUERY_GT, MACRO_QUERY_EQ
+};
+
+bool _MacroQueryParser_predicate(MacroQueryParser_t *self) {
+  MacroQuery_t *query = self->query;
+  uint32_t operand = _MacroQueryParser_oneOf(self, _MacroQuery_operands, MACRO_QUERY_OPERAND_WEEKDAY + 1);
+  if (operand > MACRO_QUERY_OPERAND_WEEKDAY)
+    return _MacroQueryParser_fail(self, "expected cals, protein, fat, carbs, date or weekday");
+
+  uint32_t compare = 0;
+  while (compare < 6 && !_MacroQueryParser_symbol(self, _MacroQuery_compares[compare])) {
+    compare++;
+  }
+  if (compare == 6)
+    return _MacroQueryParser_fail(self, "expected a comparison");
+
+  uint32_t value = 0;
+  if (operand == MACRO_QUERY_OPERAND_DATE) {
+    Date_t date = {0};
+    if (!_MacroQueryParser_number(self, &date.year) || !_MacroQueryParser_symbol(self, "-") ||
+        !_MacroQueryParser_number(self, &date.month) || !_MacroQueryParser_symbol(self, "-") ||
+        !_MacroQueryParser_number(self, &date.day) || !Date_isStorable(date))
+      return _MacroQueryParser_fail(self, "expected a YYYY-MM-DD date between 1970 and 9999");
+    value = Date_toDayNum(date);
+  } else if (operand == MACRO_QUERY_OPERAND_WEEKDAY) {
+    value = _MacroQueryParser_oneOf(self, _MacroQuery_weekdays, 7);
+    if (value == 7)
+      return _MacroQueryParser_fail(self, "expected mon, tue, wed, thu, fri, sat or sun");
+  } else if (!_MacroQueryParser_number(self, &value)) {
+    return _MacroQueryParser_fail(self, "expected a number");
+  }
+
+  if (query->predicateCount == MACRO_QUERY_MAX_PREDICATES)
+    return _MacroQueryParser_fail(self, "too many conditions");
+
+  query->predicates[query->predicateCount] = (MacroQueryPredicate_t) {
+    .operand = (uint8_t)operand,
+    .compare = (uint8_t)_MacroQuery_compareOps[compare],
+    .value = value
+  };
+  return _MacroQueryParser_emit(self, MACRO_QUERY_OP_PREDICATE, query->predicateCount++);
+}
+
+bool _MacroQueryParser_or(MacroQueryParser_t *self);
+
+bool _MacroQueryParser_not(MacroQueryParser_t *self) {
+  bool negated = _MacroQueryParser_keyword(self, "not");
+  if (!negated && !_MacroQueryParser_symbol(self, "("))
+    return _MacroQueryParser_predicate(self);
+
+  if (self->nesting == MACRO_QUERY_MAX_NESTING)
+    return _MacroQueryParser_fail(self, "where clause nested too deep");
+
+  self->nesting++;
+  bool parsed = negated ?
+    _MacroQueryParser_not(self) && _MacroQueryParser_emit(self, MACRO_QUERY_OP_NOT, 0) :
+    _MacroQueryParser_or(self) && (_MacroQueryParser_symbol(self, ")") || _MacroQueryParser_fail(self, "expected )"));
+  self->nesting--;
+  return parsed;
+}
+
+bool _MacroQueryParser_and(MacroQueryParser_t *self) {
+  if (!_MacroQueryParser_not(self))
+    return false;
+
+  while (_MacroQueryParser_keyword(self, "and")) {
+    if (!_MacroQueryParser_not(self) || !_MacroQueryParser_emit(self, MACRO_QUERY_OP_AND, 0))
+      return false;
+  }
+  return true;
+}
+
+bool _MacroQueryParser_or(MacroQueryParser_t *self) {
+  if (!_MacroQueryParser_and(self))
+    return false;
+
+  while (_MacroQueryParser_keyword(self, "or")) {
+    if (!_MacroQueryParser_and(self) || !_MacroQueryParser_emit(self, MACRO_QUERY_OP_OR, 0))
+      return false;
+  }
+  return true;
+}
+
+static const char *const _MacroQuery_groups[] = { "day", "week", "month", "year", "weekday" };
+static const char *const _MacroQuery_aggregates[] = { "count", "sum", "avg", "min", "max" };
+
+bool _MacroQueryParser_select(MacroQueryParser_t *self) {
+  MacroQuery_t *query = self->query;
+  do {
+    uint32_t aggregate = _MacroQueryParser_oneOf(self, _MacroQuery_aggregates, 5);
+    if (aggregate == 5)
+      return _MacroQueryParser_fail(self, "expected count, sum, avg, min or max");
+
+    uint32_t column = 0;
+    if (aggregate != MACRO_QUERY_COUNT) {
+      if (!_MacroQueryParser_symbol(self, "("))
+        return _MacroQueryParser_fail(self, "expected (");
+      column = _MacroQueryParser_oneOf(self, _MacroQuery_operands, MACRO_COLUMN_COUNT);
+      if (column == MACRO_COLUMN_COUNT)
+        return _MacroQueryParser_fail(self, "expected cals, protein, fat or carbs");
+      if (!_MacroQueryParser_symbol(self, ")"))
+        return _MacroQueryParser_fail(self, "expected )");
+      query->_columnMask |= 1u << column;
+    }
+
+    if (query->selectCount == MACRO_QUERY_MAX_SELECT)
+      return _MacroQueryParser_fail(self, "too many aggregates");
+    query->select[query->selectCount++] = (MacroQuerySelect_t) {
+      .aggregate = (uint8_t)aggregate,
+      .column = (uint8_t)column
+    };
+  } while (_MacroQueryParser_symbol(self, ","));
+
+  return true;
+}
+
+Result_t MacroQuery_compile(MacroQuery_t *self, const char *text) {
+  *self = (MacroQuery_t) {
+    .source = MACRO_QUERY_SOURCE_MEALS,
+    .group = MACRO_QUERY_GROUP_NONE
+  };
+  MacroQueryParser_t parser = { .text = text, .at = text, .query = self, .depth = 0, .nesting = 0 };
+
+  if (_MacroQueryParser_keyword(&parser, "from")) {
+    if (_MacroQueryParser_keyword(&parser, "days"))
+      self->source = MACRO_QUERY_SOURCE_DAYS;
+    else if (!_MacroQueryParser_keyword(&parser, "meals")) {
+      _MacroQueryParser_fail(&parser, "expected meals or days");
+      return RESULT_FAIL;
+    }
+  }
+
+  if (_MacroQueryParser_keyword(&parser, "where") && !_MacroQueryParser_or(&parser))
+    return RESULT_FAIL;
+
+  if (_MacroQueryParser_keyword(&parser, "group")) {
+    if (!_MacroQueryParser_keyword(&parser, "by")) {
+      _MacroQueryParser_fail(&parser, "expected by");
+      return RESULT_FAIL;
+    }
+
+    uint32_t group = _MacroQueryParser_oneOf(&parser, _MacroQuery_groups, 5);
+    if (group == 5) {
+      _MacroQueryParser_fail(&parser, "expected day, week, month, year or weekday");
+      return RESULT_FAIL;
+    }
+    self->group = (MacroQueryGroup_t)(MACRO_QUERY_GROUP_DAY + group);
+  }
+
+  if (_MacroQueryParser_keyword(&parser, "select")) {
+    if (!_MacroQueryParser_select(&parser))
+      return RESULT_FAIL;
+  } else {
+    self->select[self->selectCount++] = (MacroQuerySelect_t) { .aggregate = MACRO_QUERY_COUNT };
+  }
+
+  _MacroQueryParser_skipSpaces(&parser);
+  if (*parser.at != '\0') {
+    _MacroQueryParser_fail(&parser, "unexpected text");
+    return RESULT_FAIL;
+  }
+
+  return RESULT_SUCCESS;
+}
+
+typedef struct __MacroQueryGroupState_t {
+  uint64_t sum[MACRO_COLUMN_COUNT];
+  uint32_t min[MACRO_COLUMN_COUNT];
+  uint32_t max[MACRO_COLUMN_COUNT];
+  uint32_t count;
+} MacroQueryGroupState_t;
+
+// One column batch, columns and days hold count rows
+typedef struct __MacroQueryBatch_t {
+  const uint32_t *columns[MACRO_COLUMN_COUNT];
+  const DayNum_t *days;
+  uint32_t count;
+} MacroQueryBatch_t;
+
+typedef struct __MacroQueryGroupSlot_t {
+  uint32_t key;
+  // Group index + 1, 0 is a free slot
+  uint32_t group;
+} MacroQueryGroupSlot_t;
+
+typedef struct __MacroQueryState_t {
+  uint8_t masks[MACRO_QUERY_MAX_PREDICATES][MACRO_QUERY_BATCH_ROWS];
+  uint16_t selection[MACRO_QUERY_BATCH_ROWS];
+  uint32_t keys[MACRO_QUERY_BATCH_ROWS];
+  uint32_t weekdays[MACRO_QUERY_BATCH_ROWS];
+
+  // Day totals are gathered here when the query reads days
+  uint32_t values[MACRO_COLUMN_COUNT][MACRO_QUERY_BATCH_ROWS];
+  DayNum_t days[MACRO_QUERY_BATCH_ROWS];
+  // Frozen meal rows are decoded here
+  MacroRows_t rows;
+
+  // Groups in the order they got their first row, groupKeys[i] is the key of groups[i].
+  // Found by key through _slots, an open addressed table twice the size of the groups
+  MacroQueryGroupState_t *groups;
+  uint32_t *groupKeys;
+  uint32_t groupCount, _groupCap;
+  MacroQueryGroupSlot_t *_slots;
+  // Groups of recently seen keys by key % MACRO_QUERY_RECENT_GROUPS, a batch's rows mostly
+  // share a handful of keys (one day, seven weekdays) that skip the probe this way
+  MacroQueryGroupSlot_t _recent[MACRO_QUERY_RECENT_GROUPS];
+  // An allocation failed, the state stopped aggregating
+  bool failed;
+
+  // Month/year key of every day of the history, dayKeys[day - firstDay]. Shared by the workers
+  const uint32_t *dayKeys;
+  DayNum_t firstDay;
+
+  MacroZoneCounts_t counts;
+} MacroQueryState_t;
+
+// Group keys come in runs of consecutive days, weeks, months or years. Runs of 8 keys share
+// a cache line of slots, the runs themselves are scattered so far apart keys never pile up
+uint32_t _MacroQuery_hash(uint32_t key) {
+  uint32_t hash = key >> 3;
+  hash = (hash ^ (hash >> 16)) * 0x7FEB352Du;
+  hash = (hash ^ (hash >> 15)) * 0x846CA68Bu;
+  return ((hash ^ (hash >> 16)) << 3) | (key & 7);
+}
+
+// Rehashes the groups into _slots sized for capacity, keeps the old table when it can't
+bool _MacroQueryState_rehash(MacroQueryState_t *self, uint32_t capacity) {
+  MacroQueryGroupSlot_t *slots = calloc((size_t)capacity * 2, sizeof(MacroQueryGroupSlot_t));
+  if (slots == NULL)
+    return false;
+
+  uint32_t mask = capacity * 2 - 1;
+  for (uint32_t group = 0; group < self->groupCount; group++) {
+    uint32_t slot = _MacroQuery_hash(self->groupKeys[group]) & mask;
+    while (slots[slot].group != 0) {
+      slot = (slot + 1) & mask;
+    }
+    slots[slot] = (MacroQueryGroupSlot_t) { .key = self->groupKeys[group], .group = group + 1 };
+  }
+
+  free(self->_slots);
+  self->_slots = slots;
+  return true;
+}
+
+// Index of key's group, a new empty one when key has none yet. UINT32_MAX when it can't grow
+uint32_t _MacroQueryState_group(MacroQueryState_t *self, uint32_t key) {
+  MacroQueryGroupSlot_t *recent = &self->_recent[key % MACRO_QUERY_RECENT_GROUPS];
+  if (recent->group != 0 && recent->key == key)
+    return recent->group - 1;
+
+  uint32_t mask = self->_groupCap * 2 - 1;
+  uint32_t slot = _MacroQuery_hash(key) & mask;
+  while (self->_slots[slot].group != 0 && self->_slots[slot].key != key) {
+    slot = (slot + 1) & mask;
+  }
+
+  uint32_t group = self->_slots[slot].group - 1;
+  if (self->_slots[slot].group == 0) {
+    if (self->groupCount == self->_groupCap) {
+      uint32_t capacity = self->_groupCap << 1;
+      MacroQueryGroupState_t *groups = realloc(self->groups, sizeof(MacroQueryGroupState_t) * capacity);
+      if (groups != NULL)
+        self->groups = groups;
+      uint32_t *keys = groups != NULL ? realloc(self->groupKeys, sizeof(uint32_t) * capacity) : NULL;
+      if (keys != NULL)
+        self->groupKeys = keys;
+      if (keys == NULL || !_MacroQueryState_rehash(self, capacity))
+        return UINT32_MAX;
+
+      self->_groupCap = capacity;
+      return _MacroQueryState_group(self, key);
+    }
+
+    group = self->groupCount++;
+    self->_slots[slot] = (MacroQueryGroupSlot_t) { .key = key, .group = group + 1 };
+    self->groupKeys[group] = key;
+    self->groups[group] = (MacroQueryGroupState_t) { .count = 0 };
+    for (uint32_t column = 0; column < MACRO_COLUMN_COUNT; column++) {
+      self->groups[group].min[column] = UINT32_MAX;
+    }
+  }
+
+  *recent = (MacroQueryGroupSlot_t) { .key = key, .group = group + 1 };
+  return group;
+}
+
+#define MACRO_QUERY_COMPARE_LOOP(op)                    \
+  for (uint32_t row = 0; row < count; row++) {          \
+    mask[row] = values[row] op value;                   \
+  }                                                     \
+  break
+
+// Filter: runs the where program into one mask, then turns it into a selection vector
+uint32_t _MacroQuery_filter(const MacroQuery_t *self, MacroQueryState_t *state, const MacroQueryBatch_t *batch, bool all) {
+  uint32_t count = batch->count;
+  if (self->programLength == 0 || all) {
+    for (uint32_t row = 0; row < count; row++) {
+      state->selection[row] = (uint16_t)row;
+    }
+    return count;
+  }
+
+  bool weekdays = false;
+  uint32_t depth = 0;
+  for (uint32_t op = 0; op < self->programLength; op++) {
+    const MacroQueryOp_t *instruction = &self->program[op];
+    switch (instruction->opcode) {
+      case MACRO_QUERY_OP_PREDICATE: {
+        const MacroQueryPredicate_t *predicate = &self->predicates[instruction->predicate];
+        const uint32_t *values = predicate->operand < MACRO_COLUMN_COUNT ? batch->columns[predicate->operand] : batch->days;
+        if (predicate->operand == MACRO_QUERY_OPERAND_WEEKDAY) {
+          if (!weekdays) {
+            for (uint32_t row = 0; row < count; row++) {
+              state->weekdays[row] = (uint32_t)(((uint64_t)batch->days[row] + 3) % 7);
+            }
+            weekdays = true;
+          }
+          values = state->weekdays;
+        }
+
+        uint8_t *mask = state->masks[depth++];
+        uint32_t value = predicate->value;
+        switch (predicate->compare) {
+          case MACRO_QUERY_LT: MACRO_QUERY_COMPARE_LOOP(<);
+          case MACRO_QUERY_LE: MACRO_QUERY_COMPARE_LOOP(<=);
+          case MACRO_QUERY_GT: MACRO_QUERY_COMPARE_LOOP(>);
+          case MACRO_QUERY_GE: MACRO_QUERY_COMPARE_LOOP(>=);
+          case MACRO_QUERY_EQ: MACRO_QUERY_COMPARE_LOOP(==);
+          default: MACRO_QUERY_COMPARE_LOOP(!=);
+        }
+        break;
+      }
+      case MACRO_QUERY_OP_AND: {
+        uint8_t *mask = state->masks[depth - 2], *other = state->masks[--depth];
+        for (uint32_t row = 0; row < count; row++) {
+          mask[row] &= other[row];
+        }
+        break;
+      }
+      case MACRO_QUERY_OP_OR: {
+        uint8_t *mask = state->masks[depth - 2], *other = state->masks[--depth];
+        for (uint32_t row = 0; row < count; row++) {
+          mask[row] |= other[row];
+        }
+        break;
+      }
+      default: {
+        uint8_t *mask = state->masks[depth - 1];
+        for (uint32_t row = 0; row < count; row++) {
+          mask[row] ^= 1;
+        }
+        break;
+      }
+    }
+  }
+
+  // Branch free, every row is written and only the selected ones move the cursor on
+  const uint8_t *mask = state->masks[0];
+  uint32_t selected = 0;
+  for (uint32_t row = 0; row < count; row++) {
+    state->selection[selected] = (uint16_t)row;
+    selected += mask[row];
+  }
+  return selected;
+}
+
+// Project: group key of every selected row
+void _MacroQuery_project(const MacroQuery_t *self, MacroQueryState_t *state, const MacroQueryBatch_t *batch, uint32_t selected) {
+  const uint16_t *selection = state->selection;
+  const DayNum_t *days = batch->days;
+  uint32_t *keys = state->keys;
+
+  switch (self->group) {
+    case MACRO_QUERY_GROUP_DAY:
+      for (uint32_t index = 0; index < selected; index++) {
+        keys[index] = days[selection[index]];
+      }
+      break;
+    case MACRO_QUERY_GROUP_WEEK:
+      for (uint32_t index = 0; index < selected; index++) {
+        keys[index] = (uint32_t)(((uint64_t)days[selection[index]] + 3) / 7);
+      }
+      break;
+    case MACRO_QUERY_GROUP_WEEKDAY:
+      for (uint32_t index = 0; index < selected; index++) {
+        keys[index] = (uint32_t)(((uint64_t)days[selection[index]] + 3) % 7);
+      }
+      break;
+    case MACRO_QUERY_GROUP_MONTH:
+    case MACRO_QUERY_GROUP_YEAR: {
+      const uint32_t *dayKeys = state->dayKeys - state->firstDay;
+      for (uint32_t index = 0; index < selected; index++) {
+        keys[index] = dayKeys[days[selection[index]]];
+      }
+      break;
+    }
+    default:
+      memset(keys, 0, sizeof(uint32_t) * selected);
+      break;
+  }
+}
+
+// Ungrouped, every selected row goes to the one group and the sums stay in registers
+void _MacroQuery_aggregateOne(const MacroQuery_t *self, MacroQueryGroupState_t *group, const MacroQueryBatch_t *batch,
+  const uint16_t *selection, uint32_t selected) {
+  group->count += selected;
+
+  for (uint32_t column = 0; column < MACRO_COLUMN_COUNT; column++) {
+    if ((self->_columnMask & (1u << column)) == 0)
+      continue;
+
+    const uint32_t *values = batch->columns[column];
+    uint64_t sum = 0;
+    uint32_t min = group->min[column], max = group->max[column];
+    for (uint32_t index = 0; index < selected; index++) {
+      uint32_t value = values[selection[index]];
+      sum += value;
+      min = value < min ? value : min;
+      max = value > max ? value : max;
+    }
+    group->sum[column] += sum;
+    group->min[column] = min;
+    group->max[column] = max;
+  }
+}
+
+// Aggregate: keys are swapped for group indices first, so the column loops below only index
+// the groups. Sparse keys (a stray date years away) cost one group each, not the span between
+void _MacroQuery_aggregate(const MacroQuery_t *self, MacroQueryState_t *state, const MacroQueryBatch_t *batch, uint32_t selected) {
+  const uint16_t *selection = state->selection;
+  uint32_t *keys = state->keys;
+
+  if (self->group == MACRO_QUERY_GROUP_NONE) {
+    uint32_t group = _MacroQueryState_group(state, 0);
+    if (group == UINT32_MAX) {
+      state->failed = true;
+      return;
+    }
+    _MacroQuery_aggregateOne(self, &state->groups[group], batch, selection, selected);
+    return;
+  }
+
+  for (uint32_t index = 0; index < selected; index++) {
+    uint32_t group = _MacroQueryState_group(state, keys[index]);
+    if (group == UINT32_MAX) {
+      state->failed = true;
+      return;
+    }
+    keys[index] = group;
+    state->groups[group].count++;
+  }
+
+  MacroQueryGroupState_t *groups = state->groups;
+  for (uint32_t column = 0; column < MACRO_COLUMN_COUNT; column++) {
+    if ((self->_columnMask & (1u << column)) == 0)
+      continue;
+
+    const uint32_t *values = batch->columns[column];
+    for (uint32_t index = 0; index < selected; index++) {
+      MacroQueryGroupState_t *group = &groups[keys[index]];
+      uint32_t value = values[selection[index]];
+      group->sum[column] += value;
+      group->min[column] = value < group->min[column] ? value : group->min[column];
+      group->max[column] = value > group->max[column] ? value : group->max[column];
+    }
+  }
+}
+
+// all when the zone of the batch already showed every row matches
+void _MacroQuery_process(const MacroQuery_t *self, MacroQueryState_t *state, const MacroQueryBatch_t *batch, bool all) {
+  if (state->failed)
+    return;
+
+  uint32_t selected = _MacroQuery_filter(self, state, batch, all);
+  if (selected == 0)
+    return;
+
+  _MacroQuery_project(self, state, batch, selected);
+  _MacroQuery_aggregate(self, state, batch, selected);
+}
+
+// Day totals of the days with meals in buckets [first, first + count), clamped to the meal columns' width
+void _MacroQuery_scanDays(const MacroQuery_t *self, MacroQueryState_t *state, const MacroRollupTable_t *table,
+  uint32_t first, uint32_t count) {
+  MacroQueryBatch_t batch = { .days = state->days, .count = 0 };
+  for (uint32_t column = 0; column < MACRO_COLUMN_COUNT; column++) {
+    batch.columns[column] = state->values[column];
+  }
+
+  for (uint32_t bucket = first; bucket < first + count; bucket++) {
+    const MacroTotals_t *totals = &table->buckets[bucket];
+    if (totals->count == 0)
+      continue;
+
+    for (uint32_t column = 0; column < MACRO_COLUMN_COUNT; column++) {
+      state->values[column][batch.count] = totals->sum[column] < UINT32_MAX ? (uint32_t)totals->sum[column] : UINT32_MAX;
+    }
+    state->days[batch.count] = table->firstKey + bucket;
+
+    if (++batch.count == MACRO_QUERY_BATCH_ROWS) {
+      _MacroQuery_process(self, state, &batch, false);
+      batch.count = 0;
+    }
+  }
+
+  if (batch.count > 0)
+    _MacroQuery_process(self, state, &batch, false);
+}
+
+typedef enum __MacroQueryZoneMatch_t {
+  MACRO_QUERY_ZONE_NONE = 0,
+  MACRO_QUERY_ZONE_SOME = 1,
+  MACRO_QUERY_ZONE_ALL = 2
+} MacroQueryZoneMatch_t;
+
+// How many rows of a column ranging over [min, max] can match the predicate
+MacroQueryZoneMatch_t _MacroQuery_matchRange(const MacroQueryPredicate_t *predicate, uint32_t min, uint32_t max) {
+  uint32_t value = predicate->value;
+  bool all = false, none = false;
+  switch (predicate->compare) {
+    case MACRO_QUERY_LT: all = max < value; none = min >= value; break;
+    case MACRO_QUERY_LE: all = max <= value; none = min > value; break;
+    case MACRO_QUERY_GT: all = min > value; none = max <= value; break;
+    case MACRO_QUERY_GE: all = min >= value; none = max < value; break;
+    case MACRO_QUERY_EQ: all = min == value && max == value; none = value < min || value > max; break;
+    default: all = value < min || value > max; none = min == value && max == value; break;
+  }
+
+  return all ? MACRO_QUERY_ZONE_ALL : none ? MACRO_QUERY_ZONE_NONE : MACRO_QUERY_ZONE_SOME;
+}
+
+// Runs the where program on the zone's ranges: and takes the lesser match, or the greater one
+MacroQueryZoneMatch_t _MacroQuery_matchZone(const MacroQuery_t *self, const MacroZone_t *zone) {
+  uint8_t stack[MACRO_QUERY_MAX_PREDICATES];
+  uint32_t depth = 0;
+  for (uint32_t op = 0; op < self->programLength; op++) {
+    const MacroQueryOp_t *instruction = &self->program[op];
+    switch (instruction->opcode) {
+      case MACRO_QUERY_OP_PREDICATE: {
+        const MacroQueryPredicate_t *predicate = &self->predicates[instruction->predicate];
+        uint32_t min = 0, max = 6;
+        if (predicate->operand < MACRO_COLUMN_COUNT) {
+          min = zone->min[predicate->operand];
+          max = zone->max[predicate->operand];
+        } else if (predicate->operand == MACRO_QUERY_OPERAND_DATE) {
+          min = zone->minDay;
+          max = zone->maxDay;
+        } else if (zone->minDay == zone->maxDay) {
+          min = max = (uint32_t)(((uint64_t)zone->minDay + 3) % 7);
+        }
+        stack[depth++] = (uint8_t)_MacroQuery_matchRange(predicate, min, max);
+        break;
+      }
+      case MACRO_QUERY_OP_AND:
+        depth--;
+        stack[depth - 1] = stack[depth] < stack[depth - 1] ? stack[depth] : stack[depth - 1];
+        break;
+      case MACRO_QUERY_OP_OR:
+        depth--;
+        stack[depth - 1] = stack[depth] > stack[depth - 1] ? stack[depth] : stack[depth - 1];
+        break;
+      default:
+        stack[depth - 1] = MACRO_QUERY_ZONE_ALL - stack[depth - 1];
+        break;
+    }
+  }
+
+  return depth > 0 ? (MacroQueryZoneMatch_t)stack[0] : MACRO_QUERY_ZONE_ALL;
+}
+
+// Meal batches are windows on the columns themselves, only frozen rows are decoded. Rows are
+// frozen a zone at a time, so a batch is either all frozen or all hot
+void _MacroQuery_scanMeals(const MacroQuery_t *self, MacroQueryState_t *state, const MacroDatabase_t *db,
+  const MacroZoneMap_t *zones, uint32_t first, uint32_t count) {
+  for (uint32_t row = first; row < first + count; row += MACRO_QUERY_BATCH_ROWS) {
+    MacroQueryZoneMatch_t match = _MacroQuery_matchZone(self, &zones->zones[row / MACRO_ZONE_ROWS]);
+    if (match == MACRO_QUERY_ZONE_NONE) {
+      state->counts.skipped++;
+      continue;
+    }
+    state->counts.read++;
+
+    uint32_t batchRows = first + count - row < MACRO_QUERY_BATCH_ROWS ? first + count - row : MACRO_QUERY_BATCH_ROWS;
+    MacroQueryBatch_t batch = { .count = MacroDatabase_rows(db, row, batchRows, &state->rows) };
+    batch.days = state->rows.days;
+    for (uint32_t column = 0; column < MACRO_COLUMN_COUNT; column++) {
+      batch.columns[column] = state->rows.columns[column];
+    }
+    _MacroQuery_process(self, state, &batch, match == MACRO_QUERY_ZONE_ALL);
+  }
+}
+
+void _MacroQueryState_destroy(MacroQueryState_t *self);
+
+MacroQueryState_t *_MacroQueryState_create(const uint32_t *dayKeys, DayNum_t firstDay) {
+  MacroQueryState_t *self = malloc(sizeof(MacroQueryState_t));
+  if (self == NULL)
+    return NULL;
+
+  self->groups = malloc(sizeof(MacroQueryGroupState_t) * DEFAULT_GROUP_CAP);
+  self->groupKeys = malloc(sizeof(uint32_t) * DEFAULT_GROUP_CAP);
+  self->groupCount = 0;
+  self->_groupCap = DEFAULT_GROUP_CAP;
+  self->_slots = calloc(DEFAULT_GROUP_CAP * 2, sizeof(MacroQueryGroupSlot_t));
+  memset(self->_recent, 0, sizeof(self->_recent));
+  self->failed = false;
+  self->dayKeys = dayKeys;
+  self->firstDay = firstDay;
+  self->counts = (MacroZoneCounts_t) {0};
+
+  if (self->groups == NULL || self->groupKeys == NULL || self->_slots == NULL) {
+    _MacroQueryState_destroy(self);
+    return NULL;
+  }
+  return self;
+}
+
+void _MacroQueryState_destroy(MacroQueryState_t *self) {
+  free(self->groups);
+  free(self->groupKeys);
+  free(self->_slots);
+  free(self);
+}
+
+// Month/year key of every day in [first, last]
+uint32_t *_MacroQuery_dayKeys(const MacroQuery_t *self, DayNum_t first, DayNum_t last) {
+  MacroRollupLevel_t level = self->group == MACRO_QUERY_GROUP_MONTH ? MACRO_ROLLUP_MONTH : MACRO_ROLLUP_YEAR;
+  uint32_t *keys = malloc(sizeof(uint32_t) * ((size_t)last - first + 1));
+  if (keys == NULL)
+    return NULL;
+
+  for (DayNum_t day = first;; day++) {
+    keys[day - first] = MacroRollup_key(level, day);
+    if (day == last)
+      break;
+  }
+  return keys;
+}
+
+// Folds the groups of other into self
+void _MacroQueryState_merge(MacroQueryState_t *self, const MacroQueryState_t *other) {
+  self->failed |= other->failed;
+  for (uint32_t index = 0; index < other->groupCount && !self->failed; index++) {
+    uint32_t group = _MacroQueryState_group(self, other->groupKeys[index]);
+    if (group == UINT32_MAX) {
+      self->failed = true;
+      return;
+    }
+
+    const MacroQueryGroupState_t *from = &other->groups[index];
+    MacroQueryGroupState_t *to = &self->groups[group];
+    to->count += from->count;
+    for (uint32_t column = 0; column < MACRO_COLUMN_COUNT; column++) {
+      to->sum[column] += from->sum[column];
+      to->min[column] = from->min[column] < to->min[column] ? from->min[column] : to->min[column];
+      to->max[column] = from->max[column] > to->max[column] ? from->max[column] : to->max[column];
+    }
+  }
+}
+
+// Days the rows can be on, only the zones the where clause may match count when there are zones
+bool _MacroQuery_dayBounds(const MacroQuery_t *self, const MacroDatabase_t *db, const MacroZoneMap_t *zones,
+  DayNum_t *first, DayNum_t *last) {
+  if (zones == NULL)
+    return MacroIndex_bounds(&db->index, first, last);
+
+  *first = DAY_NUM_MAX;
+  *last = DAY_NUM_MIN;
+  for (uint32_t zone = 0; zone < zones->zoneCount; zone++) {
+    if (_MacroQuery_matchZone(self, &zones->zones[zone]) == MACRO_QUERY_ZONE_NONE)
+      continue;
+
+    *first = zones->zones[zone].minDay < *first ? zones->zones[zone].minDay : *first;
+    *last = zones->zones[zone].maxDay > *last ? zones->zones[zone].maxDay : *last;
+  }
+  return *first <= *last;
+}
+
+typedef struct __MacroQueryMorsels_t {
+  const MacroQuery_t *query;
+  const MacroDatabase_t *db;
+  const MacroZoneMap_t *zones;
+  const MacroRollupTable_t *days;
+  // One per worker
+  MacroQueryState_t **states;
+} MacroQueryMorsels_t;
+
+void _MacroQuery_morsel(MacroQueryMorsels_t *self, uint32_t worker, uint32_t first, uint32_t count) {
+  if (self->query->source == MACRO_QUERY_SOURCE_DAYS)
+    _MacroQuery_scanDays(self->query, self->states[worker], self->days, first, count);
+  else
+    _MacroQuery_scanMeals(self->query, self->states[worker], self->db, self->zones, first, count);
+}
+
+int _MacroQuery_compareRows(const void *a, const void *b) {
+  uint32_t left = ((const MacroQueryRow_t *)a)->key, right = ((const MacroQueryRow_t *)b)->key;
+  return (left > right) - (left < right);
+}
+
+// Rows in key order, the groups themselves are in the order they were met (sorted already
+// when the history was added in day order)
+Result_t _MacroQuery_emit(const MacroQuery_t *self, const MacroQueryState_t *state, MacroQueryResult_t *out) {
+  out->rows = malloc(sizeof(MacroQueryRow_t) * (state->groupCount + 1));
+  if (out->rows == NULL)
+    return RESULT_FAIL;
+
+  bool sorted = true;
+  for (uint32_t index = 0; index < state->groupCount; index++) {
+    const MacroQueryGroupState_t *group = &state->groups[index];
+    MacroQueryRow_t *row = &out->rows[out->rowCount++];
+    *row = (MacroQueryRow_t) { .key = state->groupKeys[index], .count = group->count };
+    sorted &= index == 0 || state->groupKeys[index - 1] < state->groupKeys[index];
+    for (uint32_t select = 0; select < self->selectCount; select++) {
+      uint32_t column = self->select[select].column;
+      switch (self->select[select].aggregate) {
+        case MACRO_QUERY_COUNT:
+          row->values[select] = group->count;
+          break;
+        case MACRO_QUERY_SUM:
+          row->values[select] = (double)group->sum[column];
+          break;
+        case MACRO_QUERY_AVG:
+          row->values[select] = group->count > 0 ? (double)group->sum[column] / group->count : 0.0;
+          break;
+        case MACRO_QUERY_MIN:
+          row->values[select] = group->count > 0 ? group->min[column] : 0.0;
+          break;
+        case MACRO_QUERY_MAX:
+          row->values[select] = group->max[column];
+          break;
+      }
+    }
+  }
+
+  if (!sorted)
+    qsort(out->rows, out->rowCount, sizeof(MacroQueryRow_t), _MacroQuery_compareRows);
+  return RESULT_SUCCESS;
+}
+
+Result_t MacroQuery_run(const MacroQuery_t *self, MacroDatabase_t *db, MacroQueryResult_t *out) {
+  return MacroQuery_runParallel(self, db, 1, out);
+}
+
+Result_t MacroQuery_runParallel(const MacroQuery_t *self, MacroDatabase_t *db, uint32_t threadCount, MacroQueryResult_t *out) {
+  *out = (MacroQueryResult_t) {0};
+  threadCount = MacroMorsel_threadCount(threadCount);
+
+  // Built here, before any worker could race to build it
+  const MacroRollupTable_t *days = NULL;
+  const MacroZoneMap_t *zones = NULL;
+  uint32_t rowCount = db->mealCount;
+  if (self->source == MACRO_QUERY_SOURCE_DAYS) {
+    const MacroRollup_t *rollup = MacroDatabase_rollup(db);
+    if (rollup == NULL)
+      return RESULT_FAIL;
+    days = &rollup->levels[MACRO_ROLLUP_DAY];
+    rowCount = days->count;
+  } else if ((zones = MacroDatabase_zones(db)) == NULL) {
+    return RESULT_FAIL;
+  }
+
+  DayNum_t firstDay = 0, lastDay = 0;
+  uint32_t *dayKeys = NULL;
+  bool keyed = self->group == MACRO_QUERY_GROUP_MONTH || self->group == MACRO_QUERY_GROUP_YEAR;
+  if (keyed && _MacroQuery_dayBounds(self, db, zones, &firstDay, &lastDay) &&
+      (dayKeys = _MacroQuery_dayKeys(self, firstDay, lastDay)) == NULL) {
+    log_error("Couldn't allocate the query's day keys" ENDL);
+    return RESULT_FAIL;
+  }
+
+  MacroQueryMorsels_t morsels = {
+    .query = self,
+    .db = db,
+    .zones = zones,
+    .days = days,
+    .states = calloc(threadCount, sizeof(MacroQueryState_t *))
+  };
+  Result_t result = morsels.states != NULL ? RESULT_SUCCESS : RESULT_FAIL;
+  for (uint32_t worker = 0; worker < threadCount && result == RESULT_SUCCESS; worker++) {
+    morsels.states[worker] = _MacroQueryState_create(dayKeys, firstDay);
+    result = morsels.states[worker] != NULL ? RESULT_SUCCESS : RESULT_FAIL;
+  }
+  if (result != RESULT_SUCCESS) {
+    log_error("Couldn't allocate the query state" ENDL);
+  } else {
+    MacroMorsel_run(rowCount, threadCount, (MacroMorselFn_t)_MacroQuery_morsel, &morsels);
+
+    // Partial groups of every worker are merged into the first one
+    MacroQueryState_t *state = morsels.states[0];
+    for (uint32_t worker = 1; worker < threadCount; worker++) {
+      _MacroQueryState_merge(state, morsels.states[worker]);
+    }
+    for (uint32_t worker = 0; worker < threadCount && zones != NULL; worker++) {
+      db->_zones->counts.read += morsels.states[worker]->counts.read;
+      db->_zones->counts.skipped += morsels.states[worker]->counts.skipped;
+    }
+    if (self->group == MACRO_QUERY_GROUP_NONE && state->groupCount == 0 &&
+        _MacroQueryState_group(state, 0) == UINT32_MAX)
+      state->failed = true;
+
+    if (state->failed || _MacroQuery_emit(self, state, out) != RESULT_SUCCESS) {
+      log_error("Couldn't allocate the query's groups" ENDL);
+      MacroQueryResult_cleanup(out);
+      result = RESULT_FAIL;
+    }
+  }
+
+  for (uint32_t worker = 0; morsels.states != NULL && worker < threadCount; worker++) {
+    if (morsels.states[worker] != NULL)
+      _MacroQueryState_destroy(morsels.states[worker]);
+  }
+  free(morsels.states);
+  free(dayKeys);
+  return result;
+}
+
+void MacroQueryResult_cleanup(MacroQueryResult_t *self) {
+  free(self->rows);
+  *self = (MacroQueryResult_t) {0};
+}
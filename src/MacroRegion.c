@@ -0,0 +1,135 @@
+#include <log.h>
+
+#include "MacroRegion.h"
+
+#define MAPPED_RESERVE_ATTEMPTS 8
+
+Result_t MacroRegion_reserve(MacroRegion_t *self, uint64_t reserveBytes) {
+  *self = (MacroRegion_t) {
+    .base = VirtualAlloc(NULL, reserveBytes, MEM_RESERVE, PAGE_READWRITE),
+    .reserved = reserveBytes,
+    .mapped = 0,
+    .committed = 0,
+    .discarded = 0
+  };
+
+  if (self->base == NULL) {
+    log_error("Failed to reserve %llu bytes of address space, error code: %lu" ENDL,
+      (unsigned long long)reserveBytes, GetLastError()
+    );
+    self->reserved = 0;
+    return RESULT_FAIL;
+  }
+
+  return RESULT_SUCCESS;
+}
+
+Result_t MacroRegion_reserveMapped(MacroRegion_t *self, HANDLE mapping,
+  uint64_t offset, uint64_t viewBytes, uint64_t reserveBytes) {
+  DEBUG_ASSERT(viewBytes % MACRO_REGION_GRANULARITY == 0 && viewBytes <= reserveBytes,
+    "View has to be granularity aligned and fit the reservation"
+  );
+
+  if (viewBytes == 0)
+    return MacroRegion_reserve(self, reserveBytes);
+
+  // Find a free range big enough for view + growth, release it and map the view at its start.
+  // Another thread may grab the range in between, so it is retried a few times
+  for (uint32_t attempt = 0; attempt < MAPPED_RESERVE_ATTEMPTS; attempt++) {
+    uint8_t *base = VirtualAlloc(NULL, reserveBytes, MEM_RESERVE, PAGE_NOACCESS);
+    if (base == NULL)
+      break;
+    VirtualFree(base, 0, MEM_RELEASE);
+
+    uint8_t *view = MapViewOfFileEx(mapping, FILE_MAP_COPY,
+      (DWORD)(offset >> 32), (DWORD)offset, (SIZE_T)viewBytes, base
+    );
+    if (view == NULL)
+      continue;
+
+    if (reserveBytes > viewBytes &&
+        VirtualAlloc(base + viewBytes, reserveBytes - viewBytes, MEM_RESERVE, PAGE_READWRITE) == NULL) {
+      UnmapViewOfFile(view);
+      continue;
+    }
+
+    *self = (MacroRegion_t) {
+      .base = base,
+      .reserved = reserveBytes,
+      .mapped = viewBytes,
+      .committed = viewBytes,
+      .discarded = 0
+    };
+    return RESULT_SUCCESS;
+  }
+
+  log_error("Failed to map a %llu byte view into a %llu byte reservation, error code: %lu" ENDL,
+    (unsigned long long)viewBytes, (unsigned long long)reserveBytes, GetLastError()
+  );
+  *self = (MacroRegion_t) {0};
+  return RESULT_FAIL;
+}
+
+Result_t MacroRegion_commit(MacroRegion_t *self, uint64_t bytes) {
+  if (bytes <= self->committed)
+    return RESULT_SUCCESS;
+
+  uint64_t newCommitted = ALIGN_UP(bytes, MACRO_REGION_COMMIT_STEP);
+  newCommitted = newCommitted > self->reserved ? self->reserved : newCommitted;
+  if (bytes > newCommitted) {
+    log_error("Region of %llu bytes can't grow to %llu bytes" ENDL,
+      (unsigned long long)self->reserved, (unsigned long long)bytes
+    );
+    return RESULT_FAIL;
+  }
+
+  if (VirtualAlloc(self->base + self->committed, newCommitted - self->committed,
+      MEM_COMMIT, PAGE_READWRITE) == NULL) {
+    log_error("Failed to commit %llu bytes, error code: %lu" ENDL,
+      (unsigned long long)(newCommitted - self->committed), GetLastError()
+    );
+    return RESULT_FAIL;
+  }
+
+  self->committed = newCommitted;
+  return RESULT_SUCCESS;
+}
+
+void MacroRegion_discard(MacroRegion_t *self, uint64_t bytes) {
+  bytes = bytes < self->committed ? bytes : self->committed;
+  bytes &= ~(MACRO_REGION_PAGE - 1);
+  if (bytes <= self->discarded)
+    return;
+
+  // A view can't be decommitted in parts. Unlocking pages that were never locked drops them
+  // from the working set, clean ones go back to the file and written ones to the page file
+  uint64_t mappedEnd = bytes < self->mapped ? bytes : self->mapped;
+  if (self->discarded < mappedEnd)
+    VirtualUnlock(self->base + self->discarded, (SIZE_T)(mappedEnd - self->discarded));
+
+  uint64_t anonymousStart = self->discarded > self->mapped ? self->discarded : self->mapped;
+  if (anonymousStart < bytes &&
+      !VirtualFree(self->base + anonymousStart, (SIZE_T)(bytes - anonymousStart), MEM_DECOMMIT)) {
+    log_error("Failed to decommit %llu bytes, error code: %lu" ENDL,
+      (unsigned long long)(bytes - anonymousStart), GetLastError()
+    );
+    return;
+  }
+
+  self->discarded = bytes;
+}
+
+void MacroRegion_release(MacroRegion_t *self) {
+  if (self->base == NULL)
+    return;
+
+  if (self->mapped > 0) {
+    UnmapViewOfFile(self->base);
+    if (self->reserved > self->mapped)
+      VirtualFree(self->base + self->mapped, 0, MEM_RELEASE);
+  } else {
+    VirtualFree(self->base, 0, MEM_RELEASE);
+  }
+
+  *self = (MacroRegion_t) {0};
+}
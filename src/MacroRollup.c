@@ -0,0 +1,194 @@
+#include <stdlib.h>
+#include <string.h>
+
+#include <log.h>
+
+#include "MacroRollup.h"
+
+#define DEFAULT_TABLE_CAP (1 << 6)
+
+Result_t MacroRollup_init(MacroRollup_t *self) {
+  Result_t result = RESULT_SUCCESS;
+  for (uint32_t level = 0; level < MACRO_ROLLUP_LEVEL_COUNT; level++) {
+    self->levels[level] = (MacroRollupTable_t) {
+      .buckets = malloc(sizeof(MacroTotals_t) * DEFAULT_TABLE_CAP),
+      .firstKey = 0,
+      .count = 0,
+      ._capacity = DEFAULT_TABLE_CAP
+    };
+    result = self->levels[level].buckets != NULL ? result : RESULT_FAIL;
+  }
+  return result;
+}
+
+void MacroRollup_cleanup(MacroRollup_t *self) {
+  for (uint32_t level = 0; level < MACRO_ROLLUP_LEVEL_COUNT; level++) {
+    free(self->levels[level].buckets);
+    self->levels[level] = (MacroRollupTable_t) {0};
+  }
+}
+
+uint32_t MacroRollup_key(MacroRollupLevel_t level, DayNum_t day) {
+  switch (level) {
+    case MACRO_ROLLUP_DAY:
+      return day;
+    case MACRO_ROLLUP_WEEK:
+      // 1970/1/1 is a Thursday, week 0 starts on the Monday before it
+      return (uint32_t)(((uint64_t)day + 3) / 7);
+    case MACRO_ROLLUP_MONTH: {
+      Date_t date = Date_fromDayNum(day);
+      return date.year * 12 + date.month - 1;
+    }
+    case MACRO_ROLLUP_YEAR:
+      return Date_fromDayNum(day).year;
+    default:
+      DEBUG_ASSERT(false, "Invalid rollup level %d", level);
+      return 0;
+  }
+}
+
+// Grows the table to cover key on either side, new buckets start empty. NULL when it can't grow
+MacroTotals_t *_MacroRollupTable_at(MacroRollupTable_t *self, uint32_t key) {
+  if (self->count == 0) {
+    self->firstKey = key;
+  }
+
+  uint32_t first = key < self->firstKey ? key : self->firstKey;
+  uint32_t last = self->count == 0 ? key : self->firstKey + self->count - 1;
+  last = key > last ? key : last;
+  uint32_t newCount = last - first + 1;
+
+  if (newCount > self->_capacity) {
+    uint32_t capacity;
+    if (!Common_growCapacity(self->_capacity, newCount, &capacity))
+      return NULL;
+    MacroTotals_t *buckets = realloc(self->buckets, sizeof(MacroTotals_t) * capacity);
+    if (buckets == NULL)
+      return NULL;
+    self->buckets = buckets;
+    self->_capacity = capacity;
+  }
+
+  uint32_t shift = self->firstKey - first;
+  if (shift > 0) {
+    memmove(&self->buckets[shift], self->buckets, sizeof(MacroTotals_t) * self->count);
+    memset(self->buckets, 0, sizeof(MacroTotals_t) * shift);
+  }
+  memset(&self->buckets[shift + self->count], 0, sizeof(MacroTotals_t) * (newCount - shift - self->count));
+
+  self->firstKey = first;
+  self->count = newCount;
+  return &self->buckets[key - first];
+}
+
+const MacroTotals_t *_MacroRollupTable_find(const MacroRollupTable_t *self, uint32_t key) {
+  if (key < self->firstKey || key - self->firstKey >= self->count)
+    return NULL;
+
+  return &self->buckets[key - self->firstKey];
+}
+
+void _MacroTotals_merge(MacroTotals_t *self, const MacroTotals_t *other) {
+  for (uint32_t column = 0; column < MACRO_COLUMN_COUNT; column++) {
+    self->sum[column] += other->sum[column];
+  }
+  self->count += other->count;
+}
+
+void MacroRollup_add(MacroRollup_t *self, DayNum_t day, const Macro_t *macro) {
+  if (day > DATE_MAX_DAY_NUM) {
+    log_error("Day %u is past %u/12/31, left out of the rollups" ENDL, day, DATE_MAX_YEAR);
+    return;
+  }
+
+  const uint32_t *values = &macro->cals;
+  Date_t date = Date_fromDayNum(day);
+  uint32_t keys[MACRO_ROLLUP_LEVEL_COUNT] = {
+    [MACRO_ROLLUP_DAY] = day,
+    [MACRO_ROLLUP_WEEK] = MacroRollup_key(MACRO_ROLLUP_WEEK, day),
+    [MACRO_ROLLUP_MONTH] = date.year * 12 + date.month - 1,
+    [MACRO_ROLLUP_YEAR] = date.year
+  };
+
+  for (uint32_t level = 0; level < MACRO_ROLLUP_LEVEL_COUNT; level++) {
+    MacroTotals_t *bucket = _MacroRollupTable_at(&self->levels[level], keys[level]);
+    if (bucket == NULL) {
+      log_error("Failed to grow rollup level %u to key %u" ENDL, level, keys[level]);
+      continue;
+    }
+
+    for (uint32_t column = 0; column < MACRO_COLUMN_COUNT; column++) {
+      bucket->sum[column] += values[column];
+    }
+    bucket->count++;
+  }
+}
+
+void MacroRollup_remove(MacroRollup_t *self, DayNum_t day, const Macro_t *macro) {
+  const uint32_t *values = &macro->cals;
+
+  for (uint32_t level = 0; level < MACRO_ROLLUP_LEVEL_COUNT; level++) {
+    MacroTotals_t *bucket = (MacroTotals_t *)_MacroRollupTable_find(&self->levels[level],
+      MacroRollup_key(level, day)
+    );
+    DEBUG_ASSERT(bucket != NULL && bucket->count > 0, "Removing a meal that was never added");
+    if (bucket == NULL)
+      continue;
+
+    for (uint32_t column = 0; column < MACRO_COLUMN_COUNT; column++) {
+      bucket->sum[column] -= values[column];
+    }
+    bucket->count--;
+  }
+}
+
+void MacroRollup_bucket(const MacroRollup_t *self, MacroRollupLevel_t level, DayNum_t day, MacroTotals_t *out) {
+  const MacroTotals_t *bucket = _MacroRollupTable_find(&self->levels[level], MacroRollup_key(level, day));
+  *out = bucket != NULL ? *bucket : (MacroTotals_t) {0};
+}
+
+void MacroRollup_range(const MacroRollup_t *self, DayNum_t from, DayNum_t to, MacroTotals_t *out) {
+  *out = (MacroTotals_t) {0};
+
+  // Only walk the days that can hold meals
+  const MacroRollupTable_t *days = &self->levels[MACRO_ROLLUP_DAY];
+  if (days->count == 0)
+    return;
+  from = from > days->firstKey ? from : days->firstKey;
+  to = to < days->firstKey + days->count - 1 ? to : days->firstKey + days->count - 1;
+
+  // Years, then months inside partial years, then weeks and days inside partial months.
+  // ISO weeks do cross months, a week is only taken when it ends by monthEnd so the walk
+  // still lands on the first of the next month
+  uint64_t day = from;
+  while (day <= to) {
+    Date_t date = Date_fromDayNum((DayNum_t)day);
+    DayNum_t monthEnd = Date_toDayNum((Date_t) {
+      .year = date.year + (date.month == 12),
+      .month = date.month % 12 + 1,
+      .day = 1
+    }) - 1;
+    DayNum_t yearEnd = Date_toDayNum((Date_t) { .year = date.year, .month = 12, .day = 31 });
+
+    MacroRollupLevel_t level = MACRO_ROLLUP_DAY;
+    uint64_t last = day;
+    if (date.day == 1 && date.month == 1 && yearEnd <= to) {
+      level = MACRO_ROLLUP_YEAR;
+      last = yearEnd;
+    } else if (date.day == 1 && monthEnd <= to) {
+      level = MACRO_ROLLUP_MONTH;
+      last = monthEnd;
+    } else if ((day + 3) % 7 == 0 && day + 6 <= to && day + 6 <= monthEnd) {
+      level = MACRO_ROLLUP_WEEK;
+      last = day + 6;
+    }
+
+    const MacroTotals_t *bucket = _MacroRollupTable_find(&self->levels[level],
+      MacroRollup_key(level, (DayNum_t)day)
+    );
+    if (bucket != NULL)
+      _MacroTotals_merge(out, bucket);
+
+    day = last + 1;
+  }
+}
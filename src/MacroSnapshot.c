@@ -0,0 +1,353 @@
+#include <stddef.h>
+#include <log.h>
+
+#define WIN32_LEAN_AND_MEAN
+#include <Windows.h>
+
+#include "MacroSnapshot.h"
+
+// ReadFile/WriteFile take a DWORD size, bigger columns go through in chunks
+#define SNAPSHOT_IO_CHUNK (1u << 26)
+#define SNAPSHOT_STAGING_ENTRIES (1u << 14)
+
+Result_t _MacroSnapshot_writeAll(HANDLE file, const void *data, uint64_t size) {
+  const uint8_t *bytes = data;
+  while (size > 0) {
+    DWORD chunk = size > SNAPSHOT_IO_CHUNK ? SNAPSHOT_IO_CHUNK : (DWORD)size;
+    DWORD written = 0;
+    if (!WriteFile(file, bytes, chunk, &written, NULL) || written != chunk)
+      return RESULT_FAIL;
+
+    bytes += chunk;
+    size -= chunk;
+  }
+
+  return RESULT_SUCCESS;
+}
+
+Result_t _MacroSnapshot_readAll(HANDLE file, void *data, uint64_t size) {
+  uint8_t *bytes = data;
+  while (size > 0) {
+    DWORD chunk = size > SNAPSHOT_IO_CHUNK ? SNAPSHOT_IO_CHUNK : (DWORD)size;
+    DWORD readBytes = 0;
+    if (!ReadFile(file, bytes, chunk, &readBytes, NULL) || readBytes != chunk)
+      return RESULT_FAIL;
+
+    bytes += chunk;
+    size -= chunk;
+  }
+
+  return RESULT_SUCCESS;
+}
+
+Result_t _MacroSnapshot_seek(HANDLE file, uint64_t offset) {
+  LARGE_INTEGER position = { .QuadPart = (LONGLONG)offset };
+  return SetFilePointerEx(file, position, NULL, FILE_BEGIN) ? RESULT_SUCCESS : RESULT_FAIL;
+}
+
+uint64_t _MacroSnapshot_sectionBytes(uint32_t mealCount) {
+  return ALIGN_UP(sizeof(uint32_t) * (uint64_t)mealCount, MACRO_SNAPSHOT_ALIGNMENT);
+}
+
+uint64_t _MacroSnapshot_sectionOffset(uint32_t mealCount, uint32_t section) {
+  return MACRO_SNAPSHOT_ALIGNMENT + _MacroSnapshot_sectionBytes(mealCount) * section;
+}
+
+// Streams one column, or the days for MACRO_DATABASE_REGION_DAYS. Frozen rows are decoded a
+// chunk at a time, the hot ones are written straight from the column
+Result_t _MacroSnapshot_writeColumn(HANDLE file, MacroDatabase_t *db, uint32_t section) {
+  MacroRows_t *rows = malloc(sizeof(MacroRows_t));
+  if (rows == NULL)
+    return RESULT_FAIL;
+
+  Result_t result = RESULT_SUCCESS;
+  for (uint32_t row = 0; row < db->mealCount && result == RESULT_SUCCESS; row += rows->count) {
+    MacroDatabase_rows(db, row, db->mealCount - row, rows);
+    const uint32_t *values = section < MACRO_COLUMN_COUNT ? rows->columns[section] : rows->days;
+    result = _MacroSnapshot_writeAll(file, values, sizeof(uint32_t) * rows->count);
+  }
+
+  free(rows);
+  return result;
+}
+
+// Streams the merged index (snapshot run + blocks) as one sorted array of days or rows
+Result_t _MacroSnapshot_writeIndex(HANDLE file, MacroDatabase_t *db, bool rows) {
+  uint32_t *staging = malloc(sizeof(uint32_t) * SNAPSHOT_STAGING_ENTRIES);
+  uint32_t staged = 0;
+  Result_t result = RESULT_SUCCESS;
+
+  MacroIndexRange_t range = {0};
+  MacroSpan_t span = {0};
+  MacroIndex_range(&db->index, DAY_NUM_MIN, DAY_NUM_MAX, &range);
+  while (result == RESULT_SUCCESS && MacroIndexRange_next(&range, &span)) {
+    const uint32_t *values = rows ? span.rows : span.days;
+    for (uint32_t entry = 0; entry < span.count; entry++) {
+      staging[staged++] = values[entry];
+      if (staged == SNAPSHOT_STAGING_ENTRIES) {
+        result = _MacroSnapshot_writeAll(file, staging, sizeof(uint32_t) * staged);
+        staged = 0;
+      }
+    }
+  }
+  if (result == RESULT_SUCCESS)
+    result = _MacroSnapshot_writeAll(file, staging, sizeof(uint32_t) * staged);
+
+  free(staging);
+  return result;
+}
+
+// Finishes or rolls back a replacement interrupted by a crash (see MacroSnapshot_write)
+void _MacroSnapshot_settle(const char *path) {
+  char tmpPath[MAX_PATH] = {0};
+  char pattern[MAX_PATH] = {0};
+  char oldPath[MAX_PATH] = {0};
+  snprintf(tmpPath, sizeof(tmpPath), "%s.tmp", path);
+  snprintf(pattern, sizeof(pattern), "%s.*.old", path);
+
+  // FindFirstFileA only returns file names, keep the directory part of the path
+  const char *name = path;
+  for (const char *c = path; *c != '\0'; c++) {
+    if (*c == '\\' || *c == '/')
+      name = c + 1;
+  }
+  int directoryLength = (int)(name - path);
+
+  WIN32_FIND_DATAA found = {0};
+  HANDLE search = FindFirstFileA(pattern, &found);
+  bool movedAside = search != INVALID_HANDLE_VALUE;
+
+  // The old snapshot is only moved aside once the new one is complete on disk
+  if (GetFileAttributesA(path) == INVALID_FILE_ATTRIBUTES && movedAside) {
+    if (!MoveFileExA(tmpPath, path, MOVEFILE_WRITE_THROUGH)) {
+      log_error("Snapshot %s is missing, keeping the old ones around" ENDL, path);
+      FindClose(search);
+      return;
+    }
+  } else {
+    DeleteFileA(tmpPath);
+  }
+
+  if (!movedAside)
+    return;
+
+  do {
+    snprintf(oldPath, sizeof(oldPath), "%.*s%s", directoryLength, path, found.cFileName);
+    DeleteFileA(oldPath);
+  } while (FindNextFileA(search, &found));
+  FindClose(search);
+}
+
+// Opens and validates the snapshot, *file is INVALID_HANDLE_VALUE when there is none
+Result_t _MacroSnapshot_open(const char *path, uint32_t maxMeals, HANDLE *file, MacroSnapshotHeader_t *header) {
+  _MacroSnapshot_settle(path);
+
+  // Shared for delete so a mapped snapshot can still be moved aside by the next compaction
+  *file = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_DELETE, NULL, OPEN_EXISTING,
+    FILE_ATTRIBUTE_NORMAL, NULL
+  );
+  if (*file == INVALID_HANDLE_VALUE) {
+    if (GetLastError() == ERROR_FILE_NOT_FOUND)
+      return RESULT_SUCCESS;
+
+    log_error("Couldn't open the snapshot file %s, error code: %lu" ENDL, path, GetLastError());
+    return RESULT_FAIL;
+  }
+
+  LARGE_INTEGER fileSize = {0};
+  if (_MacroSnapshot_readAll(*file, header, sizeof(*header)) != RESULT_SUCCESS ||
+      header->magic != MACRO_SNAPSHOT_MAGIC || header->version != MACRO_SNAPSHOT_VERSION ||
+      header->alignment != MACRO_SNAPSHOT_ALIGNMENT || header->mealCount > MACRO_DATABASE_MAX_MEALS_LIMIT ||
+      header->checksum != MacroLog_checksum(header, offsetof(MacroSnapshotHeader_t, checksum)) ||
+      !GetFileSizeEx(*file, &fileSize) ||
+      (uint64_t)fileSize.QuadPart != _MacroSnapshot_sectionOffset(header->mealCount, MACRO_DATABASE_REGION_COUNT)) {
+    log_error("Snapshot %s is corrupted or of an unsupported version" ENDL, path);
+    CloseHandle(*file);
+    *file = INVALID_HANDLE_VALUE;
+    return RESULT_FAIL;
+  }
+
+  if (header->mealCount > maxMeals) {
+    log_error("Snapshot %s holds %u meals, the database has room for %u" ENDL, path, header->mealCount, maxMeals);
+    CloseHandle(*file);
+    *file = INVALID_HANDLE_VALUE;
+    return RESULT_FAIL;
+  }
+
+  return RESULT_SUCCESS;
+}
+
+// Points db at regions that already hold the snapshot's sections
+Result_t _MacroSnapshot_attach(MacroDatabase_t *db, const MacroSnapshotHeader_t *header, uint64_t *nextSequence) {
+  _MacroDatabase_bindRegions(db);
+  if (_MacroDatabase_resize(db, header->mealCount) != RESULT_SUCCESS)
+    return RESULT_FAIL;
+
+  MacroIndex_setBase(&db->index,
+    (const DayNum_t *)db->_regions[MACRO_DATABASE_REGION_INDEX_DAYS].base,
+    (const uint32_t *)db->_regions[MACRO_DATABASE_REGION_INDEX_ROWS].base,
+    header->mealCount
+  );
+
+  *nextSequence = header->nextSequence;
+  return RESULT_SUCCESS;
+}
+
+Result_t MacroSnapshot_write(MacroDatabase_t *db, const char *path, uint64_t nextSequence) {
+  char tmpPath[MAX_PATH] = {0};
+  snprintf(tmpPath, sizeof(tmpPath), "%s.tmp", path);
+
+  HANDLE file = CreateFileA(tmpPath, GENERIC_WRITE, 0, NULL, CREATE_ALWAYS,
+    FILE_ATTRIBUTE_NORMAL, NULL
+  );
+  if (file == INVALID_HANDLE_VALUE) {
+    log_error("Couldn't create the snapshot file %s, error code: %lu" ENDL,
+      tmpPath, GetLastError()
+    );
+    return RESULT_FAIL;
+  }
+
+  MacroSnapshotHeader_t header = {
+    .magic = MACRO_SNAPSHOT_MAGIC,
+    .version = MACRO_SNAPSHOT_VERSION,
+    .mealCount = db->mealCount,
+    .alignment = MACRO_SNAPSHOT_ALIGNMENT,
+    .nextSequence = nextSequence
+  };
+  header.checksum = MacroLog_checksum(&header, offsetof(MacroSnapshotHeader_t, checksum));
+
+  // Sections are seeked to, the padding in between reads back as zeros
+  Result_t result = _MacroSnapshot_writeAll(file, &header, sizeof(header));
+  for (uint32_t section = 0; section < MACRO_DATABASE_REGION_COUNT && result == RESULT_SUCCESS; section++) {
+    result = _MacroSnapshot_seek(file, _MacroSnapshot_sectionOffset(db->mealCount, section));
+    if (result != RESULT_SUCCESS)
+      break;
+
+    if (section <= MACRO_DATABASE_REGION_DAYS) {
+      result = _MacroSnapshot_writeColumn(file, db, section);
+    } else {
+      result = _MacroSnapshot_writeIndex(file, db, section == MACRO_DATABASE_REGION_INDEX_ROWS);
+    }
+  }
+
+  if (result == RESULT_SUCCESS) {
+    result = _MacroSnapshot_seek(file, _MacroSnapshot_sectionOffset(db->mealCount, MACRO_DATABASE_REGION_COUNT));
+    if (result == RESULT_SUCCESS && (!SetEndOfFile(file) || !FlushFileBuffers(file)))
+      result = RESULT_FAIL;
+  }
+  CloseHandle(file);
+
+  if (result != RESULT_SUCCESS) {
+    log_error("Failed to write the snapshot %s, error code: %lu" ENDL, tmpPath, GetLastError());
+    DeleteFileA(tmpPath);
+    return RESULT_FAIL;
+  }
+
+  // A mapped snapshot can be renamed but not replaced, so it is moved aside first. Deleting it
+  // only marks it, the file goes away with its last view (or on the next open's settle)
+  char oldPath[MAX_PATH] = {0};
+  snprintf(oldPath, sizeof(oldPath), "%s.%llu.old", path, (unsigned long long)nextSequence);
+  DeleteFileA(oldPath);
+  bool movedAside = MoveFileExA(path, oldPath, MOVEFILE_WRITE_THROUGH);
+
+  if (!MoveFileExA(tmpPath, path, MOVEFILE_REPLACE_EXISTING | MOVEFILE_WRITE_THROUGH)) {
+    log_error("Failed to replace the snapshot %s, error code: %lu" ENDL, path, GetLastError());
+    if (movedAside)
+      MoveFileExA(oldPath, path, MOVEFILE_WRITE_THROUGH);
+    return RESULT_FAIL;
+  }
+
+  if (movedAside)
+    DeleteFileA(oldPath);
+  return RESULT_SUCCESS;
+}
+
+Result_t MacroSnapshot_read(MacroDatabase_t *db, const char *path, uint64_t *nextSequence) {
+  DEBUG_ASSERT(db->mealCount == 0, "Snapshots are only read into empty databases");
+  *nextSequence = 0;
+
+  HANDLE file = INVALID_HANDLE_VALUE;
+  MacroSnapshotHeader_t header = {0};
+  if (_MacroSnapshot_open(path, db->maxMeals, &file, &header) != RESULT_SUCCESS)
+    return RESULT_FAIL;
+  if (file == INVALID_HANDLE_VALUE)
+    return RESULT_SUCCESS;
+
+  uint64_t columnSize = sizeof(uint32_t) * (uint64_t)header.mealCount;
+  Result_t result = _MacroDatabase_resize(db, header.mealCount);
+  for (uint32_t region = MACRO_DATABASE_REGION_INDEX_DAYS; region < MACRO_DATABASE_REGION_COUNT &&
+       result == RESULT_SUCCESS && columnSize > 0; region++) {
+    MacroRegion_release(&db->_regions[region]);
+    result = MacroRegion_reserve(&db->_regions[region], _MacroSnapshot_sectionBytes(header.mealCount));
+    if (result == RESULT_SUCCESS)
+      result = MacroRegion_commit(&db->_regions[region], columnSize);
+  }
+
+  for (uint32_t region = 0; region < MACRO_DATABASE_REGION_COUNT && result == RESULT_SUCCESS; region++) {
+    result = _MacroSnapshot_seek(file, _MacroSnapshot_sectionOffset(header.mealCount, region));
+    if (result == RESULT_SUCCESS)
+      result = _MacroSnapshot_readAll(file, db->_regions[region].base, columnSize);
+  }
+  CloseHandle(file);
+
+  if (result == RESULT_SUCCESS)
+    result = _MacroSnapshot_attach(db, &header, nextSequence);
+
+  if (result != RESULT_SUCCESS) {
+    log_error("Failed to read the snapshot %s, error code: %lu" ENDL, path, GetLastError());
+    db->mealCount = 0;
+    return RESULT_FAIL;
+  }
+
+  return RESULT_SUCCESS;
+}
+
+Result_t MacroSnapshot_map(MacroDatabase_t *db, const char *path, uint64_t *nextSequence) {
+  DEBUG_ASSERT(db->mealCount == 0, "Snapshots are only mapped into empty databases");
+  *nextSequence = 0;
+
+  HANDLE file = INVALID_HANDLE_VALUE;
+  MacroSnapshotHeader_t header = {0};
+  if (_MacroSnapshot_open(path, db->maxMeals, &file, &header) != RESULT_SUCCESS)
+    return RESULT_FAIL;
+  if (file == INVALID_HANDLE_VALUE)
+    return RESULT_SUCCESS;
+
+  // The views keep the mapping (and the file) alive, neither handle is needed afterwards
+  HANDLE mapping = CreateFileMappingA(file, NULL, PAGE_WRITECOPY, 0, 0, NULL);
+  CloseHandle(file);
+  if (mapping == NULL) {
+    log_error("Couldn't map the snapshot %s, error code: %lu" ENDL, path, GetLastError());
+    return RESULT_FAIL;
+  }
+
+  // Column and day views are followed by reserved space so appends grow them in place,
+  // the index run never grows and gets exactly its section
+  uint64_t sectionBytes = _MacroSnapshot_sectionBytes(header.mealCount);
+  Result_t result = RESULT_SUCCESS;
+  for (uint32_t region = 0; region < MACRO_DATABASE_REGION_COUNT && result == RESULT_SUCCESS; region++) {
+    uint64_t reserveBytes = region <= MACRO_DATABASE_REGION_DAYS ?
+      _MacroSnapshot_sectionBytes(db->maxMeals) : sectionBytes;
+
+    MacroRegion_release(&db->_regions[region]);
+    if (reserveBytes == 0)
+      continue;
+
+    result = MacroRegion_reserveMapped(&db->_regions[region], mapping,
+      _MacroSnapshot_sectionOffset(header.mealCount, region), sectionBytes, reserveBytes
+    );
+  }
+  CloseHandle(mapping);
+
+  if (result == RESULT_SUCCESS)
+    result = _MacroSnapshot_attach(db, &header, nextSequence);
+
+  if (result != RESULT_SUCCESS) {
+    log_error("Failed to map the snapshot %s" ENDL, path);
+    _MacroDatabase_bindRegions(db);
+    db->mealCount = 0;
+    return RESULT_FAIL;
+  }
+
+  return RESULT_SUCCESS;
+}
@@ -0,0 +1,253 @@
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <log.h>
+
+#include "MacroTrend.h"
+
+#define DEFAULT_TREND_CAP (1 << 9)
+
+Result_t MacroTrend_init(MacroTrend_t *self) {
+  *self = (MacroTrend_t) {
+    .days = malloc(sizeof(MacroTrendDay_t) * DEFAULT_TREND_CAP),
+    .firstDay = 0,
+    .dayCount = 0,
+    ._dayCap = DEFAULT_TREND_CAP,
+    ._emaDirty = 0
+  };
+  return self->days != NULL ? RESULT_SUCCESS : RESULT_FAIL;
+}
+
+void MacroTrend_cleanup(MacroTrend_t *self) {
+  free(self->days);
+  *self = (MacroTrend_t) {0};
+}
+
+uint32_t MacroTrend_windowDays(MacroTrendLine_t line) {
+  switch (line) {
+    case MACRO_TREND_SMA_7:
+      return 7;
+    case MACRO_TREND_SMA_30:
+      return 30;
+    default:
+      DEBUG_ASSERT(false, "Trend line %d has no window", line);
+      return 1;
+  }
+}
+
+bool _MacroTrend_reserve(MacroTrend_t *self, uint32_t count) {
+  if (count <= self->_dayCap)
+    return true;
+
+  uint32_t capacity;
+  if (!Common_growCapacity(self->_dayCap, count, &capacity))
+    return false;
+  MacroTrendDay_t *days = realloc(self->days, sizeof(MacroTrendDay_t) * capacity);
+  if (days == NULL)
+    return false;
+
+  self->days = days;
+  self->_dayCap = capacity;
+  return true;
+}
+
+// Windows of days [first, dayCount) from their totals and the windows before them
+void _MacroTrend_slide(MacroTrend_t *self, uint32_t first) {
+  for (uint32_t index = first; index < self->dayCount; index++) {
+    MacroTrendDay_t *day = &self->days[index];
+
+    for (uint32_t line = 0; line < MACRO_TREND_WINDOW_COUNT; line++) {
+      uint32_t window = MacroTrend_windowDays(line);
+      const MacroTrendDay_t *previous = index > 0 ? &self->days[index - 1] : NULL;
+      const MacroTrendDay_t *dropped = index >= window ? &self->days[index - window] : NULL;
+
+      for (uint32_t column = 0; column < MACRO_COLUMN_COUNT; column++) {
+        day->window[line][column] = day->totals.sum[column] +
+          (previous != NULL ? previous->window[line][column] : 0) -
+          (dropped != NULL ? dropped->totals.sum[column] : 0);
+      }
+      day->windowDays[line] = (day->totals.count > 0) +
+        (previous != NULL ? previous->windowDays[line] : 0) -
+        (dropped != NULL && dropped->totals.count > 0);
+    }
+  }
+}
+
+// Index of day, the table grows to it on either side with empty days. UINT32_MAX when it can't grow
+uint32_t _MacroTrend_at(MacroTrend_t *self, DayNum_t day) {
+  if (self->dayCount == 0) {
+    self->firstDay = day;
+    self->days[0] = (MacroTrendDay_t) {0};
+    self->dayCount = 1;
+    return 0;
+  }
+
+  if (day < self->firstDay) {
+    // Nothing before the new days, their windows are empty and the old ones don't change
+    uint32_t shift = self->firstDay - day;
+    if (!_MacroTrend_reserve(self, self->dayCount + shift))
+      return UINT32_MAX;
+    memmove(&self->days[shift], self->days, sizeof(MacroTrendDay_t) * self->dayCount);
+    memset(self->days, 0, sizeof(MacroTrendDay_t) * shift);
+
+    self->firstDay = day;
+    self->dayCount += shift;
+    self->_emaDirty = 0;
+    return 0;
+  }
+
+  uint32_t index = day - self->firstDay;
+  if (index >= self->dayCount) {
+    uint32_t first = self->dayCount;
+    if (!_MacroTrend_reserve(self, index + 1))
+      return UINT32_MAX;
+    memset(&self->days[first], 0, sizeof(MacroTrendDay_t) * (index + 1 - first));
+
+    self->dayCount = index + 1;
+    _MacroTrend_slide(self, first);
+    self->_emaDirty = first < self->_emaDirty ? first : self->_emaDirty;
+  }
+  return index;
+}
+
+void MacroTrend_add(MacroTrend_t *self, DayNum_t day, const Macro_t *macro) {
+  const uint32_t *values = &macro->cals;
+  uint32_t index = day <= DATE_MAX_DAY_NUM ? _MacroTrend_at(self, day) : UINT32_MAX;
+  if (index == UINT32_MAX) {
+    log_error("Day %u left out of the trend lines" ENDL, day);
+    return;
+  }
+
+  MacroTrendDay_t *entry = &self->days[index];
+  uint32_t logged = entry->totals.count == 0;
+
+  for (uint32_t column = 0; column < MACRO_COLUMN_COUNT; column++) {
+    entry->totals.sum[column] += values[column];
+  }
+  entry->totals.count++;
+
+  // Only the windows that contain the day move
+  for (uint32_t line = 0; line < MACRO_TREND_WINDOW_COUNT; line++) {
+    uint32_t window = MacroTrend_windowDays(line);
+    uint32_t end = self->dayCount - index > window ? index + window : self->dayCount;
+
+    for (uint32_t covering = index; covering < end; covering++) {
+      for (uint32_t column = 0; column < MACRO_COLUMN_COUNT; column++) {
+        self->days[covering].window[line][column] += values[column];
+      }
+      self->days[covering].windowDays[line] += logged;
+    }
+  }
+
+  self->_emaDirty = index < self->_emaDirty ? index : self->_emaDirty;
+}
+
+void MacroTrend_build(MacroTrend_t *self, const MacroDatabase_t *db) {
+  DEBUG_ASSERT(self->dayCount == 0, "Trend table is already built");
+
+  // Days past DATE_MAX_DAY_NUM are left out, like MacroTrend_add does
+  DayNum_t first, last;
+  if (!MacroDatabase_dayBounds(db, &first, &last) || !_MacroTrend_reserve(self, last - first + 1))
+    return;
+
+  self->firstDay = first;
+  self->dayCount = last - first + 1;
+  memset(self->days, 0, sizeof(MacroTrendDay_t) * self->dayCount);
+
+  MacroRows_t rows;
+  for (uint32_t row = 0; row < db->mealCount; row += rows.count) {
+    MacroDatabase_rows(db, row, db->mealCount - row, &rows);
+    for (uint32_t index = 0; index < rows.count; index++) {
+      if (rows.days[index] > DATE_MAX_DAY_NUM)
+        continue;
+
+      MacroTotals_t *totals = &self->days[rows.days[index] - first].totals;
+      for (uint32_t column = 0; column < MACRO_COLUMN_COUNT; column++) {
+        totals->sum[column] += rows.columns[column][index];
+      }
+      totals->count++;
+    }
+  }
+
+  _MacroTrend_slide(self, 0);
+  self->_emaDirty = 0;
+}
+
+// EMA of the stale days, carried over the empty ones. The first day always has meals
+void _MacroTrend_catchUpEma(MacroTrend_t *self) {
+  const double alpha = 2.0 / (MACRO_TREND_EMA_DAYS + 1);
+
+  for (uint32_t index = self->_emaDirty; index < self->dayCount; index++) {
+    MacroTrendDay_t *day = &self->days[index];
+
+    for (uint32_t column = 0; column < MACRO_COLUMN_COUNT; column++) {
+      double value = (double)day->totals.sum[column];
+      if (index == 0) {
+        day->ema[column] = value;
+      } else {
+        double previous = self->days[index - 1].ema[column];
+        day->ema[column] = day->totals.count > 0 ? previous + alpha * (value - previous) : previous;
+      }
+    }
+  }
+
+  self->_emaDirty = self->dayCount;
+}
+
+void MacroTrend_series(MacroTrend_t *self, MacroTrendLine_t line, MacroColumn_t column, DayNum_t from, DayNum_t to, float *out) {
+  if (from > to)
+    return;
+
+  if (self->dayCount == 0 || to < self->firstDay) {
+    memset(out, 0, sizeof(float) * ((uint64_t)to - from + 1));
+    return;
+  }
+
+  if (line == MACRO_TREND_EMA && self->_emaDirty < self->dayCount)
+    _MacroTrend_catchUpEma(self);
+
+  // 64 bit so the loops can end past DAY_NUM_MAX
+  uint64_t lastDay = (uint64_t)self->firstDay + self->dayCount - 1;
+  uint64_t end = (uint64_t)to + 1;
+  uint64_t day = from;
+
+  // Before the history
+  for (; day < self->firstDay; day++) {
+    *out++ = 0.f;
+  }
+
+  uint64_t tableEnd = end < lastDay + 1 ? end : lastDay + 1;
+  if (line == MACRO_TREND_EMA) {
+    for (; day < tableEnd; day++) {
+      *out++ = (float)self->days[day - self->firstDay].ema[column];
+    }
+  } else {
+    for (; day < tableEnd; day++) {
+      const MacroTrendDay_t *entry = &self->days[day - self->firstDay];
+      *out++ = entry->windowDays[line] > 0 ? (float)((double)entry->window[line][column] / entry->windowDays[line]) : 0.f;
+    }
+  }
+
+  // After the last logged day the EMA holds and the windows keep sliding over empty days
+  const MacroTrendDay_t *last = &self->days[self->dayCount - 1];
+  if (line == MACRO_TREND_EMA) {
+    for (; day < end; day++) {
+      *out++ = (float)last->ema[column];
+    }
+    return;
+  }
+
+  uint32_t window = MacroTrend_windowDays(line);
+  uint64_t sum = last->window[line][column];
+  uint32_t logged = last->windowDays[line];
+  for (; day < end; day++) {
+    uint64_t dropped = day - window;
+    if (dropped >= self->firstDay && dropped <= lastDay) {
+      const MacroTotals_t *totals = &self->days[dropped - self->firstDay].totals;
+      sum -= totals->sum[column];
+      logged -= totals->count > 0;
+    }
+    *out++ = logged > 0 ? (float)((double)sum / logged) : 0.f;
+  }
+}
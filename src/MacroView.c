@@ -0,0 +1,301 @@
+#include <stdlib.h>
+#include <string.h>
+
+#include <log.h>
+
+#include "MacroView.h"
+#include "MacroKernel.h"
+
+#define DEFAULT_PAGE_CAP (1 << 6)
+#define DEFAULT_REPLACED_CAP (1 << 3)
+#define DEFAULT_RETIRED_CAP (1 << 3)
+
+// First epoch a reader can pin at, below it are the slot states
+#define MACRO_VIEW_FIRST_EPOCH 2
+
+Meal_t MacroView_getMeal(const MacroView_t *self, uint32_t index) {
+  DEBUG_ASSERT(index < self->mealCount, "Meal index out of range");
+
+  return (Meal_t) {
+    .macro = {
+      .cals = self->columns[MACRO_COLUMN_CALS][index],
+      .protein = self->columns[MACRO_COLUMN_PROTEIN][index],
+      .fat = self->columns[MACRO_COLUMN_FAT][index],
+      .carbs = self->columns[MACRO_COLUMN_CARBS][index]
+    },
+    .date = Date_fromDayNum(self->days[index])
+  };
+}
+
+void MacroView_statsDays(const MacroView_t *self, DayNum_t from, DayNum_t to, MacroStats_t *out) {
+  MacroStats_reset(out);
+  MacroKernel_reduce(self->columns, self->days, self->mealCount, from, to, out);
+  MacroStats_finalize(out);
+}
+
+void MacroView_totalsDays(const MacroView_t *self, DayNum_t from, DayNum_t to, MacroTotals_t *out) {
+  *out = (MacroTotals_t) {0};
+  if (self->pageCount == 0 || from > to)
+    return;
+
+  // Clamped to the pages the view has
+  uint64_t first = (uint64_t)self->firstPage << MACRO_VIEW_PAGE_SHIFT;
+  uint64_t last = ((uint64_t)self->firstPage + self->pageCount) * MACRO_VIEW_PAGE_DAYS - 1;
+  first = from > first ? from : first;
+  last = to < last ? to : last;
+
+  for (uint64_t day = first; day <= last;) {
+    const MacroViewPage_t *page = self->pages[(day >> MACRO_VIEW_PAGE_SHIFT) - self->firstPage];
+    uint64_t pageEnd = ((day >> MACRO_VIEW_PAGE_SHIFT) + 1) * MACRO_VIEW_PAGE_DAYS;
+    uint64_t end = pageEnd <= last ? pageEnd : last + 1;
+    if (page == NULL) {
+      day = end;
+      continue;
+    }
+
+    for (; day < end; day++) {
+      const MacroTotals_t *totals = &page->days[day & (MACRO_VIEW_PAGE_DAYS - 1)];
+      for (uint32_t column = 0; column < MACRO_COLUMN_COUNT; column++) {
+        out->sum[column] += totals->sum[column];
+      }
+      out->count += totals->count;
+    }
+  }
+}
+
+// Slot of page key in the writer's table, grown on either side with NULL pages. NULL when it can't grow
+MacroViewPage_t **_MacroViews_page(MacroViews_t *self, uint32_t key) {
+  if (self->pageCount == 0) {
+    self->firstPage = key;
+  }
+
+  uint32_t first = key < self->firstPage ? key : self->firstPage;
+  uint32_t last = self->pageCount == 0 ? key : self->firstPage + self->pageCount - 1;
+  last = key > last ? key : last;
+  uint32_t newCount = last - first + 1;
+
+  if (newCount > self->_pageCap) {
+    uint32_t capacity;
+    if (!Common_growCapacity(self->_pageCap, newCount, &capacity))
+      return NULL;
+    MacroViewPage_t **pages = realloc(self->pages, sizeof(MacroViewPage_t *) * capacity);
+    if (pages == NULL)
+      return NULL;
+    self->pages = pages;
+    self->_pageCap = capacity;
+  }
+
+  uint32_t shift = self->firstPage - first;
+  if (shift > 0) {
+    memmove(&self->pages[shift], self->pages, sizeof(MacroViewPage_t *) * self->pageCount);
+    memset(self->pages, 0, sizeof(MacroViewPage_t *) * shift);
+  }
+  memset(&self->pages[shift + self->pageCount], 0, sizeof(MacroViewPage_t *) * (newCount - shift - self->pageCount));
+
+  self->firstPage = first;
+  self->pageCount = newCount;
+  return &self->pages[key - first];
+}
+
+void MacroViews_add(MacroViews_t *self, DayNum_t day, const Macro_t *macro) {
+  MacroViewPage_t **slot = day <= DATE_MAX_DAY_NUM ? _MacroViews_page(self, day >> MACRO_VIEW_PAGE_SHIFT) : NULL;
+  if (slot == NULL) {
+    log_error("Day %u left out of the views" ENDL, day);
+    return;
+  }
+
+  MacroViewPage_t *page = *slot;
+
+  if (page == NULL) {
+    page = calloc(1, sizeof(MacroViewPage_t));
+    page->version = self->version;
+    *slot = page;
+  } else if (page->version != self->version) {
+    // Copy on write, readers keep the old page until the view holding it retires
+    if (self->_replacedCount == self->_replacedCap) {
+      self->_replacedCap <<= 1;
+      self->_replaced = realloc(self->_replaced, sizeof(MacroViewPage_t *) * self->_replacedCap);
+    }
+    self->_replaced[self->_replacedCount++] = page;
+
+    MacroViewPage_t *copy = malloc(sizeof(MacroViewPage_t));
+    memcpy(copy, page, sizeof(MacroViewPage_t));
+    copy->version = self->version;
+    *slot = page = copy;
+  }
+
+  MacroTotals_t *totals = &page->days[day & (MACRO_VIEW_PAGE_DAYS - 1)];
+  const uint32_t *values = &macro->cals;
+  for (uint32_t column = 0; column < MACRO_COLUMN_COUNT; column++) {
+    totals->sum[column] += values[column];
+  }
+  totals->count++;
+}
+
+// Frees the retired views no pinned reader can still hold, in retire order
+void _MacroViews_reclaim(MacroViews_t *self) {
+  LONG64 oldest = self->epoch;
+  for (uint32_t slot = 0; slot < MACRO_VIEW_MAX_READERS; slot++) {
+    LONG64 epoch = self->slots[slot].epoch;
+    if (epoch >= MACRO_VIEW_FIRST_EPOCH && epoch < oldest)
+      oldest = epoch;
+  }
+
+  // A reader pinned at epoch may hold anything retired at epoch or later
+  uint32_t freed = 0;
+  while (freed < self->_retiredCount && self->_retired[freed].epoch < oldest) {
+    MacroViewRetired_t *retired = &self->_retired[freed++];
+    for (uint32_t page = 0; page < retired->pageCount; page++) {
+      free(retired->pages[page]);
+    }
+    free(retired->pages);
+    free(retired->view);
+  }
+
+  memmove(self->_retired, &self->_retired[freed], sizeof(MacroViewRetired_t) * (self->_retiredCount - freed));
+  self->_retiredCount -= freed;
+}
+
+void MacroViews_publish(MacroViews_t *self, const MacroDatabase_t *db) {
+  MacroView_t *old = self->current;
+
+  MacroView_t *view = malloc(sizeof(MacroView_t) + sizeof(MacroViewPage_t *) * self->pageCount);
+  *view = (MacroView_t) {
+    .days = db->days,
+    .mealCount = db->mealCount,
+    .version = self->version++,
+    .firstPage = self->firstPage,
+    .pageCount = self->pageCount
+  };
+  for (uint32_t column = 0; column < MACRO_COLUMN_COUNT; column++) {
+    view->columns[column] = db->columns[column];
+  }
+  memcpy(view->pages, self->pages, sizeof(MacroViewPage_t *) * self->pageCount);
+
+  // Full barrier, the rows and pages written before are visible to whoever reads the pointer
+  InterlockedExchangePointer((void *volatile *)&self->current, view);
+
+  if (old != NULL) {
+    if (self->_retiredCount == self->_retiredCap) {
+      self->_retiredCap <<= 1;
+      self->_retired = realloc(self->_retired, sizeof(MacroViewRetired_t) * self->_retiredCap);
+    }
+
+    // The replaced pages only go with the old view, the list starts over for the new one
+    MacroViewPage_t **pages = NULL;
+    if (self->_replacedCount > 0) {
+      pages = malloc(sizeof(MacroViewPage_t *) * self->_replacedCount);
+      memcpy(pages, self->_replaced, sizeof(MacroViewPage_t *) * self->_replacedCount);
+    }
+    self->_retired[self->_retiredCount++] = (MacroViewRetired_t) {
+      .view = old,
+      .pages = pages,
+      .pageCount = self->_replacedCount,
+      .epoch = self->epoch
+    };
+    self->_replacedCount = 0;
+  }
+
+  InterlockedIncrement64(&self->epoch);
+  _MacroViews_reclaim(self);
+}
+
+MacroViews_t *MacroViews_create(MacroDatabase_t *db) {
+  MacroViews_t *self = malloc(sizeof(MacroViews_t));
+  if (self == NULL) {
+    log_error("Couldn't allocate the database views" ENDL);
+    return NULL;
+  }
+
+  *self = (MacroViews_t) {
+    .epoch = MACRO_VIEW_FIRST_EPOCH,
+    .current = NULL,
+    .version = 1,
+    .pages = malloc(sizeof(MacroViewPage_t *) * DEFAULT_PAGE_CAP),
+    .firstPage = 0,
+    .pageCount = 0,
+    ._pageCap = DEFAULT_PAGE_CAP,
+    ._replaced = malloc(sizeof(MacroViewPage_t *) * DEFAULT_REPLACED_CAP),
+    ._replacedCount = 0,
+    ._replacedCap = DEFAULT_REPLACED_CAP,
+    ._retired = malloc(sizeof(MacroViewRetired_t) * DEFAULT_RETIRED_CAP),
+    ._retiredCount = 0,
+    ._retiredCap = DEFAULT_RETIRED_CAP
+  };
+  for (uint32_t slot = 0; slot < MACRO_VIEW_MAX_READERS; slot++) {
+    self->slots[slot].epoch = MACRO_VIEW_SLOT_FREE;
+  }
+
+  for (uint32_t row = 0; row < db->mealCount; row++) {
+    Macro_t macro = {
+      .cals = db->cals[row],
+      .protein = db->protein[row],
+      .fat = db->fat[row],
+      .carbs = db->carbs[row]
+    };
+    MacroViews_add(self, db->days[row], &macro);
+  }
+  MacroViews_publish(self, db);
+
+  return self;
+}
+
+void MacroViews_destroy(MacroViews_t *self) {
+  for (uint32_t slot = 0; slot < MACRO_VIEW_MAX_READERS; slot++) {
+    DEBUG_ASSERT(self->slots[slot].epoch == MACRO_VIEW_SLOT_FREE, "Reader %u is still open", slot);
+  }
+
+  // Nobody pins anymore, every retired view goes
+  self->epoch = INT64_MAX;
+  _MacroViews_reclaim(self);
+
+  // The current view holds the working pages plus the ones replaced since it was published
+  for (uint32_t page = 0; page < self->pageCount; page++) {
+    free(self->pages[page]);
+  }
+  for (uint32_t page = 0; page < self->_replacedCount; page++) {
+    free(self->_replaced[page]);
+  }
+  free(self->pages);
+  free(self->_replaced);
+  free(self->_retired);
+  free(self->current);
+  free(self);
+}
+
+Result_t MacroReader_open(MacroReader_t *self, MacroDatabase_t *db) {
+  *self = (MacroReader_t) { .views = db->_views, .slot = 0 };
+  if (self->views == NULL) {
+    log_error("Views aren't enabled on the database" ENDL);
+    return RESULT_FAIL;
+  }
+
+  for (uint32_t slot = 0; slot < MACRO_VIEW_MAX_READERS; slot++) {
+    if (InterlockedCompareExchange64(&self->views->slots[slot].epoch, MACRO_VIEW_SLOT_IDLE, MACRO_VIEW_SLOT_FREE) == MACRO_VIEW_SLOT_FREE) {
+      self->slot = slot;
+      return RESULT_SUCCESS;
+    }
+  }
+
+  log_error("All %u database readers are taken" ENDL, MACRO_VIEW_MAX_READERS);
+  self->views = NULL;
+  return RESULT_FAIL;
+}
+
+void MacroReader_close(MacroReader_t *self) {
+  InterlockedExchange64(&self->views->slots[self->slot].epoch, MACRO_VIEW_SLOT_FREE);
+  *self = (MacroReader_t) {0};
+}
+
+const MacroView_t *MacroReader_pin(MacroReader_t *self) {
+  MacroViews_t *views = self->views;
+
+  // Announced before the view is read, so the writer can't free what it's about to read. A
+  // reader that gets the new epoch also gets the view published before the epoch moved on
+  InterlockedExchange64(&views->slots[self->slot].epoch, views->epoch);
+  return views->current;
+}
+
+void MacroReader_unpin(MacroReader_t *self) {
+  InterlockedExchange64(&self->views->slots[self->slot].epoch, MACRO_VIEW_SLOT_IDLE);
+}
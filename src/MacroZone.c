@@ -0,0 +1,85 @@
+#include <stdlib.h>
+#include <string.h>
+
+#include "MacroZone.h"
+
+#define DEFAULT_ZONE_CAP (1 << 6)
+
+Result_t MacroZoneMap_init(MacroZoneMap_t *self) {
+  *self = (MacroZoneMap_t) {
+    .zones = malloc(sizeof(MacroZone_t) * DEFAULT_ZONE_CAP),
+    .zoneCount = 0,
+    ._zoneCap = DEFAULT_ZONE_CAP,
+    .rowCount = 0
+  };
+  return self->zones != NULL ? RESULT_SUCCESS : RESULT_FAIL;
+}
+
+void MacroZoneMap_cleanup(MacroZoneMap_t *self) {
+  free(self->zones);
+  *self = (MacroZoneMap_t) {0};
+}
+
+Result_t MacroZoneMap_update(MacroZoneMap_t *self, const uint32_t *const columns[MACRO_COLUMN_COUNT],
+  const DayNum_t *days, uint32_t rowCount) {
+  if (rowCount <= self->rowCount)
+    return RESULT_SUCCESS;
+
+  uint32_t zoneCount = (rowCount + MACRO_ZONE_ROWS - 1) / MACRO_ZONE_ROWS;
+  if (zoneCount > self->_zoneCap) {
+    uint32_t zoneCap;
+    if (!Common_growCapacity(self->_zoneCap, zoneCount, &zoneCap))
+      return RESULT_FAIL;
+    MacroZone_t *zones = realloc(self->zones, sizeof(MacroZone_t) * (size_t)zoneCap);
+    if (zones == NULL)
+      return RESULT_FAIL;
+    self->zones = zones;
+    self->_zoneCap = zoneCap;
+  }
+
+  for (uint32_t row = self->rowCount; row < rowCount;) {
+    uint32_t zoneIndex = row / MACRO_ZONE_ROWS;
+    uint32_t end = (zoneIndex + 1) * MACRO_ZONE_ROWS;
+    end = end < rowCount ? end : rowCount;
+
+    // A partial zone from the last update is widened, a new one starts empty
+    MacroZone_t *zone = &self->zones[zoneIndex];
+    if (zoneIndex == self->zoneCount) {
+      for (uint32_t column = 0; column < MACRO_COLUMN_COUNT; column++) {
+        zone->min[column] = UINT32_MAX;
+        zone->max[column] = 0;
+      }
+      zone->minDay = DAY_NUM_MAX;
+      zone->maxDay = DAY_NUM_MIN;
+      self->zoneCount++;
+    }
+
+    for (uint32_t column = 0; column < MACRO_COLUMN_COUNT; column++) {
+      const uint32_t *values = columns[column];
+      uint32_t min = zone->min[column], max = zone->max[column];
+      for (uint32_t index = row; index < end; index++) {
+        min = values[index] < min ? values[index] : min;
+        max = values[index] > max ? values[index] : max;
+      }
+      zone->min[column] = min;
+      zone->max[column] = max;
+    }
+
+    DayNum_t minDay = zone->minDay, maxDay = zone->maxDay;
+    for (uint32_t index = row; index < end; index++) {
+      minDay = days[index] < minDay ? days[index] : minDay;
+      maxDay = days[index] > maxDay ? days[index] : maxDay;
+    }
+    zone->minDay = minDay;
+    zone->maxDay = maxDay;
+
+    row = end;
+  }
+
+  self->rowCount = rowCount;
+  return RESULT_SUCCESS;
+}
+
+bool MacroZone_overlapsDays(const MacroZone_t *self, DayNum_t from, DayNum_t to) {
+  return self->minDay <= to && self->maxDay >= from;
+}
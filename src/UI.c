@@ -1,4 +1,5 @@
 #include "UI.h"
+#include "MacroDatabase.h"
 
 void UiSize_copy(UiSize_t *dst, UiSize_t *src) {
   memcpy(dst->dimentions, src->dimentions, sizeof(dst->dimentions));
@@ -154,9 +155,20 @@ void UI_destroy(UI_t *self) {
       UStr_destroy(&((UiText_t *)self->_unique)->str);
     case UI_EL_TYPE_BUTTON:
     case UI_EL_TYPE_CONTAINER:
+    case UI_EL_TYPE_HEATMAP:
+    case UI_EL_TYPE_LIST:
       free(self->_unique);
       self->_unique = NULL;
       break;
+    case UI_EL_TYPE_CHART: {
+      UiChart_t *unique = self->_unique;
+      for (uint32_t index = 0; index < unique->seriesCount; index++) {
+        free(unique->series[index].points);
+      }
+      free(self->_unique);
+      self->_unique = NULL;
+      break;
+    }
     default:
       break;
   }
@@ -301,6 +313,8 @@ bool UI_buttonProcessEvent(UI_t *self, void *ctx, Event_t *ev) {
 void __UI_initInput(UI_t *self, UiInputInfo_t *specInfo) {
   UiInput_t *unique = (self->_unique = malloc(sizeof(UiInput_t)));
   UStr_init(&unique->str, specInfo->str);
+  unique->onChange = specInfo->onChange;
+  unique->onSubmit = specInfo->onSubmit;
   self->flags &= ~UI_FLAG_FOCUS;
 }
 
@@ -323,7 +337,7 @@ UI_t *UI_addChildInputById(UI_t *root, UiInfo_t *info, UiInputInfo_t *specInfo)
   return UI_addChildInput(parent, info, specInfo);
 }
 
-bool UI_inputProcessEvent(UI_t *self, Event_t *ev) {
+bool UI_inputProcessEvent(UI_t *self, void *ctx, Event_t *ev) {
   if (ev->category != EVENT_CAT_INPUT) {
     return false;
   }
@@ -351,6 +365,8 @@ bool UI_inputProcessEvent(UI_t *self, Event_t *ev) {
         return false;
 
       UStr_pushUC(&unique->str, ev->character);
+      if (unique->onChange != NULL)
+        unique->onChange(ctx, self);
       return true;
     }
     case EVENT_TYPE_KEY: {
@@ -359,10 +375,385 @@ bool UI_inputProcessEvent(UI_t *self, Event_t *ev) {
 
       if (ev->glfwAction != GLFW_REPEAT && ev->glfwAction != GLFW_PRESS)
         return false;
+      if (ev->glfwKey == GLFW_KEY_ENTER && ev->glfwAction == GLFW_PRESS) {
+        if (unique->onSubmit != NULL)
+          unique->onSubmit(ctx, self);
+        return true;
+      }
       if (ev->glfwKey != GLFW_KEY_BACKSPACE)
         return false;
 
       UStr_trimEnd(&unique->str, 1);
+      if (unique->onChange != NULL)
+        unique->onChange(ctx, self);
+      return true;
+    }
+    default:
+      break;
+  }
+
+  return false;
+}
+
+void __UI_initChart(UI_t *self, UiChartInfo_t *specInfo) {
+  UiChart_t *unique = (self->_unique = malloc(sizeof(UiChart_t)));
+  *unique = (UiChart_t) {
+    .seriesCount = 0,
+    .lineWidth = specInfo->lineWidth,
+    .barWidth = specInfo->barWidth,
+    ._dragging = false
+  };
+
+  glm_vec2_copy(specInfo->offset, unique->offset);
+  glm_vec2_copy(specInfo->extent, unique->extent);
+}
+
+UI_t *UI_addChildChart(UI_t *self, UiInfo_t *info, UiChartInfo_t *specInfo) {
+  info->type = UI_EL_TYPE_CHART;
+  info->parent = self;
+
+  UI_t *child = UI_addChild(self, info);
+  __UI_initChart(child, specInfo);
+
+  return child;
+}
+
+UI_t *UI_addChildChartById(UI_t *root, UiInfo_t *info, UiChartInfo_t *specInfo) {
+  UI_t *parent = UI_findById(root, info->parentId);
+  if (parent == NULL)
+    parent = root;
+
+  return UI_addChildChart(parent, info, specInfo);
+}
+
+// Sets the bottoms of the stacked series from seriesIndex on, every one of them gets uploaded again
+void _UI_chartRestack(UiChart_t *chart, uint32_t seriesIndex) {
+  const UiChartSeries_t *below = NULL;
+  for (uint32_t index = 0; index < chart->seriesCount; index++) {
+    UiChartSeries_t *series = &chart->series[index];
+    if (!series->stacked)
+      continue;
+
+    if (index >= seriesIndex) {
+      for (uint32_t point = 0; point < series->count; point++) {
+        series->points[point][1] = below != NULL && point < below->count ?
+          below->points[point][0] + below->points[point][1] : 0.f;
+      }
+      series->_dirty = true;
+    }
+    below = series;
+  }
+}
+
+int32_t UI_chartAddSeries(UI_t *self, UiChartSeriesInfo_t *seriesInfo) {
+  UiChart_t *unique = self->_unique;
+  if (unique->seriesCount == UI_CHART_MAX_SERIES)
+    return -1;
+
+  uint32_t seriesIndex = unique->seriesCount++;
+  UiChartSeries_t *series = &unique->series[seriesIndex];
+  *series = (UiChartSeries_t) {
+    .kind = seriesInfo->kind,
+    .stacked = seriesInfo->stacked,
+    .points = NULL,
+    .count = 0,
+    ._buffer = 0,
+    ._dirty = true
+  };
+  glm_vec4_copy(seriesInfo->color, series->color);
+
+  if (UI_chartSetValues(self, seriesIndex, seriesInfo->values, seriesInfo->count) != RESULT_SUCCESS) {
+    unique->seriesCount--;
+    return -1;
+  }
+  return (int32_t)seriesIndex;
+}
+
+Result_t UI_chartSetValues(UI_t *self, uint32_t seriesIndex, const float *values, uint32_t count) {
+  UiChart_t *unique = self->_unique;
+  DEBUG_ASSERT(seriesIndex < unique->seriesCount, "Chart series index out of range");
+
+  UiChartSeries_t *series = &unique->series[seriesIndex];
+  vec2 *points = realloc(series->points, sizeof(vec2) * (count > 0 ? count : 1));
+  if (points == NULL) {
+    log_error("Failed to allocate %u chart points" ENDL, count);
+    return RESULT_FAIL;
+  }
+  series->points = points;
+  series->count = count;
+  for (uint32_t point = 0; point < count; point++) {
+    series->points[point][0] = values[point];
+    series->points[point][1] = 0.f;
+  }
+  series->_dirty = true;
+
+  // The stacked series above it sit on new tops
+  if (series->stacked)
+    _UI_chartRestack(unique, seriesIndex);
+  return RESULT_SUCCESS;
+}
+
+bool UI_chartProcessEvent(UI_t *self, void *ctx, Event_t *ev) {
+  if (ev->category != EVENT_CAT_INPUT) {
+    return false;
+  }
+
+  UiChart_t *unique = self->_unique;
+
+  switch(ev->type) {
+    case EVENT_TYPE_MOUSE_PRESS: {
+      if (!UI_isHovered(self, ev->position))
+        return false;
+
+      unique->_dragging = true;
+      glm_vec2_copy(ev->position, unique->_dragStart);
+      glm_vec2_copy(unique->offset, unique->_offsetStart);
+      return true;
+    }
+    case EVENT_TYPE_MOUSE_MOVE: {
+      glm_vec2_copy(ev->position, unique->_cursor);
+      if (!unique->_dragging)
+        return false;
+
+      // The point grabbed stays under the cursor
+      float moved = (ev->position[0] - unique->_dragStart[0]) / self->size.width;
+      unique->offset[0] = unique->_offsetStart[0] - moved * unique->extent[0];
+      return false; // NEVER ABSORB
+    }
+    case EVENT_TYPE_CLICK: {
+      if (!unique->_dragging)
+        return false;
+
+      unique->_dragging = false;
+      return true;
+    }
+    case EVENT_TYPE_SCROLL: {
+      if (!UI_isHovered(self, unique->_cursor))
+        return false;
+
+      // Zooms around the point under the cursor
+      float anchor = (unique->_cursor[0] - self->_globalPos[0]) / self->size.width + 0.5f;
+      float pivot = unique->offset[0] + anchor * unique->extent[0];
+      float extent = unique->extent[0] * powf(UI_CHART_ZOOM_STEP, ev->scroll);
+
+      unique->extent[0] = extent > UI_CHART_MIN_EXTENT ? extent : UI_CHART_MIN_EXTENT;
+      unique->offset[0] = pivot - anchor * unique->extent[0];
+      return true;
+    }
+    default:
+      break;
+  }
+
+  return false;
+}
+
+void __UI_initHeatmap(UI_t *self, UiHeatmapInfo_t *specInfo) {
+  UiHeatmap_t *unique = (self->_unique = malloc(sizeof(UiHeatmap_t)));
+  *unique = (UiHeatmap_t) {
+    .year = specInfo->year,
+    .mode = specInfo->mode,
+    .firstWeekday = 0,
+    .dayCount = 0,
+    .cellGap = specInfo->cellGap,
+    .onChange = specInfo->onChange,
+    ._buffer = 0,
+    ._dirty = true
+  };
+}
+
+UI_t *UI_addChildHeatmap(UI_t *self, UiInfo_t *info, UiHeatmapInfo_t *specInfo) {
+  info->type = UI_EL_TYPE_HEATMAP;
+  info->parent = self;
+
+  UI_t *child = UI_addChild(self, info);
+  __UI_initHeatmap(child, specInfo);
+
+  return child;
+}
+
+UI_t *UI_addChildHeatmapById(UI_t *root, UiInfo_t *info, UiHeatmapInfo_t *specInfo) {
+  UI_t *parent = UI_findById(root, info->parentId);
+  if (parent == NULL)
+    parent = root;
+
+  return UI_addChildHeatmap(parent, info, specInfo);
+}
+
+void UI_heatmapSetDays(UI_t *self, uint32_t firstWeekday, const vec4 *colors, uint32_t dayCount) {
+  UiHeatmap_t *unique = self->_unique;
+  DEBUG_ASSERT(dayCount <= UI_HEATMAP_MAX_DAYS, "A heatmap holds a year of days at most");
+
+  unique->firstWeekday = firstWeekday;
+  unique->dayCount = dayCount;
+  memcpy(unique->colors, colors, sizeof(vec4) * dayCount);
+  unique->_dirty = true;
+}
+
+bool UI_heatmapProcessEvent(UI_t *self, void *ctx, Event_t *ev) {
+  if (ev->category != EVENT_CAT_INPUT) {
+    return false;
+  }
+
+  UiHeatmap_t *unique = self->_unique;
+
+  switch(ev->type) {
+    case EVENT_TYPE_MOUSE_MOVE: {
+      glm_vec2_copy(ev->position, unique->_cursor);
+      return false; // NEVER ABSORB
+    }
+    case EVENT_TYPE_SCROLL: {
+      if (!UI_isHovered(self, unique->_cursor) || ev->scroll == 0.f)
+        return false;
+
+      int32_t year = unique->year + (ev->scroll > 0.f ? 1 : -1);
+      if (year < DATE_MIN_YEAR || year > DATE_MAX_YEAR)
+        return true;
+
+      unique->year = year;
+      break;
+    }
+    case EVENT_TYPE_CLICK: {
+      if (!UI_isHovered(self, ev->position))
+        return false;
+
+      unique->mode = unique->mode == UI_HEATMAP_CALS ? UI_HEATMAP_GOALS : UI_HEATMAP_CALS;
+      break;
+    }
+    default:
+      return false;
+  }
+
+  if (unique->onChange != NULL)
+    unique->onChange(ctx, self);
+  return true;
+}
+
+void __UI_initList(UI_t *self, UiListInfo_t *specInfo) {
+  UiList_t *unique = (self->_unique = malloc(sizeof(UiList_t)));
+  *unique = (UiList_t) {
+    .rowCount = 0,
+    .rowHeight = specInfo->rowHeight,
+    .scroll = 0.f,
+    .getRow = specInfo->getRow,
+    // Rows in view plus the one scrolling in
+    .slotCount = (uint32_t)ceilf(1.f / specInfo->rowHeight) + 1
+  };
+
+  if (unique->slotCount > UI_LIST_MAX_SLOTS)
+    unique->slotCount = UI_LIST_MAX_SLOTS;
+
+  UiTextInfo_t textInfo = {
+    .str = ""
+  };
+
+  for (uint32_t slot = 0; slot < unique->slotCount; slot++) {
+    unique->slots[slot] = (UiListSlot_t) {
+      .row = UI_LIST_NO_ROW,
+      ._layoutValid = false
+    };
+
+    UiInfo_t rowInfo = {
+      .flags = UI_FLAG_HIDE,
+      .size = (UiSize_t) {
+        .flag = UI_SIZE_FLAG_REAL,
+        .width = self->size.width,
+        .height = self->size.height * unique->rowHeight
+      },
+      .position = {0.f, 0.f},
+      .id = NO_ID
+    };
+    glm_vec4_copy(specInfo->rowColor, rowInfo.color);
+    UI_addChildText(self, &rowInfo, &textInfo);
+  }
+}
+
+UI_t *UI_addChildList(UI_t *self, UiInfo_t *info, UiListInfo_t *specInfo) {
+  info->type = UI_EL_TYPE_LIST;
+  info->parent = self;
+
+  UI_t *child = UI_addChild(self, info);
+  __UI_initList(child, specInfo);
+
+  return child;
+}
+
+UI_t *UI_addChildListById(UI_t *root, UiInfo_t *info, UiListInfo_t *specInfo) {
+  UI_t *parent = UI_findById(root, info->parentId);
+  if (parent == NULL)
+    parent = root;
+
+  return UI_addChildList(parent, info, specInfo);
+}
+
+// Gives every row in view its slot, fetching only rows the slot doesn't hold yet
+void _UI_listBind(UI_t *self, void *ctx) {
+  UiList_t *unique = self->_unique;
+  uint32_t first = (uint32_t)unique->scroll;
+
+  for (uint32_t row = first; row < first + unique->slotCount; row++) {
+    uint32_t slot = row % unique->slotCount;
+    UI_t *node = &self->children[slot];
+    UiListSlot_t *listSlot = &unique->slots[slot];
+
+    if (row >= unique->rowCount) {
+      listSlot->row = UI_LIST_NO_ROW;
+      node->flags |= UI_FLAG_HIDE;
+      continue;
+    }
+
+    if (listSlot->row != row) {
+      UiText_t *text = node->_unique;
+      UStr_reset(&text->str);
+      unique->getRow(ctx, self, row, &text->str);
+
+      listSlot->row = row;
+      listSlot->_layoutValid = false;
+    }
+
+    node->flags &= ~UI_FLAG_HIDE;
+    vec2 position = {
+      0.f,
+      self->size.height * (0.5f - (row - unique->scroll + 0.5f) * unique->rowHeight)
+    };
+    UI_setPosition(node, position);
+  }
+}
+
+void UI_listRefresh(UI_t *self, void *ctx, uint32_t rowCount) {
+  UiList_t *unique = self->_unique;
+  unique->rowCount = rowCount;
+
+  float maxScroll = rowCount > 1.f / unique->rowHeight ? rowCount - 1.f / unique->rowHeight : 0.f;
+  unique->scroll = unique->scroll < maxScroll ? unique->scroll : maxScroll;
+
+  for (uint32_t slot = 0; slot < unique->slotCount; slot++) {
+    unique->slots[slot].row = UI_LIST_NO_ROW;
+  }
+  _UI_listBind(self, ctx);
+}
+
+bool UI_listProcessEvent(UI_t *self, void *ctx, Event_t *ev) {
+  if (ev->category != EVENT_CAT_INPUT) {
+    return false;
+  }
+
+  UiList_t *unique = self->_unique;
+
+  switch(ev->type) {
+    case EVENT_TYPE_MOUSE_MOVE: {
+      glm_vec2_copy(ev->position, unique->_cursor);
+      return false; // NEVER ABSORB
+    }
+    case EVENT_TYPE_SCROLL: {
+      if (!UI_isHovered(self, unique->_cursor))
+        return false;
+
+      float visibleRows = 1.f / unique->rowHeight;
+      float maxScroll = unique->rowCount > visibleRows ? unique->rowCount - visibleRows : 0.f;
+      float scroll = unique->scroll - ev->scroll * UI_LIST_SCROLL_ROWS;
+
+      unique->scroll = scroll < 0.f ? 0.f : (scroll > maxScroll ? maxScroll : scroll);
+      _UI_listBind(self, ctx);
       return true;
     }
     default:
@@ -370,4 +761,4 @@ bool UI_inputProcessEvent(UI_t *self, Event_t *ev) {
   }
 
   return false;
-}
\ No newline at end of file
+}
@@ -24,6 +24,11 @@
 #include <log.h>
 
 #include "MacroDatabase.h"
+#include "MacroTrend.h"
+#include "MacroRollup.h"
+#include "MacroGoal.h"
+#include "FoodCatalog.h"
+#include "FoodSearch.h"
 #include "Common.h"
 #include "UStr.h"
 #include "UI.h"
@@ -64,10 +69,28 @@ typedef struct __App_t {
   EventQueue_t _evQueue;
   UI_t _uiRoot;
 
+  MacroDatabase_t *db;
+  // Set the first time the heatmap shows goal compliance
+  MacroGoals_t *goals;
+
+  FoodCatalog_t foods;
+  FoodSearch_t _foodSearch;
+  // Suggestions for the food input, refined a budget at a time until the query is done
+  FoodSearchQuery_t foodQuery;
+  bool _foodQueryDone;
+  // Meal history, chart and heatmap, refreshed when a food is logged
+  UI_t *_mealList;
+  UI_t *_historyChart;
+  UI_t *_heatmap;
+  UI_t *_foodSuggestions;
+
   HANDLE _renderThread;
   AppInfo_t info;
 } App_t;
 
+#define MACRO_DB_PATH "macro"
+#define FOOD_CATALOG_PATH "foods.csv"
+
 #define FPS_LIMIT 144
 #define FRAME_TIME (1.0 / FPS_LIMIT)
 
@@ -199,6 +222,14 @@ void _App_wndMouseBtnCBCK(GLFWwindow* window, int button, int action, int mods)
     memcpy(app->_camStart, app->camera, sizeof(vec2));
     memcpy(app->_camNew, app->camera, sizeof(vec2));
     app->_camMoving = true;
+
+    Event_t payload = {
+      .category = EVENT_CAT_INPUT,
+      .type = EVENT_TYPE_MOUSE_PRESS,
+      .position = {0}
+    };
+    _App_getMouseScreenNormalizedCentered(app, payload.position);
+    EventQueue_push(&app->_evQueue, &payload);
   } else {
     app->_camMoving = false;
   }
@@ -219,6 +250,17 @@ void _App_wndMouseBtnCBCK(GLFWwindow* window, int button, int action, int mods)
   // _App_UI_onClick(app, &app->_uiRoot, cPos);
 }
 
+void _App_wndScrollCBCK(GLFWwindow* window, double xoffset, double yoffset) {
+  App_t *app = glfwGetWindowUserPointer(window);
+
+  Event_t payload = {
+    .category = EVENT_CAT_INPUT,
+    .type = EVENT_TYPE_SCROLL,
+    .scroll = (float)yoffset
+  };
+  EventQueue_push(&app->_evQueue, &payload);
+}
+
 void _App_wndInputCBCK(GLFWwindow* window,
     int key, int scancode, int action, int mods) {
   App_t *app = glfwGetWindowUserPointer(window);
@@ -250,8 +292,6 @@ void _App_wndInputCBCK(GLFWwindow* window,
 }
 
 #define SHADER_DIR "glsl\\"
-#define VERT_FILE_NAME "vert_default_2d.glsl"
-#define FRAG_FILE_NAME "frag_default_2d.glsl"
 
 #ifdef APP_DEBUG
 void APIENTRY _App_OpenGL_debugMsgCallback(GLenum source, GLenum type, GLuint id,
@@ -384,16 +424,113 @@ Result_t _OpenGL_validateAndLogError(GLuint shader, const char *shaderFileName,
 #define OPENGL_VALIDATE_AND_LOG_ERROR(sha, fname, p_cbuf, p_bufSize)
 #endif
 
-void _App_OpenGlCleanup(App_t *app) {
-  glDeleteProgram(app->draw._texShader);
-  glDeleteProgram(app->draw._flatShader);
+// Maps DRAW_STREAM_FRAMES regions of frameSize bytes for as long as the buffer lives
+void _Draw_createStream(App_t *app, GLsizeiptr frameSize) {
+  _DrawStream_t *stream = &app->draw._stream;
+  const GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+
+  glCreateBuffers(1, &stream->buffer);
+  glNamedBufferStorage(stream->buffer, frameSize * DRAW_STREAM_FRAMES, NULL, flags);
+  stream->mapped = glMapNamedBufferRange(stream->buffer, 0,
+    frameSize * DRAW_STREAM_FRAMES, flags
+  );
+  glGetIntegerv(GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT, &stream->uniformAlignment);
+
+  stream->frameSize = frameSize;
+  stream->frame = 0;
+  stream->offset = 0;
+}
+
+// Draws already submitted keep the buffer alive until the GPU is done with them
+void _Draw_destroyStream(App_t *app) {
+  _DrawStream_t *stream = &app->draw._stream;
+  for (uint32_t frame = 0; frame < DRAW_STREAM_FRAMES; frame++) {
+    glDeleteSync(stream->fences[frame]);
+    stream->fences[frame] = NULL;
+  }
+
+  if (stream->buffer != 0) {
+    glUnmapNamedBuffer(stream->buffer);
+    glDeleteBuffers(1, &stream->buffer);
+  }
+  stream->buffer = 0;
+  stream->mapped = NULL;
+}
 
+// Waits until the GPU is done with this frame's region, it was last used DRAW_STREAM_FRAMES ago
+void _Draw_beginStreamFrame(App_t *app) {
+  _DrawStream_t *stream = &app->draw._stream;
+  GLsync fence = stream->fences[stream->frame];
+  if (fence != NULL) {
+    while (glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, UINT64_MAX) == GL_TIMEOUT_EXPIRED) {
+    }
+    glDeleteSync(fence);
+    stream->fences[stream->frame] = NULL;
+  }
+  stream->offset = 0;
+}
+
+void _Draw_endStreamFrame(App_t *app) {
+  _DrawStream_t *stream = &app->draw._stream;
+  stream->fences[stream->frame] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+  stream->frame = (stream->frame + 1) % DRAW_STREAM_FRAMES;
+}
+
+// Room for count allocations of size bytes in total in this frame's region. A frame that runs
+// out moves to a new buffer with twice the room, which drops every range bound from the old
+// one, so a draw reserves all its allocations before it makes and binds the first of them
+void _Draw_streamReserve(App_t *app, GLsizeiptr size, uint32_t count) {
+  _DrawStream_t *stream = &app->draw._stream;
+  // Worst case padding, uniform blocks have the strictest alignment
+  GLintptr alignment = stream->uniformAlignment > (GLint)sizeof(vec4) ? stream->uniformAlignment : sizeof(vec4);
+  size += (GLsizeiptr)count * (alignment - 1);
+  if (stream->offset + size <= stream->frameSize)
+    return;
+
+  GLsizeiptr frameSize = stream->frameSize;
+  do {
+    frameSize <<= 1;
+  } while (frameSize < size);
+
+  _Draw_destroyStream(app);
+  _Draw_createStream(app, frameSize);
+}
+
+// Size bytes in this frame's region, offset is from the start of the buffer. Only grows the
+// stream when the draw didn't reserve its allocations
+void *_Draw_streamAlloc(App_t *app, GLsizeiptr size, GLintptr alignment, GLintptr *offset) {
+  _Draw_streamReserve(app, size, 1);
+
+  _DrawStream_t *stream = &app->draw._stream;
+  GLintptr start = (stream->offset + alignment - 1) / alignment * alignment;
+  stream->offset = start + size;
+  *offset = (GLintptr)stream->frame * stream->frameSize + start;
+  return stream->mapped + *offset;
+}
+
+// Copies a uniform block into the stream and binds it for the next draws
+void _Draw_streamUniform(App_t *app, GLuint binding, const void *data, GLsizeiptr size) {
+  GLintptr offset;
+  void *dst = _Draw_streamAlloc(app, size, app->draw._stream.uniformAlignment, &offset);
+  memcpy(dst, data, size);
+  glBindBufferRange(GL_UNIFORM_BUFFER, binding, app->draw._stream.buffer, offset, size);
+}
+
+void _App_OpenGlCleanup(App_t *app) {
   glDeleteBuffers(1, &app->draw._quadEBO);
   glDeleteBuffers(1, &app->draw._quadVBO);
 
-  glDeleteVertexArrays(1, &app->draw._quadVAO);
+  _Draw_destroyStream(app);
 
-  glDeleteBuffers(1, &app->draw._globalUB);
+  glDeleteProgram(app->draw._chartShader);
+  glDeleteVertexArrays(1, &app->draw._chartVAO);
+
+  glDeleteProgram(app->draw._quadShader);
+  glDeleteVertexArrays(1, &app->draw._batchVAO);
+  free(app->draw._batch);
+
+  glDeleteProgram(app->draw._heatmapShader);
+  glDeleteVertexArrays(1, &app->draw._heatmapVAO);
 }
 
 typedef struct _Vertex2D_t {
@@ -561,6 +698,8 @@ Result_t __Draw_loadShaderStringFromFiles(GLuint *p_program, const char *vert, c
   return RESULT_SUCCESS;
 }
 
+#define DEFAULT_BATCH_CAP (1 << 12)
+
 Result_t _App_initOpenGL(App_t *app) {
 #ifdef APP_DEBUG
   glEnable(GL_DEBUG_OUTPUT);
@@ -583,54 +722,132 @@ Result_t _App_initOpenGL(App_t *app) {
       2, 3, 0    // second triangle
   };
 
-  glCreateVertexArrays(1, &app->draw._quadVAO);
-  
+  // The unit quad, every VAO below reads it from binding 0
   glCreateBuffers(1, &app->draw._quadVBO);
   glNamedBufferData(app->draw._quadVBO, sizeof(vertices),
     vertices, GL_STATIC_DRAW
   );
-  glVertexArrayVertexBuffer(app->draw._quadVAO, 0, app->draw._quadVBO,
-    0, sizeof(Vertex2D_t)
-  );
 
   glCreateBuffers(1, &app->draw._quadEBO);
   glNamedBufferData(app->draw._quadEBO, sizeof(indices),
     indices, GL_STATIC_DRAW
   );
-  glVertexArrayElementBuffer(app->draw._quadVAO, app->draw._quadEBO);
 
-  glVertexArrayAttribFormat(app->draw._quadVAO, 0, 3, GL_FLOAT,
+  _Draw_createStream(app, DRAW_STREAM_FRAME_SIZE);
+
+  // Same quad, binding 1 and 2 read a series' points once per instance, 2 one point ahead
+  glCreateVertexArrays(1, &app->draw._chartVAO);
+  glVertexArrayVertexBuffer(app->draw._chartVAO, 0, app->draw._quadVBO,
+    0, sizeof(Vertex2D_t)
+  );
+  glVertexArrayElementBuffer(app->draw._chartVAO, app->draw._quadEBO);
+
+  glVertexArrayAttribFormat(app->draw._chartVAO, 0, 2, GL_FLOAT,
     GL_FALSE, offsetof(Vertex2D_t, position)
   );
-  glVertexArrayAttribBinding(app->draw._quadVAO, 0, 0);
-  glEnableVertexArrayAttrib(app->draw._quadVAO, 0);
+  glVertexArrayAttribBinding(app->draw._chartVAO, 0, 0);
+  glEnableVertexArrayAttrib(app->draw._chartVAO, 0);
 
-  glVertexArrayAttribFormat(app->draw._quadVAO, 1, 2, GL_FLOAT,
+  glVertexArrayAttribFormat(app->draw._chartVAO, 1, 2, GL_FLOAT,
     GL_FALSE, offsetof(Vertex2D_t, tex)
   );
-  glVertexArrayAttribBinding(app->draw._quadVAO, 1, 0);
-  glEnableVertexArrayAttrib(app->draw._quadVAO, 1);
+  glVertexArrayAttribBinding(app->draw._chartVAO, 1, 0);
+  glEnableVertexArrayAttrib(app->draw._chartVAO, 1);
+
+  for (GLuint binding = 1; binding <= 2; binding++) {
+    glVertexArrayAttribFormat(app->draw._chartVAO, binding + 1, 2, GL_FLOAT, GL_FALSE, 0);
+    glVertexArrayAttribBinding(app->draw._chartVAO, binding + 1, binding);
+    glEnableVertexArrayAttrib(app->draw._chartVAO, binding + 1);
+    glVertexArrayBindingDivisor(app->draw._chartVAO, binding, 1);
+  }
 
   __Draw_loadShaderStringFromFiles(
-    &app->draw._texShader, 
-    SHADER_DIR VERT_FILE_NAME, 
-    SHADER_DIR FRAG_FILE_NAME
+    &app->draw._chartShader,
+    SHADER_DIR "vert_chart_2d.glsl",
+    SHADER_DIR "frag_chart_2d.glsl"
+  );
+
+  // Same quad, binding 1 holds the frame's quad instances
+  glCreateVertexArrays(1, &app->draw._batchVAO);
+  glVertexArrayVertexBuffer(app->draw._batchVAO, 0, app->draw._quadVBO,
+    0, sizeof(Vertex2D_t)
+  );
+  glVertexArrayElementBuffer(app->draw._batchVAO, app->draw._quadEBO);
+
+  glVertexArrayAttribFormat(app->draw._batchVAO, 0, 2, GL_FLOAT,
+    GL_FALSE, offsetof(Vertex2D_t, position)
   );
+  glVertexArrayAttribBinding(app->draw._batchVAO, 0, 0);
+  glEnableVertexArrayAttrib(app->draw._batchVAO, 0);
+
+  glVertexArrayAttribFormat(app->draw._batchVAO, 1, 2, GL_FLOAT,
+    GL_FALSE, offsetof(Vertex2D_t, tex)
+  );
+  glVertexArrayAttribBinding(app->draw._batchVAO, 1, 0);
+  glEnableVertexArrayAttrib(app->draw._batchVAO, 1);
+
+  const struct { GLint size; GLenum type; GLuint offset; } batchAttribs[] = {
+    { 4, GL_FLOAT, offsetof(_QuadInstance_t, axes) },
+    { 2, GL_FLOAT, offsetof(_QuadInstance_t, translation) },
+    { 1, GL_INT, offsetof(_QuadInstance_t, texture) },
+    { 4, GL_FLOAT, offsetof(_QuadInstance_t, uvRect) },
+    { 4, GL_FLOAT, offsetof(_QuadInstance_t, color) }
+  };
+  for (GLuint attrib = 0; attrib < sizeof(batchAttribs) / sizeof(batchAttribs[0]); attrib++) {
+    if (batchAttribs[attrib].type == GL_INT) {
+      glVertexArrayAttribIFormat(app->draw._batchVAO, attrib + 2, batchAttribs[attrib].size,
+        GL_INT, batchAttribs[attrib].offset
+      );
+    } else {
+      glVertexArrayAttribFormat(app->draw._batchVAO, attrib + 2, batchAttribs[attrib].size,
+        GL_FLOAT, GL_FALSE, batchAttribs[attrib].offset
+      );
+    }
+    glVertexArrayAttribBinding(app->draw._batchVAO, attrib + 2, 1);
+    glEnableVertexArrayAttrib(app->draw._batchVAO, attrib + 2);
+  }
+  glVertexArrayBindingDivisor(app->draw._batchVAO, 1, 1);
+
+  app->draw._batchCap = DEFAULT_BATCH_CAP;
+  if ((app->draw._batch = malloc(sizeof(_QuadInstance_t) * app->draw._batchCap)) == NULL) {
+    log_error("Failed to allocate the quad batch" ENDL);
+    return RESULT_FAIL;
+  }
 
   __Draw_loadShaderStringFromFiles(
-    &app->draw._flatShader,
-    SHADER_DIR "vert_flat_2d.glsl",
-    SHADER_DIR "frag_flat_2d.glsl"
+    &app->draw._quadShader,
+    SHADER_DIR "vert_quad_2d.glsl",
+    SHADER_DIR "frag_quad_2d.glsl"
   );
-  
-  glCreateBuffers(1, &app->draw._globalUB);
-  glNamedBufferData(app->draw._globalUB, sizeof(_GlobalUBData_t),
-    &app->draw._globalUBData, GL_STATIC_DRAW
+
+  // Same quad, binding 1 is a heatmap's colors, one per instance
+  glCreateVertexArrays(1, &app->draw._heatmapVAO);
+  glVertexArrayVertexBuffer(app->draw._heatmapVAO, 0, app->draw._quadVBO,
+    0, sizeof(Vertex2D_t)
   );
+  glVertexArrayElementBuffer(app->draw._heatmapVAO, app->draw._quadEBO);
 
-  glCreateBuffers(1, &app->draw._localUB);
-  glNamedBufferData(app->draw._localUB,
-    sizeof(_LocalUBData2D_t), NULL, GL_STATIC_DRAW
+  glVertexArrayAttribFormat(app->draw._heatmapVAO, 0, 2, GL_FLOAT,
+    GL_FALSE, offsetof(Vertex2D_t, position)
+  );
+  glVertexArrayAttribBinding(app->draw._heatmapVAO, 0, 0);
+  glEnableVertexArrayAttrib(app->draw._heatmapVAO, 0);
+
+  glVertexArrayAttribFormat(app->draw._heatmapVAO, 1, 2, GL_FLOAT,
+    GL_FALSE, offsetof(Vertex2D_t, tex)
+  );
+  glVertexArrayAttribBinding(app->draw._heatmapVAO, 1, 0);
+  glEnableVertexArrayAttrib(app->draw._heatmapVAO, 1);
+
+  glVertexArrayAttribFormat(app->draw._heatmapVAO, 2, 4, GL_FLOAT, GL_FALSE, 0);
+  glVertexArrayAttribBinding(app->draw._heatmapVAO, 2, 1);
+  glEnableVertexArrayAttrib(app->draw._heatmapVAO, 2);
+  glVertexArrayBindingDivisor(app->draw._heatmapVAO, 1, 1);
+
+  __Draw_loadShaderStringFromFiles(
+    &app->draw._heatmapShader,
+    SHADER_DIR "vert_heatmap_2d.glsl",
+    SHADER_DIR "frag_flat_2d.glsl"
   );
 
   return RESULT_SUCCESS;
@@ -638,33 +855,14 @@ Result_t _App_initOpenGL(App_t *app) {
 
 #define FONT_PATH "fonts/NotoSans-SemiBold.ttf"
 #define FONT_SIZE (1 << 7)
-#define ATLAS_START_SIZE (SizeVec2_t) { 1 << 12, 1 << 12 }
+#define ATLAS_PAGE_SIZE (1 << 11)
 
 
 _Glyph_t *_Draw_getGlyph(App_t *app, UC_t character) {
-  if (character < app->draw._glyphCount) {
-    _Glyph_t *sample = &app->draw._glyphs[character];
-
-    if (sample->character == character) {
-      return sample;
-    }
-  }
-
-  size_t ucharInd = 0;
-  for (;ucharInd < app->draw._glyphCount; ucharInd++) {
-    _Glyph_t *iglyph = &app->draw._glyphs[ucharInd];
-    if (iglyph->character == character) {
-      return iglyph;
-    }
-
-    if (iglyph->character > character) {
-      return NULL;
-    }
-  }
-
-  return NULL;
+  return GlyphTable_get(&app->draw._glyphs, character);
 }
 
+// NULL when the glyph can't be loaded, text skips the character
 _Glyph_t *_Draw_getGlyphOrLoad(App_t *app, UC_t character) {
   _Glyph_t *result = _Draw_getGlyph(app, character);
   if (result != NULL) {
@@ -675,38 +873,59 @@ _Glyph_t *_Draw_getGlyphOrLoad(App_t *app, UC_t character) {
   return _Draw_getGlyph(app, character);
 }
 
+// Texture of a page the atlas just opened, cleared so the padding around glyphs stays empty
+void _Draw_createAtlasPage(App_t *app, GlyphAtlasPage_t *page) {
+  GLuint texture = 0;
+  glCreateTextures(GL_TEXTURE_2D, 1, &texture);
+  glTextureStorage2D(texture, 1, GL_R8, ATLAS_PAGE_SIZE, ATLAS_PAGE_SIZE);
+
+  // set texture options
+  glTextureParameteri(texture, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+  glTextureParameteri(texture, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+  glTextureParameteri(texture, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+  glTextureParameteri(texture, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+
+  GLubyte clear = 0;
+  glClearTexImage(texture, 0, GL_RED, GL_UNSIGNED_BYTE, &clear);
+  page->texture = texture;
+}
+
 Result_t _Draw_loadGlyph(App_t *app, UC_t character) {
     if (FT_Load_Char(app->draw._ftFace, character, FT_LOAD_RENDER)) {
       log_warn("Failed to load char %c of font " FONT_PATH ENDL);
       return RESULT_FAIL;
     }
 
-    // generate texture
-    GLuint texture = 0;
+    // pack the bitmap into the atlas
+    GlyphAtlasRect_t rect = {0};
     if (app->draw._ftFace->glyph->bitmap.buffer == NULL)
       goto skip_glyph_texture_creation;
 
-    glCreateTextures(GL_TEXTURE_2D, 1, &texture);
-    glTextureStorage2D(texture, 1, GL_R8,
-      app->draw._ftFace->glyph->bitmap.width, app->draw._ftFace->glyph->bitmap.rows
-    );
+    if (GlyphAtlas_pack(&app->draw._atlas, app->draw._ftFace->glyph->bitmap.width,
+      app->draw._ftFace->glyph->bitmap.rows, &rect) != RESULT_SUCCESS) {
+      return RESULT_FAIL;
+    }
 
-    // set texture options
-    glTextureParameteri(texture, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
-    glTextureParameteri(texture, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
-    glTextureParameteri(texture, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-    glTextureParameteri(texture, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    GlyphAtlasPage_t *page = &app->draw._atlas.pages[rect.page];
+    if (page->texture == 0)
+      _Draw_createAtlasPage(app, page);
 
-    glTextureSubImage2D(texture, 0, 
-      0, 0,
-      app->draw._ftFace->glyph->bitmap.width, app->draw._ftFace->glyph->bitmap.rows,
+    glTextureSubImage2D(page->texture, 0,
+      rect.x, rect.y,
+      rect.width, rect.height,
       GL_RED, GL_UNSIGNED_BYTE, app->draw._ftFace->glyph->bitmap.buffer
     );
 
 skip_glyph_texture_creation:
     _Glyph_t glyph = {
       .character = character,
-      .glTextureHandle = texture,
+      .page = rect.page,
+      .uv = {
+        rect.x / (float)ATLAS_PAGE_SIZE,
+        rect.y / (float)ATLAS_PAGE_SIZE,
+        (rect.x + rect.width) / (float)ATLAS_PAGE_SIZE,
+        (rect.y + rect.height) / (float)ATLAS_PAGE_SIZE
+      },
       .isWhitespace = app->draw._ftFace->glyph->bitmap.buffer == NULL,
       .size = { 
         app->draw._ftFace->glyph->bitmap.width / (float)FONT_SIZE,
@@ -722,37 +941,13 @@ skip_glyph_texture_creation:
       }
     };
 
-    app->draw._glyphCount++;
-
-    while (app->draw._glyphCap < app->draw._glyphCount * sizeof(_Glyph_t)) {
-      app->draw._glyphCap <<= 1;
-    }
-    app->draw._glyphs = realloc(app->draw._glyphs, app->draw._glyphCap);
-
-    size_t ucharInd = 0;
-    for (;ucharInd < app->draw._glyphCount - 1; ucharInd++) {
-      _Glyph_t *iglyph = &app->draw._glyphs[ucharInd];
-      if (iglyph->character == character) {
-        log_error("Unicode character has already been loaded" ENDL);
-        return RESULT_FAIL;
-      }
-
-      if (iglyph->character > character) {
-        break;
-      }
-    }
-
-    size_t spaceDiff = app->draw._glyphCount - ucharInd - 1;
-    if (spaceDiff > 0) {
-      memcpy(
-        &app->draw._glyphs[ucharInd + 1],
-        &app->draw._glyphs[ucharInd],
-        sizeof(_Glyph_t)
-      );
+    _Glyph_t *entry = GlyphTable_insert(&app->draw._glyphs, character);
+    if (entry == NULL) {
+      log_error("Unicode character has already been loaded" ENDL);
+      return RESULT_FAIL;
     }
 
-    app->draw._glyphs[ucharInd] = glyph;
-
+    *entry = glyph;
     return RESULT_SUCCESS;
 }
 
@@ -772,14 +967,9 @@ Result_t _Draw_loadAsciiGlyphs(App_t *app) {
   FT_Set_Pixel_Sizes(app->draw._ftFace, 0, FONT_SIZE);
   glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
 
-  // TODO:
-  // Create texture atlas optimisations
-
-  app->draw._glyphCount = 0,
-  app->draw._glyphCap = DEFAULT_BUF_CAP,
-  app->draw._glyphs = malloc(app->draw._glyphCap),
+  GlyphAtlas_init(&app->draw._atlas, ATLAS_PAGE_SIZE);
 
-  memset(app->draw._glyphs, 0, app->draw._glyphCap);
+  GlyphTable_init(&app->draw._glyphs, sizeof(_Glyph_t));
   for (UC_t character = 0; character < ASCII_LOAD_LIMIT; character++) {
     _Draw_loadGlyph(app, character);
   }
@@ -791,11 +981,11 @@ void _App_cleanupTextRenderer(App_t *app) {
   FT_Done_Face(app->draw._ftFace);
   FT_Done_FreeType(app->draw._ft);
 
-  for (size_t glyphIndex = 0; glyphIndex < app->draw._glyphCount; glyphIndex++) {
-    _Glyph_t *glyph = &app->draw._glyphs[glyphIndex];
-    glDeleteTextures(1, &glyph->glTextureHandle);
+  for (uint32_t page = 0; page < app->draw._atlas.pageCount; page++) {
+    glDeleteTextures(1, &app->draw._atlas.pages[page].texture);
   }
-  free(app->draw._glyphs);
+  GlyphAtlas_cleanup(&app->draw._atlas);
+  GlyphTable_cleanup(&app->draw._glyphs);
 }
 
 typedef struct __TextInfo_t {
@@ -822,16 +1012,85 @@ void _App_wndCharCBCK(GLFWwindow* window, unsigned int character) {
   EventQueue_push(&app->_evQueue, &payload);
 }
 
-void _Draw_text(App_t *app, UStr_t *str,
-  const Transform_t transform, const TextInfo_t info) {
-  glUseProgram(app->draw._texShader);
-  glBindBufferBase(GL_UNIFORM_BUFFER, 0, app->draw._globalUB);
-  glBindVertexArray(app->draw._quadVAO);
+// Draws every quad batched so far in one instanced call
+void _Draw_flushQuads(App_t *app) {
+  if (app->draw._batchCount == 0)
+    return;
 
-  _LocalUBData2D_t ubData = {
-    .color = COLOR_RED,
-    .model = GLM_MAT4_IDENTITY_INIT
+  GLintptr offset;
+  GLsizeiptr size = sizeof(_QuadInstance_t) * app->draw._batchCount;
+  _Draw_streamReserve(app, size + sizeof(_GlobalUBData_t), 2);
+  memcpy(_Draw_streamAlloc(app, size, sizeof(vec4), &offset), app->draw._batch, size);
+
+  glUseProgram(app->draw._quadShader);
+  _Draw_streamUniform(app, 0, &app->draw._globalUBData, sizeof(_GlobalUBData_t));
+  glVertexArrayVertexBuffer(app->draw._batchVAO, 1, app->draw._stream.buffer,
+    offset, sizeof(_QuadInstance_t)
+  );
+  glBindVertexArray(app->draw._batchVAO);
+  if (app->draw._batchTextureCount > 0)
+    glBindTextures(0, app->draw._batchTextureCount, app->draw._batchTextures);
+  glDrawElementsInstanced(GL_TRIANGLES, 6, GL_UNSIGNED_INT, 0,
+    app->draw._batchCount
+  );
+
+  app->draw._batchCount = 0;
+  app->draw._batchTextureCount = 0;
+}
+
+// Slot of texture in the current batch, flushes it when every slot is taken
+int32_t _Draw_batchTexture(App_t *app, GLuint texture) {
+  for (uint32_t slot = 0; slot < app->draw._batchTextureCount; slot++) {
+    if (app->draw._batchTextures[slot] == texture)
+      return (int32_t)slot;
+  }
+
+  if (app->draw._batchTextureCount == DRAW_QUAD_TEXTURE_SLOTS)
+    _Draw_flushQuads(app);
+
+  app->draw._batchTextures[app->draw._batchTextureCount] = texture;
+  return (int32_t)app->draw._batchTextureCount++;
+}
+
+// Adds the unit quad under model to the batch, texture is a slot or DRAW_QUAD_FLAT/OUTLINE
+void _Draw_pushQuad(App_t *app, mat4 model, int32_t texture, vec4 uvRect, vec4 color) {
+  if (app->draw._batchCount == app->draw._batchCap) {
+    _QuadInstance_t *batch = realloc(app->draw._batch,
+      sizeof(_QuadInstance_t) * ((size_t)app->draw._batchCap << 1)
+    );
+    if (batch != NULL) {
+      app->draw._batch = batch;
+      app->draw._batchCap <<= 1;
+    } else {
+      // Draws what the batch holds and starts over in it, texture keeps its slot
+      GLuint textures[DRAW_QUAD_TEXTURE_SLOTS];
+      uint32_t textureCount = app->draw._batchTextureCount;
+      memcpy(textures, app->draw._batchTextures, sizeof(GLuint) * textureCount);
+      _Draw_flushQuads(app);
+      memcpy(app->draw._batchTextures, textures, sizeof(GLuint) * textureCount);
+      app->draw._batchTextureCount = textureCount;
+    }
+  }
+
+  _QuadInstance_t *instance = &app->draw._batch[app->draw._batchCount++];
+  *instance = (_QuadInstance_t) {
+    .axes = { model[0][0], model[0][1], model[1][0], model[1][1] },
+    .translation = { model[3][0], model[3][1] },
+    .texture = texture
   };
+  glm_vec4_copy(uvRect, instance->uvRect);
+  glm_vec4_copy(color, instance->color);
+}
+
+void _Draw_pushGlyph(App_t *app, mat4 model, _Glyph_t *glyph, vec4 color) {
+  int32_t slot = _Draw_batchTexture(app, app->draw._atlas.pages[glyph->page].texture);
+  _Draw_pushQuad(app, model, slot, glyph->uv, color);
+}
+
+void _Draw_text(App_t *app, UStr_t *str,
+  const Transform_t transform, const TextInfo_t info) {
+  vec4 color = COLOR_RED;
+  mat4 model = GLM_MAT4_IDENTITY_INIT;
   vec2 lPos = { transform.position[0], transform.position[1] };
 
   int wwidth = 0, wheight = 0;
@@ -847,6 +1106,8 @@ void _Draw_text(App_t *app, UStr_t *str,
 
   for (UC_t *code_point = str->str; code_point < &str->str[str->count + 1]; code_point++) {
       _Glyph_t *glyph = _Draw_getGlyphOrLoad(app, *code_point);
+      if (glyph == NULL)
+        continue;
       lPos[0] += (glyph->advance[0] / 2.f) * scaleX;
 
       if (glyph->isWhitespace || *code_point == '\n')
@@ -864,14 +1125,8 @@ void _Draw_text(App_t *app, UStr_t *str,
         }
       };
 
-      Transform_toMat4(&trans, ubData.model);
-
-      glNamedBufferSubData(app->draw._localUB, 0,
-        sizeof(_LocalUBData2D_t), &ubData
-      );
-      glBindBufferBase(GL_UNIFORM_BUFFER, 1, app->draw._localUB);
-      glBindTextureUnit(0, glyph->glTextureHandle);
-      glDrawElements(GL_TRIANGLES, 6, GL_UNSIGNED_INT, 0);
+      Transform_toMat4(&trans, model);
+      _Draw_pushGlyph(app, model, glyph, color);
       
 skip_glyph_rendering:
       lPos[0] += (glyph->advance[0] / 2.f + info.horSpacing) * scaleX;
@@ -900,6 +1155,8 @@ void _Draw_calculateUiTextSize(App_t* app, UI_t *ui, vec2 out) {
 
   for (UC_t *code_point = text->str.str; code_point < &text->str.str[text->str.count + 1]; code_point++) {
     _Glyph_t *glyph = _Draw_getGlyphOrLoad(app, *code_point);
+    if (glyph == NULL)
+      continue;
     out[0] += glyph->advance[0] / 2.f;
     out[0] += glyph->advance[0] / 2.f;
     
@@ -915,21 +1172,10 @@ void _Draw_calculateUiTextSize(App_t* app, UI_t *ui, vec2 out) {
   }
 }
 
-void _Draw_uiText(App_t* app, UI_t *ui) {
+// Draws text already measured by _Draw_calculateUiTextSize
+void _Draw_uiTextLayout(App_t* app, UI_t *ui, vec2 resultingSize) {
   UiText_t *text = ui->_unique;
 
-  glUseProgram(app->draw._texShader);
-  glBindBufferBase(GL_UNIFORM_BUFFER, 0, app->draw._globalUB);
-  glBindVertexArray(app->draw._quadVAO);
-
-  _LocalUBData2D_t ubData = {
-    .color = COLOR_RED,
-    .model = GLM_MAT4_IDENTITY_INIT
-  };
-
-  vec2 resultingSize = {0};
-  _Draw_calculateUiTextSize(app, ui, resultingSize);
-
   vec2 normalizedScale = {0};
   glm_vec2_div(ui->parent->size.dimentions, resultingSize, normalizedScale);
   if (resultingSize[1] < 0.001f)
@@ -942,6 +1188,8 @@ void _Draw_uiText(App_t* app, UI_t *ui) {
 
   for (UC_t *code_point = text->str.str; code_point < &text->str.str[text->str.count + 1]; code_point++) {
       _Glyph_t *glyph = _Draw_getGlyphOrLoad(app, *code_point);
+      if (glyph == NULL)
+        continue;
       lPos[0] += glyph->advance[0] / 2.f * normalizedScale[0];
 
       if (glyph->isWhitespace || *code_point == '\n')
@@ -959,16 +1207,9 @@ void _Draw_uiText(App_t* app, UI_t *ui) {
         glyph->size[1] * normalizedScale[1]
       });
 
-      _LocalUBData2D_t ubData = {0};
-      glm_mat4_mul(ui->_matrix, modelMatrix, ubData.model);
-      glm_vec4_copy(ui->_color, ubData.color);
-
-      glNamedBufferSubData(app->draw._localUB, 0,
-        sizeof(_LocalUBData2D_t), &ubData
-      );
-      glBindBufferBase(GL_UNIFORM_BUFFER, 1, app->draw._localUB);
-      glBindTextureUnit(0, glyph->glTextureHandle);
-      glDrawElements(GL_TRIANGLES, 6, GL_UNSIGNED_INT, 0);
+      mat4 model;
+      glm_mat4_mul(ui->_matrix, modelMatrix, model);
+      _Draw_pushGlyph(app, model, glyph, ui->_color);
       
 skip_ui_glyph_rendering:
       lPos[0] += (glyph->advance[0] / 2.f) * normalizedScale[0];
@@ -985,31 +1226,192 @@ skip_ui_glyph_rendering:
   }
 }
 
+void _Draw_uiText(App_t* app, UI_t *ui) {
+  vec2 resultingSize = {0};
+  _Draw_calculateUiTextSize(app, ui, resultingSize);
+  _Draw_uiTextLayout(app, ui, resultingSize);
+}
+
 void _Draw_uiContainer(App_t* app, UI_t *ui) {
-  glm_mat4_copy(app->draw._projection, app->draw._globalUBData.projectionView);
-  glNamedBufferSubData(app->draw._globalUB, 0,
-    sizeof(_GlobalUBData_t), &app->draw._globalUBData
+  _Draw_pushQuad(app, ui->_matrix, DRAW_QUAD_FLAT, (vec4) { 0.f, 0.f, 1.f, 1.f }, ui->_color);
+}
+
+void _Draw_uiWireframe(App_t* app, UI_t *ui) {
+  _Draw_pushQuad(app, ui->_matrix, DRAW_QUAD_OUTLINE, (vec4) { 0.f, 0.f, 1.f, 1.f }, ui->_color);
+}
+
+// Uploads the points of a series the first time it's drawn and after they change
+void _Draw_uploadChartSeries(UiChartSeries_t *series) {
+  if (series->_buffer != 0 && !series->_dirty)
+    return;
+
+  if (series->_buffer != 0)
+    glDeleteBuffers(1, &series->_buffer);
+
+  // The next point attribute reads one past every instance, bars included. The last point is
+  // repeated after the series so that read stays inside the buffer
+  glCreateBuffers(1, &series->_buffer);
+  glNamedBufferStorage(series->_buffer, sizeof(vec2) * (series->count + 1),
+    NULL, GL_DYNAMIC_STORAGE_BIT
+  );
+  glNamedBufferSubData(series->_buffer, 0, sizeof(vec2) * series->count, series->points);
+  glNamedBufferSubData(series->_buffer, sizeof(vec2) * series->count, sizeof(vec2),
+    series->points[series->count - 1]
   );
+  series->_dirty = false;
+}
 
-  _LocalUBData2D_t ubData = {0};
+// One instanced draw per series, a line or an area segment or a bar per instance
+void _Draw_uiChart(App_t* app, UI_t *ui) {
+  UiChart_t *chart = ui->_unique;
+  _Draw_uiContainer(app, ui);
+  _Draw_flushQuads(app);
+
+  _ChartUBData_t ubData = {
+    .view = {
+      chart->offset[0], chart->offset[1],
+      1.f / chart->extent[0], 1.f / chart->extent[1]
+    },
+    .lineWidth = chart->lineWidth,
+    .barWidth = chart->barWidth
+  };
   glm_mat4_copy(ui->_matrix, ubData.model);
-  glm_vec4_copy(ui->_color, ubData.color);
 
-  glNamedBufferSubData(app->draw._localUB, 0,
-    sizeof(_LocalUBData2D_t), &ubData
+  // Only points in view get an instance, plus one on each side for what crosses the edges
+  float firstX = floorf(chart->offset[0]) - 1.f;
+  float lastX = ceilf(chart->offset[0] + chart->extent[0]) + 1.f;
+  if (lastX < 0.f)
+    return;
+
+  uint32_t first = firstX > 0.f ? (uint32_t)firstX : 0;
+  ubData.firstPoint = (int32_t)first;
+
+  _Draw_streamReserve(app, sizeof(_GlobalUBData_t) + sizeof(_ChartUBData_t) * chart->seriesCount,
+    1 + chart->seriesCount
   );
+  glUseProgram(app->draw._chartShader);
+  _Draw_streamUniform(app, 0, &app->draw._globalUBData, sizeof(_GlobalUBData_t));
+  glBindVertexArray(app->draw._chartVAO);
+
+  for (uint32_t index = 0; index < chart->seriesCount; index++) {
+    UiChartSeries_t *series = &chart->series[index];
+    uint32_t end = lastX < series->count ? (uint32_t)lastX + 1 : series->count;
+    if (series->count == 0 || end <= first)
+      continue;
+
+    // Lines and areas draw a segment to the next point, the last point has none
+    uint32_t instances = end - first;
+    if (series->kind != UI_CHART_BAR)
+      instances--;
+    if (instances == 0)
+      continue;
 
-  glUseProgram(app->draw._flatShader);
-  glBindBufferBase(GL_UNIFORM_BUFFER, 0, app->draw._globalUB); 
-  glBindBufferBase(GL_UNIFORM_BUFFER, 1, app->draw._localUB);
-  glBindVertexArray(app->draw._quadVAO);
-  glDrawElements(GL_TRIANGLES, 6, GL_UNSIGNED_INT, 0);
+    _Draw_uploadChartSeries(series);
+
+    ubData.kind = series->kind;
+    glm_vec4_copy(series->color, ubData.color);
+    _Draw_streamUniform(app, 2, &ubData, sizeof(_ChartUBData_t));
+
+    glVertexArrayVertexBuffer(app->draw._chartVAO, 1, series->_buffer, 0, sizeof(vec2));
+    glVertexArrayVertexBuffer(app->draw._chartVAO, 2, series->_buffer, sizeof(vec2), sizeof(vec2));
+    glDrawElementsInstancedBaseInstance(GL_TRIANGLES, 6, GL_UNSIGNED_INT, 0,
+      instances, first
+    );
+  }
 }
 
-void _Draw_uiWireframe(App_t* app, UI_t *ui) {
-  glPolygonMode(GL_FRONT_AND_BACK, GL_LINE);
+// Every day of the year in one instanced draw, the colors only go to the GPU when they change
+void _Draw_uiHeatmap(App_t* app, UI_t *ui) {
+  UiHeatmap_t *heatmap = ui->_unique;
   _Draw_uiContainer(app, ui);
-  glPolygonMode(GL_FRONT_AND_BACK, GL_FILL);
+
+  if (heatmap->dayCount == 0)
+    return;
+  _Draw_flushQuads(app);
+
+  // Sized for any year once, a new year rewrites its colors in place
+  if (heatmap->_buffer == 0) {
+    glCreateBuffers(1, &heatmap->_buffer);
+    glNamedBufferStorage(heatmap->_buffer, sizeof(vec4) * UI_HEATMAP_MAX_DAYS,
+      NULL, GL_DYNAMIC_STORAGE_BIT
+    );
+  }
+
+  if (heatmap->_dirty) {
+    glNamedBufferSubData(heatmap->_buffer, 0,
+      sizeof(vec4) * heatmap->dayCount, heatmap->colors
+    );
+    heatmap->_dirty = false;
+  }
+
+  _HeatmapUBData_t ubData = {
+    .firstWeekday = (int32_t)heatmap->firstWeekday,
+    .cellGap = heatmap->cellGap
+  };
+  glm_mat4_copy(ui->_matrix, ubData.model);
+
+  _Draw_streamReserve(app, sizeof(_GlobalUBData_t) + sizeof(_HeatmapUBData_t), 2);
+  glUseProgram(app->draw._heatmapShader);
+  _Draw_streamUniform(app, 0, &app->draw._globalUBData, sizeof(_GlobalUBData_t));
+  _Draw_streamUniform(app, 2, &ubData, sizeof(_HeatmapUBData_t));
+  glVertexArrayVertexBuffer(app->draw._heatmapVAO, 1, heatmap->_buffer, 0, sizeof(vec4));
+  glBindVertexArray(app->draw._heatmapVAO);
+  glDrawElementsInstanced(GL_TRIANGLES, 6, GL_UNSIGNED_INT, 0,
+    heatmap->dayCount
+  );
+}
+
+// Rows in view from the slot pool, a row is measured once when it comes into view
+void _Draw_uiList(App_t* app, UI_t *ui) {
+  UiList_t *list = ui->_unique;
+  _Draw_uiContainer(app, ui);
+
+  for (uint32_t slot = 0; slot < list->slotCount; slot++) {
+    UiListSlot_t *listSlot = &list->slots[slot];
+    UI_t *row = &ui->children[slot];
+    if (listSlot->row == UI_LIST_NO_ROW || row->flags & UI_FLAG_HIDE)
+      continue;
+
+    if (!listSlot->_layoutValid) {
+      _Draw_calculateUiTextSize(app, row, listSlot->_layoutSize);
+      listSlot->_layoutValid = true;
+    }
+    _Draw_uiTextLayout(app, row, listSlot->_layoutSize);
+  }
+}
+
+// Deletes the GL buffers of the charts and heatmaps under ui, before UI_destroy frees them
+void _Draw_releaseUiBuffers(App_t* app, UI_t *ui) {
+  for (UI_t *child = ui->children;
+    child < &ui->children[ui->childCount]; child++) {
+    _Draw_releaseUiBuffers(app, child);
+  }
+
+  switch (ui->type) {
+    case UI_EL_TYPE_CHART: {
+      UiChart_t *chart = ui->_unique;
+      for (uint32_t index = 0; index < chart->seriesCount; index++) {
+        glDeleteBuffers(1, &chart->series[index]._buffer);
+        chart->series[index]._buffer = 0;
+      }
+      break;
+    }
+    case UI_EL_TYPE_HEATMAP: {
+      UiHeatmap_t *heatmap = ui->_unique;
+      glDeleteBuffers(1, &heatmap->_buffer);
+      heatmap->_buffer = 0;
+      break;
+    }
+    default:
+      break;
+  }
+}
+
+// Draws the world's quads and switches the batch to the UI's screen space
+void _Draw_beginUI(App_t* app) {
+  _Draw_flushQuads(app);
+
+  glm_mat4_copy(app->draw._projection, app->draw._globalUBData.projectionView);
 }
 
 void _Draw_UI(App_t* app, UI_t *ui) {
@@ -1025,6 +1427,19 @@ void _Draw_UI(App_t* app, UI_t *ui) {
       _Draw_uiText(app, ui);
       break;
     }
+    case UI_EL_TYPE_CHART: {
+      _Draw_uiChart(app, ui);
+      break;
+    }
+    case UI_EL_TYPE_HEATMAP: {
+      _Draw_uiHeatmap(app, ui);
+      break;
+    }
+    case UI_EL_TYPE_LIST: {
+      // The row nodes are drawn with their cached layout, not as children
+      _Draw_uiList(app, ui);
+      return;
+    }
     default:
       _Draw_uiContainer(app, ui);
       break;
@@ -1052,42 +1467,26 @@ void _Draw_loadCamera(App_t *app, vec2 cameraPosition) {
     app->draw._view,
     app->draw._globalUBData.projectionView
   );
-
-  glNamedBufferSubData(app->draw._globalUB, 0, 
-    sizeof(_GlobalUBData_t), &app->draw._globalUBData
-  );
 }
 
 void _App_render(App_t *app) {
   glfwMakeContextCurrent(app->_wnd);
+  _Draw_beginStreamFrame(app);
   
   _Draw_loadCamera(app, app->camera);
   glClear(GL_COLOR_BUFFER_BIT);
 
-  _LocalUBData2D_t spriteUB = {
-    .color = {0.75, 0.0, 0.5, 1.0},
-    .model = GLM_MAT4_IDENTITY_INIT
-  };
-  glm_translate(spriteUB.model, 
+  vec4 spriteColor = {0.75, 0.0, 0.5, 1.0};
+  mat4 spriteModel = GLM_MAT4_IDENTITY_INIT;
+  glm_translate(spriteModel, 
     (vec3) { app->_spritePosition[0], app->_spritePosition[1], 0 }
   );
-  glm_scale(spriteUB.model, 
+  glm_scale(spriteModel, 
     (vec3) { 0.1f, 0.1f, 0 }
   );
-  glNamedBufferSubData(app->draw._localUB, 0, 
-    sizeof(_LocalUBData2D_t), &spriteUB
-  );
+  _Draw_pushQuad(app, spriteModel, DRAW_QUAD_FLAT, (vec4) { 0.f, 0.f, 1.f, 1.f }, spriteColor);
 
-  glUseProgram(app->draw._flatShader);
-  glBindBufferBase(GL_UNIFORM_BUFFER, 0, app->draw._globalUB); 
-  glBindBufferBase(GL_UNIFORM_BUFFER, 1, app->draw._localUB);
-  glBindVertexArray(app->draw._quadVAO);
-  glDrawElements(GL_TRIANGLES, 6, GL_UNSIGNED_INT, 0);
-
-  spriteUB = (_LocalUBData2D_t) {
-    .color = {0.75, 0.0, 0.5, 1.0},
-    .model = GLM_MAT4_IDENTITY_INIT
-  };
+  glm_mat4_identity(spriteModel);
 
   // Drawing cursor
   vec3 cPos = {0};
@@ -1096,16 +1495,9 @@ void _App_render(App_t *app) {
   // INVESTIGATE
   cPos[1] += 1;
 
-  glm_translate(spriteUB.model, cPos);
-  glm_scale(spriteUB.model, (vec3) {0.025, 0.025, 1.f});
-
-  glNamedBufferSubData(app->draw._localUB, 0, 
-    sizeof(_LocalUBData2D_t), &spriteUB
-  );
-  glBindBufferBase(GL_UNIFORM_BUFFER, 0, app->draw._globalUB); 
-  glBindBufferBase(GL_UNIFORM_BUFFER, 1, app->draw._localUB);
-  glBindVertexArray(app->draw._quadVAO);
-  glDrawElements(GL_TRIANGLES, 6, GL_UNSIGNED_INT, 0);
+  glm_translate(spriteModel, cPos);
+  glm_scale(spriteModel, (vec3) {0.025, 0.025, 1.f});
+  _Draw_pushQuad(app, spriteModel, DRAW_QUAD_FLAT, (vec4) { 0.f, 0.f, 1.f, 1.f }, spriteColor);
 
   char cPosBuffer[64];
   sprintf_s(cPosBuffer, sizeof(cPosBuffer) / sizeof(char), 
@@ -1176,7 +1568,10 @@ void _App_render(App_t *app) {
     }
   );
 
+  _Draw_beginUI(app);
   _Draw_UI(app, &app->_uiRoot);
+  _Draw_flushQuads(app);
+  _Draw_endStreamFrame(app);
   glfwSwapBuffers(app->_wnd);
   UStr_destroy(&str);
 
@@ -1190,6 +1585,280 @@ void __testButtonCallback(App_t  *app, UI_t *self) {
   UI_setPosition(self, newPosition);
 }
 
+// Days in view when the history chart opens
+#define CHART_HISTORY_DAYS 90
+
+// Adds series index of the chart the first time, replaces its values after
+int32_t _App_chartSeries(UI_t *chart, uint32_t index, UiChartSeriesInfo_t *seriesInfo) {
+  UiChart_t *unique = chart->_unique;
+  if (index >= unique->seriesCount)
+    return UI_chartAddSeries(chart, seriesInfo);
+  return UI_chartSetValues(chart, index, seriesInfo->values, seriesInfo->count) == RESULT_SUCCESS ? (int32_t)index : -1;
+}
+
+// Calories from protein, fat and carbs stacked per day, the 30 day average behind them and
+// the calorie EMA over them. One point per day of the history, called again after a meal is logged
+void _App_chartHistory(App_t *app, UI_t *chart) {
+  MacroTrend_t *trend = MacroDatabase_trend(app->db);
+  if (trend == NULL || trend->dayCount == 0)
+    return;
+
+  static const MacroColumn_t columns[] = {
+    MACRO_COLUMN_PROTEIN, MACRO_COLUMN_FAT, MACRO_COLUMN_CARBS
+  };
+  static const float calsPerGram[] = { 4.f, 9.f, 4.f };
+  static const vec4 colors[] = { COLOR_PRIMARY, COLOR_SECONDARY, COLOR_BASE };
+
+  uint32_t count = trend->dayCount;
+  DayNum_t lastDay = trend->firstDay + count - 1;
+  float *values = malloc(sizeof(float) * count);
+  if (values == NULL) {
+    log_error("Failed to allocate the history chart values of %u days" ENDL, count);
+    return;
+  }
+
+  UiChartSeriesInfo_t seriesInfo = {
+    .kind = UI_CHART_AREA,
+    .color = { 1.f, 1.f, 1.f, 0.25f },
+    .values = values,
+    .count = count,
+    .stacked = false
+  };
+  uint32_t seriesIndex = 0;
+  MacroTrend_series(trend, MACRO_TREND_SMA_30, MACRO_COLUMN_CALS, trend->firstDay, lastDay, values);
+  _App_chartSeries(chart, seriesIndex++, &seriesInfo);
+
+  int32_t top = -1;
+  for (uint32_t macro = 0; macro < sizeof(columns) / sizeof(columns[0]); macro++) {
+    for (uint32_t day = 0; day < count; day++) {
+      values[day] = trend->days[day].totals.sum[columns[macro]] * calsPerGram[macro];
+    }
+
+    seriesInfo.kind = UI_CHART_BAR;
+    seriesInfo.stacked = true;
+    glm_vec4_copy((float *)colors[macro], seriesInfo.color);
+    int32_t added = _App_chartSeries(chart, seriesIndex++, &seriesInfo);
+    top = added >= 0 ? added : top;
+  }
+
+  MacroTrend_series(trend, MACRO_TREND_EMA, MACRO_COLUMN_CALS, trend->firstDay, lastDay, values);
+  seriesInfo.kind = UI_CHART_LINE;
+  seriesInfo.stacked = false;
+  glm_vec4_copy((vec4)COLOR_WHITE, seriesInfo.color);
+  _App_chartSeries(chart, seriesIndex++, &seriesInfo);
+  free(values);
+
+  // The top of the last stacked series is the tallest day
+  UiChart_t *unique = chart->_unique;
+  float peak = 0.f;
+  for (uint32_t day = 0; top >= 0 && day < count; day++) {
+    const UiChartSeries_t *series = &unique->series[top];
+    float total = series->points[day][0] + series->points[day][1];
+    peak = total > peak ? total : peak;
+  }
+
+  unique->extent[0] = count < CHART_HISTORY_DAYS ? (float)count : CHART_HISTORY_DAYS;
+  unique->extent[1] = peak > 0.f ? peak * 1.1f : 1.f;
+  unique->offset[0] = count - unique->extent[0];
+  unique->offset[1] = 0.f;
+}
+
+// Goals the heatmap judges days against
+#define APP_GOAL_TARGET { .cals = 2500, .calsTolerance = 250, .proteinMin = 120, .fatMax = 90, .carbsMax = 300 }
+static const MacroGoalTarget_t _appGoalTargets[7] = {
+  APP_GOAL_TARGET, APP_GOAL_TARGET, APP_GOAL_TARGET, APP_GOAL_TARGET,
+  APP_GOAL_TARGET, APP_GOAL_TARGET, APP_GOAL_TARGET
+};
+
+#define COLOR_HEATMAP_EMPTY { 0.15f, 0.15f, 0.15f, 1.f }
+
+// Colors the heatmap's year from the day rollups or the goal status of every day
+void _App_heatmapChanged(App_t *app, UI_t *self) {
+  UiHeatmap_t *unique = self->_unique;
+  DayNum_t first = Date_toDayNum((Date_t) { .year = unique->year, .month = 1, .day = 1 });
+  DayNum_t next = Date_toDayNum((Date_t) { .year = unique->year + 1, .month = 1, .day = 1 });
+  uint32_t dayCount = next - first;
+
+  vec4 colors[UI_HEATMAP_MAX_DAYS];
+  vec4 empty = COLOR_HEATMAP_EMPTY;
+
+  if (unique->mode == UI_HEATMAP_GOALS) {
+    if (app->goals == NULL)
+      app->goals = MacroDatabase_setGoals(app->db, _appGoalTargets);
+
+    vec4 passed = COLOR_SECONDARY, failed = COLOR_RED;
+    for (uint32_t day = 0; day < dayCount; day++) {
+      MacroGoalStatus_t status = app->goals != NULL ? MacroGoals_status(app->goals, first + day) : MACRO_GOAL_NONE;
+      switch (status) {
+        case MACRO_GOAL_PASS:
+          glm_vec4_copy(passed, colors[day]);
+          break;
+        case MACRO_GOAL_FAIL:
+          glm_vec4_copy(failed, colors[day]);
+          break;
+        default:
+          glm_vec4_copy(empty, colors[day]);
+          break;
+      }
+    }
+  } else {
+    // Shades of one color up to the year's biggest day
+    const MacroRollup_t *rollup = MacroDatabase_rollup(app->db);
+    float cals[UI_HEATMAP_MAX_DAYS];
+    float peak = 0.f;
+    for (uint32_t day = 0; day < dayCount; day++) {
+      MacroTotals_t totals = {0};
+      if (rollup != NULL)
+        MacroRollup_bucket(rollup, MACRO_ROLLUP_DAY, first + day, &totals);
+      cals[day] = totals.count > 0 ? (float)totals.sum[MACRO_COLUMN_CALS] : -1.f;
+      peak = cals[day] > peak ? cals[day] : peak;
+    }
+
+    vec4 low = { 0.2f, 0.25f, 0.3f, 1.f }, high = COLOR_BASE;
+    for (uint32_t day = 0; day < dayCount; day++) {
+      if (cals[day] < 0.f || peak <= 0.f)
+        glm_vec4_copy(empty, colors[day]);
+      else
+        glm_vec4_lerp(low, high, cals[day] / peak, colors[day]);
+    }
+  }
+
+  UI_heatmapSetDays(self, (uint32_t)(((uint64_t)first + 3) % 7), colors, dayCount);
+}
+
+// Meal history newest first, one meal per row
+void _App_mealRow(App_t *app, UI_t *list, uint32_t row, UStr_t *out) {
+  Meal_t meal = MacroDatabase_getMeal(app->db, app->db->mealCount - 1 - row);
+
+  char rowBuffer[96];
+  sprintf_s(rowBuffer, sizeof(rowBuffer) / sizeof(char),
+    "%04u-%02u-%02u  %u kcal  P %u  F %u  C %u",
+    meal.date.year, meal.date.month, meal.date.day,
+    meal.macro.cals, meal.macro.protein, meal.macro.fat, meal.macro.carbs
+  );
+  UStr_appendLiteral(out, rowBuffer);
+}
+
+// Grams logged when the food input doesn't start with an amount ("150g oats")
+#define FOOD_DEFAULT_GRAMS 100
+#define FOOD_INPUT_MAX_BYTES 256
+
+// Food input as UTF-8 in text, returns the name after the amount and its length in *length
+const char *_App_foodInput(UI_t *input, char text[FOOD_INPUT_MAX_BYTES], uint32_t *length, uint32_t *grams) {
+  UiInput_t *unique = input->_unique;
+
+  char *end = text;
+  for (size_t index = 0; index < unique->str.count; index++) {
+    encode_code_point(&end, &text[FOOD_INPUT_MAX_BYTES], unique->str.str[index]);
+  }
+
+  const char *name = text;
+  uint32_t amount = 0;
+  while (name < end && *name >= '0' && *name <= '9' && amount < UINT32_MAX / 10) {
+    amount = amount * 10 + (uint32_t)(*name++ - '0');
+  }
+  if (name > text && name + 1 < end && name[0] == 'g' && name[1] == ' ' && amount > 0) {
+    name += 2;
+    *grams = amount;
+  } else {
+    name = text;
+    *grams = FOOD_DEFAULT_GRAMS;
+  }
+
+  while (name < end && *name == ' ') {
+    name++;
+  }
+  *length = (uint32_t)(end - name);
+  return name;
+}
+
+// Names looked at per keystroke and per frame, an unfinished search carries on next frame
+#define FOOD_SEARCH_FRAME_BUDGET (1 << 14)
+
+// Suggestions best first, with their calories per 100 grams
+void _App_foodSuggestionRow(App_t *app, UI_t *list, uint32_t row, UStr_t *out) {
+  FoodId_t food = app->foodQuery.results[row].food;
+
+  char rowBuffer[48];
+  sprintf_s(rowBuffer, sizeof(rowBuffer) / sizeof(char), "  %.0f kcal/100g",
+    FoodCatalog_get(&app->foods, food)->per100g.cals
+  );
+  UStr_appendLiteral(out, FoodCatalog_name(&app->foods, food));
+  UStr_appendLiteral(out, rowBuffer);
+}
+
+// Runs the food query for one budget and shows what it has found so far
+void _App_runFoodQuery(App_t *app) {
+  app->_foodQueryDone = FoodSearchQuery_run(&app->foodQuery, FOOD_SEARCH_FRAME_BUDGET);
+  UI_listRefresh(app->_foodSuggestions, app, app->foodQuery.length > 0 ? app->foodQuery.resultCount : 0);
+}
+
+// Every keystroke narrows the last query, FoodSearchQuery_set keeps the work both share
+void _App_foodInputChanged(App_t *app, UI_t *self) {
+  char text[FOOD_INPUT_MAX_BYTES];
+  uint32_t length, grams;
+  const char *name = _App_foodInput(self, text, &length, &grams);
+
+  FoodSearchQuery_set(&app->foodQuery, name, length);
+  _App_runFoodQuery(app);
+
+  // Back from a rejection tint, edits only come while the input is focused
+  glm_vec4_copy(self->color, self->_color);
+  self->_color[0] = 1.f;
+}
+
+// Logs grams of food as one meal of today, fails when the database rejects the meal
+Result_t _App_logFood(App_t *app, FoodId_t food, uint32_t grams) {
+  SYSTEMTIME now;
+  GetLocalTime(&now);
+
+  FoodMeal_t meal;
+  FoodMeal_init(&meal, (Date_t) { .year = now.wYear, .month = now.wMonth, .day = now.wDay });
+  FoodMeal_add(&meal, food, grams);
+
+  uint32_t mealCount = app->db->mealCount;
+  MacroDatabase_add(app->db, FoodMeal_toMeal(&meal, &app->foods));
+  FoodMeal_cleanup(&meal);
+
+  if (app->db->mealCount == mealCount)
+    return RESULT_FAIL;
+
+  UI_listRefresh(app->_mealList, app, app->db->mealCount);
+  _App_chartHistory(app, app->_historyChart);
+  _App_heatmapChanged(app, app->_heatmap);
+  return RESULT_SUCCESS;
+}
+
+// Tints the food input until its next edit
+void _App_foodInputRejected(UI_t *input) {
+  glm_vec4_copy((vec4)COLOR_RED, input->_color);
+}
+
+// Enter logs the food the input names, or the best suggestion for it
+void _App_foodInputSubmitted(App_t *app, UI_t *self) {
+  char text[FOOD_INPUT_MAX_BYTES];
+  uint32_t length, grams;
+  const char *name = _App_foodInput(self, text, &length, &grams);
+
+  FoodId_t food = FoodCatalog_find(&app->foods, name, length);
+  if (food == FOOD_ID_NONE && length > 0 && app->foodQuery.resultCount > 0)
+    food = app->foodQuery.results[0].food;
+  if (food == FOOD_ID_NONE) {
+    log_info("No food named %.*s in the catalog" ENDL, (int)length, name);
+    _App_foodInputRejected(self);
+    return;
+  }
+
+  // A rejected meal keeps its text in the input to be corrected
+  if (_App_logFood(app, food, grams) != RESULT_SUCCESS) {
+    log_info("Meal of %ug %s rejected" ENDL, grams, FoodCatalog_name(&app->foods, food));
+    _App_foodInputRejected(self);
+    return;
+  }
+  UStr_reset(&((UiInput_t *)self->_unique)->str);
+  _App_foodInputChanged(app, self);
+}
+
 Result_t _App_initUI(App_t *app) {
   UiInfo_t info = {
     .color = {1.f, 0.f, 0.f, 0.5f},
@@ -1224,7 +1893,9 @@ Result_t _App_initUI(App_t *app) {
   UI_addChildContainerById(&app->_uiRoot, &info, &containerInfo);
 
   UiInputInfo_t inputInfo = {
-    .str = "Default Input"
+    .str = "",
+    .onChange = _App_foodInputChanged,
+    .onSubmit = _App_foodInputSubmitted
   };
 
   info = (UiInfo_t) {
@@ -1240,6 +1911,93 @@ Result_t _App_initUI(App_t *app) {
     .parentId = 1
   };
   UI_addChildInputById(&app->_uiRoot, &info, &inputInfo);
+
+  UiChartInfo_t chartInfo = {
+    .offset = {0.f, 0.f},
+    .extent = {CHART_HISTORY_DAYS, 1.f},
+    .lineWidth = 0.005f,
+    .barWidth = 0.8f
+  };
+
+  info = (UiInfo_t) {
+    .flags = UI_FLAG_NONE,
+    .color = COLOR_BLACK,
+    .size = (UiSize_t) {
+      .flag = UI_SIZE_FLAG_REAL,
+      .width = 1.6f,
+      .height = 0.6f
+    },
+    .position = {0.f, 0.5f},
+    .id = 3,
+    .parentId = 0
+  };
+  app->_historyChart = UI_addChildChartById(&app->_uiRoot, &info, &chartInfo);
+  _App_chartHistory(app, app->_historyChart);
+
+  SYSTEMTIME now;
+  GetLocalTime(&now);
+  UiHeatmapInfo_t heatmapInfo = {
+    .year = now.wYear,
+    .mode = UI_HEATMAP_CALS,
+    .cellGap = 0.15f,
+    .onChange = _App_heatmapChanged
+  };
+
+  info = (UiInfo_t) {
+    .flags = UI_FLAG_NONE,
+    .color = COLOR_BLACK,
+    .size = (UiSize_t) {
+      .flag = UI_SIZE_FLAG_REAL,
+      .width = 1.6f,
+      .height = 1.6f * 7.f / UI_HEATMAP_WEEKS
+    },
+    .position = {0.f, 0.f},
+    .id = 4,
+    .parentId = 0
+  };
+  app->_heatmap = UI_addChildHeatmapById(&app->_uiRoot, &info, &heatmapInfo);
+  _App_heatmapChanged(app, app->_heatmap);
+
+  UiListInfo_t listInfo = {
+    .rowHeight = 1.f / 16.f,
+    .rowColor = COLOR_WHITE,
+    .getRow = _App_mealRow
+  };
+
+  info = (UiInfo_t) {
+    .flags = UI_FLAG_NONE,
+    .color = COLOR_BLACK,
+    .size = (UiSize_t) {
+      .flag = UI_SIZE_FLAG_REAL,
+      .width = 0.8f,
+      .height = 0.8f
+    },
+    .position = {-0.5f, 0.f},
+    .id = 5,
+    .parentId = 1
+  };
+  app->_mealList = UI_addChildListById(&app->_uiRoot, &info, &listInfo);
+  UI_listRefresh(app->_mealList, app, app->db->mealCount);
+
+  listInfo = (UiListInfo_t) {
+    .rowHeight = 1.f / 8.f,
+    .rowColor = COLOR_WHITE,
+    .getRow = _App_foodSuggestionRow
+  };
+
+  info = (UiInfo_t) {
+    .flags = UI_FLAG_NONE,
+    .color = COLOR_BLACK,
+    .size = (UiSize_t) {
+      .flag = UI_SIZE_FLAG_REAL,
+      .width = 0.8f,
+      .height = 0.6f
+    },
+    .position = {0.5f, 0.05f},
+    .id = 6,
+    .parentId = 1
+  };
+  app->_foodSuggestions = UI_addChildListById(&app->_uiRoot, &info, &listInfo);
 //
 //  UiButtonInfo_t buttonInfo = {
 //    .onHoverColor = COLOR_SECONDARY,
@@ -1313,7 +2071,13 @@ bool _App_UIprocessEvent(App_t *app, UI_t *ui, Event_t *ev) {
     case UI_EL_TYPE_BUTTON:
       return UI_buttonProcessEvent(ui, app, ev);
     case UI_EL_TYPE_INPUT:
-      return UI_inputProcessEvent(ui, ev);
+      return UI_inputProcessEvent(ui, app, ev);
+    case UI_EL_TYPE_CHART:
+      return UI_chartProcessEvent(ui, app, ev);
+    case UI_EL_TYPE_HEATMAP:
+      return UI_heatmapProcessEvent(ui, app, ev);
+    case UI_EL_TYPE_LIST:
+      return UI_listProcessEvent(ui, app, ev);
     default:
       return false;
   }
@@ -1364,6 +2128,10 @@ void _App_update(App_t *app)
   while (EventQueue_pop(&app->_evQueue, &ev)) {
     _App_UIprocessEvent(app, &app->_uiRoot, &ev);
   }
+
+  if (!app->_foodQueryDone)
+    _App_runFoodQuery(app);
+  MacroDatabase_poll(app->db);
 }
 
 void App_destroy(App_t *app) {
@@ -1371,10 +2139,15 @@ void App_destroy(App_t *app) {
 
   CloseHandle(app->_renderThread);
 
+  _Draw_releaseUiBuffers(app, &app->_uiRoot);
   UI_destroy(&app->_uiRoot);
   EventQueue_cleanup(&app->_evQueue);
+  FoodSearch_cleanup(&app->_foodSearch);
+  FoodCatalog_cleanup(&app->foods);
   _App_cleanupTextRenderer(app);
   _App_OpenGlCleanup(app);
+  if (app->db != NULL)
+    MacroDatabase_destroy(app->db);
   
   DEBUG_ASSERT(app->_wnd != NULL, "GLFWwindow app->_wnd is set to NULL, not initialized");
   glfwDestroyWindow(app->_wnd);
@@ -1511,16 +2284,18 @@ Result_t App_create(App_t** p_app, AppInfo_t info) {
 
     .draw = (Draw_t) {
       ._quadEBO = 0,
-      ._quadVAO = 0,
       ._quadVBO = 0,
 
-      ._texShader = 0,
-      ._flatShader = 0,
-
       ._view = GLM_MAT4_IDENTITY_INIT,
       ._projection = GLM_MAT4_IDENTITY_INIT,
 
-      ._globalUB = 0, ._localUB = 0,
+      ._stream = (_DrawStream_t) {0},
+      ._chartShader = 0, ._chartVAO = 0,
+      ._heatmapShader = 0, ._heatmapVAO = 0,
+      ._quadShader = 0, ._batchVAO = 0,
+      ._batch = NULL,
+      ._batchCount = 0, ._batchCap = 0,
+      ._batchTextureCount = 0,
       ._globalUBData = (_GlobalUBData_t) {
         .projectionView = GLM_MAT4_IDENTITY_INIT 
       },
@@ -1532,6 +2307,14 @@ Result_t App_create(App_t** p_app, AppInfo_t info) {
     ._spritePosition = {0, 0},
     ._mouseStart = {0, 0},
 
+    .db = NULL,
+    .goals = NULL,
+    ._foodQueryDone = true,
+    ._mealList = NULL,
+    ._historyChart = NULL,
+    ._heatmap = NULL,
+    ._foodSuggestions = NULL,
+
     .info = info,
     ._inCap = DEFAULT_BUF_CAP,
     ._inCount = 0,
@@ -1551,6 +2334,7 @@ Result_t App_create(App_t** p_app, AppInfo_t info) {
   glfwSetMouseButtonCallback(window, _App_wndMouseBtnCBCK);
   glfwSetFramebufferSizeCallback(window, _App_wndFbResizeCBCK);
   glfwSetCharCallback(window, _App_wndCharCBCK);
+  glfwSetScrollCallback(window, _App_wndScrollCBCK);
 
   glfwMakeContextCurrent(window);
   int glVersion = 0;
@@ -1564,6 +2348,26 @@ Result_t App_create(App_t** p_app, AppInfo_t info) {
   }
 
   EventQueue_init(&(*p_app)->_evQueue);
+
+  MacroLogInfo_t logInfo = MACRO_LOG_INFO_INIT;
+  if (((*p_app)->db = MacroDatabase_open(MACRO_DB_PATH, &logInfo, 0)) == NULL) {
+    log_error("Failed to open the macro database at " MACRO_DB_PATH ENDL);
+    return RESULT_FAIL;
+  }
+  // The history so far is only scanned from now on, it moves to the packed tier right away.
+  // New meals stay on the columns, the database works the same if this fails
+  MacroDatabase_freeze((*p_app)->db, (*p_app)->db->mealCount);
+
+  // Foods are optional, without a catalog nothing can be logged by name
+  FoodCatalog_init(&(*p_app)->foods);
+  if (FoodCatalog_load(&(*p_app)->foods, FOOD_CATALOG_PATH) != RESULT_SUCCESS)
+    log_warn("Starting without a food catalog" ENDL);
+  if (FoodSearch_build(&(*p_app)->_foodSearch, &(*p_app)->foods) != RESULT_SUCCESS) {
+    log_error("Failed to index the food catalog" ENDL);
+    return RESULT_FAIL;
+  }
+  FoodSearchQuery_init(&(*p_app)->foodQuery, &(*p_app)->_foodSearch);
+
   if (_App_initUI(*p_app) != RESULT_SUCCESS) {
     log_error("Failed to initialize app ui" ENDL);
     return RESULT_FAIL;